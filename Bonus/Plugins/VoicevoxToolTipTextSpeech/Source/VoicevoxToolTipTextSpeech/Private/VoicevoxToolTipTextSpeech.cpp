@@ -2,12 +2,8 @@
 
 #include "VoicevoxToolTipTextSpeech.h"
 #include "VoicevoxToolTipTextSpeechCommands.h"
-
-#if PLATFORM_WINDOWS
-#include "VoicevoxCoreUtil.h"
-#include "Windows/WindowsHWrapper.h"
-#include <playsoundapi.h>
-#endif
+#include "VoicevoxToolTipTextSpeechActions.h"
+#include "Misc/CoreDelegates.h"
 
 // Todo Naotsunさんが公開されたサンプルソースコードをインクルード
 #include "SlateTextAccessors/DefaultSlateTextAccessor.h"
@@ -15,28 +11,28 @@
 
 #define LOCTEXT_NAMESPACE "FVoicevoxToolTipTextSpeechModule"
 
+DEFINE_LOG_CATEGORY(LogVoicevoxToolTipTextSpeech);
+
 void FVoicevoxToolTipTextSpeechModule::StartupModule()
 {
 	FVoicevoxToolTipTextSpeechCommands::Register();
 	FVoicevoxToolTipTextSpeechCommands::Bind();
 	VoicevoxToolTipTextSpeech::FDefaultSlateTextAccessor::Register();
-#if PLATFORM_WINDOWS
-	FVoicevoxCoreUtil::Initialize(false);
-	constexpr int SpeakerId = static_cast<int64>(ESpeakerType::Zundamon);
-	int OutputBinarySize = 0;
-	uint8* OutputWAV = FVoicevoxCoreUtil::RunTextToSpeech(SpeakerId, TEXT("アンリアルエンジン、ファイブ"), OutputBinarySize);
-	PlaySound(reinterpret_cast<LPCTSTR>(OutputWAV), nullptr, SND_MEMORY);
-	FVoicevoxCoreUtil::WavFree(OutputWAV);	
-#endif
+	FCoreDelegates::OnPostEngineInit.AddRaw(this, &FVoicevoxToolTipTextSpeechModule::OnPostEngineInit);
 }
 
 void FVoicevoxToolTipTextSpeechModule::ShutdownModule()
 {
+	FCoreDelegates::OnPostEngineInit.RemoveAll(this);
 	VoicevoxToolTipTextSpeech::FDefaultSlateTextAccessor::Unregister();
 	FVoicevoxToolTipTextSpeechCommands::Unregister();
-#if PLATFORM_WINDOWS
-	FVoicevoxCoreUtil::Finalize();
-#endif
+	FVoicevoxToolTipTextSpeechActions::Shutdown();
+}
+
+void FVoicevoxToolTipTextSpeechModule::OnPostEngineInit()
+{
+	// VOICEVOX COREの初期化を兼ねて、バックグラウンドで合成して読み上げる
+	FVoicevoxToolTipTextSpeechActions::Speak(TEXT("アンリアルエンジン、ファイブ"));
 }
 
 #undef LOCTEXT_NAMESPACE
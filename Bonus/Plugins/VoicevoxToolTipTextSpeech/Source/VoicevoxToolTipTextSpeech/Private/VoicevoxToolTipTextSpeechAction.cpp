@@ -1,22 +1,136 @@
 ﻿// Copyright Yuuki Ogino. All Rights Reserved.
 
 #include "VoicevoxToolTipTextSpeechActions.h"
+#include "VoicevoxToolTipTextSpeech.h"
+#include "VoicevoxBlueprintLibrary.h"
+#include "Containers/Ticker.h"
+#include "Editor.h"
+#include "Subsystems/VoicevoxCoreSubsystem.h"
+#include "Tasks/Task.h"
 
 // Todo Naotsunさんが公開されたサンプルソースコードをインクルード
 #include "Utilities/SamplePluginSlateHelpers.h"
 #include "SlateTextAccessors/TooltipTextAccessor.h"
-//↑ここまで 
+//↑ここまで
 
-#if PLATFORM_WINDOWS
-#include "VoicevoxCoreUtil.h"
-#include "Windows/WindowsHWrapper.h"
-#include <playsoundapi.h>
-#endif
+namespace
+{
+	//! 読み上げる話者番号（ずんだもん）
+	constexpr int64 SpeakerId = 3;
+
+	//! 音声合成結果のキャッシュの最大数（ツールチップは同じ文言を何度も表示するため、合成済みの文言は再合成しない）
+	constexpr int32 SynthesisCacheMaxNum = 64;
+
+	//! 音声合成結果のキャッシュ（キーはツールチップの文言）
+	TMap<FString, TArray<uint8>> SynthesisCacheMap;
+
+	//! 音声合成結果キャッシュの使用順キーリスト（先頭が最も古い）
+	TArray<FString> SynthesisCacheKeyList;
+
+	//! 実行中のバックグラウンド音声合成タスク
+	UE::Tasks::TTask<TArray<uint8>> SynthesisTask;
+
+	//! 実行中のバックグラウンド音声合成のテキスト
+	FString SynthesisTaskMessage;
+
+	//! 合成中に要求された、次に合成するテキスト
+	FString PendingMessage;
+
+	//! 音声合成タスクの完了を確認するティッカー
+	FTSTicker::FDelegateHandle SynthesisTickerHandle;
+
+	/**
+	 * @brief 音声データをエディタのプレビュー音声として再生する（直前のプレビュー音声は停止する）
+	 */
+	void PlayPreview(const TArray<uint8>& OutputWAV)
+	{
+		if (GEditor == nullptr) return;
+
+		if (USoundWave* Sound = UVoicevoxBlueprintLibrary::CreateSoundWave(OutputWAV))
+		{
+			GEditor->PlayPreviewSound(Sound);
+		}
+	}
+
+	/**
+	 * @brief 音声合成結果をキャッシュに登録する
+	 */
+	void AddSynthesisCache(const FString& Message, const TArray<uint8>& OutputWAV)
+	{
+		SynthesisCacheMap.Add(Message, OutputWAV);
+		SynthesisCacheKeyList.Remove(Message);
+		SynthesisCacheKeyList.Add(Message);
+		while (SynthesisCacheKeyList.Num() > SynthesisCacheMaxNum)
+		{
+			SynthesisCacheMap.Remove(SynthesisCacheKeyList[0]);
+			SynthesisCacheKeyList.RemoveAt(0);
+		}
+	}
+
+	/**
+	 * @brief バックグラウンドで音声合成を開始する
+	 */
+	void LaunchSynthesis(const FString& Message)
+	{
+		SynthesisTaskMessage = Message;
+		SynthesisTask = UE::Tasks::Launch(TEXT("VoicevoxToolTipTextSpeechTask"), [Message]
+		{
+			// 初期化、モデル読み込みもエディタを止めないようにバックグラウンドで行う
+			UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+			if (!Subsystem->GetIsInitialize() && !Subsystem->Initialize(false))
+			{
+				return TArray<uint8>();
+			}
+			if (!Subsystem->LoadModel(SpeakerId))
+			{
+				return TArray<uint8>();
+			}
+			return Subsystem->RunTextToSpeech(SpeakerId, Message, false, true);
+		});
+
+		if (!SynthesisTickerHandle.IsValid())
+		{
+			SynthesisTickerHandle = FTSTicker::GetCoreTicker().AddTicker(TEXT("VoicevoxToolTipTextSpeech"), 0.0f, [](float)
+			{
+				if (!SynthesisTask.IsCompleted()) return true;
+
+				const TArray<uint8> OutputWAV = SynthesisTask.GetResult();
+				const FString Message = MoveTemp(SynthesisTaskMessage);
+				SynthesisTask = UE::Tasks::TTask<TArray<uint8>>();
+
+				if (OutputWAV.IsEmpty())
+				{
+					UE_LOG(LogVoicevoxToolTipTextSpeech, Error, TEXT("Error:TextToSpeech Failed %s"), *Message);
+				}
+				else
+				{
+					AddSynthesisCache(Message, OutputWAV);
+				}
+
+				// 合成中に別の文言が要求されていた場合は、合成した文言は再生せずに最新の文言を合成する
+				if (!PendingMessage.IsEmpty())
+				{
+					const FString NextMessage = MoveTemp(PendingMessage);
+					PendingMessage.Empty();
+					FVoicevoxToolTipTextSpeechActions::Speak(NextMessage);
+				}
+				else if (!OutputWAV.IsEmpty())
+				{
+					PlayPreview(OutputWAV);
+				}
+
+				if (SynthesisTask.IsValid()) return true;
+				SynthesisTickerHandle.Reset();
+				return false;
+			});
+		}
+	}
+}
 
 void FVoicevoxToolTipTextSpeechActions::VoicevoxTooltipTextSpeechAccessor()
 {
 	const TSharedPtr<SWidget> TooltipWidget = FSamplePluginSlateHelpers::GetTooltipWidget();
-	
+
 	TSharedPtr<VoicevoxToolTipTextSpeech::ITooltipTextAccessor> TooltipText = nullptr;
 	{
 		TArray<TSharedPtr<SWidget>> ChildWidgets;
@@ -36,13 +150,55 @@ void FVoicevoxToolTipTextSpeechActions::VoicevoxTooltipTextSpeechAccessor()
 		if (const FText& TextTooltip = TooltipText->GetTextTooltip(); !TextTooltip.IsEmpty())
 		{
 			// ToolTipの文言を読み上げる
-#if PLATFORM_WINDOWS
-			constexpr int SpeakerId = static_cast<int64>(ESpeakerType::Zundamon);
-			int OutputBinarySize = 0;
-			uint8* OutputWAV = FVoicevoxCoreUtil::RunTextToSpeech(SpeakerId, *TextTooltip.ToString(), OutputBinarySize);
-			PlaySound(reinterpret_cast<LPCTSTR>(OutputWAV), nullptr, SND_MEMORY);
-			FVoicevoxCoreUtil::WavFree(OutputWAV);	
-#endif			
+			Speak(TextTooltip.ToString());
 		}
 	}
 }
+
+/**
+ * @brief テキストをバックグラウンドで音声合成し、エディタのプレビュー音声として再生する
+ */
+void FVoicevoxToolTipTextSpeechActions::Speak(const FString& Message)
+{
+	check(IsInGameThread());
+
+	if (Message.IsEmpty()) return;
+
+	if (const TArray<uint8>* OutputWAV = SynthesisCacheMap.Find(Message))
+	{
+		SynthesisCacheKeyList.Remove(Message);
+		SynthesisCacheKeyList.Add(Message);
+		PendingMessage.Empty();
+		PlayPreview(*OutputWAV);
+		return;
+	}
+
+	// 合成中は最後に要求された文言だけを待機させる
+	if (SynthesisTask.IsValid())
+	{
+		PendingMessage = SynthesisTaskMessage.Equals(Message, ESearchCase::CaseSensitive) ? FString() : Message;
+		return;
+	}
+
+	LaunchSynthesis(Message);
+}
+
+/**
+ * @brief 実行中の音声合成の完了を待ち、キャッシュを破棄する
+ */
+void FVoicevoxToolTipTextSpeechActions::Shutdown()
+{
+	if (SynthesisTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(SynthesisTickerHandle);
+		SynthesisTickerHandle.Reset();
+	}
+	if (SynthesisTask.IsValid())
+	{
+		SynthesisTask.Wait();
+		SynthesisTask = UE::Tasks::TTask<TArray<uint8>>();
+	}
+	PendingMessage.Empty();
+	SynthesisCacheMap.Empty();
+	SynthesisCacheKeyList.Empty();
+}
@@ -1,19 +1,12 @@
 // Copyright Yuuki Ogino. All Rights Reserved.
 
 #include "VoicevoxToolTipTextSpeechCommands.h"
+#include "VoicevoxToolTipTextSpeech.h"
 #include "VoicevoxToolTipTextSpeechActions.h"
 #include "Interfaces/IMainFrameModule.h"
 
-#if PLATFORM_WINDOWS
-#include "VoicevoxCoreUtil.h"
-#endif
-
 #define LOCTEXT_NAMESPACE "FVoicevoxToolTipTextSpeechModule"
 
-#if PLATFORM_WINDOWS
-DEFINE_LOG_CATEGORY(LogVoicevoxEngine);
-#endif
-
 FVoicevoxToolTipTextSpeechCommands::FVoicevoxToolTipTextSpeechCommands()
 	: TCommands<FVoicevoxToolTipTextSpeechCommands>
 	(
@@ -51,16 +44,12 @@ void FVoicevoxToolTipTextSpeechCommands::BindCommands()
 {
 	if (!IsRegistered())
 	{
-#if PLATFORM_WINDOWS
-		UE_LOG(LogVoicevoxEngine, Fatal, TEXT("Bound before UI Command was registered.\nPlease be sure to bind after registration."));
-#endif
+		UE_LOG(LogVoicevoxToolTipTextSpeech, Fatal, TEXT("Bound before UI Command was registered.\nPlease be sure to bind after registration."));
 	}
 
 	if (IsBound())
 	{
-#if PLATFORM_WINDOWS
-		UE_LOG(LogVoicevoxEngine, Warning, TEXT("The binding process has already been completed."));
-#endif
+		UE_LOG(LogVoicevoxToolTipTextSpeech, Warning, TEXT("The binding process has already been completed."));
 	}
 	bIsBound = true;
 
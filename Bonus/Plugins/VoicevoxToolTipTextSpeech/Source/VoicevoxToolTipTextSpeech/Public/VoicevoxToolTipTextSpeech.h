@@ -4,9 +4,14 @@
 
 #include "CoreMinimal.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogVoicevoxToolTipTextSpeech, Log, All);
+
 class FVoicevoxToolTipTextSpeechModule : public IModuleInterface
 {
 public:
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+private:
+	void OnPostEngineInit();
 };
@@ -8,4 +8,16 @@ class FVoicevoxToolTipTextSpeechActions
 {
 public:
 	static void VoicevoxTooltipTextSpeechAccessor();
+
+	/**
+	 * @brief テキストをバックグラウンドで音声合成し、エディタのプレビュー音声として再生する
+	 * @param[in] Message 読み上げるテキスト
+	 * @details 合成済みのテキストはキャッシュから即座に再生します。合成中に呼ばれた場合は最後に呼ばれたテキストだけを合成完了後に合成します。
+	 */
+	static void Speak(const FString& Message);
+
+	/**
+	 * @brief 実行中の音声合成の完了を待ち、キャッシュを破棄する
+	 */
+	static void Shutdown();
 };
@@ -27,7 +27,8 @@ public class VoicevoxToolTipTextSpeech : ModuleRules
 				"SlateCore",
 				"MainFrame",
 				"EditorStyle",
-				"VoicevoxEngine"
+				"VoicevoxEngine",
+				"VoicevoxUECore"
 			}
 		);
 	}
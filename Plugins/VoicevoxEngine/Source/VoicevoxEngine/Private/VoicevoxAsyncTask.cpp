@@ -10,6 +10,26 @@
 #include "VoicevoxBlueprintLibrary.h"
 #include "Subsystems/VoicevoxCoreSubsystem.h"
 
+namespace
+{
+	/**
+	 * @brief タスクの完了処理をゲームスレッドで実行するキューへ積む
+	 * @param[in] Action 完了処理を実行するノード（実行時に破棄されている場合は実行しない）
+	 * @param[in] Completion ゲームスレッドで実行する完了処理（USoundWaveの生成、デリゲートの呼び出し等）
+	 */
+	void EnqueueCompletion(UBlueprintAsyncActionBase* Action, TUniqueFunction<void()>&& Completion)
+	{
+		GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->EnqueueGameThreadCompletion(
+			[WeakAction = TWeakObjectPtr<UBlueprintAsyncActionBase>(Action), Completion = MoveTemp(Completion)]
+			{
+				if (WeakAction.IsValid())
+				{
+					Completion();
+				}
+			});
+	}
+}
+
 //------------------------------------------------------------------------
 // UVoicevoxInitializeAsyncTask
 //------------------------------------------------------------------------
@@ -33,15 +53,19 @@ void UVoicevoxInitializeAsyncTask::Activate()
 {
 	Task = UE::Tasks::Launch<>(TEXT("VoicevoxCoreTask"), [&]
 	{
-		if (GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->Initialize(bUseGPU, CPUNumThreads, false))
-		{
-			OnSuccess.Broadcast();
-		}
-		else
+		const bool bIsSucceeded = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->Initialize(bUseGPU, CPUNumThreads, false);
+		EnqueueCompletion(this, [this, bIsSucceeded]
 		{
-			OnFail.Broadcast();
-		}
-		SetReadyToDestroy();
+			if (bIsSucceeded)
+			{
+				OnSuccess.Broadcast();
+			}
+			else
+			{
+				OnFail.Broadcast();
+			}
+			SetReadyToDestroy();
+		});
 	});
 }
 
@@ -54,6 +78,54 @@ void UVoicevoxInitializeAsyncTask::BeginDestroy()
 	Super::BeginDestroy();
 }
 
+//------------------------------------------------------------------------
+// UVoicevoxCalibrateCPUNumThreadsAsyncTask
+//------------------------------------------------------------------------
+
+/**
+ * @brief 推論スレッド数を計測し、このマシンの設定として保存する(Blueprint公開ノード)
+ */
+UVoicevoxCalibrateCPUNumThreadsAsyncTask* UVoicevoxCalibrateCPUNumThreadsAsyncTask::CalibrateCPUNumThreads(UObject* WorldContextObject, const int SpeakerType, const bool bForce)
+{
+	UVoicevoxCalibrateCPUNumThreadsAsyncTask* Task = NewObject<UVoicevoxCalibrateCPUNumThreadsAsyncTask>();
+	Task->SpeakerId = static_cast<int64>(SpeakerType);
+	Task->bForce = bForce;
+	Task->RegisterWithGameInstance(WorldContextObject);
+	return Task;
+}
+
+/**
+ * @brief デリゲートがバインドされた後、アクションをトリガーするために呼び出される
+ */
+void UVoicevoxCalibrateCPUNumThreadsAsyncTask::Activate()
+{
+	Task = UE::Tasks::Launch<>(TEXT("VoicevoxCoreTask"), [&]
+	{
+		const bool bIsSucceeded = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->CalibrateCPUNumThreads(SpeakerId, bForce) > 0;
+		EnqueueCompletion(this, [this, bIsSucceeded]
+		{
+			if (bIsSucceeded)
+			{
+				OnSuccess.Broadcast();
+			}
+			else
+			{
+				OnFail.Broadcast();
+			}
+			SetReadyToDestroy();
+		});
+	});
+}
+
+/**
+ * @brief BeginDestroy
+ */
+void UVoicevoxCalibrateCPUNumThreadsAsyncTask::BeginDestroy()
+{
+	Task.Wait();
+	Super::BeginDestroy();
+}
+
 //------------------------------------------------------------------------
 // UVoicevoxLoadModelAsyncTask
 //------------------------------------------------------------------------
@@ -126,19 +198,25 @@ void UVoicevoxTextToSpeechAsyncTask::Activate()
 {
 	Task = UE::Tasks::Launch<>(TEXT("VoicevoxCoreTextToSpeechTask"), [&]
 	{
-		if (USoundWave* Sound = bIsUseAudioQuery ?
-			UVoicevoxBlueprintLibrary::TextToAudioQueryOutput(SpeakerId, Message, bRunKana, bEnableInterrogativeUpspeak) :
-			UVoicevoxBlueprintLibrary::TextToSpeechOutput(SpeakerId, Message, bRunKana, bEnableInterrogativeUpspeak);
-			Sound != nullptr)
-		{
-			OnSuccess.Broadcast(Sound);
-		}
-		else
+		// 音声合成のみタスク内で行い、USoundWaveの生成と通知はゲームスレッドで行う
+		const UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+		TArray<uint8> OutputWAV = bIsUseAudioQuery ?
+			Subsystem->RunSynthesis(Subsystem->GetAudioQuery(SpeakerId, Message, bRunKana), SpeakerId, bEnableInterrogativeUpspeak) :
+			Subsystem->RunTextToSpeech(SpeakerId, Message, bRunKana, bEnableInterrogativeUpspeak);
+		EnqueueCompletion(this, [this, OutputWAV = MoveTemp(OutputWAV)]
 		{
-			OnFail.Broadcast();
-		}
-		
-		SetReadyToDestroy();
+			if (USoundWave* Sound = !OutputWAV.IsEmpty() ? UVoicevoxBlueprintLibrary::CreateSoundWave(OutputWAV) : nullptr;
+				Sound != nullptr)
+			{
+				OnSuccess.Broadcast(Sound);
+			}
+			else
+			{
+				OnFail.Broadcast();
+			}
+			
+			SetReadyToDestroy();
+		});
 	});
 
 }
@@ -169,6 +247,18 @@ UVoicevoxAudioQueryToSpeechAsyncTask* UVoicevoxAudioQueryToSpeechAsyncTask::Audi
 	return Task;
 }
 
+/**
+ * @brief 期限を指定し、非同期でVOICEVOX COREで取得したAudioQueryを元に音声データを取得(Blueprint公開ノード)
+ */
+UVoicevoxAudioQueryToSpeechAsyncTask* UVoicevoxAudioQueryToSpeechAsyncTask::AudioQueryOutputWithDeadline(UObject* WorldContextObject, int SpeakerType, FVoicevoxAudioQuery AudioQuery, const float Deadline,
+																										 const bool bCancelOnDeadlineMiss, const bool bEnableInterrogativeUpspeak)
+{
+	UVoicevoxAudioQueryToSpeechAsyncTask* Task = AudioQueryOutput(WorldContextObject, SpeakerType, AudioQuery, bEnableInterrogativeUpspeak);
+	Task->Deadline = Deadline;
+	Task->bCancelOnDeadlineMiss = bCancelOnDeadlineMiss;
+	return Task;
+}
+
 UVoicevoxAudioQueryToSpeechAsyncTask* UVoicevoxAudioQueryToSpeechAsyncTask::VoicevoxQueryOutput(UObject* WorldContextObject, UVoicevoxQuery* VoicevoxQuery, bool bEnableInterrogativeUpspeak)
 {
 	UVoicevoxAudioQueryToSpeechAsyncTask* Task = NewObject<UVoicevoxAudioQueryToSpeechAsyncTask>();
@@ -196,19 +286,42 @@ void UVoicevoxAudioQueryToSpeechAsyncTask::Activate()
 		return;
 	}
 	
-	Task = UE::Tasks::Launch<>(TEXT("VoicevoxCoreTextToSpeechTask"), [&]
+	FVoicevoxSynthesisDeadline SynthesisDeadline;
+	if (Deadline > 0.0f)
 	{
-		if (USoundWave* Sound = UVoicevoxBlueprintLibrary::AudioQueryOutput(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak);
-			Sound != nullptr)
+		// 期限はノード実行時から数える
+		SynthesisDeadline = FVoicevoxSynthesisDeadline::FromNow(Deadline);
+		SynthesisDeadline.bCancelOnDeadlineMiss = bCancelOnDeadlineMiss;
+		SynthesisDeadline.OnDeadlineMiss = [this](double)
 		{
-			OnSuccess.Broadcast(Sound);
-		}
-		else
+			EnqueueCompletion(this, [this]
+			{
+				OnDeadlineMiss.Broadcast();
+			});
+		};
+	}
+	
+	Task = UE::Tasks::Launch<>(TEXT("VoicevoxCoreTextToSpeechTask"), [this, SynthesisDeadline = MoveTemp(SynthesisDeadline)]
+	{
+		// 音声合成のみタスク内で行い、USoundWaveの生成と通知はゲームスレッドで行う
+		const UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+		TArray<uint8> OutputWAV = SynthesisDeadline.Deadline > 0.0 ?
+			Subsystem->RunSynthesisWithDeadline(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, SynthesisDeadline) :
+			Subsystem->RunSynthesis(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak);
+		EnqueueCompletion(this, [this, OutputWAV = MoveTemp(OutputWAV)]
 		{
-			OnFail.Broadcast();
-		}
-		
-		SetReadyToDestroy();
+			if (USoundWave* Sound = !OutputWAV.IsEmpty() ? UVoicevoxBlueprintLibrary::CreateSoundWave(OutputWAV) : nullptr;
+				Sound != nullptr)
+			{
+				OnSuccess.Broadcast(Sound);
+			}
+			else
+			{
+				OnFail.Broadcast();
+			}
+			
+			SetReadyToDestroy();
+		});
 	});
 
 }
@@ -7,6 +7,7 @@
 
 #include "VoicevoxBlueprintLibrary.h"
 #include <Sound/SoundWaveProcedural.h>
+#include "Sound/VoicevoxSoundWaveProcedural.h"
 
 #include "Subsystems/VoicevoxCoreSubsystem.h"
 
@@ -115,6 +116,184 @@ USoundWave* UVoicevoxBlueprintLibrary::AudioQueryOutput(const FVoicevoxAudioQuer
 	return nullptr;
 }
 
+/**
+ * @brief アクセント句単位のキャッシュを利用して、VOICEVOX COREで取得したAudioQueryを元にSoundWaveを作成(Blueprint公開ノード)
+ */
+USoundWave* UVoicevoxBlueprintLibrary::AudioQueryOutputWithPhraseCache(const FVoicevoxAudioQuery AudioQuery, int SpeakerType, bool bEnableInterrogativeUpspeak)
+{
+	if (const TArray<uint8> OutputWAV = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->RunSynthesisWithPhraseCache(AudioQuery, SpeakerType, bEnableInterrogativeUpspeak); !OutputWAV.IsEmpty())
+	{
+		return CreateSoundWave(OutputWAV);
+	}
+
+	return nullptr;
+}
+
+/**
+ * @brief アクセント句単位の音声データキャッシュを破棄する(Blueprint公開ノード)
+ */
+void UVoicevoxBlueprintLibrary::ClearPhraseCache()
+{
+	GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->ClearPhraseCache();
+}
+
+/**
+ * @brief 最近再生したセリフのキャッシュのメモリ予算を設定する(Blueprint公開ノード)
+ */
+void UVoicevoxBlueprintLibrary::SetRecentLineCacheMemoryBudget(const float MemoryBudgetMB)
+{
+	GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->SetRecentLineCacheMemoryBudget(static_cast<int64>(FMath::Max(0.0f, MemoryBudgetMB) * 1024.0 * 1024.0));
+}
+
+/**
+ * @brief 最近再生したセリフのキャッシュの使用メモリを取得する(Blueprint公開ノード)
+ */
+float UVoicevoxBlueprintLibrary::GetRecentLineCacheMemoryUsage()
+{
+	return static_cast<float>(GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->GetRecentLineCacheMemoryUsage() / (1024.0 * 1024.0));
+}
+
+/**
+ * @brief 最近再生したセリフのキャッシュを破棄する(Blueprint公開ノード)
+ */
+void UVoicevoxBlueprintLibrary::ClearRecentLineCache()
+{
+	GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->ClearRecentLineCache();
+}
+
+/**
+ * @brief 音声合成リクエストのキャプチャを開始する(Blueprint公開ノード)
+ */
+bool UVoicevoxBlueprintLibrary::StartTraceCapture(const FString& FilePath)
+{
+	const FString TracePath = FilePath.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("Voicevox") / TEXT("Trace.jsonl") : FilePath;
+	return GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->StartTraceCapture(TracePath);
+}
+
+/**
+ * @brief 音声合成リクエストのキャプチャを終了し、トレースファイルへ保存する(Blueprint公開ノード)
+ */
+bool UVoicevoxBlueprintLibrary::StopTraceCapture()
+{
+	return GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->StopTraceCapture();
+}
+
+/**
+ * @brief VOICEVOX COREの初期化、モデルのロードで増加したネイティブ側の常駐メモリを取得する(Blueprint公開ノード)
+ */
+float UVoicevoxBlueprintLibrary::GetNativeMemoryUsage()
+{
+	const UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+	int64 MemoryUsage = Subsystem->GetNativeCoreMemory();
+	for (const TPair<int64, int64>& ModelMemory : Subsystem->GetNativeModelMemoryMap())
+	{
+		MemoryUsage += ModelMemory.Value;
+	}
+	return static_cast<float>(MemoryUsage / (1024.0 * 1024.0));
+}
+
+/**
+ * @brief 定型文の差し込み部分だけ音声合成してSoundWaveを作成(Blueprint公開ノード)
+ */
+USoundWave* UVoicevoxBlueprintLibrary::LineTemplateOutput(const int SpeakerType, const FString Template, const TMap<FString, FString>& SlotValues, const bool bEnableInterrogativeUpspeak)
+{
+	FVoicevoxAudioQuery AudioQuery;
+	if (const TArray<uint8> OutputWAV = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->RunSynthesisWithTemplate(Template, SlotValues, SpeakerType, bEnableInterrogativeUpspeak, AudioQuery); !OutputWAV.IsEmpty())
+	{
+		return CreateSoundWave(OutputWAV);
+	}
+
+	return nullptr;
+}
+
+/**
+ * @brief 定型文の固定部分を事前に音声合成してキャッシュする(Blueprint公開ノード)
+ */
+bool UVoicevoxBlueprintLibrary::PrepareLineTemplate(const int SpeakerType, const FString Template, const bool bEnableInterrogativeUpspeak)
+{
+	return GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->PrepareLineTemplate(Template, SpeakerType, bEnableInterrogativeUpspeak);
+}
+
+/**
+ * @brief 定型文の固定部分のキャッシュを破棄する(Blueprint公開ノード)
+ */
+void UVoicevoxBlueprintLibrary::ClearLineTemplateCache()
+{
+	GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->ClearLineTemplateCache();
+}
+
+/**
+ * @brief 再生用に変換するサンプリングレートを設定する(Blueprint公開ノード)
+ */
+void UVoicevoxBlueprintLibrary::SetPlaybackSampleRate(const int SampleRate)
+{
+	GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->SetPlaybackSampleRate(SampleRate);
+}
+
+/**
+ * @brief 再生用に変換するサンプリングレートをメインのオーディオデバイスに合わせる(Blueprint公開ノード)
+ */
+int UVoicevoxBlueprintLibrary::SetPlaybackSampleRateToAudioDevice()
+{
+	return GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->SetPlaybackSampleRateToAudioDevice();
+}
+
+/**
+ * @brief 選択肢のテキスト等、次に再生する可能性のある候補テキストを投機的に音声合成する(Blueprint公開ノード)
+ */
+void UVoicevoxBlueprintLibrary::SubmitSpeculativeSynthesis(const int SpeakerType, const TArray<FString>& MessageList, const bool bRunKana, const bool bEnableInterrogativeUpspeak)
+{
+	GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->SubmitSpeculativeSynthesis(SpeakerType, MessageList, bRunKana, bEnableInterrogativeUpspeak);
+}
+
+/**
+ * @brief 投機的に音声合成している候補を全て破棄する(Blueprint公開ノード)
+ */
+void UVoicevoxBlueprintLibrary::CancelSpeculativeSynthesis()
+{
+	GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->CancelSpeculativeSynthesis();
+}
+
+/**
+ * @brief 投機的な音声合成のCPU使用率の予算を設定する(Blueprint公開ノード)
+ */
+void UVoicevoxBlueprintLibrary::SetSpeculativeSynthesisCPUBudget(const float CPUBudget)
+{
+	GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->SetSpeculativeSynthesisCPUBudget(CPUBudget);
+}
+
+/**
+ * @brief 音声合成に割り当てるCPU予算を設定する(Blueprint公開ノード)
+ */
+void UVoicevoxBlueprintLibrary::SetSynthesisBudget(const FVoicevoxSynthesisBudget& Budget)
+{
+	GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->SetSynthesisBudget(Budget);
+}
+
+/**
+ * @brief 音声合成に割り当てるCPU予算を取得する(Blueprint公開ノード)
+ */
+FVoicevoxSynthesisBudget UVoicevoxBlueprintLibrary::GetSynthesisBudget()
+{
+	return GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->GetSynthesisBudget();
+}
+
+/**
+ * @brief 音声合成の負荷に応じて品質を調整する設定を変更する(Blueprint公開ノード)
+ */
+void UVoicevoxBlueprintLibrary::SetQualityGovernorSettings(const FVoicevoxQualityGovernorSettings& Settings)
+{
+	GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->SetQualityGovernorSettings(Settings);
+}
+
+/**
+ * @brief 現在の負荷段階を取得する(Blueprint公開ノード)
+ */
+int32 UVoicevoxBlueprintLibrary::GetQualityGovernorLevel()
+{
+	return GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->GetQualityGovernorLevel();
+}
+
 /**
  * @brief AudioQueryアセットからSoundWaveを作成(Blueprint公開ノード)
  * @param[in] VoicevoxQuery						Queryアセット
@@ -138,31 +317,28 @@ USoundWave* UVoicevoxBlueprintLibrary::VoicevoxQueryOutput(UVoicevoxQuery* Voice
  */
 USoundWave* UVoicevoxBlueprintLibrary::CreateSoundWave(TArray<uint8> PCMData)
 {
+	GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->ConvertToPlaybackSampleRate(PCMData);
 	FString ErrorMessage = "";
 	
 	if (FWaveModInfo WaveInfo; WaveInfo.ReadWaveInfo(PCMData.GetData(), PCMData.Num(), &ErrorMessage))
 	{
-		USoundWaveProcedural* Sound = NewObject<USoundWaveProcedural>(USoundWaveProcedural::StaticClass());
-		const int32 ChannelCount = *WaveInfo.pChannels;
-		const int32 SizeOfSample = *WaveInfo.pBitsPerSample / 8;
-		const int32 NumSamples = WaveInfo.SampleDataSize / SizeOfSample;
-		const int32 NumFrames = NumSamples / ChannelCount;
-		
-		Sound->RawPCMDataSize = WaveInfo.SampleDataSize;
-		Sound->QueueAudio(WaveInfo.SampleDataStart, WaveInfo.SampleDataSize);
-		
-		Sound->Duration = static_cast<float>(NumFrames) / *WaveInfo.pSamplesPerSec;
-		Sound->SetSampleRate(*WaveInfo.pSamplesPerSec);
-		Sound->NumChannels = ChannelCount;
-		Sound->TotalSamples = *WaveInfo.pSamplesPerSec * Sound->Duration;
-		Sound->SoundGroup = SOUNDGROUP_Default;
-		
+		// 再生が終わってプールへ返されたSoundWaveがあれば再利用する
+		UVoicevoxSoundWaveProcedural* Sound = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->AcquireSoundWave();
+		Sound->QueuePCMData(WaveInfo.SampleDataStart, WaveInfo.SampleDataSize, *WaveInfo.pSamplesPerSec, *WaveInfo.pChannels);
 		return Sound;
 	}
 
 	return nullptr;
 }
 
+/**
+ * @brief 再生が終わったSoundWaveをプールへ返す(Blueprint公開ノード)
+ */
+void UVoicevoxBlueprintLibrary::ReleaseSoundWave(USoundWave* Sound)
+{
+	GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->ReleaseSoundWave(Cast<UVoicevoxSoundWaveProcedural>(Sound));
+}
+
 /**
  * @brief VOICEVOX COREで取得したAudioQuery元に、中品質なLipSyncに必要なデータリストを取得(Blueprint公開ノード)
  */
@@ -88,6 +88,51 @@ public:
 	virtual void BeginDestroy() override;
 };
 
+//------------------------------------------------------------------------
+// UVoicevoxCalibrateCPUNumThreadsAsyncTask
+//------------------------------------------------------------------------
+
+/**
+ * @class UVoicevoxCalibrateCPUNumThreadsAsyncTask
+ * @brief Blueprintで推論スレッド数のキャリブレーションを実行するLatentノードクラス
+ */
+UCLASS()
+class VOICEVOXENGINE_API UVoicevoxCalibrateCPUNumThreadsAsyncTask : public UVoicevoxAsyncTaskBase
+{
+	GENERATED_BODY()
+
+	//! 実行タスク
+	UE::Tasks::TTask<void> Task;
+public:
+
+	/**
+	 * @brief 推論スレッド数を計測し、このマシンの設定として保存する(Blueprint公開ノード)
+	 * @param[in] WorldContextObject
+	 * @param[in] SpeakerType	計測に使う話者番号
+	 * @param[in] bForce		trueなら計測済みでも計測し直す
+	 * @detail
+	 * 事前にVoicevoxInitializeを実行してください。計測済みの場合はすぐにOnSuccessが呼ばれます。
+	 * 以降はVoicevoxInitializeのCPUNumThreadsが0の場合に計測したスレッド数で初期化します。
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "VoicevoxCalibrateCPUNumThreads", BlueprintInternalUseOnly="true", WorldContext="WorldContextObject"))
+	static UVoicevoxCalibrateCPUNumThreadsAsyncTask* CalibrateCPUNumThreads(UObject* WorldContextObject, int SpeakerType, bool bForce = false);
+
+	//! 計測に使う話者番号
+	int64 SpeakerId = 0;
+	//! trueなら計測済みでも計測し直す
+	bool bForce = false;
+
+	/**
+	 * @brief デリゲートがバインドされた後、アクションをトリガーするために呼び出される
+	 */
+	virtual void Activate() override;
+
+	/**
+	 * @brief BeginDestroy
+	 */
+	virtual void BeginDestroy() override;
+};
+
 //------------------------------------------------------------------------
 // UVoicevoxLoadModelAsyncTask
 //------------------------------------------------------------------------
@@ -216,6 +261,10 @@ public:
 	//! 処理失敗時のデリゲート
 	UPROPERTY(BlueprintAssignable)
 	FVoicevoxCoreAsyncTaskDelegate OnFail;
+
+	//! 期限に間に合わないと予測した時のデリゲート（音声合成の完了を待たずに呼び出される）
+	UPROPERTY(BlueprintAssignable)
+	FVoicevoxCoreAsyncTaskDelegate OnDeadlineMiss;
 	
 	/**
 	 * @brief 非同期でVOICEVOX COREで取得したAudioQueryを元に音声データを取得(Blueprint公開ノード)
@@ -227,6 +276,20 @@ public:
 	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "VoicevoxAudioQueryOutputAsync", BlueprintInternalUseOnly="true", WorldContext="WorldContextObject"))
 	static UVoicevoxAudioQueryToSpeechAsyncTask* AudioQueryOutput(UObject* WorldContextObject, int SpeakerType, FVoicevoxAudioQuery AudioQuery, bool bEnableInterrogativeUpspeak = true);
 
+	/**
+	 * @brief 期限を指定し、非同期でVOICEVOX COREで取得したAudioQueryを元に音声データを取得(Blueprint公開ノード)
+	 * @param[in] WorldContextObject
+	 * @param[in] SpeakerType	話者番号
+	 * @param[in] AudioQuery						AudioQuery構造体
+	 * @param[in] Deadline							音声合成を完了させる期限（ノード実行時からの秒数）
+	 * @param[in] bCancelOnDeadlineMiss				期限に間に合わないと予測した場合、音声合成を中止してOnFailを呼び出す
+	 * @param[in] bEnableInterrogativeUpspeak		疑問文の調整を有効にする
+	 * @details 期限に間に合わないと予測した場合は、音声合成の完了を待たずにOnDeadlineMissを呼び出します。字幕のみの表示等に切り替えてください。
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "VoicevoxAudioQueryOutputWithDeadlineAsync", BlueprintInternalUseOnly="true", WorldContext="WorldContextObject"))
+	static UVoicevoxAudioQueryToSpeechAsyncTask* AudioQueryOutputWithDeadline(UObject* WorldContextObject, int SpeakerType, FVoicevoxAudioQuery AudioQuery, float Deadline,
+																			  bool bCancelOnDeadlineMiss = false, bool bEnableInterrogativeUpspeak = true);
+
 	/**
 	 * @brief 非同期でVOICEVOX COERで変換した音声データを取得(Blueprint公開ノード)
 	 * @param[in] WorldContextObject
@@ -242,6 +305,10 @@ public:
 	FVoicevoxAudioQuery AudioQuery;
 	//! 疑問文の調整を有効
 	bool bEnableInterrogativeUpspeak = true;
+	//! 音声合成を完了させる期限（ノード実行時からの秒数、0以下の場合は期限無し）
+	float Deadline = 0.0f;
+	//! 期限に間に合わないと予測した場合に音声合成を中止する
+	bool bCancelOnDeadlineMiss = false;
 	
 	/**
 	 * @brief デリゲートがバインドされた後、アクションをトリガーするために呼び出される
@@ -127,6 +127,159 @@ public:
 	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "VoicevoxAudioQueryOutput"))
 	static UPARAM(DisplayName="Sound") USoundWave* AudioQueryOutput(FVoicevoxAudioQuery AudioQuery, int SpeakerType, bool bEnableInterrogativeUpspeak = true);
 
+	/**
+	 * @brief アクセント句単位のキャッシュを利用して、VOICEVOX COREで取得したAudioQueryを元にSoundWaveを作成(Blueprint公開ノード)
+	 * @param[in] AudioQuery						AudioQuery構造体
+	 * @param[in] SpeakerType						話者番号
+	 * @param[in] bEnableInterrogativeUpspeak		疑問文の調整を有効にする
+	 * @return AudioQuery情報を元に作成された音楽データが格納されたUSoundWave
+	 * @details AudioQueryの一部を編集しながら繰り返しプレビューする場合、編集したアクセント句と前後のアクセント句のみ再合成します。
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "VoicevoxAudioQueryOutputWithPhraseCache"))
+	static UPARAM(DisplayName="Sound") USoundWave* AudioQueryOutputWithPhraseCache(FVoicevoxAudioQuery AudioQuery, int SpeakerType, bool bEnableInterrogativeUpspeak = true);
+
+	/**
+	 * @brief アクセント句単位の音声データキャッシュを破棄する(Blueprint公開ノード)
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "ClearVoicevoxPhraseCache"))
+	static void ClearPhraseCache();
+
+	/**
+	 * @brief 最近再生したセリフのキャッシュのメモリ予算を設定する(Blueprint公開ノード)
+	 * @param[in] MemoryBudgetMB  メモリ予算（MB、0の場合はキャッシュしない）
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "SetVoicevoxRecentLineCacheMemoryBudget"))
+	static void SetRecentLineCacheMemoryBudget(float MemoryBudgetMB);
+
+	/**
+	 * @brief 最近再生したセリフのキャッシュの使用メモリを取得する(Blueprint公開ノード)
+	 * @return 使用メモリ（MB）
+	 */
+	UFUNCTION(BlueprintPure, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "GetVoicevoxRecentLineCacheMemoryUsage"))
+	static UPARAM(DisplayName="MemoryUsageMB") float GetRecentLineCacheMemoryUsage();
+
+	/**
+	 * @brief 最近再生したセリフのキャッシュを破棄する(Blueprint公開ノード)
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "ClearVoicevoxRecentLineCache"))
+	static void ClearRecentLineCache();
+
+	/**
+	 * @brief 音声合成リクエストのキャプチャを開始する(Blueprint公開ノード)
+	 * @param[in] FilePath  トレースファイルの保存先（空の場合はSaved/Voicevox/Trace.jsonl）
+	 * @return 開始できたらtrue
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "StartVoicevoxTraceCapture"))
+	static bool StartTraceCapture(const FString& FilePath);
+
+	/**
+	 * @brief 音声合成リクエストのキャプチャを終了し、トレースファイルへ保存する(Blueprint公開ノード)
+	 * @return 保存できたらtrue
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "StopVoicevoxTraceCapture"))
+	static bool StopTraceCapture();
+
+	/**
+	 * @brief VOICEVOX COREの初期化、モデルのロードで増加したネイティブ側の常駐メモリを取得する(Blueprint公開ノード)
+	 * @return 使用メモリ（MB、計測した目安の値）
+	 */
+	UFUNCTION(BlueprintPure, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "GetVoicevoxNativeMemoryUsage"))
+	static UPARAM(DisplayName="MemoryUsageMB") float GetNativeMemoryUsage();
+
+	/**
+	 * @brief 定型文の差し込み部分だけ音声合成してSoundWaveを作成(Blueprint公開ノード)
+	 * @param[in] SpeakerType						話者番号
+	 * @param[in] Template							定型文（差し込み部分は{名前}で記述する）
+	 * @param[in] SlotValues						差し込み部分の名前とテキストのマップ
+	 * @param[in] bEnableInterrogativeUpspeak		疑問文の調整を有効にする
+	 * @return 各部分の音声データを繋いだUSoundWave
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "VoicevoxLineTemplateOutput"))
+	static UPARAM(DisplayName="Sound") USoundWave* LineTemplateOutput(int SpeakerType, FString Template, const TMap<FString, FString>& SlotValues, bool bEnableInterrogativeUpspeak = true);
+
+	/**
+	 * @brief 定型文の固定部分を事前に音声合成してキャッシュする(Blueprint公開ノード)
+	 * @param[in] SpeakerType						話者番号
+	 * @param[in] Template							定型文（差し込み部分は{名前}で記述する）
+	 * @param[in] bEnableInterrogativeUpspeak		疑問文の調整を有効にする
+	 * @return 音声合成に成功したらtrue
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "PrepareVoicevoxLineTemplate"))
+	static UPARAM(DisplayName="IsSucceeded") bool PrepareLineTemplate(int SpeakerType, FString Template, bool bEnableInterrogativeUpspeak = true);
+
+	/**
+	 * @brief 定型文の固定部分のキャッシュを破棄する(Blueprint公開ノード)
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "ClearVoicevoxLineTemplateCache"))
+	static void ClearLineTemplateCache();
+
+	/**
+	 * @brief 再生用に変換するサンプリングレートを設定する(Blueprint公開ノード)
+	 * @param[in] SampleRate サンプリングレート（0の場合は変換しない）
+	 * @details 設定すると、生成するSoundWaveの音声データを1度だけリサンプリングし、再生時のオーディオミキサーの負荷を減らします。
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "SetVoicevoxPlaybackSampleRate"))
+	static void SetPlaybackSampleRate(int SampleRate);
+
+	/**
+	 * @brief 再生用に変換するサンプリングレートをメインのオーディオデバイスに合わせる(Blueprint公開ノード)
+	 * @return 設定したサンプリングレート
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "SetVoicevoxPlaybackSampleRateToAudioDevice"))
+	static UPARAM(DisplayName="SampleRate") int SetPlaybackSampleRateToAudioDevice();
+
+	/**
+	 * @brief 選択肢のテキスト等、次に再生する可能性のある候補テキストを投機的に音声合成する(Blueprint公開ノード)
+	 * @param[in] SpeakerType						話者番号
+	 * @param[in] MessageList						候補テキストのリスト
+	 * @param[in] bRunKana							AquesTalkライクな記法で実行するか
+	 * @param[in] bEnableInterrogativeUpspeak		疑問文の調整を有効にする
+	 * @details 選択肢を表示した時に実行すると、選ばれたテキストをPlayToText等で再生する時に合成済みの音声データを使用します。
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "SubmitVoicevoxSpeculativeSynthesis"))
+	static void SubmitSpeculativeSynthesis(int SpeakerType, const TArray<FString>& MessageList, bool bRunKana = false, bool bEnableInterrogativeUpspeak = true);
+
+	/**
+	 * @brief 投機的に音声合成している候補を全て破棄する(Blueprint公開ノード)
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "CancelVoicevoxSpeculativeSynthesis"))
+	static void CancelSpeculativeSynthesis();
+
+	/**
+	 * @brief 投機的な音声合成のCPU使用率の予算を設定する(Blueprint公開ノード)
+	 * @param[in] CPUBudget 候補の合成に使う時間の割合（0.01～1.0）
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "SetVoicevoxSpeculativeSynthesisCPUBudget"))
+	static void SetSpeculativeSynthesisCPUBudget(float CPUBudget);
+
+	/**
+	 * @brief 音声合成に割り当てるCPU予算を設定する(Blueprint公開ノード)
+	 * @param[in] Budget 同時実行数、呼び出し元スレッドの優先度、フレーム時間の余裕の設定
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "SetVoicevoxSynthesisBudget"))
+	static void SetSynthesisBudget(const FVoicevoxSynthesisBudget& Budget);
+
+	/**
+	 * @brief 音声合成に割り当てるCPU予算を取得する(Blueprint公開ノード)
+	 * @return 同時実行数、呼び出し元スレッドの優先度、フレーム時間の余裕の設定
+	 */
+	UFUNCTION(BlueprintPure, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "GetVoicevoxSynthesisBudget"))
+	static FVoicevoxSynthesisBudget GetSynthesisBudget();
+
+	/**
+	 * @brief 音声合成の負荷に応じて品質を調整する設定を変更する(Blueprint公開ノード)
+	 * @param[in] Settings 負荷に応じて品質を調整する設定
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "SetVoicevoxQualityGovernorSettings"))
+	static void SetQualityGovernorSettings(const FVoicevoxQualityGovernorSettings& Settings);
+
+	/**
+	 * @brief 現在の負荷段階を取得する(Blueprint公開ノード)
+	 * @return 負荷段階（0～3、0の場合は品質を下げない）
+	 */
+	UFUNCTION(BlueprintPure, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "GetVoicevoxQualityGovernorLevel"))
+	static int32 GetQualityGovernorLevel();
+
 	/**
 	 * @brief AudioQueryアセットからSoundWaveを作成(Blueprint公開ノード)
 	 * @param[in] VoicevoxQuery						Queryアセット
@@ -143,6 +296,15 @@ public:
 	 */
 	static USoundWave* CreateSoundWave(TArray<uint8> PCMData);
 
+	/**
+	 * @brief 再生が終わったSoundWaveをプールへ返す(Blueprint公開ノード)
+	 * @param[in] Sound  VOICEVOXのノードで作成したUSoundWave
+	 * @details 返したSoundWaveは次の音声合成で再利用されるため、呼び出し後は再生や参照をしないでください。
+	 *			再生中のまま返した場合は、再生が止まるまで再利用しません。
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Engine", meta=(Keywords="voicevox", DisplayName = "ReleaseVoicevoxSoundWave"))
+	static void ReleaseSoundWave(USoundWave* Sound);
+
 	/**
 	 * @brief VOICEVOX COREで取得したAudioQuery元に、中品質なLipSyncに必要なデータリストを取得(Blueprint公開ノード)
 	 * @param[in] AudioQuery AudioQuery構造体
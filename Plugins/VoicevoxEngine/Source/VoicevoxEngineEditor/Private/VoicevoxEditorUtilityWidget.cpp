@@ -12,6 +12,7 @@
 #include "DesktopPlatformModule.h"
 #include "IContentBrowserSingleton.h"
 #include "IDesktopPlatform.h"
+#include "JsonObjectConverter.h"
 #include "VoicevoxBlueprintLibrary.h"
 #include "Factories/VoicevoxQueryFactory.h"
 #include "Factories/VoicevoxSoundWaveFactory.h"
@@ -57,56 +58,229 @@ void UVoicevoxEditorUtilityWidget::SaveAudioQueryAssets(const int64 SpeakerType,
 /**
  * @brief 編集したAudioQueryからSoundWaveアセットを生成して保存する（Blueprint公開ノード）
  */
-void UVoicevoxEditorUtilityWidget::SaveSoundWaveAssets(const int64 SpeakerType, const bool bEnableInterrogativeUpspeak) const
+void UVoicevoxEditorUtilityWidget::SaveSoundWaveAssets(const int64 SpeakerType, const bool bEnableInterrogativeUpspeak)
 {
-    if (const TArray<uint8> OutputWAV = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->RunSynthesis(EditorAudioQueryPtr, SpeakerType, bEnableInterrogativeUpspeak); !OutputWAV.IsEmpty())
+    // プレビュー済みであればキャッシュを利用し、未合成の場合はバックグラウンドで合成後に保存する
+    RequestSynthesis(SpeakerType, bEnableInterrogativeUpspeak, EVoicevoxEditorSynthesisRequest::SoundWave, 0.0f);
+}
+
+/**
+ * @brief 編集したAudioQueryからWavファイルを生成して保存する（Blueprint公開ノード）
+ */
+void UVoicevoxEditorUtilityWidget::SaveWavFile(const int64 SpeakerType, const bool bEnableInterrogativeUpspeak)
+{
+    // プレビュー済みであればキャッシュを利用し、未合成の場合はバックグラウンドで合成後に保存する
+    RequestSynthesis(SpeakerType, bEnableInterrogativeUpspeak, EVoicevoxEditorSynthesisRequest::WavFile, 0.0f);
+}
+
+/**
+ * @brief 編集したAudioQueryのプレビュー音声生成を要求する（Blueprint公開ノード）
+ */
+void UVoicevoxEditorUtilityWidget::RequestPreview(const int64 SpeakerType, const bool bEnableInterrogativeUpspeak)
+{
+    RequestSynthesis(SpeakerType, bEnableInterrogativeUpspeak, EVoicevoxEditorSynthesisRequest::Preview, PreviewDebounceTime);
+}
+
+/**
+ * @brief バックグラウンドの音声合成が待機中、もしくは実行中か（Blueprint公開ノード）
+ */
+bool UVoicevoxEditorUtilityWidget::IsSynthesisPending() const
+{
+    return PendingPreviewJob.IsSet() || !PendingExportJobList.IsEmpty() || SynthesisTask.IsValid();
+}
+
+/**
+ * @brief NativeTick
+ */
+void UVoicevoxEditorUtilityWidget::NativeTick(const FGeometry& MyGeometry, const float InDeltaTime)
+{
+    Super::NativeTick(MyGeometry, InDeltaTime);
+
+    if (SynthesisTask.IsValid() && SynthesisTask.IsCompleted())
     {
-        UVoicevoxSoundWaveFactory* Factory = NewObject<UVoicevoxSoundWaveFactory>();
-        Factory->OutputWAV = OutputWAV;
-        Factory->AddToRoot();
-    
-        const FAssetToolsModule& AssetToolsModule = FAssetToolsModule::GetModule();
-        if (UObject* CreatedAsset = AssetToolsModule.Get().CreateAssetWithDialog(Factory->GetSupportedClass(), Factory); CreatedAsset != nullptr)
+        const TArray<uint8> OutputWAV = SynthesisTask.GetResult();
+        const FVoicevoxEditorSynthesisJob Job = MoveTemp(SynthesisJob);
+        SynthesisTask = UE::Tasks::TTask<TArray<uint8>>();
+        SynthesisJob = FVoicevoxEditorSynthesisJob();
+
+        if (OutputWAV.IsEmpty())
         {
-            FAssetRegistryModule::AssetCreated(CreatedAsset);
-            if (const bool IsMark = CreatedAsset->MarkPackageDirty(); !IsMark)
+            UE_LOG(LogVoicevoxEditor, Error, TEXT("Error:Synthesis Failed"));
+        }
+        else
+        {
+            SynthesisCacheMap.Add(Job.Key, OutputWAV);
+            SynthesisCacheKeyList.Remove(Job.Key);
+            SynthesisCacheKeyList.Add(Job.Key);
+            while (SynthesisCacheKeyList.Num() > SynthesisCacheMaxNum)
             {
-                UE_LOG(LogVoicevoxEditor, Log, TEXT("MarkPackageDirty Error:Create SoundWave Asset"));
+                SynthesisCacheMap.Remove(SynthesisCacheKeyList[0]);
+                SynthesisCacheKeyList.RemoveAt(0);
             }
+            ExecuteSynthesisRequest(OutputWAV, Job.Request);
+        }
+    }
+
+    // 合成タスクは1つずつ実行し、保存要求を優先する。実行中に要求されたAudioQueryは完了後に合成する
+    while (!PendingExportJobList.IsEmpty() && !SynthesisTask.IsValid())
+    {
+        const FVoicevoxEditorSynthesisJob Job = PendingExportJobList[0];
+        PendingExportJobList.RemoveAt(0);
+        ProcessSynthesisJob(Job);
+    }
+
+    if (PendingPreviewJob.IsSet() && !SynthesisTask.IsValid())
+    {
+        PreviewDebounceRemain -= InDeltaTime;
+        if (PreviewDebounceRemain <= 0.0f)
+        {
+            const FVoicevoxEditorSynthesisJob Job = PendingPreviewJob.GetValue();
+            PendingPreviewJob.Reset();
+            ProcessSynthesisJob(Job);
         }
-        Factory->RemoveFromRoot();
+    }
+
+    if (const bool bIsPending = IsSynthesisPending(); bIsPending != bIsNotifiedPending)
+    {
+        bIsNotifiedPending = bIsPending;
+        OnSynthesisPendingChanged(bIsPending);
     }
 }
 
 /**
- * @brief 編集したAudioQueryからWavファイルを生成して保存する（Blueprint公開ノード）
+ * @brief 編集中のAudioQueryから音声合成結果キャッシュのキーを求める
+ */
+FString UVoicevoxEditorUtilityWidget::GetEditorAudioQueryKey(const int64 SpeakerType, const bool bEnableInterrogativeUpspeak) const
+{
+    // ハッシュ値の衝突で別の音声を再生、保存しないよう、JSON文字列をそのままキーにする
+    FString AudioQueryJson;
+    FJsonObjectConverter::UStructToJsonObjectString(EditorAudioQueryPtr, AudioQueryJson, 0, 0, 0, nullptr, false);
+    return FString::Printf(TEXT("%s|%lld|%d"), *AudioQueryJson, SpeakerType, bEnableInterrogativeUpspeak ? 1 : 0);
+}
+
+/**
+ * @brief 編集中のAudioQueryの音声合成を要求する
+ */
+void UVoicevoxEditorUtilityWidget::RequestSynthesis(const int64 SpeakerType, const bool bEnableInterrogativeUpspeak, const EVoicevoxEditorSynthesisRequest Request, const float DebounceTime)
+{
+    FVoicevoxEditorSynthesisJob Job;
+    Job.Key = GetEditorAudioQueryKey(SpeakerType, bEnableInterrogativeUpspeak);
+    Job.AudioQuery = EditorAudioQueryPtr;
+    Job.SpeakerType = SpeakerType;
+    Job.bEnableInterrogativeUpspeak = bEnableInterrogativeUpspeak;
+    Job.Request = Request;
+
+    const bool bIsPreview = EnumHasAnyFlags(Request, EVoicevoxEditorSynthesisRequest::Preview);
+    if (const TArray<uint8>* OutputWAV = SynthesisCacheMap.Find(Job.Key))
+    {
+        // 古いAudioQueryのプレビュー待ちは不要になるので破棄する
+        if (bIsPreview)
+        {
+            PendingPreviewJob.Reset();
+        }
+        ExecuteSynthesisRequest(*OutputWAV, Request);
+        return;
+    }
+
+    // プレビュー待ちは最新の編集内容で置き換え、保存要求は要求した時点のAudioQueryのまま順に処理する
+    if (bIsPreview)
+    {
+        PendingPreviewJob = MoveTemp(Job);
+        PreviewDebounceRemain = DebounceTime;
+    }
+    else
+    {
+        PendingExportJobList.Add(MoveTemp(Job));
+    }
+}
+
+/**
+ * @brief 音声合成待ちの要求をキャッシュから処理し、キャッシュに無い場合はバックグラウンド音声合成を開始する
+ */
+void UVoicevoxEditorUtilityWidget::ProcessSynthesisJob(const FVoicevoxEditorSynthesisJob& Job)
+{
+    if (const TArray<uint8>* OutputWAV = SynthesisCacheMap.Find(Job.Key))
+    {
+        ExecuteSynthesisRequest(*OutputWAV, Job.Request);
+        return;
+    }
+
+    SynthesisJob = Job;
+    SynthesisTask = UE::Tasks::Launch(TEXT("VoicevoxEditorSynthesisTask"),
+        [AudioQuery = Job.AudioQuery, SpeakerType = Job.SpeakerType, bEnableInterrogativeUpspeak = Job.bEnableInterrogativeUpspeak]
+        {
+            return GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->RunSynthesisWithPhraseCache(AudioQuery, SpeakerType, bEnableInterrogativeUpspeak);
+        });
+}
+
+/**
+ * @brief 音声合成結果を元に要求された処理を実行する
+ */
+void UVoicevoxEditorUtilityWidget::ExecuteSynthesisRequest(const TArray<uint8>& OutputWAV, const EVoicevoxEditorSynthesisRequest Request)
+{
+    if (EnumHasAnyFlags(Request, EVoicevoxEditorSynthesisRequest::Preview))
+    {
+        OnPreviewSynthesized(UVoicevoxBlueprintLibrary::CreateSoundWave(OutputWAV));
+    }
+
+    if (EnumHasAnyFlags(Request, EVoicevoxEditorSynthesisRequest::SoundWave))
+    {
+        ExportSoundWaveAssets(OutputWAV);
+    }
+
+    if (EnumHasAnyFlags(Request, EVoicevoxEditorSynthesisRequest::WavFile))
+    {
+        ExportWavFile(OutputWAV);
+    }
+}
+
+/**
+ * @brief 音声データからSoundWaveアセットを生成して保存する
+ */
+void UVoicevoxEditorUtilityWidget::ExportSoundWaveAssets(const TArray<uint8>& OutputWAV)
+{
+    UVoicevoxSoundWaveFactory* Factory = NewObject<UVoicevoxSoundWaveFactory>();
+    Factory->OutputWAV = OutputWAV;
+    Factory->AddToRoot();
+
+    const FAssetToolsModule& AssetToolsModule = FAssetToolsModule::GetModule();
+    if (UObject* CreatedAsset = AssetToolsModule.Get().CreateAssetWithDialog(Factory->GetSupportedClass(), Factory); CreatedAsset != nullptr)
+    {
+        FAssetRegistryModule::AssetCreated(CreatedAsset);
+        if (const bool IsMark = CreatedAsset->MarkPackageDirty(); !IsMark)
+        {
+            UE_LOG(LogVoicevoxEditor, Log, TEXT("MarkPackageDirty Error:Create SoundWave Asset"));
+        }
+    }
+    Factory->RemoveFromRoot();
+}
+
+/**
+ * @brief 音声データをWavファイルに保存する
  */
-void UVoicevoxEditorUtilityWidget::SaveWavFile(const int64 SpeakerType, const bool bEnableInterrogativeUpspeak) const
+void UVoicevoxEditorUtilityWidget::ExportWavFile(const TArray<uint8>& OutputWAV)
 {
-    if (const TArray<uint8> OutputWAV = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->RunSynthesis(EditorAudioQueryPtr, SpeakerType, bEnableInterrogativeUpspeak); !OutputWAV.IsEmpty())
+    if (IDesktopPlatform* DesktopPlatform = FDesktopPlatformModule::Get())
     {
-        if (IDesktopPlatform* DesktopPlatform = FDesktopPlatformModule::Get())
+        TArray<FString> Filenames;
+        if(const bool bSaved = DesktopPlatform->SaveFileDialog(
+            FSlateApplication::Get().FindBestParentWindowHandleForDialogs(nullptr),
+            TEXT("Save Wave File"),
+            TEXT(""),
+            TEXT(""),
+            TEXT( "Wave file|*.wav" ),
+            EFileDialogFlags::None,
+            Filenames
+        ); bSaved && Filenames.Num() > 0)
         {
-            TArray<FString> Filenames;
-            if(const bool bSaved = DesktopPlatform->SaveFileDialog(
-                FSlateApplication::Get().FindBestParentWindowHandleForDialogs(nullptr),
-                TEXT("Save Wave File"),
-                TEXT(""),
-                TEXT(""),
-                TEXT( "Wave file|*.wav" ),
-                EFileDialogFlags::None,
-                Filenames
-            ); bSaved && Filenames.Num() > 0)
+            IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+            TUniquePtr<IFileHandle> FileHandle;
+            FileHandle.Reset(PlatformFile.OpenWrite(*Filenames[0]));
+            if (FileHandle)
             {
-                IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
-                TUniquePtr<IFileHandle> FileHandle;
-                FileHandle.Reset(PlatformFile.OpenWrite(*Filenames[0]));
-                if (FileHandle)
+                if (!FileHandle->Write(OutputWAV.GetData(), OutputWAV.Num()))
                 {
-                    if (!FileHandle->Write(OutputWAV.GetData(), OutputWAV.Num()))
-                    {
-                        UE_LOG(LogVoicevoxEditor, Error, TEXT("Error:Can,t Save to Wave File"));
-                    }
+                    UE_LOG(LogVoicevoxEditor, Error, TEXT("Error:Can,t Save to Wave File"));
                 }
             }
         }
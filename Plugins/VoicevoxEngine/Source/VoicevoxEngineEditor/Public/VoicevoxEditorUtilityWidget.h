@@ -11,6 +11,7 @@
 #include "CoreMinimal.h"
 #include "EditorUtilityWidget.h"
 #include "VoicevoxQuery.h"
+#include "Tasks/Task.h"
 #include "VoicevoxEditorUtilityWidget.generated.h"
 
 class AActor;
@@ -26,6 +27,49 @@ DECLARE_DELEGATE_OneParam(FOnAudioQueryPickingChosen, const TArray<FAssetData>&)
 //! AudioQueryアセットデータ読込キャンセルデリゲートクラス
 DECLARE_DELEGATE(FOnAudioQueryPickingCancelled);
 
+//------------------------------------------------------------------------
+// enum
+//------------------------------------------------------------------------
+
+/**
+ * @enum EVoicevoxEditorSynthesisRequest
+ * @brief バックグラウンド音声合成完了後に実行する処理
+ */
+enum class EVoicevoxEditorSynthesisRequest : uint8
+{
+	None		= 0,
+	Preview		= 1 << 0,
+	SoundWave	= 1 << 1,
+	WavFile		= 1 << 2,
+};
+ENUM_CLASS_FLAGS(EVoicevoxEditorSynthesisRequest);
+
+//------------------------------------------------------------------------
+// struct
+//------------------------------------------------------------------------
+
+/**
+ * @struct FVoicevoxEditorSynthesisJob
+ * @brief バックグラウンド音声合成の要求1件分の構造体
+ */
+struct FVoicevoxEditorSynthesisJob
+{
+	//! 音声合成結果キャッシュのキー
+	FString Key;
+
+	//! 音声合成するAudioQuery
+	FVoicevoxAudioQuery AudioQuery;
+
+	//! スピーカータイプ
+	int64 SpeakerType = 0;
+
+	//! 疑問文調整
+	bool bEnableInterrogativeUpspeak = true;
+
+	//! 音声合成完了後に実行する処理
+	EVoicevoxEditorSynthesisRequest Request = EVoicevoxEditorSynthesisRequest::None;
+};
+
 //------------------------------------------------------------------------
 // class
 //------------------------------------------------------------------------
@@ -48,6 +92,10 @@ public:
 	UPROPERTY(Category=VOICEVOX, VisibleAnywhere, BlueprintReadWrite, meta=(AllowPrivateAccess = "true"))
 	FVoicevoxAudioQuery EditorAudioQueryPtr;
 
+	//! プレビュー要求から音声合成を開始するまでの待機時間（秒）。待機中に再度要求された場合は待機し直す
+	UPROPERTY(Category=VOICEVOX, EditAnywhere, BlueprintReadWrite, meta=(ClampMin = "0.0", UIMin = "0.0"))
+	float PreviewDebounceTime = 0.5f;
+
 	//----------------------------------------------------------------
 	// Function
 	//----------------------------------------------------------------
@@ -74,7 +122,7 @@ public:
 	 * @param [in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
 	 */
 	UFUNCTION(BlueprintCallable, Category="VOICEVOX Editor", meta=(Keywords="voicevox", DisplayName = "SaveSoundWaveAssets"))
-	void SaveSoundWaveAssets(int64 SpeakerType, bool bEnableInterrogativeUpspeak = true) const;
+	void SaveSoundWaveAssets(int64 SpeakerType, bool bEnableInterrogativeUpspeak = true);
 
 	/**
 	 * @brief 編集したAudioQueryからWavファイルを生成して保存する（Blueprint公開ノード）
@@ -82,7 +130,39 @@ public:
 	 * @param [in] bEnableInterrogativeUpspeak : 疑問文の調整を有効にする
 	 */
 	UFUNCTION(BlueprintCallable, Category="VOICEVOX Editor", meta=(Keywords="voicevox", DisplayName = "SaveWavFile"))
-	void SaveWavFile(int64 SpeakerType, bool bEnableInterrogativeUpspeak = true) const;
+	void SaveWavFile(int64 SpeakerType, bool bEnableInterrogativeUpspeak = true);
+
+	/**
+	 * @brief 編集したAudioQueryのプレビュー音声生成を要求する（Blueprint公開ノード）
+	 * @param [in] SpeakerType : スピーカータイプ
+	 * @param [in] bEnableInterrogativeUpspeak : 疑問文の調整を有効にする
+	 * @details AudioQuery編集のたびに呼び出してください。PreviewDebounceTimeの間に編集が無ければバックグラウンドで音声合成を行い、
+	 *			完了後にOnPreviewSynthesizedを呼び出します。合成結果はAudioQuery毎にキャッシュされ、保存時に再利用されます。
+	 */
+	UFUNCTION(BlueprintCallable, Category="VOICEVOX Editor", meta=(Keywords="voicevox", DisplayName = "RequestPreview"))
+	void RequestPreview(int64 SpeakerType, bool bEnableInterrogativeUpspeak = true);
+
+	/**
+	 * @brief バックグラウンドの音声合成が待機中、もしくは実行中か（Blueprint公開ノード）
+	 * @return Trueなら音声合成の待機中、もしくは実行中
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="VOICEVOX Editor", meta=(Keywords="voicevox", DisplayName = "IsSynthesisPending"))
+	bool IsSynthesisPending() const;
+
+	/**
+	 * @brief プレビュー音声の生成完了（Blueprint Eventノード）
+	 * @param [in] Sound : 編集したAudioQueryから生成したSoundWave
+	 */
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnPreviewSynthesized(USoundWave* Sound);
+
+	/**
+	 * @brief バックグラウンド音声合成の待機状態変更（Blueprint Eventノード）
+	 * @param [in] bIsPending : Trueなら音声合成の待機中、もしくは実行中
+	 * @details 進捗表示の切り替えに使用してください
+	 */
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnSynthesisPendingChanged(bool bIsPending);
 
 	/**
 	 * @brief AudioQueryアセットデータを読み込む（Blueprint公開ノード）
@@ -98,6 +178,92 @@ public:
 	 */
 	UFUNCTION(BlueprintImplementableEvent)
 	void OnLoadAudioQuery(int64 SpeakerType, const FString& Text, const FString& Yomikata);
+
+protected:
+
+	/**
+	 * @brief NativeTick
+	 */
+	virtual void NativeTick(const FGeometry& MyGeometry, float InDeltaTime) override;
+
+private:
+
+	//----------------------------------------------------------------
+	// Variable
+	//----------------------------------------------------------------
+
+	//! 音声合成結果のキャッシュ（キーはAudioQueryのJSON文字列、スピーカータイプ、疑問文調整を繋げた文字列）
+	TMap<FString, TArray<uint8>> SynthesisCacheMap;
+
+	//! 音声合成結果キャッシュの登録順キーリスト
+	TArray<FString> SynthesisCacheKeyList;
+
+	//! 音声合成結果キャッシュの最大数
+	static constexpr int32 SynthesisCacheMaxNum = 32;
+
+	//! 実行中のバックグラウンド音声合成タスク
+	UE::Tasks::TTask<TArray<uint8>> SynthesisTask;
+
+	//! 実行中のバックグラウンド音声合成の要求
+	FVoicevoxEditorSynthesisJob SynthesisJob;
+
+	//! 音声合成待ちのプレビュー要求（編集のたびに最新の内容で置き換える）
+	TOptional<FVoicevoxEditorSynthesisJob> PendingPreviewJob;
+
+	//! 音声合成待ちの保存要求（要求した時点のAudioQueryで保存するため、編集されても破棄しない）
+	TArray<FVoicevoxEditorSynthesisJob> PendingExportJobList;
+
+	//! 音声合成を開始するまでの残り待機時間（秒）
+	float PreviewDebounceRemain = 0.0f;
+
+	//! 前回通知した音声合成の待機状態
+	bool bIsNotifiedPending = false;
+
+	//----------------------------------------------------------------
+	// Function
+	//----------------------------------------------------------------
+
+	/**
+	 * @brief 編集中のAudioQueryから音声合成結果キャッシュのキーを求める
+	 * @param [in] SpeakerType : スピーカータイプ
+	 * @param [in] bEnableInterrogativeUpspeak : 疑問文の調整を有効にする
+	 * @return AudioQueryのJSON文字列、スピーカータイプ、疑問文調整を繋げた文字列
+	 */
+	FString GetEditorAudioQueryKey(int64 SpeakerType, bool bEnableInterrogativeUpspeak) const;
+
+	/**
+	 * @brief 音声合成待ちの要求をキャッシュから処理し、キャッシュに無い場合はバックグラウンド音声合成を開始する
+	 * @param [in] Job : 音声合成待ちの要求（実行中の音声合成タスクが無い時に呼び出す）
+	 */
+	void ProcessSynthesisJob(const FVoicevoxEditorSynthesisJob& Job);
+
+	/**
+	 * @brief 編集中のAudioQueryの音声合成を要求する
+	 * @param [in] SpeakerType : スピーカータイプ
+	 * @param [in] bEnableInterrogativeUpspeak : 疑問文の調整を有効にする
+	 * @param [in] Request : 音声合成完了後に実行する処理
+	 * @param [in] DebounceTime : 音声合成を開始するまでの待機時間（秒）
+	 */
+	void RequestSynthesis(int64 SpeakerType, bool bEnableInterrogativeUpspeak, EVoicevoxEditorSynthesisRequest Request, float DebounceTime);
+
+	/**
+	 * @brief 音声合成結果を元に要求された処理を実行する
+	 * @param [in] OutputWAV : 音声データ
+	 * @param [in] Request : 実行する処理
+	 */
+	void ExecuteSynthesisRequest(const TArray<uint8>& OutputWAV, EVoicevoxEditorSynthesisRequest Request);
+
+	/**
+	 * @brief 音声データからSoundWaveアセットを生成して保存する
+	 * @param [in] OutputWAV : 音声データ
+	 */
+	static void ExportSoundWaveAssets(const TArray<uint8>& OutputWAV);
+
+	/**
+	 * @brief 音声データをWavファイルに保存する
+	 * @param [in] OutputWAV : 音声データ
+	 */
+	static void ExportWavFile(const TArray<uint8>& OutputWAV);
 };
 
 DECLARE_LOG_CATEGORY_EXTERN(LogVoicevoxEditor, Log, All);
@@ -11,7 +11,9 @@
  * @author Yuuki Ogino
  */
 #include "Components/AbstractLipSyncAudioComponent.h"
+#include "AudioDevice.h"
 #include "Sound/SoundWaveProcedural.h"
+#include "Sound/VoicevoxSoundWaveProcedural.h"
 #include "Subsystems/VoicevoxCoreSubsystem.h"
 
 DEFINE_LOG_CATEGORY(LogVoicevoxLipSync);
@@ -47,6 +49,13 @@ void UAbstractLipSyncAudioComponent::BeginPlay()
 {
 	Super::BeginPlay();
 	OnAudioPlaybackPercentNative.AddUObject(this, &UAbstractLipSyncAudioComponent::HandlePlaybackPercent);
+	OnAudioFinishedNative.AddUObject(this, &UAbstractLipSyncAudioComponent::HandleAudioFinished);
+
+	// オーディオレンダースレッドが読み出した音声は、出力バッファ分遅れて再生される
+	if (const FAudioDevice* AudioDevice = GetAudioDevice(); AudioDevice != nullptr && AudioDevice->GetSampleRate() > 0.0f)
+	{
+		OutputLatency = static_cast<float>(AudioDevice->GetBufferLength() * AudioDevice->GetNumBuffers()) / AudioDevice->GetSampleRate();
+	}
 }
 
 /**
@@ -54,33 +63,26 @@ void UAbstractLipSyncAudioComponent::BeginPlay()
  */
 void UAbstractLipSyncAudioComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	CancelLongTextStreaming();
 	if (bIsExecTts)
 	{
 		bIsExecTts = false;
+		++TtsRequestSerial;
 		TtsTask.Wait();
-		Sound = nullptr;
 	}
+	ReleasePooledSoundWave();
 	Super::EndPlay(EndPlayReason);
 }
 
 /**
- * @brief TickComponent
+ * @brief OnAudioFinishedのコールバック
  */
-void UAbstractLipSyncAudioComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+void UAbstractLipSyncAudioComponent::HandleAudioFinished(UAudioComponent* InComponent)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-
-	if (bIsExecTts)
+	// 停止の通知は遅れて届くため、既に次の音声を再生している場合や長文パイプライン再生の最初の文を待っている場合は返さない
+	if (!IsPlaying() && !(bIsLongTextStreaming && !bIsLongTextPlaying))
 	{
-		if (TtsTask.IsValid() && TtsTask.IsCompleted())
-		{
-			if (Sound != nullptr)
-			{
-				Play(0.0f);
-			}
-			
-			bIsExecTts = false;
-		}
+		ReleasePooledSoundWave();
 	}
 }
 
@@ -89,9 +91,33 @@ void UAbstractLipSyncAudioComponent::TickComponent(float DeltaTime, ELevelTick T
  */
 void UAbstractLipSyncAudioComponent::HandlePlaybackPercent(const UAudioComponent* InComponent, const USoundWave* InSoundWave, const float InPlaybackPercentage)
 {
+	const float PlaybackTime = Sound != nullptr ? GetLipSyncPlaybackTime(Sound->Duration * InPlaybackPercentage) : 0.0f;
+	
+	// 長文パイプライン再生は無限長のSoundWaveにPCMを追記していくため、キューに積んだ音声を全て再生したかで終了を判定する
+	// 出力遅延を引いた再生時間はキューに積んだ時間に届かないため、読み出し位置で判定し、出力遅延分待ってから止める
+	bool bIsLongTextFinished = false;
+	if (bIsLongTextStreaming && Sound != nullptr)
+	{
+		// 文毎の再生時間の合計と読み出し位置の丸め誤差を許容する
+		constexpr double RenderedTimeTolerance = 0.001;
+		const UVoicevoxSoundWaveProcedural* SoundWave = Cast<UVoicevoxSoundWaveProcedural>(Sound);
+		const bool bIsRendered = !bIsExecTts && SoundWave != nullptr && SoundWave->GetRenderedTime() + RenderedTimeTolerance >= LongTextQueuedDuration;
+		if (!bIsRendered)
+		{
+			LongTextRenderedEndTime = 0.0;
+		}
+		else if (LongTextRenderedEndTime <= 0.0)
+		{
+			LongTextRenderedEndTime = FPlatformTime::Seconds();
+		}
+		bIsLongTextFinished = bIsRendered && FPlatformTime::Seconds() - LongTextRenderedEndTime >= GetAudioLatency();
+	}
+	
 	// ループ無しかつ最後まで再生しても止まらない場合があるので、明確にストップする
-	if (Sound != nullptr && !Sound->IsLooping() && InPlaybackPercentage >= 1.0f)
+	if (Sound != nullptr && ((!Sound->IsLooping() && InPlaybackPercentage >= 1.0f) || bIsLongTextFinished))
 	{
+		bIsLongTextStreaming = false;
+		bIsLongTextPlaying = false;
 		Stop();
 		InitMorphNumMap();
 		if (bIsPlayLipSyncSimple)
@@ -137,13 +163,21 @@ void UAbstractLipSyncAudioComponent::HandlePlaybackPercent(const UAudioComponent
 			NotificationMorphNum(Map);
 		}
 		
-		if (Sound != nullptr && LipSyncTime < Sound->Duration * InPlaybackPercentage)
+		if (Sound != nullptr && !LipSyncList.IsEmpty() && LipSyncTime < PlaybackTime)
 		{
 			NowLipSync = LipSyncList.Pop();
 			LipSyncTime += NowLipSync.Length;
 		}
 		return;
 	}
+	if (LipSyncCurveTable != nullptr)
+	{
+		if (Sound != nullptr)
+		{
+			UpdateLipSyncCurve(PlaybackTime);
+		}
+		return;
+	}
 	if (LipSyncList.IsEmpty()) return;
 	if (Sound == nullptr)
 	{
@@ -169,7 +203,7 @@ void UAbstractLipSyncAudioComponent::HandlePlaybackPercent(const UAudioComponent
 		return;
 	}
 	
-	const float NowDuration = Sound->Duration * InPlaybackPercentage;
+	const float NowDuration = PlaybackTime;
 	if (LipSyncTime < NowDuration)
 	{
 		// 前回のリップシンク情報を元に初期化
@@ -264,6 +298,58 @@ void UAbstractLipSyncAudioComponent::HandlePlaybackPercent(const UAudioComponent
 	}
 }
 
+/**
+ * @brief リップシンクに使用する再生時間を取得する
+ */
+float UAbstractLipSyncAudioComponent::GetLipSyncPlaybackTime(const float PlaybackTime) const
+{
+	if (const UVoicevoxSoundWaveProcedural* SoundWave = Cast<UVoicevoxSoundWaveProcedural>(Sound))
+	{
+		return FMath::Max(static_cast<float>(SoundWave->GetRenderedTime()) - GetAudioLatency(), 0.0f);
+	}
+	return PlaybackTime;
+}
+
+/**
+ * @brief オーディオレンダースレッドが読み出してから実際に再生されるまでの遅延を取得する
+ */
+float UAbstractLipSyncAudioComponent::GetAudioLatency() const
+{
+	return AudioLatencyCompensation >= 0.0f ? AudioLatencyCompensation : OutputLatency;
+}
+
+/**
+ * @brief ベイク済みのリップシンクカーブを評価してモーフターゲット値を通知する
+ */
+void UAbstractLipSyncAudioComponent::UpdateLipSyncCurve(const float PlaybackTime)
+{
+	const UEnum* VowelEnum = StaticEnum<ELipSyncVowelType>();
+	TMap<ELipSyncVowelType, float> Map;
+	const auto AddMorphNum = [this, &Map, VowelEnum, PlaybackTime](const ELipSyncVowelType VowelType)
+	{
+		const FRealCurve* Curve = LipSyncCurveTable->FindCurveUnchecked(FName(VowelEnum->GetNameStringByValue(static_cast<int64>(VowelType))));
+		const float Value = Curve != nullptr ? Curve->Eval(PlaybackTime) * MaxMouthScale : 0.0f;
+		LipSyncMorphNumMap[VowelType] = Value;
+		Map.Add(VowelType, Value);
+	};
+	
+	if (bIsPlayLipSyncSimple)
+	{
+		Map.Reserve(1);
+		AddMorphNum(ELipSyncVowelType::Simple);
+	}
+	else
+	{
+		Map.Reserve(5);
+		AddMorphNum(ELipSyncVowelType::A);
+		AddMorphNum(ELipSyncVowelType::I);
+		AddMorphNum(ELipSyncVowelType::U);
+		AddMorphNum(ELipSyncVowelType::E);
+		AddMorphNum(ELipSyncVowelType::O);
+	}
+	NotificationMorphNum(Map);
+}
+
 /**
  * @brief モーフターゲット値を初期化
  */
@@ -426,9 +512,11 @@ TMap<ELipSyncVowelType, float> UAbstractLipSyncAudioComponent::UpdatePauseMorphN
  */
 void UAbstractLipSyncAudioComponent::StopAudioAndLipSync()
 {
+	CancelLongTextStreaming();
 	if (bIsExecTts)
 	{
 		bIsExecTts = false;
+		++TtsRequestSerial;
 		TtsTask.Wait();
 	}
 	Super::Stop();
@@ -442,11 +530,7 @@ void UAbstractLipSyncAudioComponent::PlayToText(const FString Message, const boo
 {
 	if (CheckExecTts()) return;
 	
-	if (Sound != nullptr)
-	{
-		Stop();
-		SetSound(nullptr);
-	}
+	ReleasePooledSoundWave();
 
 	InitMorphNumMap();
 	AudioQuery = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->GetAudioQuery(SpeakerId, Message, bRunKana);
@@ -458,29 +542,237 @@ void UAbstractLipSyncAudioComponent::PlayToText(const FString Message, const boo
 	AudioQuery.Post_phoneme_length = PostPhonemeLength;
 	NowLipSync = {ELipSyncVowelType::Non, -1.0f, false, false};
 	bIsPlayLipSyncSimple = bEnabledSimpleLipSync;
+	LipSyncCurveTable = nullptr;
 	ToSoundWave(SpeakerId, bEnableInterrogativeUpspeak);
 }
 
 /**
- * @brief VOICEVOX COREで取得したAudioQueryを元にSoundWaveを生成後、音再生とリップシンク再生を行います。
+ * @brief 長文テキストを文単位に分割し、解析・音声合成・再生をパイプラインで実行しながら音再生とリップシンク再生を行います。
  */
-void UAbstractLipSyncAudioComponent::PlayToAudioQuery(const FVoicevoxAudioQuery& Query, const bool bEnableInterrogativeUpspeak)
+void UAbstractLipSyncAudioComponent::PlayToLongText(const FString Message, const bool bRunKana, const bool bEnableInterrogativeUpspeak,
+	const float SpeedScale, const float PitchScale, const float IntonationScale, const float VolumeScale, const float PrePhonemeLength, const float PostPhonemeLength)
 {
 	if (CheckExecTts()) return;
+
+	const TArray<FString> Sentences = UVoicevoxCoreSubsystem::SplitLongText(Message);
+	if (Sentences.IsEmpty()) return;
 	
-	if (Sound != nullptr)
+	ReleasePooledSoundWave();
+	CancelLongTextStreaming();
+
+	InitMorphNumMap();
+	NowLipSync = {ELipSyncVowelType::Non, -1.0f, false, false};
+	bIsPlayLipSyncSimple = bEnabledSimpleLipSync;
+	LipSyncCurveTable = nullptr;
+	LipSyncList.Empty();
+	LipSyncTime = 0.0f;
+	LongTextQueuedDuration = 0.0f;
+	LongTextRenderedEndTime = 0.0;
+	bIsLongTextCancelled = false;
+	bIsLongTextPlaying = false;
+	bIsLongTextStreaming = true;
+	bIsExecTts = true;
+	const uint32 Serial = ++TtsRequestSerial;
+
+	// 合成済みの文を順に追記していくため、再生時間は無限長として扱う
+	PooledSoundWave = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->AcquireSoundWave();
+	PooledSoundWave->Duration = INDEFINITELY_LOOPING_DURATION;
+	PooledSoundWave->SoundGroup = SOUNDGROUP_Default;
+	SetSound(PooledSoundWave);
+
+	const int64 SpeakerType = SpeakerId;
+	const bool bIsSimple = bIsPlayLipSyncSimple;
+	UE::Tasks::TTask<FVoicevoxAudioQuery> PrevQueryTask;
+	UE::Tasks::FTask PrevSynthesisTask;
+	for (int32 Index = 0; Index < Sentences.Num(); ++Index)
 	{
-		Stop();
-		SetSound(nullptr);
+		// テキスト解析は文の順に直列で実行し、前の文の音声合成と並行させる
+		TArray<UE::Tasks::FTask> QueryPrerequisites;
+		if (PrevQueryTask.IsValid())
+		{
+			QueryPrerequisites.Add(PrevQueryTask);
+		}
+		
+		const FString Sentence = Sentences[Index];
+		const float SentencePrePhonemeLength = Index == 0 ? PrePhonemeLength : 0.0f;
+		UE::Tasks::TTask<FVoicevoxAudioQuery> QueryTask = UE::Tasks::Launch(TEXT("LipSyncComponentLongTextQueryTask"), [=, this]
+		{
+			FVoicevoxAudioQuery Query;
+			if (bIsLongTextCancelled) return Query;
+			
+			Query = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->GetAudioQuery(SpeakerType, Sentence, bRunKana);
+			Query.Speed_scale = SpeedScale;
+			Query.Pitch_scale = PitchScale;
+			Query.Intonation_scale = IntonationScale;
+			Query.Volume_scale = VolumeScale;
+			Query.Pre_phoneme_length = SentencePrePhonemeLength;
+			Query.Post_phoneme_length = PostPhonemeLength;
+			return Query;
+		}, UE::Tasks::Prerequisites(QueryPrerequisites));
+
+		// 音声合成は自身のテキスト解析と前の文の音声合成の完了後に実行し、合成結果を文の順にキューへ積む
+		TArray<UE::Tasks::FTask> SynthesisPrerequisites;
+		SynthesisPrerequisites.Add(QueryTask);
+		if (PrevSynthesisTask.IsValid())
+		{
+			SynthesisPrerequisites.Add(PrevSynthesisTask);
+		}
+		
+		PrevSynthesisTask = UE::Tasks::Launch(TEXT("LipSyncComponentLongTextSynthesisTask"), [=, this]() mutable
+		{
+			if (bIsLongTextCancelled) return;
+
+			const FVoicevoxAudioQuery& Query = QueryTask.GetResult();
+			if (Query.Accent_phrases.IsEmpty()) return;
+			
+			// 負荷が高く無音を短くして音声合成した場合に備え、リップシンクは実際に音声合成したAudioQueryから生成する
+			const UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+			FVoicevoxAudioQuery SynthesisQuery;
+			TArray<uint8> OutputWAV = Subsystem->RunSynthesis(Query, SpeakerType, bEnableInterrogativeUpspeak, EVoicevoxSynthesisPriority::Normal, &SynthesisQuery);
+			if (OutputWAV.IsEmpty() || bIsLongTextCancelled) return;
+			Subsystem->ConvertToPlaybackSampleRate(OutputWAV);
+
+			FVoicevoxLongTextChunk Chunk;
+			if (!ReadChunkFromWAV(OutputWAV, Chunk)) return;
+			Chunk.LipSyncList = UVoicevoxCoreSubsystem::GetLipSyncList(SynthesisQuery, bIsSimple);
+
+			// 文をまたいでリップシンクがずれないよう、音声長との差分を無音として補う
+			float LipSyncDuration = 0.0f;
+			for (const FVoicevoxLipSync& LipSync : Chunk.LipSyncList)
+			{
+				LipSyncDuration += LipSync.Length;
+			}
+			if (const float Diff = Chunk.Duration - LipSyncDuration; Diff > 0.0f)
+			{
+				Chunk.LipSyncList.Add({ELipSyncVowelType::Non, Diff, false, false});
+			}
+			
+			EnqueueTtsCompletion(Serial, [this, Chunk = MoveTemp(Chunk)]() mutable
+			{
+				AppendLongTextChunk(Chunk);
+			});
+		}, UE::Tasks::Prerequisites(SynthesisPrerequisites));
+
+		PrevQueryTask = QueryTask;
 	}
 
+	// 全ての文の完了処理の後に終了処理を積む（完了処理は積んだ順に実行される）
+	TtsTask = UE::Tasks::Launch(TEXT("LipSyncComponentLongTextCompletionTask"), [this, Serial]
+	{
+		EnqueueTtsCompletion(Serial, [this]
+		{
+			bIsExecTts = false;
+			if (!bIsLongTextPlaying)
+			{
+				// 全ての文で音声合成に失敗した
+				bIsLongTextStreaming = false;
+				ReleasePooledSoundWave();
+			}
+		});
+	}, UE::Tasks::Prerequisites(PrevSynthesisTask));
+}
+
+/**
+ * @brief VOICEVOX COREで取得したAudioQueryを元にSoundWaveを生成後、音再生とリップシンク再生を行います。
+ */
+void UAbstractLipSyncAudioComponent::PlayToAudioQuery(const FVoicevoxAudioQuery& Query, const bool bEnableInterrogativeUpspeak)
+{
+	if (CheckExecTts()) return;
+	
+	ReleasePooledSoundWave();
+
 	InitMorphNumMap();
 	AudioQuery = Query;
 	NowLipSync = {ELipSyncVowelType::Non, -1.0f, false, false};
 	bIsPlayLipSyncSimple = bEnabledSimpleLipSync;
+	LipSyncCurveTable = nullptr;
 	ToSoundWave(SpeakerId, bEnableInterrogativeUpspeak);
 }
 
+/**
+ * @brief テキストをAudioQuery無しで音声合成し、音声データの振幅包絡から生成したリップシンクで音再生とリップシンク再生を行います。
+ */
+void UAbstractLipSyncAudioComponent::PlayToTextToSpeech(const FString Message, const bool bRunKana, const bool bEnableInterrogativeUpspeak)
+{
+	if (CheckExecTts()) return;
+	
+	ReleasePooledSoundWave();
+
+	InitMorphNumMap();
+	NowLipSync = {ELipSyncVowelType::Non, -1.0f, false, false};
+	bIsPlayLipSyncSimple = bEnabledSimpleLipSync;
+	LipSyncCurveTable = nullptr;
+	const int64 SpeakerType = SpeakerId;
+	ToSoundWaveFromWAV([SpeakerType, Message, bRunKana, bEnableInterrogativeUpspeak]
+	{
+		return GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->RunTextToSpeech(SpeakerType, Message, bRunKana, bEnableInterrogativeUpspeak);
+	});
+}
+
+/**
+ * @brief 定型文の差し込み部分だけ音声合成してSoundWaveを生成後、音再生とリップシンク再生を行います。
+ */
+void UAbstractLipSyncAudioComponent::PlayToLineTemplate(const FString Template, const TMap<FString, FString>& SlotValues, const bool bEnableInterrogativeUpspeak)
+{
+	if (CheckExecTts()) return;
+	
+	ReleasePooledSoundWave();
+
+	InitMorphNumMap();
+	NowLipSync = {ELipSyncVowelType::Non, -1.0f, false, false};
+	bIsPlayLipSyncSimple = bEnabledSimpleLipSync;
+	LipSyncCurveTable = nullptr;
+	CancelLongTextStreaming();
+	bIsExecTts = true;
+	const uint32 Serial = ++TtsRequestSerial;
+	const int64 SpeakerType = SpeakerId;
+	const bool bIsSimple = bIsPlayLipSyncSimple;
+	TtsTask = UE::Tasks::Launch<>(TEXT("LipSyncComponentLineTemplateTask"), [=, this]
+	{
+		UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+		FVoicevoxAudioQuery Query;
+		FVoicevoxLongTextChunk Chunk;
+		bool bIsSucceeded = false;
+		if (TArray<uint8> OutputWAV = Subsystem->RunSynthesisWithTemplate(Template, SlotValues, SpeakerType, bEnableInterrogativeUpspeak, Query); !OutputWAV.IsEmpty())
+		{
+			// 各部分のAudioQueryを繋いだAudioQueryからLipSyncに必要なデータを生成する
+			Chunk.LipSyncList = UVoicevoxCoreSubsystem::GetLipSyncList(Query, bIsSimple);
+			Algo::Reverse(Chunk.LipSyncList);
+
+			Subsystem->ConvertToPlaybackSampleRate(OutputWAV);
+			bIsSucceeded = ReadChunkFromWAV(OutputWAV, Chunk);
+		}
+
+		EnqueueTtsCompletion(Serial, [this, bIsSucceeded, Chunk = MoveTemp(Chunk)]() mutable
+		{
+			bIsExecTts = false;
+			if (bIsSucceeded)
+			{
+				PlaySoundWaveFromChunk(Chunk);
+			}
+		});
+	});
+}
+
+/**
+ * @brief 生成済みの音声データからSoundWaveを生成後、音声データの振幅包絡から生成したリップシンクで音再生とリップシンク再生を行います。
+ */
+void UAbstractLipSyncAudioComponent::PlayToWAV(const TArray<uint8>& OutputWAV)
+{
+	if (CheckExecTts()) return;
+	
+	ReleasePooledSoundWave();
+
+	InitMorphNumMap();
+	NowLipSync = {ELipSyncVowelType::Non, -1.0f, false, false};
+	bIsPlayLipSyncSimple = bEnabledSimpleLipSync;
+	LipSyncCurveTable = nullptr;
+	ToSoundWaveFromWAV([OutputWAV]
+	{
+		return OutputWAV;
+	});
+}
+
 /**
  * @brief AudioQueryアセットからSoundWaveを生成後、音再生とリップシンク再生を行います。
  */
@@ -488,16 +780,13 @@ void UAbstractLipSyncAudioComponent::PlayToAudioQueryAsset(UVoicevoxQuery* Voice
 {
 	if (CheckExecTts()) return;
 	
-	if (Sound != nullptr)
-	{
-		Stop();
-		SetSound(nullptr);
-	}
+	ReleasePooledSoundWave();
 
 	InitMorphNumMap();
 	AudioQuery = VoicevoxQuery->VoicevoxAudioQuery;
 	NowLipSync = {ELipSyncVowelType::Non, -1.0f, false, false};
 	bIsPlayLipSyncSimple = bEnabledSimpleLipSync;
+	LipSyncCurveTable = VoicevoxQuery->GetValidLipSyncCurveTable();
 	ToSoundWave(VoicevoxQuery->SpeakerType, bEnableInterrogativeUpspeak);
 }
 
@@ -510,6 +799,7 @@ void UAbstractLipSyncAudioComponent::SetLipSyncDataToAudioQuery(const FVoicevoxA
 	
 	AudioQuery = Query;
 	NowLipSync = {ELipSyncVowelType::Non, -1.0f, false, false};
+	LipSyncCurveTable = nullptr;
 	// LipSyncに必要なデータを生成する
 	bIsPlayLipSyncSimple = bEnabledSimpleLipSync;
 	LipSyncList = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->GetLipSyncList(AudioQuery, bIsPlayLipSyncSimple);
@@ -526,13 +816,119 @@ void UAbstractLipSyncAudioComponent::SetLipSyncDataToAudioQueryAsset(UVoicevoxQu
 	
 	AudioQuery = VoicevoxQuery->VoicevoxAudioQuery;
 	NowLipSync = {ELipSyncVowelType::Non, -1.0f, false, false};
-	// LipSyncに必要なデータを生成する
 	bIsPlayLipSyncSimple = bEnabledSimpleLipSync;
+	LipSyncTime = 0.0f;
+	// ベイク済みのカーブがある場合はリップシンクのデータリストを生成しない（ベイク後にAudioQueryを編集した場合は生成する）
+	LipSyncCurveTable = VoicevoxQuery->GetValidLipSyncCurveTable();
+	if (LipSyncCurveTable != nullptr)
+	{
+		LipSyncList.Empty();
+		return;
+	}
+	
+	// LipSyncに必要なデータを生成する
 	LipSyncList = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->GetLipSyncList(AudioQuery, bIsPlayLipSyncSimple);
 	Algo::Reverse(LipSyncList);
 	LipSyncTime = 0.0f;
 }
 
+/**
+ * @brief 音声データをセットして、振幅包絡からリップシンクデータを事前生成します
+ */
+void UAbstractLipSyncAudioComponent::SetLipSyncDataToWAV(const TArray<uint8>& OutputWAV)
+{
+	if (GetPlayState() != EAudioComponentPlayState::Stopped) return;
+	
+	NowLipSync = {ELipSyncVowelType::Non, -1.0f, false, false};
+	LipSyncCurveTable = nullptr;
+	// LipSyncに必要なデータを生成する
+	bIsPlayLipSyncSimple = bEnabledSimpleLipSync;
+	LipSyncList = UVoicevoxCoreSubsystem::GetLipSyncListFromWAV(OutputWAV, bIsPlayLipSyncSimple);
+	Algo::Reverse(LipSyncList);
+	LipSyncTime = 0.0f;
+}
+
+/**
+ * @brief 長文パイプライン再生で合成済みの文をSoundWaveとリップシンクリストへ追加する
+ */
+void UAbstractLipSyncAudioComponent::AppendLongTextChunk(FVoicevoxLongTextChunk& Chunk)
+{
+	USoundWaveProcedural* SoundWave = Cast<USoundWaveProcedural>(Sound);
+	if (SoundWave == nullptr) return;
+
+	// 音声合成が再生に追いつかずにミキサーが補った無音は読み出し位置に含まれないため、リップシンクリストに隙間を足す必要は無い
+	if (!bIsLongTextPlaying)
+	{
+		SoundWave->SetSampleRate(Chunk.SampleRate);
+		SoundWave->NumChannels = Chunk.NumChannels;
+	}
+
+	{
+		LLM_SCOPE_BYTAG(Voicevox_SoundWave);
+		SoundWave->QueueAudio(Chunk.PCMData.GetData(), Chunk.PCMData.Num());
+	}
+	
+	// LipSyncListは末尾から取り出すため、後続の文は先頭側へ逆順で追加する
+	Algo::Reverse(Chunk.LipSyncList);
+	LipSyncList.Insert(Chunk.LipSyncList, 0);
+	LongTextQueuedDuration += Chunk.Duration;
+
+	if (!bIsLongTextPlaying)
+	{
+		bIsLongTextPlaying = true;
+		Play(0.0f);
+
+		if (OnCreateSoundWave.IsBound())
+		{
+			OnCreateSoundWave.Broadcast();
+		}
+
+		if (OnCreateSoundWaveNative.IsBound())
+		{
+			OnCreateSoundWaveNative.Broadcast();
+		}
+	}
+}
+
+/**
+ * @brief 再生を止めてSoundWaveを外し、コアのプールから取得したSoundWaveであればプールへ返す
+ */
+void UAbstractLipSyncAudioComponent::ReleasePooledSoundWave()
+{
+	if (Sound != nullptr)
+	{
+		Stop();
+		SetSound(nullptr);
+	}
+
+	if (PooledSoundWave != nullptr)
+	{
+		if (GEngine != nullptr)
+		{
+			GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->ReleaseSoundWave(PooledSoundWave);
+		}
+		PooledSoundWave = nullptr;
+	}
+}
+
+/**
+ * @brief 長文パイプライン再生の実行中タスクをキャンセルして完了まで待機する
+ */
+void UAbstractLipSyncAudioComponent::CancelLongTextStreaming()
+{
+	if (!bIsLongTextStreaming) return;
+
+	bIsLongTextCancelled = true;
+	++TtsRequestSerial;
+	if (TtsTask.IsValid())
+	{
+		TtsTask.Wait();
+	}
+	bIsLongTextStreaming = false;
+	bIsLongTextPlaying = false;
+	bIsExecTts = false;
+}
+
 /**
  * テキストから音声変換を実行中かチェック
  */
@@ -556,48 +952,143 @@ bool UAbstractLipSyncAudioComponent::CheckExecTts() const
  */
 void UAbstractLipSyncAudioComponent::ToSoundWave(const int64 SpeakerType, const bool bEnableInterrogativeUpspeak)
 {
-	TtsTask = UE::Tasks::Launch<>(TEXT("LipSyncComponentTextToSpeechTask"), [=, this]
+	CancelLongTextStreaming();
+	bIsExecTts = true;
+	const uint32 Serial = ++TtsRequestSerial;
+	const bool bHasLipSyncCurve = LipSyncCurveTable != nullptr;
+	const bool bIsSimple = bIsPlayLipSyncSimple;
+	TtsTask = UE::Tasks::Launch<>(TEXT("LipSyncComponentTextToSpeechTask"), [=, this, Query = AudioQuery]
 	{
-		bIsExecTts = true;
+		// 音声合成と解析はタスク内で行い、USoundWaveの生成と再生はゲームスレッドの完了処理で行う
+		const UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+		FVoicevoxAudioQuery SynthesisQuery;
+		TArray<uint8> OutputWAV = Subsystem->RunSynthesis(Query, SpeakerType, bEnableInterrogativeUpspeak, EVoicevoxSynthesisPriority::Normal, &SynthesisQuery);
+		FVoicevoxLongTextChunk Chunk;
+		bool bIsSucceeded = false;
+		if (!OutputWAV.IsEmpty())
+		{
+			Subsystem->ConvertToPlaybackSampleRate(OutputWAV);
+			bIsSucceeded = ReadChunkFromWAV(OutputWAV, Chunk);
+		}
 
-		// LipSyncに必要なデータを生成する
-		LipSyncList = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->GetLipSyncList(AudioQuery, bIsPlayLipSyncSimple);
-		Algo::Reverse(LipSyncList);
-		LipSyncTime = 0.0f;
-		// USoundWaveを生成する。Launch内でPlayを実行するとクラッシュするため、Play処理はTickComponentで行う
-		if (const TArray<uint8> OutputWAV = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->RunSynthesis(AudioQuery, SpeakerType, bEnableInterrogativeUpspeak);
-		!OutputWAV.IsEmpty())
+		// LipSyncに必要なデータを実際に音声合成したAudioQueryから生成する
+		// ベイク済みのカーブは元のAudioQueryの長さでベイクしているため、負荷が高く無音を短くして音声合成した場合は使わない
+		const bool bUseLipSyncCurve = bHasLipSyncCurve
+			&& FMath::IsNearlyEqual(FVoicevoxQualityGovernor::GetAudioQueryDuration(SynthesisQuery), FVoicevoxQualityGovernor::GetAudioQueryDuration(Query));
+		if (bIsSucceeded && !bUseLipSyncCurve)
 		{
-			FString ErrorMessage = "";
-			if (FWaveModInfo WaveInfo; WaveInfo.ReadWaveInfo(OutputWAV.GetData(), OutputWAV.Num(), &ErrorMessage))
-			{
-				USoundWaveProcedural* SoundWave = NewObject<USoundWaveProcedural>(USoundWaveProcedural::StaticClass());
-				const int32 ChannelCount = *WaveInfo.pChannels;
-				const int32 SizeOfSample = *WaveInfo.pBitsPerSample / 8;
-				const int32 NumSamples = WaveInfo.SampleDataSize / SizeOfSample;
-				const int32 NumFrames = NumSamples / ChannelCount;
-					
-				SoundWave->RawPCMDataSize = WaveInfo.SampleDataSize;
-				SoundWave->QueueAudio(WaveInfo.SampleDataStart, WaveInfo.SampleDataSize);
-					
-				SoundWave->Duration = static_cast<float>(NumFrames) / *WaveInfo.pSamplesPerSec;
-				SoundWave->SetSampleRate(*WaveInfo.pSamplesPerSec);
-				SoundWave->NumChannels = ChannelCount;
-				SoundWave->TotalSamples = *WaveInfo.pSamplesPerSec * SoundWave->Duration;
-				SoundWave->SoundGroup = SOUNDGROUP_Default;
-
-				SetSound(SoundWave);
-
-				if (OnCreateSoundWave.IsBound())
-				{
-					OnCreateSoundWave.Broadcast();
-				}
+			Chunk.LipSyncList = UVoicevoxCoreSubsystem::GetLipSyncList(SynthesisQuery, bIsSimple);
+			Algo::Reverse(Chunk.LipSyncList);
+		}
 
-				if (OnCreateSoundWaveNative.IsBound())
+		EnqueueTtsCompletion(Serial, [this, bIsSucceeded, bUseLipSyncCurve, Chunk = MoveTemp(Chunk)]() mutable
+		{
+			bIsExecTts = false;
+			if (bIsSucceeded)
+			{
+				if (!bUseLipSyncCurve)
 				{
-					OnCreateSoundWaveNative.Broadcast();
+					LipSyncCurveTable = nullptr;
 				}
+				PlaySoundWaveFromChunk(Chunk);
 			}
+		});
+	});
+}
+
+/**
+ * @brief 音声データを生成してSoundWaveへ変換し、音声データの振幅包絡からリップシンクデータを生成する
+ */
+void UAbstractLipSyncAudioComponent::ToSoundWaveFromWAV(TUniqueFunction<TArray<uint8>()> SynthesisFunction)
+{
+	CancelLongTextStreaming();
+	bIsExecTts = true;
+	const uint32 Serial = ++TtsRequestSerial;
+	const bool bIsSimple = bIsPlayLipSyncSimple;
+	TtsTask = UE::Tasks::Launch<>(TEXT("LipSyncComponentWavToSpeechTask"), [this, Serial, bIsSimple, SynthesisFunction = MoveTemp(SynthesisFunction)]
+	{
+		FVoicevoxLongTextChunk Chunk;
+		bool bIsSucceeded = false;
+		if (TArray<uint8> OutputWAV = SynthesisFunction(); !OutputWAV.IsEmpty())
+		{
+			// AudioQueryが無いため、音声データの振幅包絡からLipSyncに必要なデータを生成する
+			Chunk.LipSyncList = UVoicevoxCoreSubsystem::GetLipSyncListFromWAV(OutputWAV, bIsSimple);
+			Algo::Reverse(Chunk.LipSyncList);
+
+			GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->ConvertToPlaybackSampleRate(OutputWAV);
+			bIsSucceeded = ReadChunkFromWAV(OutputWAV, Chunk);
 		}
+
+		EnqueueTtsCompletion(Serial, [this, bIsSucceeded, Chunk = MoveTemp(Chunk)]() mutable
+		{
+			bIsExecTts = false;
+			if (bIsSucceeded)
+			{
+				PlaySoundWaveFromChunk(Chunk);
+			}
+		});
 	});
+}
+
+/**
+ * @brief 音生成タスクの完了処理をゲームスレッドで実行するキューへ積む
+ */
+void UAbstractLipSyncAudioComponent::EnqueueTtsCompletion(const uint32 Serial, TUniqueFunction<void()>&& Completion)
+{
+	// 実行時にコンポーネントが破棄されている場合や、キャンセル後に新しい音生成を開始している場合は実行しない
+	GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->EnqueueGameThreadCompletion(
+		[WeakThis = TWeakObjectPtr<UAbstractLipSyncAudioComponent>(this), Serial, Completion = MoveTemp(Completion)]
+		{
+			if (const UAbstractLipSyncAudioComponent* This = WeakThis.Get(); This != nullptr && This->TtsRequestSerial == Serial)
+			{
+				Completion();
+			}
+		});
+}
+
+/**
+ * @brief WAVデータを解析してPCMデータを取り出す
+ */
+bool UAbstractLipSyncAudioComponent::ReadChunkFromWAV(const TArray<uint8>& OutputWAV, FVoicevoxLongTextChunk& OutChunk)
+{
+	FString ErrorMessage = "";
+	FWaveModInfo WaveInfo;
+	if (!WaveInfo.ReadWaveInfo(OutputWAV.GetData(), OutputWAV.Num(), &ErrorMessage))
+	{
+		UE_LOG(LogVoicevoxLipSync, Error, TEXT("%s"), *ErrorMessage);
+		return false;
+	}
+
+	OutChunk.NumChannels = *WaveInfo.pChannels;
+	OutChunk.SampleRate = *WaveInfo.pSamplesPerSec;
+	const int32 SizeOfSample = *WaveInfo.pBitsPerSample / 8;
+	const int32 NumFrames = WaveInfo.SampleDataSize / SizeOfSample / OutChunk.NumChannels;
+	OutChunk.Duration = static_cast<float>(NumFrames) / OutChunk.SampleRate;
+	OutChunk.PCMData.Append(WaveInfo.SampleDataStart, WaveInfo.SampleDataSize);
+	return true;
+}
+
+/**
+ * @brief 解析済みの音声データからSoundWaveを生成してセットし、再生する
+ */
+void UAbstractLipSyncAudioComponent::PlaySoundWaveFromChunk(FVoicevoxLongTextChunk& Chunk)
+{
+	LipSyncList = MoveTemp(Chunk.LipSyncList);
+	LipSyncTime = 0.0f;
+
+	PooledSoundWave = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>()->AcquireSoundWave();
+	PooledSoundWave->QueuePCMData(Chunk.PCMData.GetData(), Chunk.PCMData.Num(), Chunk.SampleRate, Chunk.NumChannels);
+	SetSound(PooledSoundWave);
+
+	if (OnCreateSoundWave.IsBound())
+	{
+		OnCreateSoundWave.Broadcast();
+	}
+
+	if (OnCreateSoundWaveNative.IsBound())
+	{
+		OnCreateSoundWaveNative.Broadcast();
+	}
+
+	Play(0.0f);
 }
\ No newline at end of file
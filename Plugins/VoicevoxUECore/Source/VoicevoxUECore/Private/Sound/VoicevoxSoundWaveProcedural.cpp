@@ -0,0 +1,89 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  オーディオレンダースレッドで再生位置を公開するUSoundWaveProceduralのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "Sound/VoicevoxSoundWaveProcedural.h"
+#include "VoicevoxMemoryTracker.h"
+
+/**
+ * @brief GeneratePCMData override
+ */
+int32 UVoicevoxSoundWaveProcedural::GeneratePCMData(uint8* PCMData, const int32 SamplesNeeded)
+{
+	// 戻り値はキューから実際に読み出したバイト数で、アンダーフロー時にミキサーが補う無音は含まれない
+	LastGeneratedTime.store(FPlatformTime::Seconds(), std::memory_order_relaxed);
+	const int32 GeneratedByteNum = Super::GeneratePCMData(PCMData, SamplesNeeded);
+	if (const int32 FrameSize = NumChannels * static_cast<int32>(sizeof(int16)); FrameSize > 0 && GeneratedByteNum > 0)
+	{
+		RenderedFrameNum.fetch_add(GeneratedByteNum / FrameSize, std::memory_order_relaxed);
+	}
+	return GeneratedByteNum;
+}
+
+/**
+ * @brief オーディオレンダースレッドが読み出した音声の時間を取得する
+ */
+double UVoicevoxSoundWaveProcedural::GetRenderedTime() const
+{
+	const float Rate = GetSampleRateForCurrentPlatform();
+	return Rate > 0.0f ? static_cast<double>(RenderedFrameNum.load(std::memory_order_relaxed)) / Rate : 0.0;
+}
+
+/**
+ * @brief 読み出し位置をリセットする
+ */
+void UVoicevoxSoundWaveProcedural::ResetRenderedTime()
+{
+	RenderedFrameNum.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief PCMデータをキューへ積み、再生時間、サンプリングレート、チャンネル数を設定する
+ */
+void UVoicevoxSoundWaveProcedural::QueuePCMData(const uint8* PCMData, const int32 PCMDataSize, const int32 InSampleRate, const int32 InNumChannels)
+{
+	LLM_SCOPE_BYTAG(Voicevox_SoundWave);
+	const int32 NumFrames = PCMDataSize / static_cast<int32>(sizeof(int16)) / FMath::Max(1, InNumChannels);
+
+	RawPCMDataSize = PCMDataSize;
+	QueueAudio(PCMData, PCMDataSize);
+
+	Duration = InSampleRate > 0 ? static_cast<float>(NumFrames) / InSampleRate : 0.0f;
+	SetSampleRate(InSampleRate);
+	NumChannels = InNumChannels;
+	TotalSamples = InSampleRate * Duration;
+	SoundGroup = SOUNDGROUP_Default;
+}
+
+/**
+ * @brief 再利用できるよう、キューに残った音声データと再生時間、読み出し位置を破棄する
+ */
+void UVoicevoxSoundWaveProcedural::ResetForReuse()
+{
+	ResetAudio();
+	ResetRenderedTime();
+	RawPCMDataSize = 0;
+	Duration = 0.0f;
+	TotalSamples = 0;
+}
+
+/**
+ * @brief プールへ返した時刻を記録する
+ */
+void UVoicevoxSoundWaveProcedural::MarkReleased()
+{
+	ReleasedTime = FPlatformTime::Seconds();
+}
+
+/**
+ * @brief 再利用できるか
+ */
+bool UVoicevoxSoundWaveProcedural::CanReuse(const double ReuseDelay) const
+{
+	// 再生中のサウンドはキューが空でも読み出し続けるため、読み出しが止まっていれば再生しているサウンドは無い
+	const double Now = FPlatformTime::Seconds();
+	return Now - ReleasedTime >= ReuseDelay && Now - LastGeneratedTime.load(std::memory_order_relaxed) >= ReuseDelay;
+}
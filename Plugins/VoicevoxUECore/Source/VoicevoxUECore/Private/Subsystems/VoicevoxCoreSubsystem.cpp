@@ -6,7 +6,35 @@
  */
 
 #include "Subsystems/VoicevoxCoreSubsystem.h"
+#include "Audio.h"
+#include "AudioDevice.h"
+#include "VoicevoxLipSyncAnalyzer.h"
+#include "Engine/CurveTable.h"
+#include "JsonObjectConverter.h"
+#include "Hash/CityHash.h"
+#include "VoicevoxResampler.h"
 #include "VoicevoxNativeObject.h"
+#include "VoicevoxPhoneme.h"
+#include "Sound/VoicevoxSoundWaveProcedural.h"
+
+DEFINE_LOG_CATEGORY(LogVoicevoxCore);
+
+namespace
+{
+	//! VOICEVOXのメモリ使用量を出力するコンソールコマンド（DefaultEngine.iniの[MemReportCommands]に追加するとmemreportにも含まれる）
+	FAutoConsoleCommandWithOutputDevice VoicevoxMemReportCommand(
+		TEXT("Voicevox.MemReport"),
+		TEXT("Dump VOICEVOX native core/model resident memory, caches and SoundWave pool usage."),
+		FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+		{
+			if (GEngine == nullptr) return;
+
+			if (const UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>())
+			{
+				Subsystem->DumpMemoryReport(Ar);
+			}
+		}));
+}
 
 //--------------------------------
 // override
@@ -21,6 +49,19 @@ void UVoicevoxCoreSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 
 	const UClass* NativeClass = UVoicevoxNativeObject::StaticClass();
 	NativeInstance = NewObject<UVoicevoxNativeObject>(this, NativeClass);
+	SynthesisThrottle.Start();
+	CompletionQueue.Start();
+
+	if (const FString VoiceBankPath = GetDefaultVoiceBankPath(); FPaths::FileExists(VoiceBankPath))
+	{
+		LoadVoiceBank(VoiceBankPath);
+	}
+
+	// 起動引数で指定された場合は起動直後からリクエストを記録する
+	if (FString TracePath; FParse::Value(FCommandLine::Get(), TEXT("-VoicevoxTraceCapture="), TracePath))
+	{
+		StartTraceCapture(TracePath);
+	}
 }
 
 /**
@@ -30,6 +71,17 @@ void UVoicevoxCoreSubsystem::Deinitialize()
 {
 	Super::Deinitialize();
 
+	StopTraceCapture();
+
+	// 待機中の音声合成を先に開始させてから、各処理の終了を待つ
+	SynthesisThrottle.Stop();
+	CompletionQueue.Stop();
+	Worker.Reset();
+	SpeculativeSynthesis.Reset();
+	StopSynthesisServer();
+	StopWorkerPool();
+	UnloadVoiceBank();
+	SoundWavePool.Empty();
 	NativeInstance->Shutdown();
 }
 
@@ -40,9 +92,32 @@ void UVoicevoxCoreSubsystem::Deinitialize()
 /**
  * @brief VoicevoxNativeCoreSubsystem管理インスタンスの初期化処理実行
  */
-void UVoicevoxCoreSubsystem::NativeInitialize() const
+void UVoicevoxCoreSubsystem::NativeInitialize()
 {
+	LLM_SCOPE_BYTAG(Voicevox_Core);
 	NativeInstance->Init();
+
+	// ワーカープロセスとして起動された場合は、ホストからのリクエスト受付を開始する
+	if (FVoicevoxWorker::IsWorkerProcess())
+	{
+		Worker = MakeUnique<FVoicevoxWorker>(this);
+		return;
+	}
+
+	SpeculativeSynthesis = MakeUnique<FVoicevoxSpeculativeSynthesis>(
+		[this](const int64 SpeakerId, const FString& Message, const bool bKana)
+		{
+			return RequestAudioQuery(SpeakerId, Message, bKana);
+		},
+		[this](const FVoicevoxAudioQuery& AudioQuery, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak, TOptional<FVoicevoxAudioQuery>& OutGovernedAudioQuery)
+		{
+			TArray<uint8> OutputWAV;
+			if (!FindVoiceBank(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, OutputWAV))
+			{
+				OutputWAV = RequestSynthesis(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, EVoicevoxSynthesisPriority::Low, nullptr, &OutGovernedAudioQuery);
+			}
+			return OutputWAV;
+		});
 }
 
 //----------------------------------------------------------------
@@ -63,7 +138,18 @@ bool UVoicevoxCoreSubsystem::Initialize(const bool bUseGPU, const int CPUNumThre
 	VoicevoxCoreVersionMap.Empty();
 	CoreNameList.Empty();
 
-	bIsInitialized = NativeInstance->CoreInitialize(bUseGPU, CPUNumThreads, bLoadAllModels);
+	bInitializeUseGPU = bUseGPU;
+	InitializeCPUNumThreads = CPUNumThreads;
+	bInitializeLoadAllModels = bLoadAllModels;
+
+	// スレッド数の指定が無ければ、このマシンで計測済みのスレッド数を使う
+	const int NumThreads = CPUNumThreads == 0 && !bUseGPU ? FVoicevoxThreadCalibration::LoadCPUNumThreads() : CPUNumThreads;
+	{
+		// Open JTalk辞書と初期化時にロードしたモデルはネイティブ側で確保されるため、前後の常駐メモリの差で計測する
+		LLM_SCOPE_BYTAG(Voicevox_Core);
+		FVoicevoxNativeMemoryTracker::FScope MemoryScope(NativeMemoryTracker);
+		bIsInitialized = NativeInstance->CoreInitialize(bUseGPU, NumThreads, bLoadAllModels);
+	}
 	return bIsInitialized;
 }
 
@@ -88,8 +174,12 @@ void UVoicevoxCoreSubsystem::Finalize()
 	SupportedDevicesMap.Empty();
 	VoicevoxCoreVersionMap.Empty();
 	CoreNameList.Empty();
+	ClearPhraseCache();
+	ClearRecentLineCache();
+	ClearLineTemplateCache();
 	
 	NativeInstance->Finalize();
+	NativeMemoryTracker.Reset();
 }
 
 //--------------------------------
@@ -101,6 +191,12 @@ void UVoicevoxCoreSubsystem::Finalize()
  */
 bool UVoicevoxCoreSubsystem::LoadModel(const int64 SpeakerId) const
 {
+	// ワーカープロセスはリクエスト時にモデルをロードする
+	if (WorkerPool.IsRunning()) return true;
+
+	LLM_SCOPE_BYTAG(Voicevox_Core);
+	FReadScopeLock CoreLock(NativeCoreLock);
+	FVoicevoxNativeMemoryTracker::FScope MemoryScope(NativeMemoryTracker, SpeakerId);
 	return NativeInstance->LoadModel(SpeakerId);
 }
 
@@ -113,7 +209,45 @@ bool UVoicevoxCoreSubsystem::LoadModel(const int64 SpeakerId) const
  */
 FVoicevoxAudioQuery UVoicevoxCoreSubsystem::GetAudioQuery(int64 SpeakerId, const FString& Message, bool bKana) const
 {
-	return NativeInstance->GetAudioQuery(SpeakerId, Message, bKana);
+	LLM_SCOPE_BYTAG(Voicevox_AudioQuery);
+	FVoicevoxTraceRecorder::FScope TraceScope(TraceRecorder, EVoicevoxTraceApi::GetAudioQuery);
+	TraceScope.SetText(SpeakerId, Message, bKana, false);
+
+	FVoicevoxAudioQuery AudioQuery;
+	if (!SpeculativeSynthesis || !SpeculativeSynthesis->FindAudioQuery(SpeakerId, Message, bKana, AudioQuery))
+	{
+		AudioQuery = RequestAudioQuery(SpeakerId, Message, bKana);
+	}
+	TraceScope.SetSucceeded(!AudioQuery.Accent_phrases.IsEmpty());
+	return AudioQuery;
+}
+
+/**
+ * @brief 投機的な音声合成の結果を参照せず、ワーカープロセス、もしくはVOICEVOX COREでAudioQueryを取得する
+ */
+FVoicevoxAudioQuery UVoicevoxCoreSubsystem::RequestAudioQuery(const int64 SpeakerId, const FString& Message, const bool bKana) const
+{
+	LLM_SCOPE_BYTAG(Voicevox_AudioQuery);
+	if (WorkerPool.IsRunning())
+	{
+		const FTCHARToUTF8 Utf8(*Message);
+		FVoicevoxAudioQuery AudioQuery;
+		if (TArray<uint8> ResponseData; WorkerPool.Request(EVoicevoxWorkerCommand::AudioQuery, SpeakerId, bKana ? EVoicevoxWorkerFlag::Kana : 0,
+			TArrayView<const uint8>(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length()), ResponseData))
+		{
+			const FUTF8ToTCHAR Json(reinterpret_cast<const ANSICHAR*>(ResponseData.GetData()), ResponseData.Num());
+			FJsonObjectConverter::JsonObjectStringToUStruct(FString(Json.Length(), Json.Get()), &AudioQuery, 0, 0);
+			FVoicevoxPhoneme::InternAudioQuery(AudioQuery);
+		}
+		return AudioQuery;
+	}
+	FVoicevoxAudioQuery AudioQuery;
+	{
+		FReadScopeLock CoreLock(NativeCoreLock);
+		AudioQuery = NativeInstance->GetAudioQuery(SpeakerId, Message, bKana);
+	}
+	FVoicevoxPhoneme::InternAudioQuery(AudioQuery);
+	return AudioQuery;
 }
 
 //--------------------------------
@@ -125,7 +259,26 @@ FVoicevoxAudioQuery UVoicevoxCoreSubsystem::GetAudioQuery(int64 SpeakerId, const
  */
 TArray<uint8> UVoicevoxCoreSubsystem::RunTextToSpeech(const int64 SpeakerId, const FString& Message, const bool bKana, const bool bEnableInterrogativeUpspeak) const
 {
-	return NativeInstance->RunTextToSpeech(SpeakerId, Message, bKana, bEnableInterrogativeUpspeak);
+	LLM_SCOPE_BYTAG(Voicevox_PCM);
+	FVoicevoxTraceRecorder::FScope TraceScope(TraceRecorder, EVoicevoxTraceApi::RunTextToSpeech);
+	TraceScope.SetText(SpeakerId, Message, bKana, bEnableInterrogativeUpspeak);
+
+	FVoicevoxSynthesisThrottle::FScope ThrottleScope(SynthesisThrottle);
+	TArray<uint8> OutputWAV;
+	if (WorkerPool.IsRunning())
+	{
+		const FTCHARToUTF8 Utf8(*Message);
+		const uint32 Flags = (bKana ? EVoicevoxWorkerFlag::Kana : 0) | (bEnableInterrogativeUpspeak ? EVoicevoxWorkerFlag::InterrogativeUpspeak : 0);
+		WorkerPool.Request(EVoicevoxWorkerCommand::TextToSpeech, SpeakerId, Flags,
+			TArrayView<const uint8>(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length()), OutputWAV);
+	}
+	else
+	{
+		FReadScopeLock CoreLock(NativeCoreLock);
+		OutputWAV = NativeInstance->RunTextToSpeech(SpeakerId, Message, bKana, bEnableInterrogativeUpspeak);
+	}
+	TraceScope.SetSucceeded(!OutputWAV.IsEmpty());
+	return OutputWAV;
 }
 
 //--------------------------------
@@ -137,15 +290,155 @@ TArray<uint8> UVoicevoxCoreSubsystem::RunTextToSpeech(const int64 SpeakerId, con
  */
 TArray<uint8> UVoicevoxCoreSubsystem::RunSynthesis(const char* AudioQueryJson, const int64 SpeakerId, bool bEnableInterrogativeUpspeak) const
 {
+	LLM_SCOPE_BYTAG(Voicevox_PCM);
+
+	// ボイスバンクやキャッシュを参照するため、構造体に変換できる場合は構造体版で音声合成する
+	if (FVoicevoxAudioQuery AudioQuery; FJsonObjectConverter::JsonObjectStringToUStruct(UTF8_TO_TCHAR(AudioQueryJson), &AudioQuery, 0, 0))
+	{
+		return RunSynthesis(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak);
+	}
+
+	FVoicevoxSynthesisThrottle::FScope ThrottleScope(SynthesisThrottle);
+	if (WorkerPool.IsRunning())
+	{
+		TArray<uint8> OutputWAV;
+		WorkerPool.Request(EVoicevoxWorkerCommand::Synthesis, SpeakerId, bEnableInterrogativeUpspeak ? EVoicevoxWorkerFlag::InterrogativeUpspeak : 0,
+			TArrayView<const uint8>(reinterpret_cast<const uint8*>(AudioQueryJson), FCStringAnsi::Strlen(AudioQueryJson)), OutputWAV);
+		return OutputWAV;
+	}
+	FReadScopeLock CoreLock(NativeCoreLock);
 	return NativeInstance->RunSynthesis(AudioQueryJson, SpeakerId,  bEnableInterrogativeUpspeak);
 }
 
 /**
  * @brief AudioQueryを音声データに変換する。
  */
-TArray<uint8> UVoicevoxCoreSubsystem::RunSynthesis(const FVoicevoxAudioQuery& AudioQuery, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak) const
+TArray<uint8> UVoicevoxCoreSubsystem::RunSynthesis(const FVoicevoxAudioQuery& AudioQuery, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak, const EVoicevoxSynthesisPriority Priority,
+												FVoicevoxAudioQuery* OutSynthesisAudioQuery) const
+{
+	LLM_SCOPE_BYTAG(Voicevox_PCM);
+	FVoicevoxTraceRecorder::FScope TraceScope(TraceRecorder, EVoicevoxTraceApi::RunSynthesis);
+	TraceScope.SetAudioQuery(SpeakerId, AudioQuery, bEnableInterrogativeUpspeak, Priority);
+
+	if (OutSynthesisAudioQuery != nullptr)
+	{
+		*OutSynthesisAudioQuery = AudioQuery;
+	}
+	TArray<uint8> OutputWAV;
+	if (!FindVoiceBank(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, OutputWAV)
+		&& !(SpeculativeSynthesis && SpeculativeSynthesis->FindSynthesis(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, Priority, OutputWAV, OutSynthesisAudioQuery))
+		&& !FindRecentLine(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, OutputWAV))
+	{
+		TOptional<FVoicevoxAudioQuery> GovernedAudioQuery;
+		OutputWAV = RequestSynthesis(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, Priority, nullptr, OutSynthesisAudioQuery != nullptr ? &GovernedAudioQuery : nullptr);
+		if (GovernedAudioQuery.IsSet())
+		{
+			*OutSynthesisAudioQuery = MoveTemp(GovernedAudioQuery.GetValue());
+		}
+	}
+	TraceScope.SetSucceeded(!OutputWAV.IsEmpty());
+	return OutputWAV;
+}
+
+/**
+ * @brief 期限を指定してAudioQueryを音声データに変換する。
+ */
+TArray<uint8> UVoicevoxCoreSubsystem::RunSynthesisWithDeadline(const FVoicevoxAudioQuery& AudioQuery, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak,
+																const FVoicevoxSynthesisDeadline& Deadline, const EVoicevoxSynthesisPriority Priority,
+																FVoicevoxAudioQuery* OutSynthesisAudioQuery) const
 {
-	return NativeInstance->RunSynthesis(AudioQuery, SpeakerId,  bEnableInterrogativeUpspeak);
+	LLM_SCOPE_BYTAG(Voicevox_PCM);
+	FVoicevoxTraceRecorder::FScope TraceScope(TraceRecorder, EVoicevoxTraceApi::RunSynthesisWithDeadline);
+	TraceScope.SetAudioQuery(SpeakerId, AudioQuery, bEnableInterrogativeUpspeak, Priority);
+	if (TraceScope.IsActive() && Deadline.Deadline > 0.0)
+	{
+		// 再生時はリクエストした時刻からの相対的な期限として扱う
+		TraceScope.GetEntry().Deadline = Deadline.Deadline - FPlatformTime::Seconds();
+		TraceScope.GetEntry().bCancelOnDeadlineMiss = Deadline.bCancelOnDeadlineMiss;
+	}
+
+	if (OutSynthesisAudioQuery != nullptr)
+	{
+		*OutSynthesisAudioQuery = AudioQuery;
+	}
+	TArray<uint8> OutputWAV;
+	if (!FindVoiceBank(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, OutputWAV)
+		&& !(SpeculativeSynthesis && SpeculativeSynthesis->FindSynthesis(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, Priority, OutputWAV, OutSynthesisAudioQuery))
+		&& !FindRecentLine(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, OutputWAV))
+	{
+		TOptional<FVoicevoxAudioQuery> GovernedAudioQuery;
+		OutputWAV = RequestSynthesis(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, Priority, &Deadline, OutSynthesisAudioQuery != nullptr ? &GovernedAudioQuery : nullptr);
+		if (GovernedAudioQuery.IsSet())
+		{
+			*OutSynthesisAudioQuery = MoveTemp(GovernedAudioQuery.GetValue());
+		}
+	}
+	TraceScope.SetSucceeded(!OutputWAV.IsEmpty());
+	return OutputWAV;
+}
+
+/**
+ * @brief AudioQueryの音声合成の所要時間を予測する
+ */
+double UVoicevoxCoreSubsystem::PredictSynthesisTime(const FVoicevoxAudioQuery& AudioQuery, const int64 SpeakerId) const
+{
+	return SynthesisCostModel.Predict(SpeakerId, FVoicevoxSynthesisCostModel::GetMoraNum(AudioQuery));
+}
+
+/**
+ * @brief 投機的な音声合成の結果を参照せず、ワーカープロセス、もしくはVOICEVOX COREで音声合成する
+ */
+TArray<uint8> UVoicevoxCoreSubsystem::RequestSynthesis(const FVoicevoxAudioQuery& AudioQuery, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak, const EVoicevoxSynthesisPriority Priority,
+												   const FVoicevoxSynthesisDeadline* Deadline, TOptional<FVoicevoxAudioQuery>* OutGovernedAudioQuery) const
+{
+	LLM_SCOPE_BYTAG(Voicevox_PCM);
+	// 負荷が高い場合は品質を下げたAudioQueryで音声合成する
+	FVoicevoxAudioQuery GovernedAudioQuery;
+	const bool bIsGoverned = QualityGovernor.Apply(AudioQuery, Priority, SynthesisThrottle.GetQueueDepth(), GovernedAudioQuery);
+	const FVoicevoxAudioQuery& SynthesisAudioQuery = bIsGoverned ? GovernedAudioQuery : AudioQuery;
+
+	// 期限付きの場合は期限の早い順に開始し、間に合わない場合は早めに通知する
+	const int32 MoraNum = FVoicevoxSynthesisCostModel::GetMoraNum(SynthesisAudioQuery);
+	FVoicevoxSynthesisThrottle::FScope ThrottleScope(SynthesisThrottle, Deadline, SynthesisCostModel.Predict(SpeakerId, MoraNum));
+	if (!ThrottleScope.IsAcquired())
+	{
+		UE_LOG(LogVoicevoxCore, Log, TEXT("Synthesis Deadline Miss: Canceled SpeakerId=%lld"), SpeakerId);
+		return {};
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	TArray<uint8> OutputWAV;
+	if (WorkerPool.IsRunning())
+	{
+		FString AudioQueryJson;
+		FJsonObjectConverter::UStructToJsonObjectString(SynthesisAudioQuery, AudioQueryJson, 0, 0, 0, nullptr, false);
+		const FTCHARToUTF8 Utf8(*AudioQueryJson);
+		WorkerPool.Request(EVoicevoxWorkerCommand::Synthesis, SpeakerId, bEnableInterrogativeUpspeak ? EVoicevoxWorkerFlag::InterrogativeUpspeak : 0,
+			TArrayView<const uint8>(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length()), OutputWAV);
+	}
+	else
+	{
+		FReadScopeLock CoreLock(NativeCoreLock);
+		OutputWAV = NativeInstance->RunSynthesis(SynthesisAudioQuery, SpeakerId,  bEnableInterrogativeUpspeak);
+	}
+
+	if (!OutputWAV.IsEmpty())
+	{
+		const double SynthesisTime = FPlatformTime::Seconds() - StartTime;
+		QualityGovernor.Record(SynthesisTime, SynthesisAudioQuery);
+		SynthesisCostModel.Record(SpeakerId, MoraNum, SynthesisTime);
+
+		// 品質を下げた音声データを元のAudioQueryのキーで保存すると、負荷が下がった後も品質を下げたまま再生されるため保存しない
+		if (!bIsGoverned)
+		{
+			AddRecentLine(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, OutputWAV);
+		}
+		else if (OutGovernedAudioQuery != nullptr)
+		{
+			*OutGovernedAudioQuery = MoveTemp(GovernedAudioQuery);
+		}
+	}
+	return OutputWAV;
 }
 
 /**
@@ -153,63 +446,1347 @@ TArray<uint8> UVoicevoxCoreSubsystem::RunSynthesis(const FVoicevoxAudioQuery& Au
  */
 TArray<uint8> UVoicevoxCoreSubsystem::RunSynthesis(const UVoicevoxQuery& VoicevoxQuery, bool bEnableInterrogativeUpspeak) const
 {
-	return NativeInstance->RunSynthesis(VoicevoxQuery.VoicevoxAudioQuery, VoicevoxQuery.SpeakerType,  bEnableInterrogativeUpspeak);
+	return RunSynthesis(VoicevoxQuery.VoicevoxAudioQuery, VoicevoxQuery.SpeakerType,  bEnableInterrogativeUpspeak);
 }
 
-//--------------------------------
-// VOICEVOX CORE LipSync関連
-//--------------------------------
-	
 /**
- * @brief VOICEVOX COREで取得したAudioQuery元に、中品質なLipSyncに必要なデータリストを取得
+ * @brief アクセント句単位のキャッシュを利用してAudioQueryを音声データに変換する。
  */
-TArray<FVoicevoxLipSync> UVoicevoxCoreSubsystem::GetLipSyncList(FVoicevoxAudioQuery AudioQuery, bool bIsSimple, float PitchModulation)
+TArray<uint8> UVoicevoxCoreSubsystem::RunSynthesisWithPhraseCache(const FVoicevoxAudioQuery& AudioQuery, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak)
 {
-	TArray<FVoicevoxLipSync> List;
-	List.Empty();
-
-	TMap<FString, ELipSyncVowelType> FruitMap;
-	FruitMap.Reserve(8);
-	FruitMap.Add(TEXT("a"), ELipSyncVowelType::A);
-	FruitMap.Add(TEXT("i"), ELipSyncVowelType::I);
-	FruitMap.Add(TEXT("u"), ELipSyncVowelType::U);
-	FruitMap.Add(TEXT("e"), ELipSyncVowelType::E);
-	FruitMap.Add(TEXT("o"), ELipSyncVowelType::O);
-	FruitMap.Add(TEXT("cl"), ELipSyncVowelType::CL);
-	FruitMap.Add(TEXT("N"), ELipSyncVowelType::Non);
-	FruitMap.Add(TEXT("pau"), ELipSyncVowelType::Non);
+	LLM_SCOPE_BYTAG(Voicevox_PCM);
+	FVoicevoxTraceRecorder::FScope TraceScope(TraceRecorder, EVoicevoxTraceApi::RunSynthesisWithPhraseCache);
+	TraceScope.SetAudioQuery(SpeakerId, AudioQuery, bEnableInterrogativeUpspeak, EVoicevoxSynthesisPriority::Normal);
 
-	List.Add({ELipSyncVowelType::Non, AudioQuery.Pre_phoneme_length / AudioQuery.Speed_scale, false, false});
-	
-	for (auto [Moras, Accent, Pause_mora, Is_interrogative] : AudioQuery.Accent_phrases)
+	const int32 PhraseNum = AudioQuery.Accent_phrases.Num();
+	if (PhraseNum == 0)
+	{
+		TArray<uint8> OutputWAV = RunSynthesis(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak);
+		TraceScope.SetSucceeded(!OutputWAV.IsEmpty());
+		return OutputWAV;
+	}
+
+	if (TArray<uint8> OutputWAV; FindVoiceBank(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, OutputWAV))
+	{
+		TraceScope.SetSucceeded(true);
+		return OutputWAV;
+	}
+
+	// アクセント句全体に影響する合成パラメータ
+	const FString QueryKeyText = FString::Printf(TEXT("%lld|%d|%.9g|%.9g|%.9g|%.9g|%d|%d"), SpeakerId, bEnableInterrogativeUpspeak ? 1 : 0,
+												AudioQuery.Speed_scale, AudioQuery.Pitch_scale, AudioQuery.Intonation_scale, AudioQuery.Volume_scale,
+												AudioQuery.Output_sampling_rate, AudioQuery.Output_stereo ? 1 : 0);
+
+	TArray<FString> PhraseKeyTextList;
+	PhraseKeyTextList.Reserve(PhraseNum);
+	for (const FVoicevoxAccentPhrase& AccentPhrase : AudioQuery.Accent_phrases)
+	{
+		PhraseKeyTextList.Add(GetAccentPhraseKeyText(AccentPhrase));
+	}
+
+	// 前後のアクセント句でイントネーションが変わるため、前後のアクセント句も含めてキーとする
+	// 衝突した場合は別のアクセント句の音声が混ざるため、32bitのハッシュ値の組み合わせではなく、内容全体の64bitハッシュ値を使う
+	TArray<uint64> KeyList;
+	KeyList.Reserve(PhraseNum);
+	for (int32 Index = 0; Index < PhraseNum; ++Index)
 	{
-		for (auto [Text, Consonant, Consonant_length, Vowel, Vowel_length, Pitch] : Moras)
+		FString KeyText = QueryKeyText;
+		KeyText += TEXT("|") + PhraseKeyTextList[Index];
+		KeyText += TEXT("|") + (Index > 0 ? PhraseKeyTextList[Index - 1] : FString());
+		KeyText += TEXT("|") + (Index < PhraseNum - 1 ? PhraseKeyTextList[Index + 1] : FString());
+		if (Index == 0)
 		{
-			if (bIsSimple)
+			KeyText += FString::Printf(TEXT("|Pre=%.9g"), AudioQuery.Pre_phoneme_length);
+		}
+		if (Index == PhraseNum - 1)
+		{
+			KeyText += FString::Printf(TEXT("|Post=%.9g"), AudioQuery.Post_phoneme_length);
+		}
+		const FTCHARToUTF8 Utf8(*KeyText);
+		KeyList.Add(CityHash64(Utf8.Get(), Utf8.Length()));
+	}
+
+	TArray<FVoicevoxPhrasePCM> PhrasePCMList;
+	PhrasePCMList.SetNum(PhraseNum);
+	TArray<bool> IsCachedList;
+	IsCachedList.Init(false, PhraseNum);
+	{
+		FScopeLock Lock(&PhrasePCMCacheCriticalSection);
+		for (int32 Index = 0; Index < PhraseNum; ++Index)
+		{
+			if (const FVoicevoxPhrasePCM* PhrasePCM = PhrasePCMCacheMap.Find(KeyList[Index]))
 			{
-				List.Add({FruitMap[Vowel], Vowel_length / AudioQuery.Speed_scale + Consonant_length / AudioQuery.Speed_scale });
+				PhrasePCMList[Index] = *PhrasePCM;
+				IsCachedList[Index] = true;
+
+				// 使用したアクセント句は最後に破棄されるよう末尾へ移す
+				PhrasePCMCacheKeyList.RemoveSingle(KeyList[Index]);
+				PhrasePCMCacheKeyList.Add(KeyList[Index]);
 			}
-			else
+		}
+	}
+
+	// キャッシュに無いアクセント句は連続した範囲ごとにまとめて合成する
+	int32 Index = 0;
+	while (Index < PhraseNum)
+	{
+		if (IsCachedList[Index])
+		{
+			++Index;
+			continue;
+		}
+
+		const int32 FirstIndex = Index;
+		while (Index < PhraseNum && !IsCachedList[Index])
+		{
+			++Index;
+		}
+		const int32 LastIndex = Index - 1;
+
+		if (!SynthesisAccentPhraseRange(AudioQuery, FirstIndex, LastIndex, SpeakerId, bEnableInterrogativeUpspeak, PhrasePCMList))
+		{
+			return TArray<uint8>();
+		}
+
+		LLM_SCOPE_BYTAG(Voicevox_Cache);
+		FScopeLock Lock(&PhrasePCMCacheCriticalSection);
+		for (int32 CacheIndex = FirstIndex; CacheIndex <= LastIndex; ++CacheIndex)
+		{
+			if (!PhrasePCMCacheMap.Contains(KeyList[CacheIndex]))
 			{
-				if (!Consonant.IsEmpty())
-				{
-					FString C = Consonant.ToLower();
-					bool IsLabialOrPlosive = C.Equals(TEXT("w")) || C.Equals(TEXT("m")) || C.Equals(TEXT("b")) || C.Equals(TEXT("p")) || C.Equals(TEXT("f")) || C.Equals(TEXT("v"));
-					List.Add({FruitMap[Vowel], Consonant_length / AudioQuery.Speed_scale, true, IsLabialOrPlosive});
-				}
-				List.Add({FruitMap[Vowel], Vowel_length / AudioQuery.Speed_scale, false, false});
+				PhrasePCMCacheMap.Add(KeyList[CacheIndex], PhrasePCMList[CacheIndex]);
+				PhrasePCMCacheKeyList.Add(KeyList[CacheIndex]);
 			}
-			
+		}
+		while (PhrasePCMCacheKeyList.Num() > PhrasePCMCacheMaxNum)
+		{
+			PhrasePCMCacheMap.Remove(PhrasePCMCacheKeyList[0]);
+			PhrasePCMCacheKeyList.RemoveAt(0);
+		}
+	}
+
+	// アクセント句の境界を短いクロスフェードで繋ぐ
+	const int32 NumChannels = PhrasePCMList[0].NumChannels;
+	const int32 SampleRate = PhrasePCMList[0].SampleRate;
+	const int32 CrossfadeFrameNum = FMath::RoundToInt(SampleRate * PhraseCrossfadeTime * 0.5f) * 2;
+	TArray<int16> Samples;
+	for (const FVoicevoxPhrasePCM& PhrasePCM : PhrasePCMList)
+	{
+		AppendPhrasePCM(Samples, PhrasePCM, CrossfadeFrameNum);
+	}
+
+	TArray<uint8> OutputWAV;
+	SerializeWaveFile(OutputWAV, reinterpret_cast<const uint8*>(Samples.GetData()), Samples.Num() * sizeof(int16), NumChannels, SampleRate);
+	TraceScope.SetSucceeded(true);
+	return OutputWAV;
+}
+
+/**
+ * @brief アクセント句単位の音声データキャッシュを破棄する
+ */
+void UVoicevoxCoreSubsystem::ClearPhraseCache()
+{
+	FScopeLock Lock(&PhrasePCMCacheCriticalSection);
+	PhrasePCMCacheMap.Empty();
+	PhrasePCMCacheKeyList.Empty();
+}
+
+//--------------------------------
+// 定型文関連
+//--------------------------------
+
+/**
+ * @brief 「{N}ゴールド手に入れた」のような定型文を、差し込み部分だけ音声合成して音声データに変換する。
+ */
+TArray<uint8> UVoicevoxCoreSubsystem::RunSynthesisWithTemplate(const FString& Template, const TMap<FString, FString>& SlotValues, const int64 SpeakerId,
+															 const bool bEnableInterrogativeUpspeak, FVoicevoxAudioQuery& OutAudioQuery)
+{
+	LLM_SCOPE_BYTAG(Voicevox_PCM);
+	FVoicevoxTraceRecorder::FScope TraceScope(TraceRecorder, EVoicevoxTraceApi::RunSynthesisWithTemplate);
+	TraceScope.SetText(SpeakerId, Template, false, bEnableInterrogativeUpspeak);
+	if (TraceScope.IsActive())
+	{
+		TraceScope.GetEntry().SlotValues = SlotValues;
+	}
+
+	TArray<FVoicevoxTemplatePart> Parts;
+	if (!ParseLineTemplate(Template, Parts))
+	{
+		UE_LOG(LogVoicevoxCore, Error, TEXT("Line Template Error: Unclosed slot in \"%s\""), *Template);
+		return {};
+	}
+
+	// 差し込み部分をテキストに置き換える（空のテキストの場合は部分ごと取り除く）
+	for (int32 Index = Parts.Num() - 1; Index >= 0; --Index)
+	{
+		if (!Parts[Index].bIsSlot) continue;
+
+		const FString* SlotValue = SlotValues.Find(Parts[Index].Text);
+		if (SlotValue == nullptr)
+		{
+			UE_LOG(LogVoicevoxCore, Error, TEXT("Line Template Error: Slot {%s} has no value"), *Parts[Index].Text);
+			return {};
+		}
+		if (SlotValue->IsEmpty())
+		{
+			Parts.RemoveAt(Index);
+			continue;
+		}
+		Parts[Index].Text = *SlotValue;
+	}
+	if (Parts.IsEmpty()) return {};
+
+	// 固定部分はキャッシュを利用し、差し込み部分は前後の固定部分が揃ってから抑揚を調整して音声合成する
+	const int32 PartNum = Parts.Num();
+	TArray<FVoicevoxTemplateSegment> Segments;
+	Segments.SetNum(PartNum);
+	for (int32 Index = 0; Index < PartNum; ++Index)
+	{
+		if (!Parts[Index].bIsSlot && !FindOrSynthesisTemplateSegment(Parts[Index].Text, Index == 0, Index == PartNum - 1, SpeakerId, bEnableInterrogativeUpspeak, Segments[Index]))
+		{
+			return {};
+		}
+	}
+	for (int32 Index = 0; Index < PartNum; ++Index)
+	{
+		if (!Parts[Index].bIsSlot) continue;
+
+		FVoicevoxTemplateSegment& Segment = Segments[Index];
+		Segment.AudioQuery = GetAudioQuery(SpeakerId, Parts[Index].Text, false);
+		if (Segment.AudioQuery.Accent_phrases.IsEmpty()) continue;
+
+		if (Index > 0)
+		{
+			Segment.AudioQuery.Pre_phoneme_length = 0.0f;
+		}
+		if (Index < PartNum - 1)
+		{
+			Segment.AudioQuery.Post_phoneme_length = 0.0f;
 		}
 
-		if (Pause_mora.Vowel.Equals(TEXT("pau"), ESearchCase::IgnoreCase))
+		// 直後が差し込み部分の場合は、まだ音声合成していないため直前の部分のみに合わせる
+		const FVoicevoxAudioQuery* PrevAudioQuery = Index > 0 ? &Segments[Index - 1].AudioQuery : nullptr;
+		const FVoicevoxAudioQuery* NextAudioQuery = Index < PartNum - 1 && !Parts[Index + 1].bIsSlot ? &Segments[Index + 1].AudioQuery : nullptr;
+		AdjustTemplateSlotPitch(Segment.AudioQuery, PrevAudioQuery, NextAudioQuery);
+		if (!SynthesisTemplateSegment(Segment.AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, Segment.PCM))
 		{
-			List.Add({ELipSyncVowelType::Non, Pause_mora.Vowel_length / AudioQuery.Speed_scale, false, false});
+			return {};
 		}
 	}
 
-	List.Add({ELipSyncVowelType::Non, AudioQuery.Post_phoneme_length / AudioQuery.Speed_scale, false, false});
-	
+	// 各部分の音声データとAudioQueryを繋ぐ
+	OutAudioQuery = FVoicevoxAudioQuery();
+	TArray<int16> Samples;
+	int32 SampleRate = 0;
+	int32 NumChannels = 0;
+	for (int32 Index = 0; Index < PartNum; ++Index)
+	{
+		const FVoicevoxTemplateSegment& Segment = Segments[Index];
+		if (Segment.PCM.Samples.IsEmpty()) continue;
+
+		if (SampleRate == 0)
+		{
+			SampleRate = Segment.PCM.SampleRate;
+			NumChannels = Segment.PCM.NumChannels;
+			OutAudioQuery = Segment.AudioQuery;
+			OutAudioQuery.Accent_phrases.Reset();
+		}
+		else if (Segment.PCM.SampleRate != SampleRate || Segment.PCM.NumChannels != NumChannels)
+		{
+			UE_LOG(LogVoicevoxCore, Error, TEXT("Line Template Error: Segment format mismatch in \"%s\""), *Template);
+			return {};
+		}
+
+		AppendPhrasePCM(Samples, Segment.PCM, FMath::RoundToInt(SampleRate * PhraseCrossfadeTime));
+		OutAudioQuery.Accent_phrases.Append(Segment.AudioQuery.Accent_phrases);
+		OutAudioQuery.Post_phoneme_length = Segment.AudioQuery.Post_phoneme_length;
+	}
+	if (Samples.IsEmpty()) return {};
+
+	TArray<uint8> OutputWAV;
+	SerializeWaveFile(OutputWAV, reinterpret_cast<const uint8*>(Samples.GetData()), Samples.Num() * sizeof(int16), NumChannels, SampleRate);
+	TraceScope.SetSucceeded(true);
+	return OutputWAV;
+}
+
+/**
+ * @brief 定型文の固定部分を事前に音声合成してキャッシュする
+ */
+bool UVoicevoxCoreSubsystem::PrepareLineTemplate(const FString& Template, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak)
+{
+	TArray<FVoicevoxTemplatePart> Parts;
+	if (!ParseLineTemplate(Template, Parts)) return false;
+
+	// 差し込み部分は空にならないものとして、固定部分の位置を決める
+	for (int32 Index = 0; Index < Parts.Num(); ++Index)
+	{
+		if (FVoicevoxTemplateSegment Segment; !Parts[Index].bIsSlot && !FindOrSynthesisTemplateSegment(Parts[Index].Text, Index == 0, Index == Parts.Num() - 1, SpeakerId, bEnableInterrogativeUpspeak, Segment))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief 定型文の固定部分のキャッシュを破棄する
+ */
+void UVoicevoxCoreSubsystem::ClearLineTemplateCache()
+{
+	FScopeLock Lock(&TemplateSegmentCacheCriticalSection);
+	TemplateSegmentCacheMap.Empty();
+	TemplateSegmentCacheKeyList.Empty();
+}
+
+//--------------------------------
+// 最近再生したセリフのキャッシュ関連
+//--------------------------------
+
+/**
+ * @brief 最近再生したセリフのキャッシュのメモリ予算を設定する
+ */
+void UVoicevoxCoreSubsystem::SetRecentLineCacheMemoryBudget(const int64 MemoryBudget)
+{
+	RecentLineCache.SetMemoryBudget(MemoryBudget);
+}
+
+/**
+ * @brief 最近再生したセリフのキャッシュのメモリ予算を取得する
+ */
+int64 UVoicevoxCoreSubsystem::GetRecentLineCacheMemoryBudget() const
+{
+	return RecentLineCache.GetMemoryBudget();
+}
+
+/**
+ * @brief 最近再生したセリフのキャッシュの使用メモリを取得する
+ */
+int64 UVoicevoxCoreSubsystem::GetRecentLineCacheMemoryUsage() const
+{
+	return RecentLineCache.GetMemoryUsage();
+}
+
+/**
+ * @brief 最近再生したセリフのキャッシュを破棄する
+ */
+void UVoicevoxCoreSubsystem::ClearRecentLineCache()
+{
+	RecentLineCache.Empty();
+}
+
+/**
+ * @brief 最近再生したセリフのキャッシュから音声データを展開する
+ */
+bool UVoicevoxCoreSubsystem::FindRecentLine(const FVoicevoxAudioQuery& AudioQuery, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak, TArray<uint8>& OutputWAV) const
+{
+	// 無効の場合はキーを求めない（AudioQueryをJSON文字列へ変換するため）
+	if (RecentLineCache.GetMemoryBudget() <= 0 || RecentLineCache.GetLineNum() == 0) return false;
+
+	return RecentLineCache.Find(FVoicevoxVoiceBank::GetKey(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak), OutputWAV);
+}
+
+/**
+ * @brief 音声合成した音声データを最近再生したセリフのキャッシュへ圧縮して保持する
+ */
+void UVoicevoxCoreSubsystem::AddRecentLine(const FVoicevoxAudioQuery& AudioQuery, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak, const TArray<uint8>& OutputWAV) const
+{
+	if (RecentLineCache.GetMemoryBudget() <= 0) return;
+
+	LLM_SCOPE_BYTAG(Voicevox_Cache);
+	RecentLineCache.Add(FVoicevoxVoiceBank::GetKey(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak), OutputWAV);
+}
+
+//--------------------------------
+// トレースのキャプチャ関連
+//--------------------------------
+
+/**
+ * @brief 音声合成リクエストのキャプチャを開始する
+ */
+bool UVoicevoxCoreSubsystem::StartTraceCapture(const FString& FilePath)
+{
+	if (!TraceRecorder.Start(FilePath))
+	{
+		UE_LOG(LogVoicevoxCore, Warning, TEXT("Can't Start Trace Capture: %s"), *FilePath);
+		return false;
+	}
+	UE_LOG(LogVoicevoxCore, Log, TEXT("Trace Capture Started: %s"), *FilePath);
+	return true;
+}
+
+/**
+ * @brief 音声合成リクエストのキャプチャを終了し、トレースファイルへ保存する
+ */
+bool UVoicevoxCoreSubsystem::StopTraceCapture()
+{
+	return TraceRecorder.Stop();
+}
+
+/**
+ * @brief 音声合成リクエストをキャプチャ中か
+ */
+bool UVoicevoxCoreSubsystem::IsTraceCapturing() const
+{
+	return TraceRecorder.IsCapturing();
+}
+
+//--------------------------------
+// メモリ使用量関連
+//--------------------------------
+
+/**
+ * @brief VOICEVOX COREの初期化で増加したネイティブ側の常駐メモリを取得する
+ */
+int64 UVoicevoxCoreSubsystem::GetNativeCoreMemory() const
+{
+	return NativeMemoryTracker.GetCoreMemory();
+}
+
+/**
+ * @brief 話者毎のモデルのロードで増加したネイティブ側の常駐メモリを取得する
+ */
+TMap<int64, int64> UVoicevoxCoreSubsystem::GetNativeModelMemoryMap() const
+{
+	return NativeMemoryTracker.GetModelMemoryMap();
+}
+
+/**
+ * @brief VOICEVOXのメモリ使用量をまとめて出力する（Voicevox.MemReportコマンド）
+ */
+void UVoicevoxCoreSubsystem::DumpMemoryReport(FOutputDevice& Ar) const
+{
+	constexpr double MB = 1024.0 * 1024.0;
+	Ar.Logf(TEXT("VOICEVOX Memory Report"));
+	if (WorkerPool.IsRunning())
+	{
+		Ar.Logf(TEXT("  VOICEVOX CORE runs in worker processes (their native memory is not included)"));
+	}
+
+	// ネイティブ側（初期化、モデルのロード前後の常駐メモリの差）
+	Ar.Logf(TEXT("  Native Core (Open JTalk dictionary, runtime): %.2f MB"), NativeMemoryTracker.GetCoreMemory() / MB);
+	TMap<int64, int64> ModelMemoryMap = NativeMemoryTracker.GetModelMemoryMap();
+	ModelMemoryMap.KeySort(TLess<int64>());
+	for (const TPair<int64, int64>& ModelMemory : ModelMemoryMap)
+	{
+		Ar.Logf(TEXT("  Native Model SpeakerId=%lld: %.2f MB"), ModelMemory.Key, ModelMemory.Value / MB);
+	}
+	Ar.Logf(TEXT("  Native Models Total: %.2f MB"), NativeMemoryTracker.GetModelMemory() / MB);
+
+	// UE側のキャッシュ
+	{
+		FScopeLock Lock(&PhrasePCMCacheCriticalSection);
+		SIZE_T Size = PhrasePCMCacheMap.GetAllocatedSize() + PhrasePCMCacheKeyList.GetAllocatedSize();
+		for (const TPair<uint64, FVoicevoxPhrasePCM>& PhrasePCM : PhrasePCMCacheMap)
+		{
+			Size += PhrasePCM.Value.Samples.GetAllocatedSize();
+		}
+		Ar.Logf(TEXT("  Phrase Cache: %d phrases, %.2f MB"), PhrasePCMCacheMap.Num(), Size / MB);
+	}
+	{
+		FScopeLock Lock(&TemplateSegmentCacheCriticalSection);
+		SIZE_T Size = TemplateSegmentCacheMap.GetAllocatedSize() + TemplateSegmentCacheKeyList.GetAllocatedSize();
+		for (const TPair<uint64, FVoicevoxTemplateSegment>& Segment : TemplateSegmentCacheMap)
+		{
+			Size += Segment.Value.PCM.Samples.GetAllocatedSize() + Segment.Value.AudioQuery.Accent_phrases.GetAllocatedSize();
+		}
+		Ar.Logf(TEXT("  Line Template Cache: %d segments, %.2f MB"), TemplateSegmentCacheMap.Num(), Size / MB);
+	}
+	Ar.Logf(TEXT("  Recent Line Cache: %d lines, %.2f / %.2f MB"), RecentLineCache.GetLineNum(), RecentLineCache.GetMemoryUsage() / MB, RecentLineCache.GetMemoryBudget() / MB);
+	if (IsInGameThread())
+	{
+		SIZE_T Size = 0;
+		for (const TObjectPtr<UVoicevoxSoundWaveProcedural>& SoundWave : SoundWavePool)
+		{
+			if (SoundWave != nullptr)
+			{
+				Size += SoundWave->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+			}
+		}
+		Ar.Logf(TEXT("  SoundWave Pool: %d waves, %.2f MB"), SoundWavePool.Num(), Size / MB);
+	}
+}
+
+//--------------------------------
+// アクセント句キャッシュ関連
+//--------------------------------
+
+/**
+ * @brief アクセント句の内容をキャッシュのキーに使う文字列にする
+ */
+FString UVoicevoxCoreSubsystem::GetAccentPhraseKeyText(const FVoicevoxAccentPhrase& AccentPhrase)
+{
+	FString KeyText;
+	FJsonObjectConverter::UStructToJsonObjectString(AccentPhrase, KeyText, 0, 0, 0, nullptr, false);
+	return KeyText;
+}
+
+/**
+ * @brief VOICEVOX COREの音素長の丸め方に合わせて、アクセント句のフレーム数を求める
+ */
+int32 UVoicevoxCoreSubsystem::GetAccentPhraseFrameNum(const FVoicevoxAccentPhrase& AccentPhrase, const float SpeedScale, const bool bEnableInterrogativeUpspeak)
+{
+	// VOICEVOX COREは音素ごとに 長さ * 93.75(24000/256) / 話速 を四捨五入したフレーム数で合成する
+	const auto ToFrameNum = [SpeedScale](const float Length)
+	{
+		return FMath::RoundToInt(Length * 24000.0f / 256.0f / SpeedScale);
+	};
+
+	int32 FrameNum = 0;
+	for (const FVoicevoxMora& Mora : AccentPhrase.Moras)
+	{
+		if (!Mora.Consonant.IsEmpty())
+		{
+			FrameNum += ToFrameNum(Mora.Consonant_length);
+		}
+		FrameNum += ToFrameNum(Mora.Vowel_length);
+	}
+
+	if (FVoicevoxPhoneme::IsPause(AccentPhrase.Pause_mora))
+	{
+		FrameNum += ToFrameNum(AccentPhrase.Pause_mora.Vowel_length);
+	}
+
+	// 疑問文の調整が有効な場合、VOICEVOX COREは末尾に0.15秒のモーラを追加する
+	if (bEnableInterrogativeUpspeak && AccentPhrase.Is_interrogative && !AccentPhrase.Moras.IsEmpty())
+	{
+		FrameNum += ToFrameNum(0.15f);
+	}
+	
+	return FrameNum;
+}
+
+/**
+ * @brief 連続したアクセント句の範囲を前後1句の文脈付きで音声合成し、アクセント句単位に切り出す
+ */
+bool UVoicevoxCoreSubsystem::SynthesisAccentPhraseRange(const FVoicevoxAudioQuery& AudioQuery, const int32 FirstIndex, const int32 LastIndex, const int64 SpeakerId,
+														const bool bEnableInterrogativeUpspeak, TArray<FVoicevoxPhrasePCM>& OutPhrasePCMList) const
+{
+	const int32 PhraseNum = AudioQuery.Accent_phrases.Num();
+	const int32 ContextFirstIndex = FMath::Max(FirstIndex - 1, 0);
+	const int32 ContextLastIndex = FMath::Min(LastIndex + 1, PhraseNum - 1);
+
+	FVoicevoxAudioQuery RangeQuery = AudioQuery;
+	RangeQuery.Accent_phrases = TArray<FVoicevoxAccentPhrase>(AudioQuery.Accent_phrases.GetData() + ContextFirstIndex, ContextLastIndex - ContextFirstIndex + 1);
+
+	// 切り出し位置をAudioQueryから求めるため、キャッシュする音声データは負荷に関わらず品質を下げない
+	const TArray<uint8> OutputWAV = RunSynthesis(RangeQuery, SpeakerId, bEnableInterrogativeUpspeak, EVoicevoxSynthesisPriority::High);
+	if (OutputWAV.IsEmpty()) return false;
+
+	FString ErrorMessage = "";
+	FWaveModInfo WaveInfo;
+	if (!WaveInfo.ReadWaveInfo(OutputWAV.GetData(), OutputWAV.Num(), &ErrorMessage) || *WaveInfo.pBitsPerSample != 16)
+	{
+		UE_LOG(LogVoicevoxCore, Error, TEXT("Phrase Cache Error: %s"), *ErrorMessage);
+		return false;
+	}
+
+	const int32 NumChannels = *WaveInfo.pChannels;
+	const int32 SampleRate = *WaveInfo.pSamplesPerSec;
+	const int16* Samples = reinterpret_cast<const int16*>(WaveInfo.SampleDataStart);
+	const int32 TotalFrameNum = WaveInfo.SampleDataSize / sizeof(int16) / NumChannels;
+	const int32 CrossfadeHalfFrameNum = FMath::RoundToInt(SampleRate * PhraseCrossfadeTime * 0.5f);
+	const auto ToSampleFrame = [SampleRate](const int32 FrameNum)
+	{
+		return static_cast<int32>(static_cast<int64>(FrameNum) * 256 * SampleRate / 24000);
+	};
+
+	// 文脈のアクセント句を含めた各アクセント句の開始位置（VOICEVOX COREのフレーム単位）
+	TArray<int32> BoundaryList;
+	BoundaryList.Reserve(ContextLastIndex - ContextFirstIndex + 2);
+	int32 FrameNum = FMath::RoundToInt(AudioQuery.Pre_phoneme_length * 24000.0f / 256.0f / AudioQuery.Speed_scale);
+	for (int32 Index = ContextFirstIndex; Index <= ContextLastIndex; ++Index)
+	{
+		BoundaryList.Add(FrameNum);
+		FrameNum += GetAccentPhraseFrameNum(AudioQuery.Accent_phrases[Index], AudioQuery.Speed_scale, bEnableInterrogativeUpspeak);
+	}
+	BoundaryList.Add(FrameNum);
+
+	for (int32 Index = FirstIndex; Index <= LastIndex; ++Index)
+	{
+		// 最初と最後のアクセント句は開始無音と終了無音を含める
+		const int32 BoundaryIndex = Index - ContextFirstIndex;
+		const int32 StartFrame = Index == 0 ? 0 : FMath::Clamp(ToSampleFrame(BoundaryList[BoundaryIndex]) - CrossfadeHalfFrameNum, 0, TotalFrameNum);
+		const int32 EndFrame = Index == PhraseNum - 1 ? TotalFrameNum : FMath::Clamp(ToSampleFrame(BoundaryList[BoundaryIndex + 1]) + CrossfadeHalfFrameNum, StartFrame, TotalFrameNum);
+
+		FVoicevoxPhrasePCM& PhrasePCM = OutPhrasePCMList[Index];
+		PhrasePCM.SampleRate = SampleRate;
+		PhrasePCM.NumChannels = NumChannels;
+		PhrasePCM.Samples.Reset();
+		PhrasePCM.Samples.Append(Samples + StartFrame * NumChannels, (EndFrame - StartFrame) * NumChannels);
+	}
+	
+	return true;
+}
+
+/**
+ * @brief 音声データの末尾に、境界を短いクロスフェードで繋いで音声データを追加する
+ */
+void UVoicevoxCoreSubsystem::AppendPhrasePCM(TArray<int16>& Samples, const FVoicevoxPhrasePCM& PhrasePCM, const int32 CrossfadeFrameNum)
+{
+	const int32 NumChannels = PhrasePCM.NumChannels;
+	if (Samples.IsEmpty() || NumChannels <= 0)
+	{
+		Samples.Append(PhrasePCM.Samples);
+		return;
+	}
+
+	const int32 OverlapFrameNum = FMath::Min3(CrossfadeFrameNum, Samples.Num() / NumChannels, PhrasePCM.Samples.Num() / NumChannels);
+	const int32 OverlapStart = Samples.Num() - OverlapFrameNum * NumChannels;
+	for (int32 Frame = 0; Frame < OverlapFrameNum; ++Frame)
+	{
+		const float Alpha = (Frame + 0.5f) / OverlapFrameNum;
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			int16& Sample = Samples[OverlapStart + Frame * NumChannels + Channel];
+			const int16 NextSample = PhrasePCM.Samples[Frame * NumChannels + Channel];
+			Sample = static_cast<int16>(FMath::RoundToInt(FMath::Lerp(static_cast<float>(Sample), static_cast<float>(NextSample), Alpha)));
+		}
+	}
+	Samples.Append(PhrasePCM.Samples.GetData() + OverlapFrameNum * NumChannels, PhrasePCM.Samples.Num() - OverlapFrameNum * NumChannels);
+}
+
+//--------------------------------
+// 定型文関連
+//--------------------------------
+
+/**
+ * @brief 定型文を固定部分と差し込み部分（{名前}）に分割する
+ */
+bool UVoicevoxCoreSubsystem::ParseLineTemplate(const FString& Template, TArray<FVoicevoxTemplatePart>& OutParts)
+{
+	OutParts.Reset();
+	FString FixedText;
+	int32 Index = 0;
+	while (Index < Template.Len())
+	{
+		if (Template[Index] != TEXT('{'))
+		{
+			FixedText.AppendChar(Template[Index++]);
+			continue;
+		}
+
+		const int32 CloseIndex = Template.Find(TEXT("}"), ESearchCase::CaseSensitive, ESearchDir::FromStart, Index + 1);
+		if (CloseIndex == INDEX_NONE) return false;
+
+		if (!FixedText.IsEmpty())
+		{
+			OutParts.Add({MoveTemp(FixedText), false});
+			FixedText.Reset();
+		}
+		OutParts.Add({Template.Mid(Index + 1, CloseIndex - Index - 1).TrimStartAndEnd(), true});
+		Index = CloseIndex + 1;
+	}
+	if (!FixedText.IsEmpty())
+	{
+		OutParts.Add({MoveTemp(FixedText), false});
+	}
+	return true;
+}
+
+/**
+ * @brief 定型文の固定部分をキャッシュから取得する（無い場合は音声合成してキャッシュする）
+ */
+bool UVoicevoxCoreSubsystem::FindOrSynthesisTemplateSegment(const FString& Text, const bool bIsFirst, const bool bIsLast, const int64 SpeakerId,
+															const bool bEnableInterrogativeUpspeak, FVoicevoxTemplateSegment& OutSegment)
+{
+	const FString KeyText = FString::Printf(TEXT("%s|%d|%d|%lld|%d"), *Text, bIsFirst ? 1 : 0, bIsLast ? 1 : 0, SpeakerId, bEnableInterrogativeUpspeak ? 1 : 0);
+	const FTCHARToUTF8 Utf8(*KeyText);
+	const uint64 Key = CityHash64(Utf8.Get(), Utf8.Length());
+	{
+		FScopeLock Lock(&TemplateSegmentCacheCriticalSection);
+		if (const FVoicevoxTemplateSegment* Segment = TemplateSegmentCacheMap.Find(Key))
+		{
+			OutSegment = *Segment;
+			return true;
+		}
+	}
+
+	// 句読点のみ等でアクセント句が無い場合は、音声データの無い部分として扱う
+	OutSegment = FVoicevoxTemplateSegment();
+	OutSegment.AudioQuery = GetAudioQuery(SpeakerId, Text, false);
+	if (!OutSegment.AudioQuery.Accent_phrases.IsEmpty())
+	{
+		if (!bIsFirst)
+		{
+			OutSegment.AudioQuery.Pre_phoneme_length = 0.0f;
+		}
+		if (!bIsLast)
+		{
+			OutSegment.AudioQuery.Post_phoneme_length = 0.0f;
+		}
+		if (!SynthesisTemplateSegment(OutSegment.AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, OutSegment.PCM))
+		{
+			return false;
+		}
+	}
+
+	LLM_SCOPE_BYTAG(Voicevox_Cache);
+	FScopeLock Lock(&TemplateSegmentCacheCriticalSection);
+	if (!TemplateSegmentCacheMap.Contains(Key))
+	{
+		TemplateSegmentCacheMap.Add(Key, OutSegment);
+		TemplateSegmentCacheKeyList.Add(Key);
+	}
+	while (TemplateSegmentCacheKeyList.Num() > TemplateSegmentCacheMaxNum)
+	{
+		TemplateSegmentCacheMap.Remove(TemplateSegmentCacheKeyList[0]);
+		TemplateSegmentCacheKeyList.RemoveAt(0);
+	}
+	return true;
+}
+
+/**
+ * @brief 定型文の部分を音声合成する
+ */
+bool UVoicevoxCoreSubsystem::SynthesisTemplateSegment(const FVoicevoxAudioQuery& AudioQuery, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak, FVoicevoxPhrasePCM& OutPCM) const
+{
+	// 各部分のサンプリングレートとチャンネル数を揃えるため、負荷に関わらず品質を下げない
+	const TArray<uint8> OutputWAV = RunSynthesis(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak, EVoicevoxSynthesisPriority::High);
+	if (OutputWAV.IsEmpty()) return false;
+
+	FString ErrorMessage = "";
+	FWaveModInfo WaveInfo;
+	if (!WaveInfo.ReadWaveInfo(OutputWAV.GetData(), OutputWAV.Num(), &ErrorMessage) || *WaveInfo.pBitsPerSample != 16)
+	{
+		UE_LOG(LogVoicevoxCore, Error, TEXT("Line Template Error: %s"), *ErrorMessage);
+		return false;
+	}
+
+	OutPCM.SampleRate = *WaveInfo.pSamplesPerSec;
+	OutPCM.NumChannels = *WaveInfo.pChannels;
+	OutPCM.Samples.Reset();
+	OutPCM.Samples.Append(reinterpret_cast<const int16*>(WaveInfo.SampleDataStart), WaveInfo.SampleDataSize / sizeof(int16));
+	return true;
+}
+
+/**
+ * @brief 差し込み部分の音高を、前後の部分との境界のモーラの音高へ近づける
+ */
+void UVoicevoxCoreSubsystem::AdjustTemplateSlotPitch(FVoicevoxAudioQuery& SlotAudioQuery, const FVoicevoxAudioQuery* PrevAudioQuery, const FVoicevoxAudioQuery* NextAudioQuery)
+{
+	// 無声化したモーラ（音高0）は調整しない
+	const auto FindBoundaryPitch = [](const FVoicevoxAudioQuery* AudioQuery, const bool bIsLast)
+	{
+		float Pitch = 0.0f;
+		if (AudioQuery == nullptr) return Pitch;
+		for (const FVoicevoxAccentPhrase& AccentPhrase : AudioQuery->Accent_phrases)
+		{
+			for (const FVoicevoxMora& Mora : AccentPhrase.Moras)
+			{
+				if (Mora.Pitch <= 0.0f) continue;
+				Pitch = Mora.Pitch;
+				if (!bIsLast) return Pitch;
+			}
+		}
+		return Pitch;
+	};
+
+	TArray<FVoicevoxMora*> VoicedMoraList;
+	for (FVoicevoxAccentPhrase& AccentPhrase : SlotAudioQuery.Accent_phrases)
+	{
+		for (FVoicevoxMora& Mora : AccentPhrase.Moras)
+		{
+			if (Mora.Pitch > 0.0f)
+			{
+				VoicedMoraList.Add(&Mora);
+			}
+		}
+	}
+	if (VoicedMoraList.IsEmpty()) return;
+
+	const float PrevPitch = FindBoundaryPitch(PrevAudioQuery, true);
+	const float NextPitch = FindBoundaryPitch(NextAudioQuery, false);
+	if (PrevPitch <= 0.0f && NextPitch <= 0.0f) return;
+
+	// 片側にしか部分が無い場合は、その境界の差で全体をずらす
+	float StartOffset = PrevPitch > 0.0f ? PrevPitch - VoicedMoraList[0]->Pitch : 0.0f;
+	float EndOffset = NextPitch > 0.0f ? NextPitch - VoicedMoraList.Last()->Pitch : StartOffset;
+	if (PrevPitch <= 0.0f)
+	{
+		StartOffset = EndOffset;
+	}
+	StartOffset = FMath::Clamp(StartOffset, -TemplateMaxPitchOffset, TemplateMaxPitchOffset);
+	EndOffset = FMath::Clamp(EndOffset, -TemplateMaxPitchOffset, TemplateMaxPitchOffset);
+
+	const int32 VoicedMoraNum = VoicedMoraList.Num();
+	for (int32 Index = 0; Index < VoicedMoraNum; ++Index)
+	{
+		const float Alpha = VoicedMoraNum > 1 ? static_cast<float>(Index) / (VoicedMoraNum - 1) : 0.5f;
+		VoicedMoraList[Index]->Pitch += FMath::Lerp(StartOffset, EndOffset, Alpha);
+	}
+}
+
+//--------------------------------
+// ボイスバンク関連
+//--------------------------------
+
+/**
+ * @brief 既定のボイスバンクファイルパスを取得する
+ */
+FString UVoicevoxCoreSubsystem::GetDefaultVoiceBankPath()
+{
+	return FPaths::Combine(FPaths::ProjectContentDir(), TEXT("Voicevox"), TEXT("VoiceBank.vvbank"));
+}
+
+/**
+ * @brief ボイスバンクファイルを読み込む
+ */
+bool UVoicevoxCoreSubsystem::LoadVoiceBank(const FString& FilePath)
+{
+	LLM_SCOPE_BYTAG(Voicevox_Cache);
+	FWriteScopeLock Lock(VoiceBankLock);
+	if (!VoiceBank.Open(FilePath))
+	{
+		UE_LOG(LogVoicevoxCore, Warning, TEXT("Voice Bank Load Error: %s"), *FilePath);
+		return false;
+	}
+	
+	UE_LOG(LogVoicevoxCore, Log, TEXT("Voice Bank Loaded: %s"), *FilePath);
+	return true;
+}
+
+/**
+ * @brief ボイスバンクファイルを閉じる
+ */
+void UVoicevoxCoreSubsystem::UnloadVoiceBank()
+{
+	FWriteScopeLock Lock(VoiceBankLock);
+	VoiceBank.Close();
+}
+
+/**
+ * @brief ボイスバンクから音声データを検索する
+ */
+bool UVoicevoxCoreSubsystem::FindVoiceBank(const FVoicevoxAudioQuery& AudioQuery, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak, TArray<uint8>& OutputWAV) const
+{
+	FReadScopeLock Lock(VoiceBankLock);
+	if (!VoiceBank.IsOpen()) return false;
+
+	return VoiceBank.Find(FVoicevoxVoiceBank::GetKey(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak), OutputWAV);
+}
+
+//--------------------------------
+// ワーカープール関連
+//--------------------------------
+
+/**
+ * @brief VOICEVOX COREを実行するワーカープロセスを起動する
+ */
+bool UVoicevoxCoreSubsystem::StartWorkerPool(const int32 WorkerNum, const bool bUseGPU, const int32 CPUNumThreads)
+{
+	// ワーカープロセスから更にワーカープロセスを起動しない
+	if (FVoicevoxWorker::IsWorkerProcess()) return false;
+
+	return WorkerPool.Start(WorkerNum, bUseGPU, CPUNumThreads);
+}
+
+/**
+ * @brief 処理中のリクエストの完了を待ち、全てのワーカープロセスを終了する
+ */
+void UVoicevoxCoreSubsystem::StopWorkerPool()
+{
+	WorkerPool.Stop();
+}
+
+/**
+ * @brief ワーカープロセスが起動しているか
+ */
+bool UVoicevoxCoreSubsystem::IsWorkerPoolRunning() const
+{
+	return WorkerPool.IsRunning();
+}
+
+//--------------------------------
+// 音声合成サーバー関連
+//--------------------------------
+
+/**
+ * @brief ループバックアドレスで音声合成サーバーを開始する
+ */
+bool UVoicevoxCoreSubsystem::StartSynthesisServer(const int32 Port)
+{
+	if (!SynthesisServer)
+	{
+		SynthesisServer = MakeUnique<FVoicevoxSynthesisServer>(this);
+	}
+	return SynthesisServer->Start(Port);
+}
+
+/**
+ * @brief 音声合成サーバーを終了する
+ */
+void UVoicevoxCoreSubsystem::StopSynthesisServer()
+{
+	SynthesisServer.Reset();
+}
+
+/**
+ * @brief 音声合成サーバーが接続を待ち受けているか
+ */
+bool UVoicevoxCoreSubsystem::IsSynthesisServerRunning() const
+{
+	return SynthesisServer && SynthesisServer->IsRunning();
+}
+
+//--------------------------------
+// 投機的音声合成関連
+//--------------------------------
+
+/**
+ * @brief 選択肢のテキスト等、次に再生する可能性のある候補テキストを投機的に音声合成する
+ */
+void UVoicevoxCoreSubsystem::SubmitSpeculativeSynthesis(const int64 SpeakerId, const TArray<FString>& MessageList, const bool bKana, const bool bEnableInterrogativeUpspeak)
+{
+	if (SpeculativeSynthesis)
+	{
+		SpeculativeSynthesis->Submit(SpeakerId, MessageList, bKana, bEnableInterrogativeUpspeak);
+	}
+}
+
+/**
+ * @brief 投機的に音声合成している候補を全て破棄する
+ */
+void UVoicevoxCoreSubsystem::CancelSpeculativeSynthesis()
+{
+	if (SpeculativeSynthesis)
+	{
+		SpeculativeSynthesis->Cancel();
+	}
+}
+
+/**
+ * @brief 投機的な音声合成のCPU使用率の予算を設定する
+ */
+void UVoicevoxCoreSubsystem::SetSpeculativeSynthesisCPUBudget(const float CPUBudget)
+{
+	if (SpeculativeSynthesis)
+	{
+		SpeculativeSynthesis->SetCPUBudget(CPUBudget);
+	}
+}
+
+//--------------------------------
+// 推論スレッド数キャリブレーション関連
+//--------------------------------
+
+/**
+ * @brief 推論スレッド数の候補毎に参照用のテキストを音声合成して最適なスレッド数を計測し、このマシンの設定として保存する
+ */
+int32 UVoicevoxCoreSubsystem::CalibrateCPUNumThreads(const int64 SpeakerId, const bool bForce)
+{
+	if (const int32 CalibratedCPUNumThreads = FVoicevoxThreadCalibration::LoadCPUNumThreads(); !bForce && CalibratedCPUNumThreads > 0)
+	{
+		return CalibratedCPUNumThreads;
+	}
+
+	// 計測中はVOICEVOX COREを初期化し直すため、このプロセスでの呼び出しを待機させる
+	FWriteScopeLock CoreLock(NativeCoreLock);
+	if (!bIsInitialized)
+	{
+		UE_LOG(LogVoicevoxCore, Error, TEXT("CalibrateCPUNumThreads Error: VOICEVOX CORE is not initialized"));
+		return 0;
+	}
+
+	// ワーカープロセスではなく、このプロセスのVOICEVOX COREで計測する
+	if (!NativeInstance->LoadModel(SpeakerId))
+	{
+		UE_LOG(LogVoicevoxCore, Error, TEXT("CalibrateCPUNumThreads Error: LoadModel Failed SpeakerId=%lld"), SpeakerId);
+		return 0;
+	}
+	const FVoicevoxAudioQuery AudioQuery = NativeInstance->GetAudioQuery(SpeakerId, TEXT("こんにちは、今日はいい天気ですね。"), false);
+	if (AudioQuery.Accent_phrases.IsEmpty())
+	{
+		UE_LOG(LogVoicevoxCore, Error, TEXT("CalibrateCPUNumThreads Error: GetAudioQuery Failed SpeakerId=%lld"), SpeakerId);
+		return 0;
+	}
+
+	// 候補毎に終了してから初期化し直し、話者リスト等が重複しないようにする
+	const bool bUseGPU = bInitializeUseGPU;
+	const int32 CPUNumThreads = InitializeCPUNumThreads;
+	const bool bLoadAllModels = bInitializeLoadAllModels;
+	const auto InitializeFunction = [this, SpeakerId](const int32 TrialCPUNumThreads)
+	{
+		Finalize();
+		return Initialize(false, TrialCPUNumThreads, false) && NativeInstance->LoadModel(SpeakerId);
+	};
+	TArray<FVoicevoxThreadCalibration::FTrialResult> ResultList;
+	const int32 BestCPUNumThreads = FVoicevoxThreadCalibration::Run(InitializeFunction, [this, &AudioQuery, SpeakerId]
+	{
+		return NativeInstance->RunSynthesis(AudioQuery, SpeakerId, true);
+	}, ResultList);
+
+	if (BestCPUNumThreads > 0)
+	{
+		FVoicevoxThreadCalibration::SaveCPUNumThreads(BestCPUNumThreads);
+		UE_LOG(LogVoicevoxCore, Log, TEXT("CalibrateCPUNumThreads: CPUNumThreads=%d"), BestCPUNumThreads);
+	}
+	else
+	{
+		UE_LOG(LogVoicevoxCore, Error, TEXT("CalibrateCPUNumThreads Error: All trials failed"));
+	}
+
+	// 計測に失敗した場合も、Initializeで指定した設定で初期化し直す（スレッド数が0の場合は計測したスレッド数を使う）
+	Finalize();
+	if (Initialize(bUseGPU, CPUNumThreads, bLoadAllModels))
+	{
+		LLM_SCOPE_BYTAG(Voicevox_Core);
+		FVoicevoxNativeMemoryTracker::FScope MemoryScope(NativeMemoryTracker, SpeakerId);
+		NativeInstance->LoadModel(SpeakerId);
+	}
+	return BestCPUNumThreads;
+}
+
+/**
+ * @brief このマシンで計測済みの推論スレッド数を取得する
+ */
+int32 UVoicevoxCoreSubsystem::GetCalibratedCPUNumThreads()
+{
+	return FVoicevoxThreadCalibration::LoadCPUNumThreads();
+}
+
+//--------------------------------
+// 音声合成のCPU予算関連
+//--------------------------------
+
+/**
+ * @brief 音声合成に割り当てるCPU予算を設定する
+ */
+void UVoicevoxCoreSubsystem::SetSynthesisBudget(const FVoicevoxSynthesisBudget& Budget)
+{
+	SynthesisThrottle.SetBudget(Budget);
+	CompletionQueue.SetMaxCompletionsPerFrame(Budget.MaxCompletionsPerFrame);
+}
+
+/**
+ * @brief 音声合成に割り当てるCPU予算を取得する
+ */
+FVoicevoxSynthesisBudget UVoicevoxCoreSubsystem::GetSynthesisBudget() const
+{
+	return SynthesisThrottle.GetBudget();
+}
+
+/**
+ * @brief 非同期の音声合成の完了処理をゲームスレッドで実行するキューへ積む
+ */
+void UVoicevoxCoreSubsystem::EnqueueGameThreadCompletion(TUniqueFunction<void()>&& Completion) const
+{
+	CompletionQueue.Enqueue(MoveTemp(Completion));
+}
+
+//--------------------------------
+// 負荷に応じた品質調整関連
+//--------------------------------
+
+/**
+ * @brief 音声合成の負荷に応じて品質を調整する設定を変更する
+ */
+void UVoicevoxCoreSubsystem::SetQualityGovernorSettings(const FVoicevoxQualityGovernorSettings& Settings)
+{
+	QualityGovernor.SetSettings(Settings);
+}
+
+/**
+ * @brief 音声合成の負荷に応じて品質を調整する設定を取得する
+ */
+FVoicevoxQualityGovernorSettings UVoicevoxCoreSubsystem::GetQualityGovernorSettings() const
+{
+	return QualityGovernor.GetSettings();
+}
+
+/**
+ * @brief 現在の負荷段階を取得する
+ */
+int32 UVoicevoxCoreSubsystem::GetQualityGovernorLevel() const
+{
+	return QualityGovernor.GetLevel();
+}
+
+//--------------------------------
+// 再生サンプリングレート関連
+//--------------------------------
+
+/**
+ * @brief 再生用に変換するサンプリングレートを設定する
+ */
+void UVoicevoxCoreSubsystem::SetPlaybackSampleRate(const int32 SampleRate)
+{
+	PlaybackSampleRate = FMath::Max(SampleRate, 0);
+}
+
+/**
+ * @brief 再生用に変換するサンプリングレートをメインのオーディオデバイスに合わせる
+ */
+int32 UVoicevoxCoreSubsystem::SetPlaybackSampleRateToAudioDevice()
+{
+	const FAudioDevice* AudioDevice = GEngine->GetMainAudioDeviceRaw();
+	SetPlaybackSampleRate(AudioDevice != nullptr ? static_cast<int32>(AudioDevice->GetSampleRate()) : 0);
+	return PlaybackSampleRate;
+}
+
+/**
+ * @brief 再生用に変換するサンプリングレートを取得する
+ */
+int32 UVoicevoxCoreSubsystem::GetPlaybackSampleRate() const
+{
+	return PlaybackSampleRate;
+}
+
+/**
+ * @brief 音声データを再生用のサンプリングレートへ変換する
+ */
+void UVoicevoxCoreSubsystem::ConvertToPlaybackSampleRate(TArray<uint8>& OutputWAV) const
+{
+	const int32 SampleRate = PlaybackSampleRate;
+	if (SampleRate <= 0 || OutputWAV.IsEmpty()) return;
+
+	if (TArray<uint8> ResampledWAV; FVoicevoxResampler::ResampleWAV(OutputWAV, SampleRate, ResampledWAV))
+	{
+		OutputWAV = MoveTemp(ResampledWAV);
+	}
+}
+
+//--------------------------------
+// SoundWaveプール関連
+//--------------------------------
+
+/**
+ * @brief 再生用のSoundWaveをプールから取得する（空の場合は生成する）
+ */
+UVoicevoxSoundWaveProcedural* UVoicevoxCoreSubsystem::AcquireSoundWave()
+{
+	LLM_SCOPE_BYTAG(Voicevox_SoundWave);
+	if (IsInGameThread())
+	{
+		// オーディオレンダースレッドがまだ読み出している可能性があるものは使わず、読み出しが止まってからキューを破棄する
+		for (int32 Index = 0; Index < SoundWavePool.Num(); ++Index)
+		{
+			if (UVoicevoxSoundWaveProcedural* SoundWave = SoundWavePool[Index]; SoundWave != nullptr && SoundWave->CanReuse(SoundWaveReuseDelay))
+			{
+				SoundWavePool.RemoveAtSwap(Index);
+				SoundWave->ResetForReuse();
+				return SoundWave;
+			}
+		}
+	}
+	return NewObject<UVoicevoxSoundWaveProcedural>(GetTransientPackage(), UVoicevoxSoundWaveProcedural::StaticClass());
+}
+
+/**
+ * @brief 再生が終わったSoundWaveをプールへ返す
+ */
+void UVoicevoxCoreSubsystem::ReleaseSoundWave(UVoicevoxSoundWaveProcedural* SoundWave)
+{
+	if (SoundWave == nullptr || !IsInGameThread() || SoundWavePool.Contains(SoundWave)) return;
+
+	// 停止してもオーディオレンダースレッドが読み出し中の場合があるため、ここではキューを破棄せず、再利用する時に破棄する
+	SoundWave->MarkReleased();
+	if (SoundWavePool.Num() < SoundWavePoolMaxNum)
+	{
+		SoundWavePool.Add(SoundWave);
+	}
+}
+
+//--------------------------------
+// VOICEVOX CORE LipSync関連
+//--------------------------------
+	
+/**
+ * @brief VOICEVOX COREで取得したAudioQuery元に、中品質なLipSyncに必要なデータリストを取得
+ */
+TArray<FVoicevoxLipSync> UVoicevoxCoreSubsystem::GetLipSyncList(const FVoicevoxAudioQuery& AudioQuery, bool bIsSimple, float PitchModulation)
+{
+	// 前後の無音 + モーラ毎に子音と母音 + 句読点の分を先に確保し、以降は音素IDを引くだけの走査にする
+	int32 LipSyncNum = 2;
+	for (const FVoicevoxAccentPhrase& AccentPhrase : AudioQuery.Accent_phrases)
+	{
+		LipSyncNum += AccentPhrase.Moras.Num() * 2 + 1;
+	}
+	
+	TArray<FVoicevoxLipSync> List;
+	List.Reserve(LipSyncNum);
+
+	List.Add({ELipSyncVowelType::Non, AudioQuery.Pre_phoneme_length / AudioQuery.Speed_scale, false, false});
+	
+	for (const FVoicevoxAccentPhrase& AccentPhrase : AudioQuery.Accent_phrases)
+	{
+		for (const FVoicevoxMora& Mora : AccentPhrase.Moras)
+		{
+			const ELipSyncVowelType VowelType = FVoicevoxPhoneme::GetVowelType(FVoicevoxPhoneme::GetVowelId(Mora));
+			if (bIsSimple)
+			{
+				List.Add({VowelType, Mora.Vowel_length / AudioQuery.Speed_scale + Mora.Consonant_length / AudioQuery.Speed_scale });
+			}
+			else
+			{
+				if (!Mora.Consonant.IsEmpty())
+				{
+					const bool IsLabialOrPlosive = FVoicevoxPhoneme::IsLabialOrPlosive(FVoicevoxPhoneme::GetConsonantId(Mora));
+					List.Add({VowelType, Mora.Consonant_length / AudioQuery.Speed_scale, true, IsLabialOrPlosive});
+				}
+				List.Add({VowelType, Mora.Vowel_length / AudioQuery.Speed_scale, false, false});
+			}
+		}
+
+		if (FVoicevoxPhoneme::IsPause(AccentPhrase.Pause_mora))
+		{
+			List.Add({ELipSyncVowelType::Non, AccentPhrase.Pause_mora.Vowel_length / AudioQuery.Speed_scale, false, false});
+		}
+	}
+
+	List.Add({ELipSyncVowelType::Non, AudioQuery.Post_phoneme_length / AudioQuery.Speed_scale, false, false});
+	
+	return List;
+}
+
+/**
+ * @brief 音声データの振幅包絡から、LipSyncに必要なデータリストを取得
+ */
+TArray<FVoicevoxLipSync> UVoicevoxCoreSubsystem::GetLipSyncListFromWAV(const TArray<uint8>& OutputWAV, const bool bIsSimple)
+{
+	return FVoicevoxLipSyncAnalyzer::AnalyzeWAV(OutputWAV, bIsSimple);
+}
+
+/**
+ * @brief AudioQueryのリップシンクをモーフターゲット値のカーブとしてカーブテーブルへベイクする
+ */
+void UVoicevoxCoreSubsystem::BakeLipSyncCurveTable(const FVoicevoxAudioQuery& AudioQuery, UCurveTable* CurveTable)
+{
+	if (CurveTable == nullptr) return;
+
+	// 口の形が切り替わるまでの時間（秒）
+	constexpr float BlendTime = 0.05f;
+	
+	CurveTable->EmptyTable();
+	const UEnum* VowelEnum = StaticEnum<ELipSyncVowelType>();
+	const auto AddCurve = [CurveTable, VowelEnum](const ELipSyncVowelType VowelType) -> FRichCurve&
+	{
+		return CurveTable->AddRichCurve(FName(VowelEnum->GetNameStringByValue(static_cast<int64>(VowelType))));
+	};
+
+	// 通常のリップシンク（あいうえお）
+	{
+		constexpr ELipSyncVowelType VowelList[] = {ELipSyncVowelType::A, ELipSyncVowelType::I, ELipSyncVowelType::U, ELipSyncVowelType::E, ELipSyncVowelType::O};
+		FRichCurve* CurveList[UE_ARRAY_COUNT(VowelList)];
+		for (int32 Index = 0; Index < UE_ARRAY_COUNT(VowelList); ++Index)
+		{
+			CurveList[Index] = &AddCurve(VowelList[Index]);
+			CurveList[Index]->AddKey(0.0f, 0.0f);
+		}
+
+		float Weight[UE_ARRAY_COUNT(VowelList)] = {};
+		float Time = 0.0f;
+		for (const FVoicevoxLipSync& LipSync : GetLipSyncList(AudioQuery, false))
+		{
+			// 口を閉じない子音は直前の口の形を維持する
+			const bool bIsKeep = LipSync.IsConsonant && !LipSync.IsLabialOrPlosive;
+			if (!bIsKeep)
+			{
+				for (int32 Index = 0; Index < UE_ARRAY_COUNT(VowelList); ++Index)
+				{
+					if (LipSync.VowelType == ELipSyncVowelType::CL)
+					{
+						Weight[Index] *= 0.8f * 0.8f;
+					}
+					else
+					{
+						Weight[Index] = !LipSync.IsConsonant && LipSync.VowelType == VowelList[Index] ? 1.0f : 0.0f;
+					}
+				}
+
+				const float KeyTime = Time + FMath::Min(BlendTime, LipSync.Length * 0.5f);
+				for (int32 Index = 0; Index < UE_ARRAY_COUNT(VowelList); ++Index)
+				{
+					CurveList[Index]->UpdateOrAddKey(Time, CurveList[Index]->Eval(Time));
+					CurveList[Index]->UpdateOrAddKey(KeyTime, Weight[Index]);
+				}
+			}
+			Time += LipSync.Length;
+		}
+	}
+
+	// 簡易のリップシンク
+	{
+		FRichCurve& Curve = AddCurve(ELipSyncVowelType::Simple);
+		Curve.AddKey(0.0f, 0.0f);
+		float Time = 0.0f;
+		for (const FVoicevoxLipSync& LipSync : GetLipSyncList(AudioQuery, true))
+		{
+			float Weight = 0.0f;
+			switch (LipSync.VowelType)
+			{
+			case ELipSyncVowelType::A:
+				Weight = 1.0f;
+				break;
+			case ELipSyncVowelType::I:
+				Weight = 0.25f;
+				break;
+			case ELipSyncVowelType::U:
+				Weight = 0.5f;
+				break;
+			case ELipSyncVowelType::E:
+				Weight = 0.45f;
+				break;
+			case ELipSyncVowelType::O:
+				Weight = 0.8f;
+				break;
+			case ELipSyncVowelType::CL:
+				Weight = 0.15f;
+				break;
+			default:
+				break;
+			}
+
+			Curve.UpdateOrAddKey(Time, Curve.Eval(Time));
+			Curve.UpdateOrAddKey(Time + FMath::Min(BlendTime, LipSync.Length * 0.5f), Weight);
+			Time += LipSync.Length;
+		}
+	}
+}
+
+//--------------------------------
+// VOICEVOX CORE 長文関連
+//--------------------------------
+
+/**
+ * @brief 長文テキストを日本語の文末記号（。！？等）と改行で文単位に分割する
+ */
+TArray<FString> UVoicevoxCoreSubsystem::SplitLongText(const FString& Message)
+{
+	TArray<FString> List;
+	FString Sentence;
+	bool bIsTerminated = false;
+
+	const auto AddSentence = [&List](FString& Text)
+	{
+		Text.TrimStartAndEndInline();
+		if (!Text.IsEmpty())
+		{
+			List.Add(Text);
+		}
+		Text.Reset();
+	};
+
+	for (const TCHAR Char : Message)
+	{
+		if (Char == TEXT('\n') || Char == TEXT('\r'))
+		{
+			AddSentence(Sentence);
+			bIsTerminated = false;
+			continue;
+		}
+
+		const bool bIsTerminator = Char == TEXT('。') || Char == TEXT('．') || Char == TEXT('！') || Char == TEXT('？')
+								|| Char == TEXT('!') || Char == TEXT('?');
+		// 「！？」のように文末記号が連続する場合は同じ文に含める
+		if (bIsTerminated && !bIsTerminator)
+		{
+			AddSentence(Sentence);
+		}
+		Sentence.AppendChar(Char);
+		bIsTerminated = bIsTerminator;
+	}
+	AddSentence(Sentence);
+
 	return List;
 }
 
@@ -321,6 +1898,7 @@ TArray<FString> UVoicevoxCoreSubsystem::GetCoreNameList()
  */
 TArray<float> UVoicevoxCoreSubsystem::GetPhonemeLength(int64 Length, TArray<int64> PhonemeList, int64 SpeakerID) const
 {
+	FReadScopeLock CoreLock(NativeCoreLock);
 	return NativeInstance->GetPhonemeLength(Length, PhonemeList,  SpeakerID);
 }
 
@@ -336,6 +1914,7 @@ TArray<float> UVoicevoxCoreSubsystem::FindPitchEachMora(int64 Length, TArray<int
 										  TArray<int64> StartAccentPhraseList, TArray<int64> EndAccentPhraseList,
 										  int64 SpeakerID) const
 {
+	FReadScopeLock CoreLock(NativeCoreLock);
 	return NativeInstance->FindPitchEachMora(Length, VowelPhonemeList,  ConsonantPhonemeList, StartAccentList, EndAccentList, StartAccentPhraseList, EndAccentPhraseList, SpeakerID);
 }
 
@@ -348,5 +1927,6 @@ TArray<float> UVoicevoxCoreSubsystem::FindPitchEachMora(int64 Length, TArray<int
  */
 TArray<float> UVoicevoxCoreSubsystem::DecodeForward(int64 Length, int64 PhonemeSize, TArray<float> F0, TArray<float> Phoneme, int64 SpeakerID) const
 {
+	FReadScopeLock CoreLock(NativeCoreLock);
 	return NativeInstance->DecodeForward(Length, PhonemeSize, F0, Phoneme, SpeakerID);
 }
@@ -7,9 +7,19 @@
 
 #include "Subsystems/VoicevoxNativeCoreSubsystem.h"
 #include "JsonObjectConverter.h"
+#include "VoicevoxRemoteProtocol.h"
 
 DEFINE_LOG_CATEGORY(LogVoicevoxNativeCore);
 
+/**
+ * @brief ShouldCreateSubsystem
+ */
+bool UVoicevoxNativeCoreSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	FString Address;
+	return !FVoicevoxRemoteProtocol::GetServerAddress(Address);
+}
+
 /**
  * @brief VOICEVOXから受信したエラーメッセージを表示
  * @param [in] MessageFormat : エラーメッセージのフォーマット
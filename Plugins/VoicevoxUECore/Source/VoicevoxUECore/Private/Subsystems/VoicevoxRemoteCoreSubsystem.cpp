@@ -0,0 +1,325 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  音声合成サーバーへVOICEVOX COREのAPI呼び出しを転送するSubsystem CPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "Subsystems/VoicevoxRemoteCoreSubsystem.h"
+#include "JsonObjectConverter.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+//--------------------------------
+// override
+//--------------------------------
+
+/**
+ * @brief ShouldCreateSubsystem
+ */
+bool UVoicevoxRemoteCoreSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	FString Address;
+	return FVoicevoxRemoteProtocol::GetServerAddress(Address);
+}
+
+/**
+ * @brief Deinitialize
+ */
+void UVoicevoxRemoteCoreSubsystem::Deinitialize()
+{
+	Super::Deinitialize();
+
+	Disconnect();
+}
+
+//--------------------------------
+// 接続関連
+//--------------------------------
+
+/**
+ * @brief 音声合成サーバーへ接続する
+ */
+bool UVoicevoxRemoteCoreSubsystem::Connect()
+{
+	Disconnect();
+
+	FVoicevoxRemoteProtocol::GetServerAddress(ServerAddress);
+	if (!ServerAddress.Contains(TEXT(":")))
+	{
+		ServerAddress += FString::Printf(TEXT(":%d"), FVoicevoxRemoteProtocol::DefaultPort);
+	}
+
+	FIPv4Endpoint Endpoint;
+	if (!FIPv4Endpoint::FromHostAndPort(ServerAddress, Endpoint))
+	{
+		ShowVoicevoxErrorMessage(FString::Printf(TEXT("VOICEVOX REMOTE Address Error: %s"), *ServerAddress));
+		return false;
+	}
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	Socket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("VoicevoxRemote"), false);
+	if (Socket == nullptr || !Socket->Connect(*Endpoint.ToInternetAddr()))
+	{
+		ShowVoicevoxErrorMessage(FString::Printf(TEXT("VOICEVOX REMOTE Connect Error: %s"), *ServerAddress));
+		Disconnect();
+		return false;
+	}
+
+	Socket->SetNoDelay(true);
+	return true;
+}
+
+/**
+ * @brief 音声合成サーバーとの接続を切断する
+ */
+void UVoicevoxRemoteCoreSubsystem::Disconnect()
+{
+	if (Socket != nullptr)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+}
+
+/**
+ * @brief リクエストを送信し、レスポンスを待つ
+ */
+FVoicevoxRemoteResponse UVoicevoxRemoteCoreSubsystem::SendRequest(FVoicevoxRemoteRequest&& Request)
+{
+	const TSharedPtr<FPendingRequest> PendingRequest = MakeShared<FPendingRequest>();
+	PendingRequest->Request = MoveTemp(Request);
+	TFuture<FVoicevoxRemoteResponse> Future = PendingRequest->Promise.GetFuture();
+
+	bool bIsSender = false;
+	{
+		FScopeLock Lock(&PendingRequestCriticalSection);
+		PendingRequestList.Add(PendingRequest);
+		if (!bIsSending)
+		{
+			bIsSending = true;
+			bIsSender = true;
+		}
+	}
+
+	// 送受信中のスレッドが無ければこのスレッドが送信役となり、送受信中に積まれたリクエストを次のバッチとしてまとめて送る
+	while (bIsSender)
+	{
+		TArray<TSharedPtr<FPendingRequest>> Batch;
+		{
+			FScopeLock Lock(&PendingRequestCriticalSection);
+			if (PendingRequestList.IsEmpty())
+			{
+				bIsSending = false;
+				break;
+			}
+			Batch = MoveTemp(PendingRequestList);
+		}
+
+		TArray<FVoicevoxRemoteResponse> ResponseList;
+		const bool bIsSucceeded = SendBatch(Batch, ResponseList);
+		for (int32 Index = 0; Index < Batch.Num(); ++Index)
+		{
+			Batch[Index]->Promise.SetValue(bIsSucceeded ? MoveTemp(ResponseList[Index]) : FVoicevoxRemoteResponse());
+		}
+	}
+
+	return Future.Get();
+}
+
+/**
+ * @brief バッチを送信し、レスポンスを受信する
+ */
+bool UVoicevoxRemoteCoreSubsystem::SendBatch(const TArray<TSharedPtr<FPendingRequest>>& Batch, TArray<FVoicevoxRemoteResponse>& OutResponseList)
+{
+	// 切断されていた場合は再接続する
+	if (Socket == nullptr && !Connect()) return false;
+
+	TArray<FVoicevoxRemoteRequest> RequestList;
+	RequestList.Reserve(Batch.Num());
+	for (const TSharedPtr<FPendingRequest>& PendingRequest : Batch)
+	{
+		RequestList.Add(PendingRequest->Request);
+	}
+
+	TArray<uint8> Payload;
+	FMemoryWriter Writer(Payload);
+	Writer << RequestList;
+
+	if (!FVoicevoxRemoteProtocol::SendFrame(*Socket, Payload) || !FVoicevoxRemoteProtocol::ReceiveFrame(*Socket, Payload))
+	{
+		UE_LOG(LogVoicevoxNativeCore, Warning, TEXT("VOICEVOX REMOTE Disconnected: %s"), *ServerAddress);
+		Disconnect();
+		return false;
+	}
+
+	FMemoryReader Reader(Payload);
+	Reader << OutResponseList;
+	return !Reader.IsError() && OutResponseList.Num() == Batch.Num();
+}
+
+/**
+ * @brief 圧縮PCMのレスポンスをWAVフォーマットの音声データに戻す
+ */
+TArray<uint8> UVoicevoxRemoteCoreSubsystem::ToWAV(const FVoicevoxRemoteResponse& Response)
+{
+	TArray<uint8> OutputWAV;
+	if (Response.bIsSucceeded)
+	{
+		FVoicevoxRemoteProtocol::DecompressWAV(Response.Data, OutputWAV);
+	}
+	return OutputWAV;
+}
+
+//--------------------------------
+// VOICEVOX CORE API
+//--------------------------------
+
+/**
+ * @brief 音声合成サーバーへ接続し、サーバーのVOICEVOX CORE情報を取得する
+ */
+bool UVoicevoxRemoteCoreSubsystem::CoreInitialize(bool bUseGPU, int CPUNumThreads, bool bLoadAllModels)
+{
+	// VOICEVOX COREの初期化オプションはサーバー側の設定に従う
+	if (!Connect()) return false;
+
+	FVoicevoxRemoteRequest Request;
+	Request.Command = EVoicevoxRemoteCommand::ServerInfo;
+	const FVoicevoxRemoteResponse Response = SendRequest(MoveTemp(Request));
+	if (!Response.bIsSucceeded)
+	{
+		ShowVoicevoxErrorMessage(FString::Printf(TEXT("VOICEVOX REMOTE Server Not Initialized: %s"), *ServerAddress));
+		return false;
+	}
+
+	FMemoryReader Reader(Response.Data);
+	Reader << ServerInfo;
+	bIsInit = !Reader.IsError();
+	return bIsInit;
+}
+
+/**
+ * @brief 音声合成サーバーとの接続を切断する（サーバーのVOICEVOX COREは終了しない）
+ */
+void UVoicevoxRemoteCoreSubsystem::Finalize()
+{
+	Disconnect();
+	bIsInit = false;
+}
+
+/**
+ * @brief 音声合成サーバーでモデルをロードする
+ */
+bool UVoicevoxRemoteCoreSubsystem::LoadModel(const int64 SpeakerId)
+{
+	FVoicevoxRemoteRequest Request;
+	Request.Command = EVoicevoxRemoteCommand::LoadModel;
+	Request.SpeakerId = SpeakerId;
+	return SendRequest(MoveTemp(Request)).bIsSucceeded;
+}
+
+/**
+ * @brief 音声合成サーバーでAudioQueryを取得する
+ */
+FVoicevoxAudioQuery UVoicevoxRemoteCoreSubsystem::GetAudioQuery(const int64 SpeakerId, const FString& Message, const bool bKana)
+{
+	FVoicevoxRemoteRequest Request;
+	Request.Command = EVoicevoxRemoteCommand::AudioQuery;
+	Request.SpeakerId = SpeakerId;
+	Request.bKana = bKana;
+	Request.Text = Message;
+
+	FVoicevoxAudioQuery AudioQuery;
+	if (const FVoicevoxRemoteResponse Response = SendRequest(MoveTemp(Request)); Response.bIsSucceeded)
+	{
+		FString AudioQueryJson;
+		FMemoryReader Reader(Response.Data);
+		Reader << AudioQueryJson;
+		FJsonObjectConverter::JsonObjectStringToUStruct(AudioQueryJson, &AudioQuery, 0, 0);
+	}
+	return AudioQuery;
+}
+
+/**
+ * @brief 音声合成サーバーでtext to speechを実行する
+ */
+TArray<uint8> UVoicevoxRemoteCoreSubsystem::RunTextToSpeech(const int64 SpeakerId, const FString& Message, const bool bKana, const bool bEnableInterrogativeUpspeak)
+{
+	FVoicevoxRemoteRequest Request;
+	Request.Command = EVoicevoxRemoteCommand::TextToSpeech;
+	Request.SpeakerId = SpeakerId;
+	Request.bKana = bKana;
+	Request.bEnableInterrogativeUpspeak = bEnableInterrogativeUpspeak;
+	Request.Text = Message;
+	return ToWAV(SendRequest(MoveTemp(Request)));
+}
+
+/**
+ * @brief 音声合成サーバーで音声合成する
+ */
+TArray<uint8> UVoicevoxRemoteCoreSubsystem::RunSynthesis(const char* AudioQueryJson, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak)
+{
+	FVoicevoxRemoteRequest Request;
+	Request.Command = EVoicevoxRemoteCommand::Synthesis;
+	Request.SpeakerId = SpeakerId;
+	Request.bEnableInterrogativeUpspeak = bEnableInterrogativeUpspeak;
+	Request.Text = UTF8_TO_TCHAR(AudioQueryJson);
+	return ToWAV(SendRequest(MoveTemp(Request)));
+}
+
+/**
+ * @brief 音声合成サーバーで音声合成する
+ */
+TArray<uint8> UVoicevoxRemoteCoreSubsystem::RunSynthesis(const FVoicevoxAudioQuery& AudioQueryJson, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak)
+{
+	FVoicevoxRemoteRequest Request;
+	Request.Command = EVoicevoxRemoteCommand::Synthesis;
+	Request.SpeakerId = SpeakerId;
+	Request.bEnableInterrogativeUpspeak = bEnableInterrogativeUpspeak;
+	FJsonObjectConverter::UStructToJsonObjectString(AudioQueryJson, Request.Text, 0, 0, 0, nullptr, false);
+	return ToWAV(SendRequest(MoveTemp(Request)));
+}
+
+/**
+ * @brief 音声合成サーバーの話者名や話者IDのリストを取得する
+ */
+TArray<FVoicevoxMeta> UVoicevoxRemoteCoreSubsystem::GetMetaList()
+{
+	return ServerInfo.MetaList;
+}
+
+/**
+ * @brief 音声合成サーバーのサポートデバイス情報を取得する
+ */
+FVoicevoxSupportedDevices UVoicevoxRemoteCoreSubsystem::GetSupportedDevices()
+{
+	return ServerInfo.SupportedDevices;
+}
+
+/**
+ * @brief 音声合成サーバーのVOICEVOX COREのバージョンを取得する
+ */
+FString UVoicevoxRemoteCoreSubsystem::GetVoicevoxVersion()
+{
+	return ServerInfo.Version;
+}
+
+/**
+ * @brief 音声合成サーバーがGPUモードか判定する
+ */
+bool UVoicevoxRemoteCoreSubsystem::IsGpuMode()
+{
+	return ServerInfo.bIsGpuMode;
+}
+
+/**
+ * @brief VOICEVOX CORE名取得
+ */
+FString UVoicevoxRemoteCoreSubsystem::GetVoicevoxCoreName()
+{
+	return TEXT("REMOTE");
+}
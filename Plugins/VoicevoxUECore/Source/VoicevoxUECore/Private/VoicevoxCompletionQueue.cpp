@@ -0,0 +1,59 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  非同期の音声合成の完了処理をゲームスレッドでまとめて実行するキューのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxCompletionQueue.h"
+#include "Misc/CoreDelegates.h"
+
+/**
+ * @brief 毎フレームの完了処理の実行を開始する
+ */
+void FVoicevoxCompletionQueue::Start()
+{
+	if (!BeginFrameHandle.IsValid())
+	{
+		BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddRaw(this, &FVoicevoxCompletionQueue::OnBeginFrame);
+	}
+}
+
+/**
+ * @brief 毎フレームの完了処理の実行を終了し、未実行の完了処理を破棄する
+ */
+void FVoicevoxCompletionQueue::Stop()
+{
+	if (BeginFrameHandle.IsValid())
+	{
+		FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+		BeginFrameHandle.Reset();
+	}
+	Queue.Empty();
+	PendingNum = 0;
+}
+
+/**
+ * @brief 完了処理を積む（任意のスレッドから呼び出せる）
+ */
+void FVoicevoxCompletionQueue::Enqueue(TUniqueFunction<void()>&& Completion)
+{
+	++PendingNum;
+	Queue.Enqueue(MoveTemp(Completion));
+}
+
+/**
+ * @brief フレーム開始時に積まれた完了処理を実行する
+ */
+void FVoicevoxCompletionQueue::OnBeginFrame()
+{
+	// 完了処理の中で積まれた完了処理は次のフレームで実行する
+	const int32 MaxNum = MaxCompletionsPerFrame.load();
+	const int32 Num = MaxNum > 0 ? FMath::Min(MaxNum, PendingNum.load()) : PendingNum.load();
+	TUniqueFunction<void()> Completion;
+	for (int32 Count = 0; Count < Num && Queue.Dequeue(Completion); ++Count)
+	{
+		--PendingNum;
+		Completion();
+	}
+}
@@ -0,0 +1,303 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  最近再生したセリフの音声データをADPCMで圧縮してメモリに保持するキャッシュのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxLineCache.h"
+#include "Audio.h"
+
+namespace
+{
+	//! 量子化幅のテーブル
+	constexpr int16 StepTable[89] =
+	{
+		7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+		50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+		337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+		2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+		15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+	};
+
+	//! 符号化した値による量子化幅の増減
+	constexpr int8 IndexTable[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+	//! チャンネル毎のブロックヘッダーのサイズ（先頭サンプル2バイト、量子化幅の番号1バイト、予約1バイト）
+	constexpr int32 BlockHeaderSize = 4;
+
+	/**
+	 * @brief 符号化した値から予測値と量子化幅の番号を更新する（圧縮と展開で同じ計算を行う）
+	 */
+	void DecodeNibble(const uint8 Nibble, int32& Predictor, int32& StepIndex)
+	{
+		const int32 Step = StepTable[StepIndex];
+		int32 Delta = Step >> 3;
+		if (Nibble & 4) Delta += Step;
+		if (Nibble & 2) Delta += Step >> 1;
+		if (Nibble & 1) Delta += Step >> 2;
+		Predictor = FMath::Clamp(Predictor + ((Nibble & 8) ? -Delta : Delta), -32768, 32767);
+		StepIndex = FMath::Clamp(StepIndex + IndexTable[Nibble & 7], 0, 88);
+	}
+
+	/**
+	 * @brief 予測値との差分を4bitに符号化する
+	 */
+	uint8 EncodeNibble(const int32 Sample, int32& Predictor, int32& StepIndex)
+	{
+		int32 Diff = Sample - Predictor;
+		uint8 Nibble = 0;
+		if (Diff < 0)
+		{
+			Nibble = 8;
+			Diff = -Diff;
+		}
+
+		int32 Step = StepTable[StepIndex];
+		for (uint8 Bit = 4; Bit > 0; Bit >>= 1)
+		{
+			if (Diff >= Step)
+			{
+				Nibble |= Bit;
+				Diff -= Step;
+			}
+			Step >>= 1;
+		}
+
+		DecodeNibble(Nibble, Predictor, StepIndex);
+		return Nibble;
+	}
+
+	/**
+	 * @brief チャンネル1つ分のブロックのサイズを求める（先頭サンプルはヘッダーに格納する）
+	 */
+	int32 GetChannelBlockSize(const int32 FrameNum)
+	{
+		return BlockHeaderSize + FrameNum / 2;
+	}
+}
+
+/**
+ * @brief メモリ予算を設定する（超えた分は古いセリフから破棄する）
+ */
+void FVoicevoxLineCache::SetMemoryBudget(const int64 InMemoryBudget)
+{
+	FScopeLock Lock(&CriticalSection);
+	MemoryBudget = FMath::Max<int64>(0, InMemoryBudget);
+	Trim();
+}
+
+/**
+ * @brief メモリ予算を取得する
+ */
+int64 FVoicevoxLineCache::GetMemoryBudget() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return MemoryBudget;
+}
+
+/**
+ * @brief 保持しているセリフの使用メモリを取得する
+ */
+int64 FVoicevoxLineCache::GetMemoryUsage() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return MemoryUsage;
+}
+
+/**
+ * @brief 保持しているセリフ数を取得する
+ */
+int32 FVoicevoxLineCache::GetLineNum() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return LineMap.Num();
+}
+
+/**
+ * @brief 音声データを圧縮して保持する
+ */
+void FVoicevoxLineCache::Add(const uint64 Key, const TArray<uint8>& OutputWAV)
+{
+	{
+		FScopeLock Lock(&CriticalSection);
+		if (MemoryBudget <= 0 || LineMap.Contains(Key)) return;
+	}
+
+	FWaveModInfo WaveInfo;
+	if (!WaveInfo.ReadWaveInfo(OutputWAV.GetData(), OutputWAV.Num()) || *WaveInfo.pBitsPerSample != 16 || *WaveInfo.pChannels <= 0) return;
+
+	// 圧縮はロックの外で行う
+	FLine Line;
+	Line.SampleRate = *WaveInfo.pSamplesPerSec;
+	Line.NumChannels = *WaveInfo.pChannels;
+	const TArrayView<const int16> Samples(reinterpret_cast<const int16*>(WaveInfo.SampleDataStart), WaveInfo.SampleDataSize / static_cast<int32>(sizeof(int16)));
+	Line.NumFrames = Samples.Num() / Line.NumChannels;
+	if (Line.NumFrames <= 0) return;
+	Encode(Samples, Line.NumChannels, Line.Data);
+
+	const int64 LineMemory = GetLineMemory(Line);
+	FScopeLock Lock(&CriticalSection);
+	if (LineMemory > MemoryBudget || LineMap.Contains(Key)) return;
+
+	LineMap.Add(Key, MoveTemp(Line));
+	KeyList.Add(Key);
+	MemoryUsage += LineMemory;
+	Trim();
+}
+
+/**
+ * @brief 保持している音声データを展開する
+ */
+bool FVoicevoxLineCache::Find(const uint64 Key, TArray<uint8>& OutputWAV)
+{
+	TArray<uint8> Data;
+	int32 SampleRate = 0;
+	int32 NumChannels = 0;
+	int32 NumFrames = 0;
+	{
+		FScopeLock Lock(&CriticalSection);
+		const FLine* Line = LineMap.Find(Key);
+		if (Line == nullptr) return false;
+
+		Data = Line->Data;
+		SampleRate = Line->SampleRate;
+		NumChannels = Line->NumChannels;
+		NumFrames = Line->NumFrames;
+
+		// 最後に使用したセリフとして末尾へ移動する
+		KeyList.Remove(Key);
+		KeyList.Add(Key);
+	}
+
+	// 展開はロックの外で行う
+	TArray<int16> Samples;
+	Decode(Data, NumChannels, NumFrames, Samples);
+	OutputWAV.Reset();
+	SerializeWaveFile(OutputWAV, reinterpret_cast<const uint8*>(Samples.GetData()), Samples.Num() * sizeof(int16), NumChannels, SampleRate);
+	return true;
+}
+
+/**
+ * @brief 保持している全てのセリフを破棄する
+ */
+void FVoicevoxLineCache::Empty()
+{
+	FScopeLock Lock(&CriticalSection);
+	LineMap.Empty();
+	KeyList.Empty();
+	MemoryUsage = 0;
+}
+
+/**
+ * @brief 16bit PCMをIMA ADPCMへ圧縮する
+ */
+void FVoicevoxLineCache::Encode(const TArrayView<const int16> Samples, const int32 NumChannels, TArray<uint8>& OutData)
+{
+	OutData.Reset();
+	if (NumChannels <= 0) return;
+
+	const int32 NumFrames = Samples.Num() / NumChannels;
+	int32 DataSize = 0;
+	for (int32 FirstFrame = 0; FirstFrame < NumFrames; FirstFrame += BlockFrameNum)
+	{
+		DataSize += GetChannelBlockSize(FMath::Min(BlockFrameNum, NumFrames - FirstFrame)) * NumChannels;
+	}
+	OutData.SetNumZeroed(DataSize);
+
+	uint8* Output = OutData.GetData();
+	for (int32 FirstFrame = 0; FirstFrame < NumFrames; FirstFrame += BlockFrameNum)
+	{
+		const int32 FrameNum = FMath::Min(BlockFrameNum, NumFrames - FirstFrame);
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			// ブロックの先頭サンプルをそのまま格納し、予測値の初期値とする
+			int32 Predictor = Samples[FirstFrame * NumChannels + Channel];
+			int32 StepIndex = 0;
+			if (FrameNum > 1)
+			{
+				// 先頭の差分に合わせて量子化幅の初期値を選ぶ
+				const int32 FirstDiff = FMath::Abs(Samples[(FirstFrame + 1) * NumChannels + Channel] - Predictor);
+				while (StepIndex < 88 && StepTable[StepIndex] < FirstDiff)
+				{
+					++StepIndex;
+				}
+			}
+			Output[0] = static_cast<uint8>(Predictor & 0xFF);
+			Output[1] = static_cast<uint8>((Predictor >> 8) & 0xFF);
+			Output[2] = static_cast<uint8>(StepIndex);
+			Output[3] = 0;
+
+			uint8* Nibbles = Output + BlockHeaderSize;
+			for (int32 Frame = 1; Frame < FrameNum; ++Frame)
+			{
+				const uint8 Nibble = EncodeNibble(Samples[(FirstFrame + Frame) * NumChannels + Channel], Predictor, StepIndex);
+				const int32 NibbleIndex = Frame - 1;
+				Nibbles[NibbleIndex / 2] |= (NibbleIndex & 1) ? Nibble << 4 : Nibble;
+			}
+			Output += GetChannelBlockSize(FrameNum);
+		}
+	}
+}
+
+/**
+ * @brief IMA ADPCMを16bit PCMへ展開する
+ */
+void FVoicevoxLineCache::Decode(const TArrayView<const uint8> Data, const int32 NumChannels, const int32 NumFrames, TArray<int16>& OutSamples)
+{
+	OutSamples.Reset();
+	if (NumChannels <= 0 || NumFrames <= 0) return;
+	OutSamples.SetNumZeroed(NumFrames * NumChannels);
+
+	const uint8* Input = Data.GetData();
+	const uint8* InputEnd = Input + Data.Num();
+	for (int32 FirstFrame = 0; FirstFrame < NumFrames; FirstFrame += BlockFrameNum)
+	{
+		const int32 FrameNum = FMath::Min(BlockFrameNum, NumFrames - FirstFrame);
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			// 圧縮データが足りない場合は無音のままにする
+			if (Input + GetChannelBlockSize(FrameNum) > InputEnd) return;
+
+			int32 Predictor = static_cast<int16>(Input[0] | (Input[1] << 8));
+			int32 StepIndex = FMath::Clamp<int32>(Input[2], 0, 88);
+			OutSamples[FirstFrame * NumChannels + Channel] = static_cast<int16>(Predictor);
+
+			const uint8* Nibbles = Input + BlockHeaderSize;
+			for (int32 Frame = 1; Frame < FrameNum; ++Frame)
+			{
+				const int32 NibbleIndex = Frame - 1;
+				const uint8 Nibble = (NibbleIndex & 1) ? Nibbles[NibbleIndex / 2] >> 4 : Nibbles[NibbleIndex / 2] & 0x0F;
+				DecodeNibble(Nibble, Predictor, StepIndex);
+				OutSamples[(FirstFrame + Frame) * NumChannels + Channel] = static_cast<int16>(Predictor);
+			}
+			Input += GetChannelBlockSize(FrameNum);
+		}
+	}
+}
+
+/**
+ * @brief メモリ予算を超えた分を古いセリフから破棄する（CriticalSectionをロックして呼び出す）
+ */
+void FVoicevoxLineCache::Trim()
+{
+	int32 RemoveNum = 0;
+	while (MemoryUsage > MemoryBudget && RemoveNum < KeyList.Num())
+	{
+		if (const FLine* Line = LineMap.Find(KeyList[RemoveNum]))
+		{
+			MemoryUsage -= GetLineMemory(*Line);
+			LineMap.Remove(KeyList[RemoveNum]);
+		}
+		++RemoveNum;
+	}
+	KeyList.RemoveAt(0, RemoveNum);
+}
+
+/**
+ * @brief セリフ1つ分の使用メモリを求める
+ */
+int64 FVoicevoxLineCache::GetLineMemory(const FLine& Line)
+{
+	return Line.Data.GetAllocatedSize() + sizeof(FLine) + sizeof(uint64);
+}
@@ -0,0 +1,146 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  音声データの振幅包絡からリップシンクのデータリストを生成する解析クラスのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxLipSyncAnalyzer.h"
+#include "Audio.h"
+
+/**
+ * @brief PCMからリップシンクのデータリストを生成する
+ */
+TArray<FVoicevoxLipSync> FVoicevoxLipSyncAnalyzer::Analyze(const TArrayView<const int16> Samples, const int32 NumChannels, const int32 SampleRate, const bool bIsSimple)
+{
+	TArray<FVoicevoxLipSync> List;
+	if (NumChannels <= 0 || SampleRate <= 0) return List;
+
+	const int32 FrameSampleNum = FMath::Max(FMath::RoundToInt(SampleRate * FrameTime), 4) & ~3;
+	const int32 SampleNum = Samples.Num() / NumChannels;
+	const int32 FrameNum = SampleNum / FrameSampleNum;
+	if (FrameNum == 0) return List;
+	const float FrameLength = static_cast<float>(FrameSampleNum) / SampleRate;
+
+	// モノラルのfloat列へ変換し、フレーム毎のRMSとゼロ交差率を求める
+	TArray<float> Mono;
+	Mono.SetNumUninitialized(FrameNum * FrameSampleNum + 1);
+	Mono[0] = 0.0f;
+	const float ChannelScale = 1.0f / (NumChannels * 32768.0f);
+	for (int32 Index = 0; Index < FrameNum * FrameSampleNum; ++Index)
+	{
+		int32 Sum = 0;
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			Sum += Samples[Index * NumChannels + Channel];
+		}
+		Mono[Index + 1] = Sum * ChannelScale;
+	}
+
+	TArray<float> RmsList;
+	TArray<float> ZeroCrossingList;
+	RmsList.SetNumUninitialized(FrameNum);
+	ZeroCrossingList.SetNumUninitialized(FrameNum);
+	float PeakRms = 0.0f;
+	const VectorRegister4Float Zero = VectorZeroFloat();
+	for (int32 Frame = 0; Frame < FrameNum; ++Frame)
+	{
+		const float* Current = Mono.GetData() + Frame * FrameSampleNum + 1;
+		VectorRegister4Float SquareSum = VectorZeroFloat();
+		int32 CrossingNum = 0;
+		for (int32 Index = 0; Index < FrameSampleNum; Index += 4)
+		{
+			const VectorRegister4Float Value = VectorLoad(Current + Index);
+			const VectorRegister4Float Prev = VectorLoad(Current + Index - 1);
+			SquareSum = VectorMultiplyAdd(Value, Value, SquareSum);
+			// 隣り合うサンプルの積が負であれば符号が変わっている
+			CrossingNum += FMath::CountBits(static_cast<uint64>(VectorMaskBits(VectorCompareLT(VectorMultiply(Value, Prev), Zero))));
+		}
+		alignas(16) float Lane[4];
+		VectorStoreAligned(SquareSum, Lane);
+		RmsList[Frame] = FMath::Sqrt((Lane[0] + Lane[1] + Lane[2] + Lane[3]) / FrameSampleNum);
+		ZeroCrossingList[Frame] = static_cast<float>(CrossingNum) / FrameSampleNum;
+		PeakRms = FMath::Max(PeakRms, RmsList[Frame]);
+	}
+
+	// フレーム毎に口の形を分類する
+	TArray<FVoicevoxLipSync> FrameList;
+	FrameList.SetNumUninitialized(FrameNum);
+	for (int32 Frame = 0; Frame < FrameNum; ++Frame)
+	{
+		const float Level = PeakRms > 0.0f && RmsList[Frame] > 0.0f ? 20.0f * FMath::LogX(10.0f, RmsList[Frame] / PeakRms) : SilenceThreshold;
+		const float ZeroCrossingRate = ZeroCrossingList[Frame];
+		FVoicevoxLipSync& LipSync = FrameList[Frame];
+		LipSync = {ELipSyncVowelType::Non, FrameLength, false, false};
+		if (Level <= SilenceThreshold) continue;
+
+		if (!bIsSimple && Level < ConsonantThreshold && ZeroCrossingRate >= ConsonantZeroCrossingRate)
+		{
+			LipSync.IsConsonant = true;
+			continue;
+		}
+
+		const float Openness = FMath::Clamp((Level - SilenceThreshold) / -SilenceThreshold, 0.0f, 1.0f);
+		const bool bIsFront = ZeroCrossingRate * SampleRate >= FrontVowelZeroCrossingNum;
+		if (bIsSimple || Openness >= 0.75f)
+		{
+			LipSync.VowelType = ELipSyncVowelType::A;
+		}
+		else if (Openness >= 0.45f)
+		{
+			LipSync.VowelType = bIsFront ? ELipSyncVowelType::E : ELipSyncVowelType::O;
+		}
+		else
+		{
+			LipSync.VowelType = bIsFront ? ELipSyncVowelType::I : ELipSyncVowelType::U;
+		}
+	}
+
+	// 子音は後に続く母音の口の形で発音する
+	ELipSyncVowelType NextVowel = ELipSyncVowelType::Non;
+	for (int32 Frame = FrameNum - 1; Frame >= 0; --Frame)
+	{
+		if (FrameList[Frame].IsConsonant)
+		{
+			FrameList[Frame].VowelType = NextVowel;
+		}
+		else
+		{
+			NextVowel = FrameList[Frame].VowelType;
+		}
+	}
+
+	// 同じ口の形が続くフレームを1つの区間にまとめ、短すぎる区間は直前の区間へまとめる
+	for (const FVoicevoxLipSync& LipSync : FrameList)
+	{
+		if (!List.IsEmpty())
+		{
+			FVoicevoxLipSync& Last = List.Last();
+			if ((Last.VowelType == LipSync.VowelType && Last.IsConsonant == LipSync.IsConsonant) || Last.Length < MinSegmentTime)
+			{
+				Last.Length += LipSync.Length;
+				continue;
+			}
+		}
+		List.Add(LipSync);
+	}
+
+	// フレームに満たない末尾のサンプルは無音として補う
+	if (const float Remain = static_cast<float>(SampleNum - FrameNum * FrameSampleNum) / SampleRate; Remain > 0.0f)
+	{
+		List.Add({ELipSyncVowelType::Non, Remain, false, false});
+	}
+	return List;
+}
+
+/**
+ * @brief WAVデータからリップシンクのデータリストを生成する
+ */
+TArray<FVoicevoxLipSync> FVoicevoxLipSyncAnalyzer::AnalyzeWAV(const TArray<uint8>& OutputWAV, const bool bIsSimple)
+{
+	FWaveModInfo WaveInfo;
+	if (!WaveInfo.ReadWaveInfo(OutputWAV.GetData(), OutputWAV.Num()) || *WaveInfo.pBitsPerSample != 16) return TArray<FVoicevoxLipSync>();
+
+	const TArrayView<const int16> Samples(reinterpret_cast<const int16*>(WaveInfo.SampleDataStart), WaveInfo.SampleDataSize / sizeof(int16));
+	return Analyze(Samples, *WaveInfo.pChannels, *WaveInfo.pSamplesPerSec, bIsSimple);
+}
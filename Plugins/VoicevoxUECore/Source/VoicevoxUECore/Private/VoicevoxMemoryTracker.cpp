@@ -0,0 +1,133 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  VOICEVOXのLLM（Low Level Memory Tracker）タグと、VOICEVOX COREのネイティブメモリを計測するクラスのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxMemoryTracker.h"
+#include "HAL/LowLevelMemStats.h"
+#include "Stats/Stats.h"
+
+//------------------------------------------------------------------------
+// LLM tag
+//------------------------------------------------------------------------
+
+DECLARE_LLM_MEMORY_STAT(TEXT("Voicevox"), STAT_VoicevoxLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Voicevox"), STAT_VoicevoxSummaryLLM, STATGROUP_LLM);
+DECLARE_LLM_MEMORY_STAT(TEXT("Voicevox Core"), STAT_VoicevoxCoreLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Voicevox AudioQuery"), STAT_VoicevoxAudioQueryLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Voicevox PCM"), STAT_VoicevoxPCMLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Voicevox Cache"), STAT_VoicevoxCacheLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Voicevox SoundWave"), STAT_VoicevoxSoundWaveLLM, STATGROUP_LLMFULL);
+
+// stat LLMFULLではタグ毎、stat LLMではVoicevoxにまとめて表示する
+LLM_DEFINE_TAG(Voicevox, NAME_None, NAME_None, GET_STATFNAME(STAT_VoicevoxLLM), GET_STATFNAME(STAT_VoicevoxSummaryLLM));
+LLM_DEFINE_TAG(Voicevox_Core, NAME_None, TEXT("Voicevox"), GET_STATFNAME(STAT_VoicevoxCoreLLM), GET_STATFNAME(STAT_VoicevoxSummaryLLM));
+LLM_DEFINE_TAG(Voicevox_AudioQuery, NAME_None, TEXT("Voicevox"), GET_STATFNAME(STAT_VoicevoxAudioQueryLLM), GET_STATFNAME(STAT_VoicevoxSummaryLLM));
+LLM_DEFINE_TAG(Voicevox_PCM, NAME_None, TEXT("Voicevox"), GET_STATFNAME(STAT_VoicevoxPCMLLM), GET_STATFNAME(STAT_VoicevoxSummaryLLM));
+LLM_DEFINE_TAG(Voicevox_Cache, NAME_None, TEXT("Voicevox"), GET_STATFNAME(STAT_VoicevoxCacheLLM), GET_STATFNAME(STAT_VoicevoxSummaryLLM));
+LLM_DEFINE_TAG(Voicevox_SoundWave, NAME_None, TEXT("Voicevox"), GET_STATFNAME(STAT_VoicevoxSoundWaveLLM), GET_STATFNAME(STAT_VoicevoxSummaryLLM));
+
+//------------------------------------------------------------------------
+// stat
+//------------------------------------------------------------------------
+
+DECLARE_STATS_GROUP(TEXT("Voicevox"), STATGROUP_Voicevox, STATCAT_Advanced);
+DECLARE_MEMORY_STAT(TEXT("Native Core"), STAT_VoicevoxNativeCoreMemory, STATGROUP_Voicevox);
+DECLARE_MEMORY_STAT(TEXT("Native Models"), STAT_VoicevoxNativeModelMemory, STATGROUP_Voicevox);
+
+/**
+ * @brief コンストラクタ
+ */
+FVoicevoxNativeMemoryTracker::FScope::FScope(FVoicevoxNativeMemoryTracker& InTracker, const int64 InSpeakerId)
+	: Tracker(InTracker)
+	, Lock(&InTracker.CriticalSection)
+	, SpeakerId(InSpeakerId)
+	, StartUsedPhysical(FPlatformMemory::GetStats().UsedPhysical)
+{
+}
+
+/**
+ * @brief デストラクタ（常駐メモリの増加量を記録する）
+ */
+FVoicevoxNativeMemoryTracker::FScope::~FScope()
+{
+	// 解放された分が多い場合は増加無しとして扱う
+	const uint64 EndUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	Tracker.Record(SpeakerId, EndUsedPhysical > StartUsedPhysical ? static_cast<int64>(EndUsedPhysical - StartUsedPhysical) : 0);
+}
+
+/**
+ * @brief VOICEVOX COREの初期化で増加した常駐メモリを取得する
+ */
+int64 FVoicevoxNativeMemoryTracker::GetCoreMemory() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return CoreMemory;
+}
+
+/**
+ * @brief モデルのロードで増加した常駐メモリの合計を取得する
+ */
+int64 FVoicevoxNativeMemoryTracker::GetModelMemory() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return ModelMemory;
+}
+
+/**
+ * @brief 話者毎のモデルのロードで増加した常駐メモリを取得する
+ */
+TMap<int64, int64> FVoicevoxNativeMemoryTracker::GetModelMemoryMap() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return ModelMemoryMap;
+}
+
+/**
+ * @brief 記録した使用メモリを破棄する（VOICEVOX COREの終了時に呼び出す）
+ */
+void FVoicevoxNativeMemoryTracker::Reset()
+{
+	FScopeLock Lock(&CriticalSection);
+	UpdateLLM(-(CoreMemory + ModelMemory));
+	CoreMemory = 0;
+	ModelMemory = 0;
+	ModelMemoryMap.Empty();
+	SET_MEMORY_STAT(STAT_VoicevoxNativeCoreMemory, 0);
+	SET_MEMORY_STAT(STAT_VoicevoxNativeModelMemory, 0);
+}
+
+/**
+ * @brief 常駐メモリの増加量を記録し、LLMとstatに計上する（CriticalSectionをロックして呼び出す）
+ */
+void FVoicevoxNativeMemoryTracker::Record(const int64 InSpeakerId, const int64 DeltaMemory)
+{
+	if (DeltaMemory <= 0) return;
+
+	if (InSpeakerId == INDEX_NONE)
+	{
+		CoreMemory += DeltaMemory;
+		SET_MEMORY_STAT(STAT_VoicevoxNativeCoreMemory, CoreMemory);
+	}
+	else
+	{
+		ModelMemoryMap.FindOrAdd(InSpeakerId) += DeltaMemory;
+		ModelMemory += DeltaMemory;
+		SET_MEMORY_STAT(STAT_VoicevoxNativeModelMemory, ModelMemory);
+	}
+	UpdateLLM(DeltaMemory);
+}
+
+/**
+ * @brief LLMのVoicevox/Coreタグの値を更新する（CriticalSectionをロックして呼び出す）
+ */
+void FVoicevoxNativeMemoryTracker::UpdateLLM(const int64 DeltaMemory) const
+{
+	if (DeltaMemory == 0) return;
+
+	// UEのアロケーターを通さないメモリのため、LLMのUntrackedからVoicevox/Coreへ付け替える
+	LLM_SCOPE_BYTAG(Voicevox_Core);
+	LLM(FLowLevelMemTracker::Get().OnLowLevelChangeInMemoryUse(ELLMTracker::Default, DeltaMemory));
+}
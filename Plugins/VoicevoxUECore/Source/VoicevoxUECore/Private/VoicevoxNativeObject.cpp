@@ -24,6 +24,12 @@ void UVoicevoxNativeObject::Init()
 #endif
 	const UClass* BaseType = UVoicevoxNativeCoreSubsystem::StaticClass();
 	GetDerivedClasses(BaseType, SubsystemClasses, true);
+
+	// ShouldCreateSubsystemで生成されなかったSubsystemは対象外にする
+	SubsystemClasses.RemoveAll([this](UClass* Element)
+	{
+		return VoicevoxSubsystemCollection.GetSubsystem(Element) == nullptr;
+	});
 }
 
 /**
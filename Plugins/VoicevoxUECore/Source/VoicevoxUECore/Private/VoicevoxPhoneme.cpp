@@ -0,0 +1,177 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  AudioQueryの子音、母音を音素IDとして扱うための音素テーブルのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxPhoneme.h"
+
+namespace
+{
+	/**
+	 * @struct FPhonemeInfo
+	 * @brief 音素テーブル1件分の情報
+	 */
+	struct FPhonemeInfo
+	{
+		//! 音素名
+		const TCHAR* Name;
+
+		//! リップシンク用の母音
+		ELipSyncVowelType VowelType;
+
+		//! 口唇音、もしくは破裂音か
+		bool bIsLabialOrPlosive;
+	};
+
+	//! VOICEVOXの音素テーブル（添字が音素ID、0番は子音なし）
+	const FPhonemeInfo PhonemeTable[] =
+	{
+		{ TEXT(""),		ELipSyncVowelType::Non,	false },
+		// 母音
+		{ TEXT("a"),	ELipSyncVowelType::A,	false },
+		{ TEXT("i"),	ELipSyncVowelType::I,	false },
+		{ TEXT("u"),	ELipSyncVowelType::U,	false },
+		{ TEXT("e"),	ELipSyncVowelType::E,	false },
+		{ TEXT("o"),	ELipSyncVowelType::O,	false },
+		// 無声化母音
+		{ TEXT("A"),	ELipSyncVowelType::A,	false },
+		{ TEXT("I"),	ELipSyncVowelType::I,	false },
+		{ TEXT("U"),	ELipSyncVowelType::U,	false },
+		{ TEXT("E"),	ELipSyncVowelType::E,	false },
+		{ TEXT("O"),	ELipSyncVowelType::O,	false },
+		// 撥音、促音、句読点
+		{ TEXT("N"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("cl"),	ELipSyncVowelType::CL,	false },
+		{ TEXT("pau"),	ELipSyncVowelType::Non,	false },
+		// 子音
+		{ TEXT("b"),	ELipSyncVowelType::Non,	true },
+		{ TEXT("by"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("ch"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("d"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("dy"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("f"),	ELipSyncVowelType::Non,	true },
+		{ TEXT("g"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("gw"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("gy"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("h"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("hy"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("j"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("k"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("kw"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("ky"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("m"),	ELipSyncVowelType::Non,	true },
+		{ TEXT("my"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("n"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("ny"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("p"),	ELipSyncVowelType::Non,	true },
+		{ TEXT("py"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("r"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("ry"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("s"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("sh"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("t"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("ts"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("ty"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("v"),	ELipSyncVowelType::Non,	true },
+		{ TEXT("w"),	ELipSyncVowelType::Non,	true },
+		{ TEXT("y"),	ELipSyncVowelType::Non,	false },
+		{ TEXT("z"),	ELipSyncVowelType::Non,	false },
+	};
+
+	//! 句読点の音素ID
+	constexpr uint8 PauseId = 13;
+
+	/**
+	 * @brief 音素IDが文字列と一致していればそのまま、一致しなければ音素テーブルから引き直す
+	 */
+	uint8 ResolveId(const uint8 PhonemeId, const FString& Phoneme)
+	{
+		return FCString::Strcmp(FVoicevoxPhoneme::GetName(PhonemeId), *Phoneme) == 0 ? PhonemeId : FVoicevoxPhoneme::FindId(Phoneme);
+	}
+}
+
+/**
+ * @brief 音素名から音素IDを取得する
+ */
+uint8 FVoicevoxPhoneme::FindId(const FString& Phoneme)
+{
+	for (int32 Index = 1; Index < UE_ARRAY_COUNT(PhonemeTable); ++Index)
+	{
+		if (FCString::Strcmp(PhonemeTable[Index].Name, *Phoneme) == 0) return static_cast<uint8>(Index);
+	}
+	return NoneId;
+}
+
+/**
+ * @brief 音素IDから音素名を取得する
+ */
+const TCHAR* FVoicevoxPhoneme::GetName(const uint8 PhonemeId)
+{
+	return PhonemeId < UE_ARRAY_COUNT(PhonemeTable) ? PhonemeTable[PhonemeId].Name : PhonemeTable[NoneId].Name;
+}
+
+/**
+ * @brief モーラの子音、母音の音素IDを設定する
+ */
+void FVoicevoxPhoneme::InternMora(FVoicevoxMora& Mora)
+{
+	Mora.ConsonantId = FindId(Mora.Consonant);
+	Mora.VowelId = FindId(Mora.Vowel);
+}
+
+/**
+ * @brief AudioQueryの全モーラ（句読点モーラを含む）の音素IDを設定する
+ */
+void FVoicevoxPhoneme::InternAudioQuery(FVoicevoxAudioQuery& AudioQuery)
+{
+	for (FVoicevoxAccentPhrase& AccentPhrase : AudioQuery.Accent_phrases)
+	{
+		for (FVoicevoxMora& Mora : AccentPhrase.Moras)
+		{
+			InternMora(Mora);
+		}
+		InternMora(AccentPhrase.Pause_mora);
+	}
+}
+
+/**
+ * @brief モーラの子音の音素IDを取得する
+ */
+uint8 FVoicevoxPhoneme::GetConsonantId(const FVoicevoxMora& Mora)
+{
+	return ResolveId(Mora.ConsonantId, Mora.Consonant);
+}
+
+/**
+ * @brief モーラの母音の音素IDを取得する
+ */
+uint8 FVoicevoxPhoneme::GetVowelId(const FVoicevoxMora& Mora)
+{
+	return ResolveId(Mora.VowelId, Mora.Vowel);
+}
+
+/**
+ * @brief 音素IDに対応するリップシンク用の母音を取得する
+ */
+ELipSyncVowelType FVoicevoxPhoneme::GetVowelType(const uint8 PhonemeId)
+{
+	return PhonemeId < UE_ARRAY_COUNT(PhonemeTable) ? PhonemeTable[PhonemeId].VowelType : ELipSyncVowelType::Non;
+}
+
+/**
+ * @brief 音素IDが口唇音、もしくは破裂音（口を閉じて発音する子音）か判定する
+ */
+bool FVoicevoxPhoneme::IsLabialOrPlosive(const uint8 PhonemeId)
+{
+	return PhonemeId < UE_ARRAY_COUNT(PhonemeTable) && PhonemeTable[PhonemeId].bIsLabialOrPlosive;
+}
+
+/**
+ * @brief モーラが句読点の無音か判定する
+ */
+bool FVoicevoxPhoneme::IsPause(const FVoicevoxMora& Mora)
+{
+	return GetVowelId(Mora) == PauseId;
+}
@@ -0,0 +1,174 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  音声合成の負荷に応じてAudioQueryの品質を調整するクラスのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxQualityGovernor.h"
+#include "VoicevoxPhoneme.h"
+
+namespace
+{
+	//! 実時間比の平滑化係数
+	constexpr double RealTimeFactorSmoothing = 0.2;
+}
+
+/**
+ * @brief 設定を変更する
+ */
+void FVoicevoxQualityGovernor::SetSettings(const FVoicevoxQualityGovernorSettings& InSettings)
+{
+	FScopeLock Lock(&CriticalSection);
+	Settings = InSettings;
+	Settings.QueueDepthThreshold = FMath::Max(1, Settings.QueueDepthThreshold);
+	Settings.RealTimeFactorThreshold = FMath::Max(0.01f, Settings.RealTimeFactorThreshold);
+	Settings.ReducedSamplingRate = FMath::Max(8000, Settings.ReducedSamplingRate);
+	Settings.PauseScale = FMath::Clamp(Settings.PauseScale, 0.0f, 1.0f);
+	Settings.RestoreDelay = FMath::Max(0.0f, Settings.RestoreDelay);
+	if (!Settings.bEnabled)
+	{
+		Level = 0;
+		LowLoadStartTime = 0.0;
+	}
+}
+
+/**
+ * @brief 設定を取得する
+ */
+FVoicevoxQualityGovernorSettings FVoicevoxQualityGovernor::GetSettings() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return Settings;
+}
+
+/**
+ * @brief 現在の負荷に応じて品質を下げたAudioQueryを作成する
+ */
+bool FVoicevoxQualityGovernor::Apply(const FVoicevoxAudioQuery& AudioQuery, const EVoicevoxSynthesisPriority Priority, const int32 QueueDepth, FVoicevoxAudioQuery& OutAudioQuery)
+{
+	int32 Severity = 0;
+	float PauseScale = 1.0f;
+	int32 ReducedSamplingRate = 0;
+	{
+		FScopeLock Lock(&CriticalSection);
+		if (!Settings.bEnabled) return false;
+
+		UpdateLevel(QueueDepth);
+		switch (Priority)
+		{
+		case EVoicevoxSynthesisPriority::Low:		Severity = Level;		break;
+		case EVoicevoxSynthesisPriority::Normal:	Severity = Level - 1;	break;
+		default:									Severity = 0;			break;
+		}
+		PauseScale = Settings.PauseScale;
+		ReducedSamplingRate = Settings.ReducedSamplingRate;
+	}
+	if (Severity <= 0) return false;
+
+	OutAudioQuery = AudioQuery;
+
+	// 無音を短くし、モノラルにする
+	OutAudioQuery.Pre_phoneme_length *= PauseScale;
+	OutAudioQuery.Post_phoneme_length *= PauseScale;
+	for (FVoicevoxAccentPhrase& AccentPhrase : OutAudioQuery.Accent_phrases)
+	{
+		if (FVoicevoxPhoneme::IsPause(AccentPhrase.Pause_mora))
+		{
+			AccentPhrase.Pause_mora.Vowel_length *= PauseScale;
+		}
+	}
+	OutAudioQuery.Output_stereo = false;
+
+	// 出力サンプリングレートを下げる
+	if (Severity >= 2)
+	{
+		OutAudioQuery.Output_sampling_rate = FMath::Min(OutAudioQuery.Output_sampling_rate, ReducedSamplingRate);
+	}
+	return true;
+}
+
+/**
+ * @brief 音声合成1回分の実時間比を記録する
+ */
+void FVoicevoxQualityGovernor::Record(const double SynthesisTime, const FVoicevoxAudioQuery& AudioQuery)
+{
+	const double Duration = GetAudioQueryDuration(AudioQuery);
+	if (Duration <= 0.0) return;
+
+	const double SampleRealTimeFactor = SynthesisTime / Duration;
+	FScopeLock Lock(&CriticalSection);
+	RealTimeFactor = RealTimeFactor <= 0.0 ? SampleRealTimeFactor : FMath::Lerp(RealTimeFactor, SampleRealTimeFactor, RealTimeFactorSmoothing);
+}
+
+/**
+ * @brief 現在の負荷段階を取得する
+ */
+int32 FVoicevoxQualityGovernor::GetLevel() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return Level;
+}
+
+/**
+ * @brief 平滑化した実時間比を取得する
+ */
+double FVoicevoxQualityGovernor::GetRealTimeFactor() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return RealTimeFactor;
+}
+
+/**
+ * @brief AudioQueryから音声の長さを求める
+ */
+double FVoicevoxQualityGovernor::GetAudioQueryDuration(const FVoicevoxAudioQuery& AudioQuery)
+{
+	double Duration = AudioQuery.Pre_phoneme_length + AudioQuery.Post_phoneme_length;
+	for (const FVoicevoxAccentPhrase& AccentPhrase : AudioQuery.Accent_phrases)
+	{
+		for (const FVoicevoxMora& Mora : AccentPhrase.Moras)
+		{
+			Duration += Mora.Consonant_length + Mora.Vowel_length;
+		}
+		Duration += AccentPhrase.Pause_mora.Consonant_length + AccentPhrase.Pause_mora.Vowel_length;
+	}
+	return AudioQuery.Speed_scale > 0.0f ? Duration / AudioQuery.Speed_scale : Duration;
+}
+
+/**
+ * @brief 待機中の音声合成数と実時間比から負荷段階を更新する（CriticalSectionをロックして呼び出す）
+ */
+void FVoicevoxQualityGovernor::UpdateLevel(const int32 QueueDepth)
+{
+	int32 TargetLevel = 0;
+	for (int32 Index = 0; Index < MaxLevel; ++Index)
+	{
+		// 段階毎の閾値（待機数は1倍、2倍、4倍、実時間比は1倍、1.5倍、2倍）
+		const int32 DepthThreshold = Settings.QueueDepthThreshold << Index;
+		const double RealTimeFactorThreshold = Settings.RealTimeFactorThreshold * (1.0 + 0.5 * Index);
+		if (QueueDepth >= DepthThreshold || RealTimeFactor >= RealTimeFactorThreshold)
+		{
+			TargetLevel = Index + 1;
+		}
+	}
+
+	// 負荷が上がった場合はすぐに品質を下げ、下がった場合は一定時間続いてから1段階ずつ戻す
+	if (TargetLevel >= Level)
+	{
+		Level = TargetLevel;
+		LowLoadStartTime = 0.0;
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	if (LowLoadStartTime <= 0.0)
+	{
+		LowLoadStartTime = Now;
+	}
+	else if (Now - LowLoadStartTime >= Settings.RestoreDelay)
+	{
+		--Level;
+		LowLoadStartTime = Level > TargetLevel ? Now : 0.0;
+	}
+}
@@ -0,0 +1,246 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  Voicevoxで生成されるクエリ情報のシリアライズを行うCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxQuery.h"
+#include "VoicevoxPhoneme.h"
+#include "VoicevoxVoiceBank.h"
+#include "Serialization/CustomVersion.h"
+#include "Subsystems/VoicevoxCoreSubsystem.h"
+
+const FGuid FVoicevoxQueryCustomVersion::GUID(0xFE7DC4E5, 0x2A704E8A, 0xB1B9B01A, 0x6868175B);
+
+// カスタムバージョンの登録
+static FCustomVersionRegistration GRegisterVoicevoxQueryCustomVersion(FVoicevoxQueryCustomVersion::GUID, FVoicevoxQueryCustomVersion::LatestVersion, TEXT("VoicevoxQueryVer"));
+
+/**
+ * @brief Serialize
+ */
+void UVoicevoxQuery::Serialize(FArchive& Ar)
+{
+	Ar.UsingCustomVersion(FVoicevoxQueryCustomVersion::GUID);
+
+	// パッケージの保存、読み込みのみバイナリ形式とし、Undo/Redo等のトランザクションはタグ付きプロパティのままにする
+	const bool bIsCompact = Ar.IsPersistent() && !Ar.IsTextFormat() && !Ar.IsTransacting()
+		&& Ar.CustomVer(FVoicevoxQueryCustomVersion::GUID) >= FVoicevoxQueryCustomVersion::CompactAudioQuery;
+
+	// 保存時はAudioQueryを一時的に空にして、タグ付きプロパティとしては書き出されないようにする
+	FVoicevoxAudioQuery SavingAudioQuery{};
+	if (bIsCompact && Ar.IsSaving())
+	{
+		Swap(SavingAudioQuery, VoicevoxAudioQuery);
+	}
+
+	Super::Serialize(Ar);
+
+	if (bIsCompact)
+	{
+		if (Ar.IsSaving())
+		{
+			Swap(SavingAudioQuery, VoicevoxAudioQuery);
+		}
+		SerializeCompactAudioQuery(Ar);
+	}
+	else if (Ar.IsLoading())
+	{
+		FVoicevoxPhoneme::InternAudioQuery(VoicevoxAudioQuery);
+	}
+}
+
+/**
+ * @brief ベイク済みのリップシンクカーブの照合に使うAudioQueryのキーを求める
+ */
+uint64 UVoicevoxQuery::GetLipSyncCurveTableKey() const
+{
+	return FVoicevoxVoiceBank::GetKey(VoicevoxAudioQuery, 0, false);
+}
+
+/**
+ * @brief ベイク済みのリップシンクカーブがAudioQueryと一致するかを求め直す
+ */
+void UVoicevoxQuery::UpdateLipSyncCurveTableValidity()
+{
+	bIsLipSyncCurveTableValid = LipSyncCurveTable != nullptr && LipSyncCurveTableKey == GetLipSyncCurveTableKey();
+}
+
+/**
+ * @brief AudioQueryと一致するベイク済みのリップシンクカーブを取得する
+ */
+UCurveTable* UVoicevoxQuery::GetValidLipSyncCurveTable() const
+{
+	if (LipSyncCurveTable == nullptr) return nullptr;
+
+	if (!bIsLipSyncCurveTableValid)
+	{
+		UE_LOG(LogVoicevoxCore, Warning, TEXT("Lip Sync Curve Table is out of date. Bake Lip Sync Curves again: %s"), *GetPathName());
+		return nullptr;
+	}
+	return LipSyncCurveTable;
+}
+
+/**
+ * @brief PostLoad
+ */
+void UVoicevoxQuery::PostLoad()
+{
+	Super::PostLoad();
+
+	UpdateLipSyncCurveTableValidity();
+}
+
+#if WITH_EDITOR
+/**
+ * @brief PostEditChangeProperty
+ */
+void UVoicevoxQuery::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// 詳細パネルで子音、母音が書き換えられた場合に音素IDを設定し直す
+	FVoicevoxPhoneme::InternAudioQuery(VoicevoxAudioQuery);
+
+	UpdateLipSyncCurveTableValidity();
+}
+#endif
+
+/**
+ * @brief VoicevoxAudioQueryをバイナリ形式でシリアライズする
+ */
+void UVoicevoxQuery::SerializeCompactAudioQuery(FArchive& Ar)
+{
+	// 音素文字列のテーブル（モーラのカナ、子音、母音はこのテーブルのIDで保存する）
+	TArray<FString> PhonemeTable;
+	// アクセント句毎のモーラ数、アクセント場所、疑問文フラグ
+	TArray<int32> MoraNumList;
+	TArray<int32> AccentList;
+	TArray<uint8> InterrogativeList;
+	// 全モーラ（各アクセント句のモーラの後に句読点モーラが続く）の音素IDと長さ、イントネーション
+	TArray<uint16> TextIdList;
+	TArray<uint16> ConsonantIdList;
+	TArray<uint16> VowelIdList;
+	TArray<float> ConsonantLengthList;
+	TArray<float> VowelLengthList;
+	TArray<float> PitchList;
+
+	if (Ar.IsSaving())
+	{
+		TMap<FString, uint16> PhonemeIdMap;
+		auto InternPhoneme = [&PhonemeTable, &PhonemeIdMap](const FString& Phoneme)
+		{
+			if (const uint16* PhonemeId = PhonemeIdMap.Find(Phoneme)) return *PhonemeId;
+			const uint16 PhonemeId = static_cast<uint16>(PhonemeTable.Add(Phoneme));
+			PhonemeIdMap.Add(Phoneme, PhonemeId);
+			return PhonemeId;
+		};
+		auto AddMora = [&](const FVoicevoxMora& Mora)
+		{
+			TextIdList.Add(InternPhoneme(Mora.Text));
+			ConsonantIdList.Add(InternPhoneme(Mora.Consonant));
+			VowelIdList.Add(InternPhoneme(Mora.Vowel));
+			ConsonantLengthList.Add(Mora.Consonant_length);
+			VowelLengthList.Add(Mora.Vowel_length);
+			PitchList.Add(Mora.Pitch);
+		};
+
+		for (const FVoicevoxAccentPhrase& AccentPhrase : VoicevoxAudioQuery.Accent_phrases)
+		{
+			MoraNumList.Add(AccentPhrase.Moras.Num());
+			AccentList.Add(AccentPhrase.Accent);
+			InterrogativeList.Add(AccentPhrase.Is_interrogative ? 1 : 0);
+			for (const FVoicevoxMora& Mora : AccentPhrase.Moras)
+			{
+				AddMora(Mora);
+			}
+			AddMora(AccentPhrase.Pause_mora);
+		}
+	}
+
+	Ar << PhonemeTable;
+	Ar << MoraNumList;
+	Ar << AccentList;
+	Ar << InterrogativeList;
+	TextIdList.BulkSerialize(Ar);
+	ConsonantIdList.BulkSerialize(Ar);
+	VowelIdList.BulkSerialize(Ar);
+	ConsonantLengthList.BulkSerialize(Ar);
+	VowelLengthList.BulkSerialize(Ar);
+	PitchList.BulkSerialize(Ar);
+
+	Ar << VoicevoxAudioQuery.Speed_scale;
+	Ar << VoicevoxAudioQuery.Pitch_scale;
+	Ar << VoicevoxAudioQuery.Intonation_scale;
+	Ar << VoicevoxAudioQuery.Volume_scale;
+	Ar << VoicevoxAudioQuery.Pre_phoneme_length;
+	Ar << VoicevoxAudioQuery.Post_phoneme_length;
+	Ar << VoicevoxAudioQuery.Output_sampling_rate;
+	Ar << VoicevoxAudioQuery.Output_stereo;
+	Ar << VoicevoxAudioQuery.Kana;
+
+	if (!Ar.IsLoading() || Ar.IsError()) return;
+
+	// 配列の長さと音素IDの範囲を検証してから復元する
+	const int32 PhraseNum = MoraNumList.Num();
+	int64 TotalMoraNum = PhraseNum;
+	bool bIsValid = AccentList.Num() == PhraseNum && InterrogativeList.Num() == PhraseNum;
+	for (const int32 MoraNum : MoraNumList)
+	{
+		bIsValid &= MoraNum >= 0;
+		TotalMoraNum += MoraNum;
+	}
+	for (const TArray<uint16>* IdList : { &TextIdList, &ConsonantIdList, &VowelIdList })
+	{
+		bIsValid &= IdList->Num() == TotalMoraNum;
+		for (const uint16 PhonemeId : *IdList)
+		{
+			bIsValid &= PhonemeTable.IsValidIndex(PhonemeId);
+		}
+	}
+	bIsValid &= ConsonantLengthList.Num() == TotalMoraNum && VowelLengthList.Num() == TotalMoraNum && PitchList.Num() == TotalMoraNum;
+
+	if (!bIsValid)
+	{
+		UE_LOG(LogVoicevoxCore, Error, TEXT("VoicevoxQuery Serialize Error: Corrupted AudioQuery data in %s"), *GetPathName());
+		Ar.SetError();
+		VoicevoxAudioQuery.Accent_phrases.Empty();
+		return;
+	}
+
+	// 音素文字列のテーブルの各エントリーに対応する音素IDは1度だけ引く
+	TArray<uint8> InternedIdList;
+	InternedIdList.Reserve(PhonemeTable.Num());
+	for (const FString& Phoneme : PhonemeTable)
+	{
+		InternedIdList.Add(FVoicevoxPhoneme::FindId(Phoneme));
+	}
+
+	int32 MoraIndex = 0;
+	auto ReadMora = [&](FVoicevoxMora& Mora)
+	{
+		Mora.Text = PhonemeTable[TextIdList[MoraIndex]];
+		Mora.Consonant = PhonemeTable[ConsonantIdList[MoraIndex]];
+		Mora.Vowel = PhonemeTable[VowelIdList[MoraIndex]];
+		Mora.ConsonantId = InternedIdList[ConsonantIdList[MoraIndex]];
+		Mora.VowelId = InternedIdList[VowelIdList[MoraIndex]];
+		Mora.Consonant_length = ConsonantLengthList[MoraIndex];
+		Mora.Vowel_length = VowelLengthList[MoraIndex];
+		Mora.Pitch = PitchList[MoraIndex];
+		++MoraIndex;
+	};
+
+	VoicevoxAudioQuery.Accent_phrases.SetNum(PhraseNum);
+	for (int32 PhraseIndex = 0; PhraseIndex < PhraseNum; ++PhraseIndex)
+	{
+		FVoicevoxAccentPhrase& AccentPhrase = VoicevoxAudioQuery.Accent_phrases[PhraseIndex];
+		AccentPhrase.Accent = AccentList[PhraseIndex];
+		AccentPhrase.Is_interrogative = InterrogativeList[PhraseIndex] != 0;
+		AccentPhrase.Moras.SetNum(MoraNumList[PhraseIndex]);
+		for (FVoicevoxMora& Mora : AccentPhrase.Moras)
+		{
+			ReadMora(Mora);
+		}
+		ReadMora(AccentPhrase.Pause_mora);
+	}
+}
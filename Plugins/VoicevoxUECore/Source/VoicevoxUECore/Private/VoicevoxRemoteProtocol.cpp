@@ -0,0 +1,242 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  音声合成サーバーとクライアント間の通信プロトコルのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxRemoteProtocol.h"
+#include "Audio.h"
+#include "VoicevoxWorkerPool.h"
+#include "Sockets.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Compression.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+	//! 受信待ちで中断フラグを確認する間隔
+	const FTimespan ReceiveWaitTime = FTimespan::FromMilliseconds(100);
+
+	/**
+	 * @brief 指定サイズを全て送信する
+	 */
+	bool SendBytes(FSocket& Socket, const uint8* Data, const int32 Size)
+	{
+		int32 SentSize = 0;
+		while (SentSize < Size)
+		{
+			int32 BytesSent = 0;
+			if (!Socket.Send(Data + SentSize, Size - SentSize, BytesSent)) return false;
+			SentSize += BytesSent;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 指定サイズを全て受信する
+	 */
+	bool ReceiveBytes(FSocket& Socket, uint8* Data, const int32 Size, const std::atomic<bool>* bAbort)
+	{
+		int32 ReadSize = 0;
+		while (ReadSize < Size)
+		{
+			if (bAbort != nullptr && bAbort->load()) return false;
+			if (!Socket.Wait(ESocketWaitConditions::WaitForRead, ReceiveWaitTime))
+			{
+				if (Socket.GetConnectionState() == SCS_ConnectionError) return false;
+				continue;
+			}
+
+			int32 BytesRead = 0;
+			if (!Socket.Recv(Data + ReadSize, Size - ReadSize, BytesRead) || BytesRead <= 0) return false;
+			ReadSize += BytesRead;
+		}
+		return true;
+	}
+}
+
+//----------------------------------------------------------------
+// シリアライズ
+//----------------------------------------------------------------
+
+/**
+ * @brief リクエストのシリアライズ
+ */
+FArchive& operator<<(FArchive& Ar, FVoicevoxRemoteRequest& Request)
+{
+	Ar << Request.Command;
+	Ar << Request.SpeakerId;
+	Ar << Request.bKana;
+	Ar << Request.bEnableInterrogativeUpspeak;
+	Ar << Request.Text;
+	return Ar;
+}
+
+/**
+ * @brief レスポンスのシリアライズ
+ */
+FArchive& operator<<(FArchive& Ar, FVoicevoxRemoteResponse& Response)
+{
+	Ar << Response.bIsSucceeded;
+	Ar << Response.Data;
+	return Ar;
+}
+
+/**
+ * @brief サーバー情報のシリアライズ
+ */
+FArchive& operator<<(FArchive& Ar, FVoicevoxRemoteServerInfo& ServerInfo)
+{
+	int32 MetaNum = ServerInfo.MetaList.Num();
+	Ar << MetaNum;
+	if (Ar.IsLoading())
+	{
+		ServerInfo.MetaList.SetNum(MetaNum);
+	}
+	for (FVoicevoxMeta& Meta : ServerInfo.MetaList)
+	{
+		Ar << Meta.Name;
+		Ar << Meta.Speaker_uuid;
+		Ar << Meta.Version;
+
+		int32 StyleNum = Meta.Styles.Num();
+		Ar << StyleNum;
+		if (Ar.IsLoading())
+		{
+			Meta.Styles.SetNum(StyleNum);
+		}
+		for (FVoicevoxStyle& Style : Meta.Styles)
+		{
+			Ar << Style.Name;
+			Ar << Style.Id;
+		}
+	}
+
+	Ar << ServerInfo.SupportedDevices.Cpu;
+	Ar << ServerInfo.SupportedDevices.Cuda;
+	Ar << ServerInfo.SupportedDevices.Dml;
+	Ar << ServerInfo.Version;
+	Ar << ServerInfo.bIsGpuMode;
+	return Ar;
+}
+
+//----------------------------------------------------------------
+// FVoicevoxRemoteProtocol
+//----------------------------------------------------------------
+
+/**
+ * @brief フレームを送信する
+ */
+bool FVoicevoxRemoteProtocol::SendFrame(FSocket& Socket, const TArrayView<const uint8> Payload)
+{
+	const uint32 Header[2] = { FrameMagic, static_cast<uint32>(Payload.Num()) };
+	return SendBytes(Socket, reinterpret_cast<const uint8*>(Header), sizeof(Header))
+		&& SendBytes(Socket, Payload.GetData(), Payload.Num());
+}
+
+/**
+ * @brief フレームを受信する
+ */
+bool FVoicevoxRemoteProtocol::ReceiveFrame(FSocket& Socket, TArray<uint8>& OutPayload, const std::atomic<bool>* bAbort)
+{
+	uint32 Header[2] = {};
+	if (!ReceiveBytes(Socket, reinterpret_cast<uint8*>(Header), sizeof(Header), bAbort)) return false;
+	if (Header[0] != FrameMagic || Header[1] > MaxFrameSize) return false;
+
+	OutPayload.SetNumUninitialized(Header[1]);
+	return ReceiveBytes(Socket, OutPayload.GetData(), OutPayload.Num(), bAbort);
+}
+
+/**
+ * @brief WAVフォーマットの音声データを圧縮PCMに変換する
+ */
+bool FVoicevoxRemoteProtocol::CompressWAV(const TArray<uint8>& OutputWAV, TArray<uint8>& OutCompressed)
+{
+	FString ErrorMessage;
+	FWaveModInfo WaveInfo;
+	if (!WaveInfo.ReadWaveInfo(OutputWAV.GetData(), OutputWAV.Num(), &ErrorMessage) || *WaveInfo.pBitsPerSample != 16) return false;
+
+	int32 SampleRate = static_cast<int32>(*WaveInfo.pSamplesPerSec);
+	int32 NumChannels = *WaveInfo.pChannels;
+	int32 SampleNum = WaveInfo.SampleDataSize / sizeof(int16);
+	const int16* Samples = reinterpret_cast<const int16*>(WaveInfo.SampleDataStart);
+
+	// 同じチャンネルの直前のサンプルとの差分をジグザグ符号化し、下位/上位バイトを別々に並べて圧縮しやすくする
+	TArray<uint8> Planes;
+	Planes.SetNumUninitialized(SampleNum * 2);
+	for (int32 Index = 0; Index < SampleNum; ++Index)
+	{
+		const int16 Delta = static_cast<int16>(Samples[Index] - (Index >= NumChannels ? Samples[Index - NumChannels] : 0));
+		const uint16 ZigZag = static_cast<uint16>((Delta << 1) ^ (Delta >> 15));
+		Planes[Index] = static_cast<uint8>(ZigZag & 0xFF);
+		Planes[SampleNum + Index] = static_cast<uint8>(ZigZag >> 8);
+	}
+
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Planes.Num());
+	TArray<uint8> CompressedData;
+	CompressedData.SetNumUninitialized(CompressedSize);
+	if (!FCompression::CompressMemory(NAME_Zlib, CompressedData.GetData(), CompressedSize, Planes.GetData(), Planes.Num())) return false;
+	CompressedData.SetNum(CompressedSize);
+
+	OutCompressed.Reset();
+	FMemoryWriter Writer(OutCompressed);
+	Writer << SampleRate;
+	Writer << NumChannels;
+	Writer << SampleNum;
+	Writer << CompressedData;
+	return true;
+}
+
+/**
+ * @brief 圧縮PCMをWAVフォーマットの音声データに戻す
+ */
+bool FVoicevoxRemoteProtocol::DecompressWAV(const TArray<uint8>& Compressed, TArray<uint8>& OutputWAV)
+{
+	int32 SampleRate = 0;
+	int32 NumChannels = 0;
+	int32 SampleNum = 0;
+	TArray<uint8> CompressedData;
+
+	FMemoryReader Reader(Compressed);
+	Reader << SampleRate;
+	Reader << NumChannels;
+	Reader << SampleNum;
+	Reader << CompressedData;
+	if (Reader.IsError() || SampleRate <= 0 || NumChannels <= 0 || SampleNum < 0 || SampleNum > static_cast<int32>(MaxFrameSize / 2)) return false;
+
+	TArray<uint8> Planes;
+	Planes.SetNumUninitialized(SampleNum * 2);
+	if (!FCompression::UncompressMemory(NAME_Zlib, Planes.GetData(), Planes.Num(), CompressedData.GetData(), CompressedData.Num())) return false;
+
+	TArray<int16> Samples;
+	Samples.SetNumUninitialized(SampleNum);
+	for (int32 Index = 0; Index < SampleNum; ++Index)
+	{
+		const uint16 ZigZag = static_cast<uint16>(Planes[Index] | Planes[SampleNum + Index] << 8);
+		const int16 Delta = static_cast<int16>((ZigZag >> 1) ^ -static_cast<int16>(ZigZag & 1));
+		Samples[Index] = static_cast<int16>(Delta + (Index >= NumChannels ? Samples[Index - NumChannels] : 0));
+	}
+
+	OutputWAV.Reset();
+	SerializeWaveFile(OutputWAV, reinterpret_cast<const uint8*>(Samples.GetData()), Samples.Num() * sizeof(int16), NumChannels, SampleRate);
+	return true;
+}
+
+/**
+ * @brief 音声合成サーバーのアドレスを取得する
+ */
+bool FVoicevoxRemoteProtocol::GetServerAddress(FString& OutAddress)
+{
+	// ワーカープロセスはホストが読み込んだ設定に関わらず、自身でVOICEVOX COREを読み込む
+	if (FVoicevoxWorker::IsWorkerProcess()) return false;
+
+	if (FParse::Value(FCommandLine::Get(), TEXT("-VoicevoxServerAddress="), OutAddress) && !OutAddress.IsEmpty())
+	{
+		return true;
+	}
+	// コマンドレット（音声合成サーバー等）はiniの設定を無視する
+	return !IsRunningCommandlet() && GConfig != nullptr && GConfig->GetString(TEXT("Voicevox"), TEXT("ServerAddress"), OutAddress, GEngineIni) && !OutAddress.IsEmpty();
+}
@@ -0,0 +1,162 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  VOICEVOX COREが出力した音声データを再生デバイスのサンプリングレートへ変換するリサンプラーのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxResampler.h"
+#include "Audio.h"
+
+namespace
+{
+	//! カイザー窓の形状パラメータ
+	constexpr double KaiserBeta = 8.0;
+
+	//! 出力側ナイキスト周波数に対する通過帯域の割合
+	constexpr double CutoffRatio = 0.95;
+
+	/**
+	 * @brief 第1種変形ベッセル関数（0次）
+	 */
+	double BesselI0(const double X)
+	{
+		double Sum = 1.0;
+		double Term = 1.0;
+		for (int32 K = 1; K < 32; ++K)
+		{
+			Term *= (X * 0.5 / K) * (X * 0.5 / K);
+			Sum += Term;
+			if (Term < Sum * 1e-12) break;
+		}
+		return Sum;
+	}
+
+	/**
+	 * @brief 位相毎のフィルタ係数を求める
+	 * @param[in] PhaseNum 位相数（L）
+	 * @param[in] Cutoff 入力ナイキスト周波数を1とした遮断周波数
+	 * @return PhaseNum * TapNum のフィルタ係数
+	 */
+	TArray<float> CreateFilterTable(const int32 PhaseNum, const double Cutoff)
+	{
+		constexpr int32 HalfTapNum = FVoicevoxResampler::TapNum / 2;
+		const double WindowNorm = BesselI0(KaiserBeta);
+		TArray<float> FilterTable;
+		FilterTable.SetNumUninitialized(PhaseNum * FVoicevoxResampler::TapNum);
+		for (int32 Phase = 0; Phase < PhaseNum; ++Phase)
+		{
+			const double Frac = static_cast<double>(Phase) / PhaseNum;
+			double Sum = 0.0;
+			float* Filter = FilterTable.GetData() + Phase * FVoicevoxResampler::TapNum;
+			for (int32 Tap = 0; Tap < FVoicevoxResampler::TapNum; ++Tap)
+			{
+				// Tap番目の係数は入力サンプル (Base - HalfTapNum + 1 + Tap) に掛かる
+				const double T = Frac - (Tap - HalfTapNum + 1);
+				const double X = Cutoff * T;
+				const double Sinc = FMath::IsNearlyZero(X) ? 1.0 : FMath::Sin(PI * X) / (PI * X);
+				const double R = T / HalfTapNum;
+				const double Window = FMath::Abs(R) >= 1.0 ? 0.0 : BesselI0(KaiserBeta * FMath::Sqrt(1.0 - R * R)) / WindowNorm;
+				Filter[Tap] = static_cast<float>(Cutoff * Sinc * Window);
+				Sum += Filter[Tap];
+			}
+
+			// 直流成分のゲインを1に揃える
+			if (Sum > 0.0)
+			{
+				for (int32 Tap = 0; Tap < FVoicevoxResampler::TapNum; ++Tap)
+				{
+					Filter[Tap] = static_cast<float>(Filter[Tap] / Sum);
+				}
+			}
+		}
+		return FilterTable;
+	}
+}
+
+/**
+ * @brief 16bit PCMをリサンプリングする
+ */
+bool FVoicevoxResampler::Resample(const TArrayView<const int16> InSamples, const int32 NumChannels, const int32 InSampleRate, const int32 OutSampleRate, TArray<int16>& OutSamples)
+{
+	if (NumChannels <= 0 || InSampleRate <= 0 || OutSampleRate <= 0 || InSampleRate == OutSampleRate) return false;
+
+	const int32 Gcd = FMath::GreatestCommonDivisor(InSampleRate, OutSampleRate);
+	const int32 PhaseNum = OutSampleRate / Gcd;
+	const int32 Step = InSampleRate / Gcd;
+	if (PhaseNum > MaxPhaseNum) return false;
+
+	// 同じ比率の変換を繰り返すため、フィルタ係数は比率毎に保持する
+	static FCriticalSection FilterTableCriticalSection;
+	static TMap<uint64, TSharedPtr<const TArray<float>>> FilterTableMap;
+	TSharedPtr<const TArray<float>> FilterTable;
+	{
+		const uint64 FilterKey = static_cast<uint64>(PhaseNum) << 32 | static_cast<uint32>(Step);
+		FScopeLock Lock(&FilterTableCriticalSection);
+		if (const TSharedPtr<const TArray<float>>* Found = FilterTableMap.Find(FilterKey))
+		{
+			FilterTable = *Found;
+		}
+		else
+		{
+			const double Cutoff = FMath::Min(1.0, static_cast<double>(PhaseNum) / Step) * CutoffRatio;
+			FilterTable = MakeShared<const TArray<float>>(CreateFilterTable(PhaseNum, Cutoff));
+			FilterTableMap.Add(FilterKey, FilterTable);
+		}
+	}
+
+	constexpr int32 HalfTapNum = TapNum / 2;
+	const int32 InFrameNum = InSamples.Num() / NumChannels;
+	const int32 OutFrameNum = static_cast<int32>(static_cast<int64>(InFrameNum) * PhaseNum / Step);
+	OutSamples.SetNumUninitialized(OutFrameNum * NumChannels);
+
+	// チャンネル毎に前後へフィルタ長分の無音を付けたfloat列へ変換し、境界判定なしで積和できるようにする
+	TArray<float> Padded;
+	Padded.SetNumZeroed(InFrameNum + TapNum * 2);
+	for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+	{
+		for (int32 Frame = 0; Frame < InFrameNum; ++Frame)
+		{
+			Padded[TapNum + Frame] = InSamples[Frame * NumChannels + Channel];
+		}
+
+		const float* Source = Padded.GetData() + TapNum - HalfTapNum + 1;
+		for (int32 Frame = 0; Frame < OutFrameNum; ++Frame)
+		{
+			const int64 Position = static_cast<int64>(Frame) * Step;
+			const int32 Base = static_cast<int32>(Position / PhaseNum);
+			const int32 Phase = static_cast<int32>(Position % PhaseNum);
+			const float* Filter = FilterTable->GetData() + Phase * TapNum;
+			const float* Input = Source + Base;
+
+			VectorRegister4Float Acc = VectorZeroFloat();
+			for (int32 Tap = 0; Tap < TapNum; Tap += 4)
+			{
+				Acc = VectorMultiplyAdd(VectorLoad(Input + Tap), VectorLoad(Filter + Tap), Acc);
+			}
+			alignas(16) float Lane[4];
+			VectorStoreAligned(Acc, Lane);
+			const float Value = Lane[0] + Lane[1] + Lane[2] + Lane[3];
+			OutSamples[Frame * NumChannels + Channel] = static_cast<int16>(FMath::Clamp(FMath::RoundToInt(Value), -32768, 32767));
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief WAVデータをリサンプリングする
+ */
+bool FVoicevoxResampler::ResampleWAV(const TArray<uint8>& InWAV, const int32 OutSampleRate, TArray<uint8>& OutWAV)
+{
+	FWaveModInfo WaveInfo;
+	if (!WaveInfo.ReadWaveInfo(InWAV.GetData(), InWAV.Num()) || *WaveInfo.pBitsPerSample != 16) return false;
+
+	const int32 NumChannels = *WaveInfo.pChannels;
+	const int32 InSampleRate = *WaveInfo.pSamplesPerSec;
+	const TArrayView<const int16> InSamples(reinterpret_cast<const int16*>(WaveInfo.SampleDataStart), WaveInfo.SampleDataSize / sizeof(int16));
+	TArray<int16> OutSamples;
+	if (!Resample(InSamples, NumChannels, InSampleRate, OutSampleRate, OutSamples)) return false;
+
+	SerializeWaveFile(OutWAV, reinterpret_cast<const uint8*>(OutSamples.GetData()), OutSamples.Num() * sizeof(int16), NumChannels, OutSampleRate);
+	return true;
+}
@@ -0,0 +1,279 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  選択肢のテキスト等、次に再生する可能性のあるテキストを投機的に音声合成するクラスのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxSpeculativeSynthesis.h"
+#include "HAL/RunnableThread.h"
+
+/**
+ * @brief コンストラクタ
+ */
+FVoicevoxSpeculativeSynthesis::FVoicevoxSpeculativeSynthesis(FQueryFunction&& InQueryFunction, FSynthesisFunction&& InSynthesisFunction)
+	: QueryFunction(MoveTemp(InQueryFunction)), SynthesisFunction(MoveTemp(InSynthesisFunction))
+{
+	// ゲームの処理や、選ばれた後の音声合成を妨げないように最低優先度で実行する
+	Thread = FRunnableThread::Create(this, TEXT("VoicevoxSpeculativeSynthesis"), 0, TPri_Lowest);
+}
+
+/**
+ * @brief デストラクタ
+ */
+FVoicevoxSpeculativeSynthesis::~FVoicevoxSpeculativeSynthesis()
+{
+	if (Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+	}
+}
+
+/**
+ * @brief 候補テキストを投機的に音声合成する（前回の候補は破棄する）
+ */
+void FVoicevoxSpeculativeSynthesis::Submit(const int64 SpeakerId, const TArray<FString>& MessageList, const bool bKana, const bool bEnableInterrogativeUpspeak)
+{
+	{
+		FScopeLock Lock(&LineCriticalSection);
+		LineList.Reset();
+		for (const FString& Message : MessageList)
+		{
+			if (LineList.Num() >= MaxLineNum) break;
+			if (Message.IsEmpty()) continue;
+
+			const TSharedRef<FLine> Line = MakeShared<FLine>();
+			Line->SpeakerId = SpeakerId;
+			Line->Message = Message;
+			Line->bKana = bKana;
+			Line->bEnableInterrogativeUpspeak = bEnableInterrogativeUpspeak;
+			LineList.Add(Line);
+		}
+	}
+	WakeEvent->Trigger();
+}
+
+/**
+ * @brief 全ての候補を破棄する（合成中の候補は合成完了後に破棄する）
+ */
+void FVoicevoxSpeculativeSynthesis::Cancel()
+{
+	FScopeLock Lock(&LineCriticalSection);
+	LineList.Reset();
+}
+
+/**
+ * @brief CPU使用率の予算を設定する
+ */
+void FVoicevoxSpeculativeSynthesis::SetCPUBudget(const float InCPUBudget)
+{
+	CPUBudget = FMath::Clamp(InCPUBudget, 0.01f, 1.0f);
+}
+
+/**
+ * @brief 候補のAudioQueryを取得する
+ */
+bool FVoicevoxSpeculativeSynthesis::FindAudioQuery(const int64 SpeakerId, const FString& Message, const bool bKana, FVoicevoxAudioQuery& OutAudioQuery)
+{
+	TSharedPtr<FLine> FoundLine;
+	{
+		FScopeLock Lock(&LineCriticalSection);
+		const TSharedRef<FLine>* Line = LineList.FindByPredicate([SpeakerId, &Message, bKana](const TSharedRef<FLine>& Line)
+		{
+			return Line->SpeakerId == SpeakerId && Line->bKana == bKana && Line->Message.Equals(Message, ESearchCase::CaseSensitive);
+		});
+		if (Line == nullptr) return false;
+
+		// 選ばれなかった候補は破棄する。未処理の場合は通常の優先度で処理した方が早いため、全て破棄する
+		if ((*Line)->State == ELineState::Pending)
+		{
+			LineList.Reset();
+			return false;
+		}
+		FoundLine = *Line;
+		LineList.Reset();
+		LineList.Add(FoundLine.ToSharedRef());
+	}
+
+	PromoteChosenLine(*FoundLine);
+	FoundLine->QueryEvent->Wait();
+	FScopeLock Lock(&LineCriticalSection);
+	OutAudioQuery = FoundLine->AudioQuery;
+	return !OutAudioQuery.Accent_phrases.IsEmpty();
+}
+
+/**
+ * @brief AudioQueryが一致する候補の音声データを取得する
+ */
+bool FVoicevoxSpeculativeSynthesis::FindSynthesis(const FVoicevoxAudioQuery& AudioQuery, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak, const EVoicevoxSynthesisPriority Priority,
+												  TArray<uint8>& OutputWAV, FVoicevoxAudioQuery* OutSynthesisAudioQuery)
+{
+	TSharedPtr<FLine> FoundLine;
+	{
+		FScopeLock Lock(&LineCriticalSection);
+		if (LineList.IsEmpty()) return false;
+
+		const uint32 AudioQueryHash = GetAudioQueryHash(AudioQuery);
+		const TSharedRef<FLine>* Line = LineList.FindByPredicate([SpeakerId, bEnableInterrogativeUpspeak, AudioQueryHash](const TSharedRef<FLine>& Line)
+		{
+			return Line->SpeakerId == SpeakerId && Line->bEnableInterrogativeUpspeak == bEnableInterrogativeUpspeak && Line->AudioQueryHash == AudioQueryHash;
+		});
+		if (Line == nullptr) return false;
+
+		FoundLine = *Line;
+		LineList.Reset();
+	}
+
+	PromoteChosenLine(*FoundLine);
+	FoundLine->DoneEvent->Wait();
+	FScopeLock Lock(&LineCriticalSection);
+	if (FoundLine->GovernedAudioQuery.IsSet())
+	{
+		// 低優先度として品質を下げた音声データを、品質を下げない優先度のセリフとして再生しない
+		if (Priority != EVoicevoxSynthesisPriority::Low) return false;
+
+		if (OutSynthesisAudioQuery != nullptr)
+		{
+			*OutSynthesisAudioQuery = MoveTemp(FoundLine->GovernedAudioQuery.GetValue());
+		}
+	}
+	OutputWAV = MoveTemp(FoundLine->OutputWAV);
+	return !OutputWAV.IsEmpty();
+}
+
+//--------------------------------
+// FRunnable override
+//--------------------------------
+
+/**
+ * @brief Run
+ */
+uint32 FVoicevoxSpeculativeSynthesis::Run()
+{
+	while (!bStopRequested.load())
+	{
+		TSharedPtr<FLine> Line;
+		{
+			FScopeLock Lock(&LineCriticalSection);
+			if (const TSharedRef<FLine>* PendingLine = LineList.FindByPredicate([](const TSharedRef<FLine>& Line) { return Line->State == ELineState::Pending; }))
+			{
+				Line = *PendingLine;
+				Line->State = ELineState::Running;
+			}
+		}
+
+		if (!Line.IsValid())
+		{
+			WakeEvent->Wait();
+			continue;
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		FVoicevoxAudioQuery AudioQuery = QueryFunction(Line->SpeakerId, Line->Message, Line->bKana);
+		const uint32 AudioQueryHash = GetAudioQueryHash(AudioQuery);
+		{
+			FScopeLock Lock(&LineCriticalSection);
+			Line->AudioQuery = AudioQuery;
+			Line->AudioQueryHash = AudioQueryHash;
+		}
+		Line->QueryEvent->Trigger();
+
+		TArray<uint8> OutputWAV;
+		TOptional<FVoicevoxAudioQuery> GovernedAudioQuery;
+		if (!AudioQuery.Accent_phrases.IsEmpty())
+		{
+			OutputWAV = SynthesisFunction(AudioQuery, Line->SpeakerId, Line->bEnableInterrogativeUpspeak, GovernedAudioQuery);
+		}
+		bool bIsChosen = false;
+		{
+			FScopeLock Lock(&LineCriticalSection);
+			Line->OutputWAV = MoveTemp(OutputWAV);
+			Line->GovernedAudioQuery = MoveTemp(GovernedAudioQuery);
+			Line->State = ELineState::Done;
+			bIsChosen = Line->bIsChosen;
+		}
+		Line->DoneEvent->Trigger();
+
+		// 選ばれた候補は待機している呼び出し元のために合成したため、優先度を戻して待機せずに次の候補へ進む
+		if (bIsChosen)
+		{
+			if (Thread != nullptr)
+			{
+				Thread->SetThreadPriority(TPri_Lowest);
+			}
+			continue;
+		}
+
+		// 合成にかかった時間に対して、CPU使用率の予算に収まるまで次の候補の合成を待機する
+		const double EndTime = FPlatformTime::Seconds();
+		const double WakeTime = EndTime + (EndTime - StartTime) * (1.0 / CPUBudget.load() - 1.0);
+		for (double Now = FPlatformTime::Seconds(); Now < WakeTime && !bStopRequested.load(); Now = FPlatformTime::Seconds())
+		{
+			WakeEvent->Wait(FTimespan::FromSeconds(WakeTime - Now));
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Stop
+ */
+void FVoicevoxSpeculativeSynthesis::Stop()
+{
+	bStopRequested = true;
+	WakeEvent->Trigger();
+}
+
+/**
+ * @brief 選ばれた候補の完了を待つため、合成中であれば合成スレッドの優先度を上げる
+ */
+void FVoicevoxSpeculativeSynthesis::PromoteChosenLine(FLine& Line)
+{
+	// 最低優先度のままではゲームの処理に埋もれて、待機している呼び出し元や実行枠を待つ他の音声合成まで止めてしまう
+	FScopeLock Lock(&LineCriticalSection);
+	if (Line.State == ELineState::Done || Line.bIsChosen) return;
+
+	Line.bIsChosen = true;
+	if (Thread != nullptr)
+	{
+		Thread->SetThreadPriority(TPri_Normal);
+	}
+}
+
+/**
+ * @brief AudioQueryのハッシュ値を求める
+ */
+uint32 FVoicevoxSpeculativeSynthesis::GetAudioQueryHash(const FVoicevoxAudioQuery& AudioQuery)
+{
+	const auto HashMora = [](uint32 Hash, const FVoicevoxMora& Mora)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(Mora.Text));
+		Hash = HashCombine(Hash, GetTypeHash(Mora.Consonant));
+		Hash = HashCombine(Hash, GetTypeHash(Mora.Consonant_length));
+		Hash = HashCombine(Hash, GetTypeHash(Mora.Vowel));
+		Hash = HashCombine(Hash, GetTypeHash(Mora.Vowel_length));
+		return HashCombine(Hash, GetTypeHash(Mora.Pitch));
+	};
+
+	uint32 Hash = GetTypeHash(AudioQuery.Speed_scale);
+	Hash = HashCombine(Hash, GetTypeHash(AudioQuery.Pitch_scale));
+	Hash = HashCombine(Hash, GetTypeHash(AudioQuery.Intonation_scale));
+	Hash = HashCombine(Hash, GetTypeHash(AudioQuery.Volume_scale));
+	Hash = HashCombine(Hash, GetTypeHash(AudioQuery.Pre_phoneme_length));
+	Hash = HashCombine(Hash, GetTypeHash(AudioQuery.Post_phoneme_length));
+	Hash = HashCombine(Hash, GetTypeHash(AudioQuery.Output_sampling_rate));
+	Hash = HashCombine(Hash, GetTypeHash(AudioQuery.Output_stereo));
+	for (const FVoicevoxAccentPhrase& AccentPhrase : AudioQuery.Accent_phrases)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(AccentPhrase.Accent));
+		Hash = HashCombine(Hash, GetTypeHash(AccentPhrase.Is_interrogative));
+		for (const FVoicevoxMora& Mora : AccentPhrase.Moras)
+		{
+			Hash = HashMora(Hash, Mora);
+		}
+		Hash = HashMora(Hash, AccentPhrase.Pause_mora);
+	}
+	return Hash != 0 ? Hash : 1;
+}
@@ -0,0 +1,76 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  話者毎のモーラあたりの合成時間から音声合成の所要時間を予測するクラスのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxSynthesisCostModel.h"
+#include "VoicevoxPhoneme.h"
+
+namespace
+{
+	//! モーラあたりの合成時間の平滑化係数
+	constexpr double SecondsPerMoraSmoothing = 0.2;
+
+	//! 何も計測していない場合のモーラあたりの合成時間（秒）
+	constexpr double DefaultSecondsPerMora = 0.05;
+}
+
+/**
+ * @brief 音声合成1回分の所要時間を記録する
+ */
+void FVoicevoxSynthesisCostModel::Record(const int64 SpeakerId, const int32 MoraNum, const double SynthesisTime)
+{
+	if (MoraNum <= 0 || SynthesisTime <= 0.0) return;
+
+	const double SampleSecondsPerMora = SynthesisTime / MoraNum;
+	FScopeLock Lock(&CriticalSection);
+	if (double* SecondsPerMora = SecondsPerMoraMap.Find(SpeakerId))
+	{
+		*SecondsPerMora = FMath::Lerp(*SecondsPerMora, SampleSecondsPerMora, SecondsPerMoraSmoothing);
+	}
+	else
+	{
+		SecondsPerMoraMap.Add(SpeakerId, SampleSecondsPerMora);
+	}
+	GlobalSecondsPerMora = GlobalSecondsPerMora <= 0.0 ? SampleSecondsPerMora : FMath::Lerp(GlobalSecondsPerMora, SampleSecondsPerMora, SecondsPerMoraSmoothing);
+}
+
+/**
+ * @brief 音声合成の所要時間を予測する
+ */
+double FVoicevoxSynthesisCostModel::Predict(const int64 SpeakerId, const int32 MoraNum) const
+{
+	return FMath::Max(0, MoraNum) * GetSecondsPerMora(SpeakerId);
+}
+
+/**
+ * @brief モーラあたりの合成時間を取得する
+ */
+double FVoicevoxSynthesisCostModel::GetSecondsPerMora(const int64 SpeakerId) const
+{
+	FScopeLock Lock(&CriticalSection);
+	if (const double* SecondsPerMora = SecondsPerMoraMap.Find(SpeakerId))
+	{
+		return *SecondsPerMora;
+	}
+	return GlobalSecondsPerMora > 0.0 ? GlobalSecondsPerMora : DefaultSecondsPerMora;
+}
+
+/**
+ * @brief AudioQueryのモーラ数を求める（無音のモーラを含む）
+ */
+int32 FVoicevoxSynthesisCostModel::GetMoraNum(const FVoicevoxAudioQuery& AudioQuery)
+{
+	int32 MoraNum = 0;
+	for (const FVoicevoxAccentPhrase& AccentPhrase : AudioQuery.Accent_phrases)
+	{
+		MoraNum += AccentPhrase.Moras.Num();
+		if (FVoicevoxPhoneme::IsPause(AccentPhrase.Pause_mora))
+		{
+			++MoraNum;
+		}
+	}
+	return MoraNum;
+}
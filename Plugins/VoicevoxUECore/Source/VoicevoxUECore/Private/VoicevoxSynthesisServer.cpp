@@ -0,0 +1,247 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  VOICEVOX COREのAPIをローカルのソケット経由で公開する音声合成サーバーのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxSynthesisServer.h"
+#include "JsonObjectConverter.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Async/ParallelFor.h"
+#include "Common/TcpListener.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Subsystems/VoicevoxCoreSubsystem.h"
+
+DEFINE_LOG_CATEGORY(LogVoicevoxServer);
+
+//----------------------------------------------------------------
+// FConnection
+//----------------------------------------------------------------
+
+/**
+ * @class FVoicevoxSynthesisServer::FConnection
+ * @brief クライアント1接続分のリクエストを受信、処理するクラス
+ */
+class FVoicevoxSynthesisServer::FConnection : public FRunnable
+{
+public:
+
+	/**
+	 * @brief コンストラクタ
+	 */
+	FConnection(FVoicevoxSynthesisServer& InServer, FSocket* InSocket) : Server(InServer), Socket(InSocket)
+	{
+		Thread = FRunnableThread::Create(this, TEXT("VoicevoxServerConnection"));
+	}
+
+	/**
+	 * @brief デストラクタ
+	 */
+	virtual ~FConnection() override
+	{
+		if (Thread != nullptr)
+		{
+			Thread->WaitForCompletion();
+			delete Thread;
+		}
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+	}
+
+	/**
+	 * @brief Run
+	 */
+	virtual uint32 Run() override
+	{
+		TArray<uint8> Payload;
+		while (FVoicevoxRemoteProtocol::ReceiveFrame(*Socket, Payload, &Server.bStopRequested))
+		{
+			TArray<FVoicevoxRemoteRequest> RequestList;
+			FMemoryReader Reader(Payload);
+			Reader << RequestList;
+			if (Reader.IsError()) break;
+
+			// バッチ内のリクエストは並列に処理し、リクエストと同じ順序でレスポンスを返す
+			TArray<FVoicevoxRemoteResponse> ResponseList;
+			ResponseList.SetNum(RequestList.Num());
+			ParallelFor(RequestList.Num(), [this, &RequestList, &ResponseList](const int32 Index)
+			{
+				ResponseList[Index] = Server.ProcessRequest(RequestList[Index]);
+			});
+
+			Payload.Reset();
+			FMemoryWriter Writer(Payload);
+			Writer << ResponseList;
+			if (!FVoicevoxRemoteProtocol::SendFrame(*Socket, Payload)) break;
+		}
+
+		bIsFinished = true;
+		return 0;
+	}
+
+	/**
+	 * @brief 接続が終了したか
+	 */
+	bool IsFinished() const
+	{
+		return bIsFinished.load();
+	}
+
+private:
+
+	//! 音声合成サーバー
+	FVoicevoxSynthesisServer& Server;
+
+	//! 接続したソケット
+	FSocket* Socket;
+
+	//! 受信スレッド
+	FRunnableThread* Thread = nullptr;
+
+	//! 接続が終了したか
+	std::atomic<bool> bIsFinished = false;
+};
+
+//----------------------------------------------------------------
+// FVoicevoxSynthesisServer
+//----------------------------------------------------------------
+
+/**
+ * @brief コンストラクタ
+ */
+FVoicevoxSynthesisServer::FVoicevoxSynthesisServer(UVoicevoxCoreSubsystem* InSubsystem) : Subsystem(InSubsystem)
+{
+}
+
+/**
+ * @brief デストラクタ
+ */
+FVoicevoxSynthesisServer::~FVoicevoxSynthesisServer()
+{
+	Stop();
+}
+
+/**
+ * @brief ループバックアドレスで接続の待ち受けを開始する
+ */
+bool FVoicevoxSynthesisServer::Start(const int32 Port)
+{
+	Stop();
+	bStopRequested = false;
+
+	Listener = MakeUnique<FTcpListener>(FIPv4Endpoint(FIPv4Address::InternalLoopback, Port), FTimespan::FromMilliseconds(100), false);
+	Listener->OnConnectionAccepted().BindRaw(this, &FVoicevoxSynthesisServer::HandleConnectionAccepted);
+	if (!Listener->IsActive())
+	{
+		UE_LOG(LogVoicevoxServer, Error, TEXT("Voicevox Server Listen Error: Port %d"), Port);
+		Listener.Reset();
+		return false;
+	}
+
+	UE_LOG(LogVoicevoxServer, Log, TEXT("Voicevox Server Listening: 127.0.0.1:%d"), Port);
+	return true;
+}
+
+/**
+ * @brief 接続の待ち受けを終了し、全ての接続を切断する
+ */
+void FVoicevoxSynthesisServer::Stop()
+{
+	bStopRequested = true;
+	Listener.Reset();
+
+	FScopeLock Lock(&ConnectionCriticalSection);
+	ConnectionList.Empty();
+}
+
+/**
+ * @brief 接続を待ち受けているか
+ */
+bool FVoicevoxSynthesisServer::IsRunning() const
+{
+	return Listener.IsValid();
+}
+
+/**
+ * @brief 接続を受け付けた時の処理
+ */
+bool FVoicevoxSynthesisServer::HandleConnectionAccepted(FSocket* Socket, const FIPv4Endpoint& Endpoint)
+{
+	if (bStopRequested.load()) return false;
+
+	Socket->SetNoDelay(true);
+
+	FScopeLock Lock(&ConnectionCriticalSection);
+	ConnectionList.RemoveAll([](const TUniquePtr<FConnection>& Connection)
+	{
+		return Connection->IsFinished();
+	});
+	ConnectionList.Add(MakeUnique<FConnection>(*this, Socket));
+
+	UE_LOG(LogVoicevoxServer, Log, TEXT("Voicevox Server Connected: %s (%d connections)"), *Endpoint.ToString(), ConnectionList.Num());
+	return true;
+}
+
+/**
+ * @brief リクエストを処理する
+ */
+FVoicevoxRemoteResponse FVoicevoxSynthesisServer::ProcessRequest(const FVoicevoxRemoteRequest& Request) const
+{
+	FVoicevoxRemoteResponse Response;
+	switch (Request.Command)
+	{
+	case EVoicevoxRemoteCommand::ServerInfo:
+		{
+			FVoicevoxRemoteServerInfo ServerInfo;
+			ServerInfo.MetaList = Subsystem->GetMetaList();
+			if (const TArray<FString> CoreNameList = Subsystem->GetCoreNameList(); !CoreNameList.IsEmpty())
+			{
+				ServerInfo.SupportedDevices = Subsystem->GetSupportedDevices(CoreNameList[0]);
+				ServerInfo.Version = Subsystem->GetVoicevoxVersion(CoreNameList[0]);
+				ServerInfo.bIsGpuMode = Subsystem->IsGpuMode(CoreNameList[0]);
+			}
+			FMemoryWriter Writer(Response.Data);
+			Writer << ServerInfo;
+			Response.bIsSucceeded = Subsystem->GetIsInitialize();
+		}
+		break;
+	case EVoicevoxRemoteCommand::LoadModel:
+		Response.bIsSucceeded = Subsystem->LoadModel(Request.SpeakerId);
+		break;
+	case EVoicevoxRemoteCommand::AudioQuery:
+		{
+			const FVoicevoxAudioQuery AudioQuery = Subsystem->GetAudioQuery(Request.SpeakerId, Request.Text, Request.bKana);
+			FString AudioQueryJson;
+			FJsonObjectConverter::UStructToJsonObjectString(AudioQuery, AudioQueryJson, 0, 0, 0, nullptr, false);
+			FMemoryWriter Writer(Response.Data);
+			Writer << AudioQueryJson;
+			Response.bIsSucceeded = !AudioQuery.Accent_phrases.IsEmpty();
+		}
+		break;
+	case EVoicevoxRemoteCommand::TextToSpeech:
+		{
+			const TArray<uint8> OutputWAV = Subsystem->RunTextToSpeech(Request.SpeakerId, Request.Text, Request.bKana, Request.bEnableInterrogativeUpspeak);
+			Response.bIsSucceeded = FVoicevoxRemoteProtocol::CompressWAV(OutputWAV, Response.Data);
+		}
+		break;
+	case EVoicevoxRemoteCommand::Synthesis:
+		{
+			FVoicevoxAudioQuery AudioQuery;
+			if (FJsonObjectConverter::JsonObjectStringToUStruct(Request.Text, &AudioQuery, 0, 0))
+			{
+				const TArray<uint8> OutputWAV = Subsystem->RunSynthesis(AudioQuery, Request.SpeakerId, Request.bEnableInterrogativeUpspeak);
+				Response.bIsSucceeded = FVoicevoxRemoteProtocol::CompressWAV(OutputWAV, Response.Data);
+			}
+		}
+		break;
+	default:
+		break;
+	}
+	return Response;
+}
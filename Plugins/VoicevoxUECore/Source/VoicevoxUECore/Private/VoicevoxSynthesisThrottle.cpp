@@ -0,0 +1,310 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  音声合成の同時実行数、スレッド優先度、フレーム時間に応じた抑制を行うクラスのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxSynthesisThrottle.h"
+#include "CoreGlobals.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/App.h"
+#include "Misc/CoreDelegates.h"
+
+namespace
+{
+	//! フレーム時間の平滑化係数
+	constexpr double FrameTimeSmoothing = 0.1;
+
+	//! フレーム時間の余裕を確認し直す間隔（秒）
+	constexpr double ThrottleCheckInterval = 0.005;
+
+	/**
+	 * @brief スレッド優先度の低さを比較するための順位を取得する
+	 */
+	int32 GetPriorityRank(const EThreadPriority Priority)
+	{
+		switch (Priority)
+		{
+		case TPri_TimeCritical:			return 6;
+		case TPri_Highest:				return 5;
+		case TPri_AboveNormal:			return 4;
+		case TPri_Normal:				return 3;
+		case TPri_SlightlyBelowNormal:	return 2;
+		case TPri_BelowNormal:			return 1;
+		case TPri_Lowest:				return 0;
+		default:						return 3;
+		}
+	}
+
+	/**
+	 * @brief 設定のスレッド優先度をEThreadPriorityに変換する
+	 */
+	EThreadPriority ToThreadPriority(const EVoicevoxSynthesisThreadPriority Priority)
+	{
+		switch (Priority)
+		{
+		case EVoicevoxSynthesisThreadPriority::SlightlyBelowNormal:	return TPri_SlightlyBelowNormal;
+		case EVoicevoxSynthesisThreadPriority::BelowNormal:			return TPri_BelowNormal;
+		case EVoicevoxSynthesisThreadPriority::Lowest:				return TPri_Lowest;
+		default:													return TPri_Num;
+		}
+	}
+}
+
+//--------------------------------
+// FScope
+//--------------------------------
+
+/**
+ * @brief コンストラクタ（実行枠が空くまで待機し、スレッド優先度を設定する）
+ */
+FVoicevoxSynthesisThrottle::FScope::FScope(FVoicevoxSynthesisThrottle& InThrottle, const FVoicevoxSynthesisDeadline* Deadline, const double PredictedCost)
+	: Throttle(InThrottle)
+{
+	bIsAcquired = Throttle.Acquire(Deadline, PredictedCost, Sequence);
+	if (!bIsAcquired) return;
+
+	// 元の優先度より低くなる場合のみ変更する（投機的な音声合成等、既に低い優先度のスレッドは上げない）
+	const EThreadPriority Priority = ToThreadPriority(Throttle.GetBudget().ThreadPriority);
+	if (FRunnableThread* Thread = FRunnableThread::GetRunnableThread(); Thread != nullptr && Priority != TPri_Num && !IsInGameThread())
+	{
+		if (const EThreadPriority CurrentPriority = Thread->GetThreadPriority(); GetPriorityRank(Priority) < GetPriorityRank(CurrentPriority))
+		{
+			PrevThreadPriority = CurrentPriority;
+			Thread->SetThreadPriority(Priority);
+		}
+	}
+}
+
+/**
+ * @brief デストラクタ（スレッド優先度を戻し、実行枠を解放する）
+ */
+FVoicevoxSynthesisThrottle::FScope::~FScope()
+{
+	if (!bIsAcquired) return;
+
+	if (PrevThreadPriority != TPri_Num)
+	{
+		if (FRunnableThread* Thread = FRunnableThread::GetRunnableThread())
+		{
+			Thread->SetThreadPriority(PrevThreadPriority);
+		}
+	}
+	Throttle.Release(Sequence);
+}
+
+//--------------------------------
+// FVoicevoxSynthesisThrottle
+//--------------------------------
+
+/**
+ * @brief フレーム時間の計測を開始する
+ */
+void FVoicevoxSynthesisThrottle::Start()
+{
+	bIsStopped = false;
+	if (!BeginFrameHandle.IsValid())
+	{
+		BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddRaw(this, &FVoicevoxSynthesisThrottle::OnBeginFrame);
+	}
+}
+
+/**
+ * @brief フレーム時間の計測を終了し、待機中の音声合成を全て開始させる
+ */
+void FVoicevoxSynthesisThrottle::Stop()
+{
+	bIsStopped = true;
+	if (BeginFrameHandle.IsValid())
+	{
+		FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+		BeginFrameHandle.Reset();
+	}
+	FrameTime = 0.0;
+	ReleaseEvent->Trigger();
+}
+
+/**
+ * @brief 設定を変更する
+ */
+void FVoicevoxSynthesisThrottle::SetBudget(const FVoicevoxSynthesisBudget& InBudget)
+{
+	{
+		FScopeLock Lock(&CriticalSection);
+		Budget = InBudget;
+		Budget.MaxConcurrentSynthesis = FMath::Max(0, Budget.MaxConcurrentSynthesis);
+		Budget.TargetFrameRate = FMath::Max(0.0f, Budget.TargetFrameRate);
+		Budget.MinFrameHeadroom = FMath::Clamp(Budget.MinFrameHeadroom, 0.0f, 1.0f);
+		Budget.MaxThrottleTime = FMath::Max(0.0f, Budget.MaxThrottleTime);
+	}
+	ReleaseEvent->Trigger();
+}
+
+/**
+ * @brief 設定を取得する
+ */
+FVoicevoxSynthesisBudget FVoicevoxSynthesisThrottle::GetBudget() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return Budget;
+}
+
+/**
+ * @brief 待機中、実行中の音声合成の数を取得する
+ */
+int32 FVoicevoxSynthesisThrottle::GetQueueDepth() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return WaitingList.Num() + RunningList.Num();
+}
+
+/**
+ * @brief 実行枠が空くまで待機して確保する
+ */
+bool FVoicevoxSynthesisThrottle::Acquire(const FVoicevoxSynthesisDeadline* Deadline, const double PredictedCost, uint64& OutSequence)
+{
+	const bool bHasDeadline = Deadline != nullptr && Deadline->Deadline > 0.0;
+
+	FEntry Entry;
+	Entry.Deadline = bHasDeadline ? Deadline->Deadline : TNumericLimits<double>::Max();
+	Entry.PredictedCost = FMath::Max(0.0, PredictedCost);
+	Entry.RequestTime = FPlatformTime::Seconds();
+	// ゲームスレッドで待機するとフレームが進まず余裕が回復しないため、フレーム時間による抑制は行わない
+	Entry.bCanThrottle = !IsInGameThread();
+	{
+		FScopeLock Lock(&CriticalSection);
+		Entry.Sequence = NextSequence++;
+		WaitingList.Add(Entry);
+	}
+	OutSequence = Entry.Sequence;
+
+	bool bIsDeadlineMissNotified = !bHasDeadline;
+	while (true)
+	{
+		bool bIsAcquired = false;
+		bool bIsCanceled = false;
+		double PredictedCompletionTime = 0.0;
+		{
+			FScopeLock Lock(&CriticalSection);
+			const double Now = FPlatformTime::Seconds();
+
+			const bool bIsFrameOverBudget = IsFrameOverBudget();
+			const auto IsThrottled = [this, Now, bIsFrameOverBudget](const FEntry& Other)
+			{
+				return Other.bCanThrottle && Now - Other.RequestTime < Budget.MaxThrottleTime && bIsFrameOverBudget;
+			};
+
+			// 同時実行数に上限がある場合のみ、期限の早い音声合成から開始する
+			// フレーム時間により抑制中の音声合成は開始できないため、ゲームスレッド等の抑制対象外の音声合成を待たせない
+			const bool bHasSlot = Budget.MaxConcurrentSynthesis <= 0 || RunningList.Num() < Budget.MaxConcurrentSynthesis;
+			const bool bIsEarliest = Budget.MaxConcurrentSynthesis <= 0
+				|| !WaitingList.ContainsByPredicate([&Entry, &IsThrottled](const FEntry& Other) { return Other.IsEarlierThan(Entry) && !IsThrottled(Other); });
+			const bool bIsThrottled = IsThrottled(Entry);
+			const bool bCanStart = bIsStopped.load() || (bHasSlot && bIsEarliest && !bIsThrottled);
+
+			if (!bIsDeadlineMissNotified)
+			{
+				PredictedCompletionTime = Now + (bCanStart ? 0.0 : PredictWaitTime(Entry, Now)) + Entry.PredictedCost;
+			}
+			const bool bWillMissDeadline = PredictedCompletionTime > Entry.Deadline;
+
+			if (bWillMissDeadline && Deadline->bCancelOnDeadlineMiss)
+			{
+				WaitingList.RemoveAll([&Entry](const FEntry& Other) { return Other.Sequence == Entry.Sequence; });
+				bIsCanceled = true;
+			}
+			else if (bCanStart)
+			{
+				WaitingList.RemoveAll([&Entry](const FEntry& Other) { return Other.Sequence == Entry.Sequence; });
+				Entry.StartTime = Now;
+				RunningList.Add(Entry);
+				bIsAcquired = true;
+			}
+			if (!bWillMissDeadline)
+			{
+				PredictedCompletionTime = 0.0;
+			}
+		}
+
+		// 期限に間に合わない場合は、待機中でも早めに呼び出し元へ通知する
+		if (PredictedCompletionTime > 0.0)
+		{
+			bIsDeadlineMissNotified = true;
+			if (Deadline->OnDeadlineMiss)
+			{
+				Deadline->OnDeadlineMiss(PredictedCompletionTime);
+			}
+		}
+		if (bIsCanceled || bIsAcquired)
+		{
+			// 次に期限の早い音声合成が実行枠の解放を待たずに確認できるようにする
+			ReleaseEvent->Trigger();
+			return bIsAcquired;
+		}
+
+		ReleaseEvent->Wait(FTimespan::FromSeconds(ThrottleCheckInterval));
+	}
+}
+
+/**
+ * @brief 実行枠を解放する
+ */
+void FVoicevoxSynthesisThrottle::Release(const uint64 Sequence)
+{
+	{
+		FScopeLock Lock(&CriticalSection);
+		RunningList.RemoveAll([Sequence](const FEntry& Entry) { return Entry.Sequence == Sequence; });
+	}
+	ReleaseEvent->Trigger();
+}
+
+/**
+ * @brief 待機中の音声合成が開始するまでの時間を予測する（CriticalSectionをロックして呼び出す）
+ */
+double FVoicevoxSynthesisThrottle::PredictWaitTime(const FEntry& Entry, const double Now) const
+{
+	// 同時実行数に上限が無い場合は、実行枠を待たずに開始できる
+	if (Budget.MaxConcurrentSynthesis <= 0) return 0.0;
+
+	// 実行中の残り時間と先に開始する音声合成の所要時間の合計を、実行枠の数で分担すると見なす
+	double AheadCost = 0.0;
+	for (const FEntry& Running : RunningList)
+	{
+		AheadCost += FMath::Max(0.0, Running.PredictedCost - (Now - Running.StartTime));
+	}
+	for (const FEntry& Waiting : WaitingList)
+	{
+		if (Waiting.IsEarlierThan(Entry))
+		{
+			AheadCost += Waiting.PredictedCost;
+		}
+	}
+	return AheadCost / Budget.MaxConcurrentSynthesis;
+}
+
+/**
+ * @brief ゲームスレッドのフレーム時間に余裕が無いか
+ */
+bool FVoicevoxSynthesisThrottle::IsFrameOverBudget() const
+{
+	const double CurrentFrameTime = FrameTime.load();
+	if (Budget.TargetFrameRate <= 0.0f || CurrentFrameTime <= 0.0) return false;
+
+	return CurrentFrameTime > (1.0 - Budget.MinFrameHeadroom) / Budget.TargetFrameRate;
+}
+
+/**
+ * @brief フレーム開始時にフレーム時間を平滑化して記録する
+ */
+void FVoicevoxSynthesisThrottle::OnBeginFrame()
+{
+	// 垂直同期等の待機時間を含めないよう、ゲームスレッドとレンダースレッドの処理時間の長い方をフレーム時間とする
+	double WorkTime = FPlatformTime::ToSeconds(FMath::Max(GGameThreadTime, GRenderThreadTime));
+	if (WorkTime <= 0.0)
+	{
+		WorkTime = FApp::GetDeltaTime();
+	}
+	const double PrevFrameTime = FrameTime.load();
+	FrameTime = PrevFrameTime <= 0.0 ? WorkTime : FMath::Lerp(PrevFrameTime, WorkTime, FrameTimeSmoothing);
+}
@@ -0,0 +1,184 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  VOICEVOX COREの推論スレッド数を実機で計測して決めるキャリブレーションクラスのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxThreadCalibration.h"
+#include "Audio.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Subsystems/VoicevoxCoreSubsystem.h"
+#include "Tasks/Task.h"
+#include <atomic>
+
+namespace
+{
+	//! iniのセクション名
+	const TCHAR* ConfigSection = TEXT("Voicevox");
+
+	//! 計測したスレッド数のキー名
+	const TCHAR* ConfigCPUNumThreadsKey = TEXT("CalibratedCPUNumThreads");
+
+	//! 計測したマシンの識別文字列のキー名
+	const TCHAR* ConfigMachineIdKey = TEXT("CalibratedMachineId");
+
+	//! 候補毎に計測する音声合成の回数（初回の合成は含めない）
+	constexpr int32 TrialSynthesisNum = 3;
+
+	//! 干渉の計測に使う計算の繰り返し回数
+	constexpr int32 ProbeIterationNum = 200000;
+}
+
+/**
+ * @brief 推論スレッド数の候補毎に計測し、最適なスレッド数を求める
+ */
+int32 FVoicevoxThreadCalibration::Run(FInitializeFunction InitializeFunction, FSynthesisFunction SynthesisFunction, TArray<FTrialResult>& OutResultList)
+{
+	OutResultList.Reset();
+
+	// 音声合成していない状態の計算時間を基準にする
+	double BaseProbeTime = TNumericLimits<double>::Max();
+	for (int32 Index = 0; Index < 5; ++Index)
+	{
+		BaseProbeTime = FMath::Min(BaseProbeTime, RunProbe());
+	}
+
+	for (const int32 CPUNumThreads : GetCandidateList())
+	{
+		// 初回の合成はモデルの準備等で遅いため計測しない
+		if (!InitializeFunction(CPUNumThreads) || SynthesisFunction().IsEmpty())
+		{
+			UE_LOG(LogVoicevoxCore, Warning, TEXT("VoicevoxThreadCalibration: Skip CPUNumThreads=%d"), CPUNumThreads);
+			continue;
+		}
+
+		// 音声合成中は別スレッドで計算を繰り返し、ゲームスレッドへの干渉として計算時間の増加を計測する
+		std::atomic<bool> bIsSynthesizing = true;
+		UE::Tasks::TTask<double> ProbeTask = UE::Tasks::Launch(TEXT("VoicevoxThreadCalibrationProbe"), [&bIsSynthesizing]
+		{
+			double TotalProbeTime = 0.0;
+			int32 ProbeNum = 0;
+			while (bIsSynthesizing.load())
+			{
+				TotalProbeTime += RunProbe();
+				++ProbeNum;
+			}
+			return ProbeNum > 0 ? TotalProbeTime / ProbeNum : 0.0;
+		}, UE::Tasks::ETaskPriority::High);
+
+		double SynthesisTime = 0.0;
+		double WaveDuration = 0.0;
+		for (int32 Index = 0; Index < TrialSynthesisNum; ++Index)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			const TArray<uint8> OutputWAV = SynthesisFunction();
+			SynthesisTime += FPlatformTime::Seconds() - StartTime;
+			WaveDuration += GetWaveDuration(OutputWAV);
+		}
+		bIsSynthesizing = false;
+		const double ProbeTime = ProbeTask.GetResult();
+
+		if (WaveDuration <= 0.0) continue;
+
+		FTrialResult& Result = OutResultList.AddDefaulted_GetRef();
+		Result.CPUNumThreads = CPUNumThreads;
+		Result.RealTimeFactor = SynthesisTime / WaveDuration;
+		Result.Interference = ProbeTime > 0.0 ? FMath::Max(0.0, ProbeTime / BaseProbeTime - 1.0) : 0.0;
+		UE_LOG(LogVoicevoxCore, Log, TEXT("VoicevoxThreadCalibration: CPUNumThreads=%d RealTimeFactor=%.3f Interference=%.3f"),
+			Result.CPUNumThreads, Result.RealTimeFactor, Result.Interference);
+	}
+
+	const FTrialResult* BestResult = nullptr;
+	for (const FTrialResult& Result : OutResultList)
+	{
+		if (BestResult == nullptr || Result.GetScore() < BestResult->GetScore())
+		{
+			BestResult = &Result;
+		}
+	}
+	return BestResult != nullptr ? BestResult->CPUNumThreads : 0;
+}
+
+/**
+ * @brief 推論スレッド数の候補リストを取得する
+ */
+TArray<int32> FVoicevoxThreadCalibration::GetCandidateList()
+{
+	const int32 PhysicalCoreNum = FMath::Max(1, FPlatformMisc::NumberOfCores());
+	const int32 LogicalCoreNum = FMath::Max(PhysicalCoreNum, FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+
+	TArray<int32> CandidateList;
+	for (int32 CPUNumThreads = 1; CPUNumThreads < PhysicalCoreNum; CPUNumThreads *= 2)
+	{
+		CandidateList.Add(CPUNumThreads);
+	}
+	CandidateList.AddUnique(PhysicalCoreNum);
+	CandidateList.AddUnique(LogicalCoreNum);
+	return CandidateList;
+}
+
+/**
+ * @brief このマシンで保存したスレッド数を読み込む
+ */
+int32 FVoicevoxThreadCalibration::LoadCPUNumThreads()
+{
+	if (GConfig == nullptr) return 0;
+
+	FString MachineId;
+	int32 CPUNumThreads = 0;
+	if (!GConfig->GetString(ConfigSection, ConfigMachineIdKey, MachineId, GGameUserSettingsIni) || MachineId != GetMachineId()
+		|| !GConfig->GetInt(ConfigSection, ConfigCPUNumThreadsKey, CPUNumThreads, GGameUserSettingsIni))
+	{
+		return 0;
+	}
+	return FMath::Max(0, CPUNumThreads);
+}
+
+/**
+ * @brief このマシンのスレッド数として保存する
+ */
+void FVoicevoxThreadCalibration::SaveCPUNumThreads(const int32 CPUNumThreads)
+{
+	if (GConfig == nullptr) return;
+
+	GConfig->SetString(ConfigSection, ConfigMachineIdKey, *GetMachineId(), GGameUserSettingsIni);
+	GConfig->SetInt(ConfigSection, ConfigCPUNumThreadsKey, CPUNumThreads, GGameUserSettingsIni);
+	GConfig->Flush(false, GGameUserSettingsIni);
+}
+
+/**
+ * @brief マシンの識別文字列を取得する
+ */
+FString FVoicevoxThreadCalibration::GetMachineId()
+{
+	return FString::Printf(TEXT("%s/%d/%d"), *FPlatformMisc::GetCPUBrand().TrimStartAndEnd(),
+		FPlatformMisc::NumberOfCores(), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+}
+
+/**
+ * @brief 一定量の計算を行い、かかった時間を計測する
+ */
+double FVoicevoxThreadCalibration::RunProbe()
+{
+	const double StartTime = FPlatformTime::Seconds();
+	volatile float Value = 0.0f;
+	for (int32 Index = 0; Index < ProbeIterationNum; ++Index)
+	{
+		Value = Value * 0.5f + FMath::Sqrt(static_cast<float>(Index));
+	}
+	return FPlatformTime::Seconds() - StartTime;
+}
+
+/**
+ * @brief WAVフォーマットの音声データの長さを取得する
+ */
+double FVoicevoxThreadCalibration::GetWaveDuration(const TArray<uint8>& OutputWAV)
+{
+	FWaveModInfo WaveInfo;
+	if (OutputWAV.IsEmpty() || !WaveInfo.ReadWaveInfo(OutputWAV.GetData(), OutputWAV.Num())) return 0.0;
+
+	const int32 BytesPerFrame = *WaveInfo.pChannels * (*WaveInfo.pBitsPerSample / 8);
+	if (BytesPerFrame <= 0 || *WaveInfo.pSamplesPerSec == 0) return 0.0;
+	return static_cast<double>(WaveInfo.SampleDataSize / BytesPerFrame) / *WaveInfo.pSamplesPerSec;
+}
@@ -0,0 +1,152 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  音声合成リクエストを時刻付きで記録し、トレースファイルへ保存するクラスのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxTraceRecorder.h"
+#include "VoicevoxVoiceBank.h"
+#include "JsonObjectConverter.h"
+#include "Misc/FileHelper.h"
+#include "Subsystems/VoicevoxCoreSubsystem.h"
+
+namespace
+{
+	//! スレッド毎のAPI呼び出しの入れ子の深さ（API内部から呼び出したAPIを記録しないため）
+	thread_local int32 TraceScopeDepth = 0;
+}
+
+/**
+ * @brief コンストラクタ
+ */
+FVoicevoxTraceRecorder::FScope::FScope(FVoicevoxTraceRecorder& InRecorder, const EVoicevoxTraceApi Api)
+	: Recorder(InRecorder)
+{
+	bIsActive = TraceScopeDepth == 0 && Recorder.IsCapturing();
+	++TraceScopeDepth;
+	if (!bIsActive) return;
+
+	StartTime = FPlatformTime::Seconds();
+	Entry.Api = Api;
+	Entry.Time = StartTime - Recorder.CaptureStartTime;
+	Entry.Concurrency = ++Recorder.InFlightNum;
+}
+
+/**
+ * @brief デストラクタ（所要時間を求めて記録する）
+ */
+FVoicevoxTraceRecorder::FScope::~FScope()
+{
+	--TraceScopeDepth;
+	if (!bIsActive) return;
+
+	--Recorder.InFlightNum;
+	Entry.Latency = FPlatformTime::Seconds() - StartTime;
+
+	// 記録中にキャプチャを終了した場合は破棄する
+	FScopeLock Lock(&Recorder.CriticalSection);
+	if (Recorder.IsCapturing())
+	{
+		Recorder.EntryList.Add(MoveTemp(Entry));
+	}
+}
+
+/**
+ * @brief テキストを使うAPIのリクエスト内容を記録する
+ */
+void FVoicevoxTraceRecorder::FScope::SetText(const int64 SpeakerId, const FString& Text, const bool bKana, const bool bEnableInterrogativeUpspeak)
+{
+	if (!bIsActive) return;
+
+	Entry.SpeakerId = SpeakerId;
+	Entry.Text = Text;
+	Entry.bKana = bKana;
+	Entry.bEnableInterrogativeUpspeak = bEnableInterrogativeUpspeak;
+}
+
+/**
+ * @brief AudioQueryを使うAPIのリクエスト内容を記録する
+ */
+void FVoicevoxTraceRecorder::FScope::SetAudioQuery(const int64 SpeakerId, const FVoicevoxAudioQuery& AudioQuery, const bool bEnableInterrogativeUpspeak, const EVoicevoxSynthesisPriority Priority)
+{
+	if (!bIsActive) return;
+
+	Entry.SpeakerId = SpeakerId;
+	Entry.AudioQuery = AudioQuery;
+	Entry.AudioQueryHash = FString::Printf(TEXT("%016llx"), FVoicevoxVoiceBank::GetKey(AudioQuery, SpeakerId, bEnableInterrogativeUpspeak));
+	Entry.bEnableInterrogativeUpspeak = bEnableInterrogativeUpspeak;
+	Entry.Priority = Priority;
+}
+
+/**
+ * @brief キャプチャを開始する
+ */
+bool FVoicevoxTraceRecorder::Start(const FString& InFilePath)
+{
+	FScopeLock Lock(&CriticalSection);
+	if (IsCapturing() || InFilePath.IsEmpty()) return false;
+
+	FilePath = InFilePath;
+	EntryList.Reset();
+	CaptureStartTime = FPlatformTime::Seconds();
+	bIsCapturing = true;
+	return true;
+}
+
+/**
+ * @brief キャプチャを終了し、記録したリクエストをトレースファイルへ保存する
+ */
+bool FVoicevoxTraceRecorder::Stop()
+{
+	TArray<FVoicevoxTraceEntry> Entries;
+	FString SavePath;
+	{
+		FScopeLock Lock(&CriticalSection);
+		if (!IsCapturing()) return false;
+
+		bIsCapturing = false;
+		Entries = MoveTemp(EntryList);
+		SavePath = MoveTemp(FilePath);
+	}
+
+	// 完了順に記録しているため、リクエスト順に並べ替えてから保存する
+	Entries.StableSort([](const FVoicevoxTraceEntry& A, const FVoicevoxTraceEntry& B) { return A.Time < B.Time; });
+	TArray<FString> Lines;
+	Lines.Reserve(Entries.Num());
+	for (const FVoicevoxTraceEntry& Entry : Entries)
+	{
+		FString& Line = Lines.AddDefaulted_GetRef();
+		FJsonObjectConverter::UStructToJsonObjectString(Entry, Line, 0, 0, 0, nullptr, false);
+	}
+
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *SavePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+	{
+		UE_LOG(LogVoicevoxCore, Error, TEXT("Can't Write Trace File: %s"), *SavePath);
+		return false;
+	}
+	UE_LOG(LogVoicevoxCore, Log, TEXT("Trace Written: %s (%d Requests)"), *SavePath, Entries.Num());
+	return true;
+}
+
+/**
+ * @brief トレースファイルを読み込む
+ */
+bool FVoicevoxTraceRecorder::Load(const FString& FilePath, TArray<FVoicevoxTraceEntry>& OutEntryList)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *FilePath)) return false;
+
+	OutEntryList.Reset(Lines.Num());
+	for (const FString& Line : Lines)
+	{
+		if (Line.TrimStartAndEnd().IsEmpty()) continue;
+
+		if (FVoicevoxTraceEntry Entry; FJsonObjectConverter::JsonObjectStringToUStruct(Line, &Entry, 0, 0))
+		{
+			OutEntryList.Add(MoveTemp(Entry));
+		}
+	}
+	OutEntryList.StableSort([](const FVoicevoxTraceEntry& A, const FVoicevoxTraceEntry& B) { return A.Time < B.Time; });
+	return true;
+}
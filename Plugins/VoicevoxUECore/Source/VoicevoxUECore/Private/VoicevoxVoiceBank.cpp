@@ -0,0 +1,135 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  事前に音声合成した音声データをまとめたボイスバンクファイルの読み書きを行うCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxVoiceBank.h"
+#include "JsonObjectConverter.h"
+#include "Algo/BinarySearch.h"
+#include "Async/MappedFileHandle.h"
+#include "Hash/CityHash.h"
+#include "HAL/PlatformFileManager.h"
+#include "Serialization/Archive.h"
+
+/**
+ * @brief デストラクタ
+ */
+FVoicevoxVoiceBank::~FVoicevoxVoiceBank()
+{
+	Close();
+}
+
+/**
+ * @brief ボイスバンクの検索キーを求める
+ */
+uint64 FVoicevoxVoiceBank::GetKey(const FVoicevoxAudioQuery& AudioQuery, const int64 SpeakerId, const bool bEnableInterrogativeUpspeak)
+{
+	// 実行環境に依存しないよう、AudioQueryをJSON文字列にしてからハッシュ値を求める
+	FString AudioQueryJson;
+	FJsonObjectConverter::UStructToJsonObjectString(AudioQuery, AudioQueryJson, 0, 0, 0, nullptr, false);
+	AudioQueryJson += FString::Printf(TEXT("|%lld|%d"), SpeakerId, bEnableInterrogativeUpspeak ? 1 : 0);
+
+	const FTCHARToUTF8 Utf8(*AudioQueryJson);
+	return CityHash64(Utf8.Get(), Utf8.Length());
+}
+
+/**
+ * @brief ボイスバンクファイルを書き込む
+ */
+bool FVoicevoxVoiceBank::Write(const FString& FilePath, const TMap<uint64, TArray<uint8>>& WavMap)
+{
+	TArray<uint64> KeyList;
+	WavMap.GenerateKeyArray(KeyList);
+	KeyList.Sort();
+
+	const TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*FilePath));
+	if (!Writer) return false;
+
+	FVoicevoxVoiceBankHeader Header{FileMagic, FileVersion, static_cast<uint32>(KeyList.Num()), 0};
+	Writer->Serialize(&Header, sizeof(Header));
+
+	uint64 Offset = sizeof(FVoicevoxVoiceBankHeader) + sizeof(FVoicevoxVoiceBankEntry) * KeyList.Num();
+	for (const uint64 Key : KeyList)
+	{
+		const TArray<uint8>& OutputWAV = WavMap[Key];
+		FVoicevoxVoiceBankEntry Entry{Key, Offset, static_cast<uint64>(OutputWAV.Num())};
+		Writer->Serialize(&Entry, sizeof(Entry));
+		Offset += OutputWAV.Num();
+	}
+
+	for (const uint64 Key : KeyList)
+	{
+		const TArray<uint8>& OutputWAV = WavMap[Key];
+		Writer->Serialize(const_cast<uint8*>(OutputWAV.GetData()), OutputWAV.Num());
+	}
+
+	return Writer->Close();
+}
+
+/**
+ * @brief ボイスバンクファイルをメモリマップで開く
+ */
+bool FVoicevoxVoiceBank::Open(const FString& FilePath)
+{
+	Close();
+
+	MappedFileHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+	if (!MappedFileHandle) return false;
+
+	MappedFileRegion.Reset(MappedFileHandle->MapRegion());
+	if (!MappedFileRegion || MappedFileRegion->GetMappedSize() < static_cast<int64>(sizeof(FVoicevoxVoiceBankHeader)))
+	{
+		Close();
+		return false;
+	}
+
+	const uint8* Data = MappedFileRegion->GetMappedPtr();
+	const FVoicevoxVoiceBankHeader* Header = reinterpret_cast<const FVoicevoxVoiceBankHeader*>(Data);
+	const int64 IndexSize = sizeof(FVoicevoxVoiceBankHeader) + static_cast<int64>(sizeof(FVoicevoxVoiceBankEntry)) * Header->EntryNum;
+	if (Header->Magic != FileMagic || Header->Version != FileVersion || MappedFileRegion->GetMappedSize() < IndexSize)
+	{
+		Close();
+		return false;
+	}
+
+	EntryList = MakeArrayView(reinterpret_cast<const FVoicevoxVoiceBankEntry*>(Data + sizeof(FVoicevoxVoiceBankHeader)), Header->EntryNum);
+	return true;
+}
+
+/**
+ * @brief ボイスバンクファイルを閉じる
+ */
+void FVoicevoxVoiceBank::Close()
+{
+	EntryList = TArrayView<const FVoicevoxVoiceBankEntry>();
+	MappedFileRegion.Reset();
+	MappedFileHandle.Reset();
+}
+
+/**
+ * @brief ボイスバンクファイルを開いているか
+ */
+bool FVoicevoxVoiceBank::IsOpen() const
+{
+	return MappedFileRegion.IsValid();
+}
+
+/**
+ * @brief 検索キーに一致するWAVデータを取得する
+ */
+bool FVoicevoxVoiceBank::Find(const uint64 Key, TArray<uint8>& OutputWAV) const
+{
+	if (!IsOpen()) return false;
+
+	const int32 Index = Algo::BinarySearchBy(EntryList, Key, &FVoicevoxVoiceBankEntry::Key);
+	if (Index == INDEX_NONE) return false;
+
+	const FVoicevoxVoiceBankEntry& Entry = EntryList[Index];
+	if (Entry.Offset + Entry.Size > static_cast<uint64>(MappedFileRegion->GetMappedSize())) return false;
+
+	OutputWAV.Reset();
+	OutputWAV.Append(MappedFileRegion->GetMappedPtr() + Entry.Offset, Entry.Size);
+	return true;
+}
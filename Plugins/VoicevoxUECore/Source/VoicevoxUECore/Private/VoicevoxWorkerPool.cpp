@@ -0,0 +1,485 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  VOICEVOX COREを別プロセスで実行するワーカープールのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "VoicevoxWorkerPool.h"
+#include "JsonObjectConverter.h"
+#include "CoreGlobals.h"
+#include "Async/Async.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/CommandLine.h"
+#include "Misc/ScopeExit.h"
+#include "Subsystems/VoicevoxCoreSubsystem.h"
+
+DEFINE_LOG_CATEGORY(LogVoicevoxWorker);
+
+namespace
+{
+	//! 共有メモリ上のデータ本体の位置
+	constexpr uint32 WorkerDataOffset = Align(static_cast<uint32>(sizeof(FVoicevoxWorkerMailbox)), 16u);
+
+	//! 共有メモリ上のデータ本体の最大サイズ
+	constexpr uint32 WorkerDataCapacity = FVoicevoxWorkerPool::SharedMemorySize - WorkerDataOffset;
+
+	//! ワーカープロセスの終了を待つ時間（秒）
+	constexpr double WorkerShutdownTimeout = 5.0;
+
+	//! ワーカープロセスから親プロセスの生存を確認する間隔（秒）
+	constexpr double ParentCheckInterval = 1.0;
+
+	/**
+	 * @brief 共有メモリ上のメールボックスを取得する
+	 */
+	FVoicevoxWorkerMailbox* GetMailbox(const FPlatformMemory::FSharedMemoryRegion* Region)
+	{
+		return static_cast<FVoicevoxWorkerMailbox*>(Region->GetAddress());
+	}
+
+	/**
+	 * @brief 共有メモリ上のデータ本体を取得する
+	 */
+	uint8* GetMailboxData(const FPlatformMemory::FSharedMemoryRegion* Region)
+	{
+		return static_cast<uint8*>(Region->GetAddress()) + WorkerDataOffset;
+	}
+}
+
+//----------------------------------------------------------------
+// FVoicevoxWorkerPool（ホスト側）
+//----------------------------------------------------------------
+
+/**
+ * @brief デストラクタ
+ */
+FVoicevoxWorkerPool::~FVoicevoxWorkerPool()
+{
+	Stop();
+}
+
+/**
+ * @brief ワーカープロセスを起動する
+ */
+bool FVoicevoxWorkerPool::Start(const int32 WorkerNum, const bool bInUseGPU, const int32 InCPUNumThreads)
+{
+	Stop();
+
+	bUseGPU = bInUseGPU;
+	CPUNumThreads = InCPUNumThreads;
+
+	FScopeLock Lock(&SlotCriticalSection);
+	for (int32 Index = 0; Index < FMath::Max(WorkerNum, 1); ++Index)
+	{
+		TUniquePtr<FWorkerSlot>& Slot = SlotList.Add_GetRef(MakeUnique<FWorkerSlot>());
+		if (!SpawnWorker(*Slot))
+		{
+			break;
+		}
+	}
+
+	// 各ワーカープロセスのVOICEVOX CORE初期化は並行して進むため、起動を全て行ってから待つ
+	bool bIsSucceeded = SlotList.Num() == FMath::Max(WorkerNum, 1);
+	for (const TUniquePtr<FWorkerSlot>& Slot : SlotList)
+	{
+		if (!bIsSucceeded) break;
+		bIsSucceeded = Slot->SharedMemoryRegion != nullptr && WaitWhile(*Slot, EVoicevoxWorkerState::Starting, StartupTimeout) == EVoicevoxWorkerState::Idle;
+	}
+
+	if (!bIsSucceeded)
+	{
+		UE_LOG(LogVoicevoxWorker, Error, TEXT("Voicevox Worker Pool Start Error"));
+		for (const TUniquePtr<FWorkerSlot>& Slot : SlotList)
+		{
+			DestroyWorker(*Slot, false);
+		}
+		SlotList.Empty();
+		return false;
+	}
+
+	UE_LOG(LogVoicevoxWorker, Log, TEXT("Voicevox Worker Pool Started: %d workers"), SlotList.Num());
+	bIsRunning = true;
+	return true;
+}
+
+/**
+ * @brief 処理中のリクエストの完了を待ち、全てのワーカープロセスを終了する
+ */
+void FVoicevoxWorkerPool::Stop()
+{
+	bIsRunning = false;
+	while (ActiveRequestNum.load() > 0)
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+
+	FScopeLock Lock(&SlotCriticalSection);
+	for (const TUniquePtr<FWorkerSlot>& Slot : SlotList)
+	{
+		DestroyWorker(*Slot, true);
+	}
+	SlotList.Empty();
+}
+
+/**
+ * @brief ワーカープロセスが起動しているか
+ */
+bool FVoicevoxWorkerPool::IsRunning() const
+{
+	return bIsRunning.load();
+}
+
+/**
+ * @brief 空いているワーカープロセスにリクエストを送り、レスポンスを待つ
+ */
+bool FVoicevoxWorkerPool::Request(const EVoicevoxWorkerCommand Command, const int64 SpeakerId, const uint32 Flags, const TArrayView<const uint8> RequestData, TArray<uint8>& OutResponseData)
+{
+	if (RequestData.Num() > static_cast<int32>(WorkerDataCapacity))
+	{
+		UE_LOG(LogVoicevoxWorker, Error, TEXT("Voicevox Worker Request Too Large: %d bytes"), RequestData.Num());
+		return false;
+	}
+
+	// Stopとの競合を避けるため、起動状態の確認より先に処理中として数える
+	++ActiveRequestNum;
+	ON_SCOPE_EXIT { --ActiveRequestNum; };
+
+	FWorkerSlot* Slot = nullptr;
+	while (Slot == nullptr)
+	{
+		if (!bIsRunning.load()) return false;
+		{
+			FScopeLock Lock(&SlotCriticalSection);
+			for (const TUniquePtr<FWorkerSlot>& Candidate : SlotList)
+			{
+				if (!Candidate->bIsBusy)
+				{
+					Candidate->bIsBusy = true;
+					Slot = Candidate.Get();
+					break;
+				}
+			}
+		}
+		if (Slot == nullptr)
+		{
+			FPlatformProcess::Sleep(0.001f);
+		}
+	}
+	ON_SCOPE_EXIT
+	{
+		FScopeLock Lock(&SlotCriticalSection);
+		Slot->bIsBusy = false;
+	};
+
+	if (Slot->SharedMemoryRegion == nullptr || !FPlatformProcess::IsProcRunning(Slot->ProcHandle))
+	{
+		UE_LOG(LogVoicevoxWorker, Warning, TEXT("Voicevox Worker Not Running, Respawn: %s"), *Slot->SharedMemoryName);
+		if (!SpawnWorker(*Slot)) return false;
+	}
+
+	if (WaitWhile(*Slot, EVoicevoxWorkerState::Starting, StartupTimeout) != EVoicevoxWorkerState::Idle)
+	{
+		UE_LOG(LogVoicevoxWorker, Error, TEXT("Voicevox Worker Startup Error: %s"), *Slot->SharedMemoryName);
+		SpawnWorker(*Slot);
+		return false;
+	}
+
+	FVoicevoxWorkerMailbox* Mailbox = GetMailbox(Slot->SharedMemoryRegion);
+	Mailbox->Command = static_cast<uint32>(Command);
+	Mailbox->SpeakerId = SpeakerId;
+	Mailbox->Flags = Flags;
+	Mailbox->DataSize = RequestData.Num();
+	FMemory::Memcpy(GetMailboxData(Slot->SharedMemoryRegion), RequestData.GetData(), RequestData.Num());
+	Mailbox->State.store(static_cast<uint32>(EVoicevoxWorkerState::Request), std::memory_order_release);
+
+	EVoicevoxWorkerState State = WaitWhile(*Slot, EVoicevoxWorkerState::Request, RequestTimeout);
+	if (State == EVoicevoxWorkerState::Processing)
+	{
+		State = WaitWhile(*Slot, EVoicevoxWorkerState::Processing, RequestTimeout);
+	}
+
+	if (State == EVoicevoxWorkerState::Done)
+	{
+		OutResponseData.Reset();
+		OutResponseData.Append(GetMailboxData(Slot->SharedMemoryRegion), FMath::Min(Mailbox->DataSize, WorkerDataCapacity));
+		Mailbox->State.store(static_cast<uint32>(EVoicevoxWorkerState::Idle), std::memory_order_release);
+		return true;
+	}
+
+	if (FPlatformProcess::IsProcRunning(Slot->ProcHandle) && Mailbox->State.load(std::memory_order_acquire) == static_cast<uint32>(EVoicevoxWorkerState::Error))
+	{
+		// ワーカープロセス内でVOICEVOX COREがエラーを返した場合は、そのまま次のリクエストを受け付ける
+		Mailbox->State.store(static_cast<uint32>(EVoicevoxWorkerState::Idle), std::memory_order_release);
+		return false;
+	}
+
+	// クラッシュ、もしくは応答しないワーカープロセスは起動しなおす
+	UE_LOG(LogVoicevoxWorker, Error, TEXT("Voicevox Worker Crashed or Timed Out, Respawn: %s"), *Slot->SharedMemoryName);
+	SpawnWorker(*Slot);
+	return false;
+}
+
+/**
+ * @brief ワーカープロセスを起動する（起動済みの場合は終了してから起動しなおす）
+ */
+bool FVoicevoxWorkerPool::SpawnWorker(FWorkerSlot& Slot) const
+{
+	static std::atomic<uint32> SpawnCount = 0;
+
+	DestroyWorker(Slot, false);
+
+	// 再起動時に終了したプロセスの共有メモリと名前が衝突しないよう、起動毎に別名にする
+	Slot.SharedMemoryName = FString::Printf(TEXT("VoicevoxWorker_%u_%u"), FPlatformProcess::GetCurrentProcessId(), SpawnCount++);
+	Slot.SharedMemoryRegion = FPlatformMemory::MapNamedSharedMemoryRegion(Slot.SharedMemoryName, true,
+		FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write, SharedMemorySize);
+	if (Slot.SharedMemoryRegion == nullptr)
+	{
+		UE_LOG(LogVoicevoxWorker, Error, TEXT("Voicevox Worker Shared Memory Error: %s"), *Slot.SharedMemoryName);
+		return false;
+	}
+
+	FVoicevoxWorkerMailbox* Mailbox = new (Slot.SharedMemoryRegion->GetAddress()) FVoicevoxWorkerMailbox();
+	Mailbox->State.store(static_cast<uint32>(EVoicevoxWorkerState::Starting), std::memory_order_release);
+
+	FString Params;
+#if WITH_EDITOR
+	// エディタ実行中はエディタの実行ファイルをゲームとして起動する
+	Params = FString::Printf(TEXT("\"%s\" -game "), *FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()));
+#endif
+	Params += FString::Printf(TEXT("-VoicevoxWorker=%s -VoicevoxWorkerParent=%u -VoicevoxCPUThreads=%d %s-nullrhi -nosound -unattended -nosplash"),
+		*Slot.SharedMemoryName, FPlatformProcess::GetCurrentProcessId(), CPUNumThreads, bUseGPU ? TEXT("-VoicevoxGPU ") : TEXT(""));
+
+	Slot.ProcHandle = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *Params, false, true, true, nullptr, 0, nullptr, nullptr);
+	if (!Slot.ProcHandle.IsValid())
+	{
+		UE_LOG(LogVoicevoxWorker, Error, TEXT("Voicevox Worker Process Create Error: %s %s"), FPlatformProcess::ExecutablePath(), *Params);
+		DestroyWorker(Slot, false);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief ワーカープロセスを終了し、共有メモリを解放する
+ */
+void FVoicevoxWorkerPool::DestroyWorker(FWorkerSlot& Slot, const bool bGraceful)
+{
+	if (Slot.ProcHandle.IsValid())
+	{
+		if (bGraceful && Slot.SharedMemoryRegion != nullptr && FPlatformProcess::IsProcRunning(Slot.ProcHandle))
+		{
+			FVoicevoxWorkerMailbox* Mailbox = GetMailbox(Slot.SharedMemoryRegion);
+			Mailbox->Command = static_cast<uint32>(EVoicevoxWorkerCommand::Shutdown);
+			Mailbox->DataSize = 0;
+			Mailbox->State.store(static_cast<uint32>(EVoicevoxWorkerState::Request), std::memory_order_release);
+
+			const double StartTime = FPlatformTime::Seconds();
+			while (FPlatformProcess::IsProcRunning(Slot.ProcHandle) && FPlatformTime::Seconds() - StartTime < WorkerShutdownTimeout)
+			{
+				FPlatformProcess::Sleep(0.01f);
+			}
+		}
+
+		if (FPlatformProcess::IsProcRunning(Slot.ProcHandle))
+		{
+			FPlatformProcess::TerminateProc(Slot.ProcHandle, true);
+		}
+		FPlatformProcess::CloseProc(Slot.ProcHandle);
+		Slot.ProcHandle.Reset();
+	}
+
+	if (Slot.SharedMemoryRegion != nullptr)
+	{
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(Slot.SharedMemoryRegion);
+		Slot.SharedMemoryRegion = nullptr;
+	}
+}
+
+/**
+ * @brief メールボックスが指定の状態以外になるまで待つ
+ */
+EVoicevoxWorkerState FVoicevoxWorkerPool::WaitWhile(FWorkerSlot& Slot, const EVoicevoxWorkerState WaitState, const double Timeout)
+{
+	const FVoicevoxWorkerMailbox* Mailbox = GetMailbox(Slot.SharedMemoryRegion);
+	const double StartTime = FPlatformTime::Seconds();
+	while (true)
+	{
+		if (const EVoicevoxWorkerState State = static_cast<EVoicevoxWorkerState>(Mailbox->State.load(std::memory_order_acquire)); State != WaitState)
+		{
+			return State;
+		}
+		if (!FPlatformProcess::IsProcRunning(Slot.ProcHandle) || FPlatformTime::Seconds() - StartTime > Timeout)
+		{
+			return EVoicevoxWorkerState::Error;
+		}
+		FPlatformProcess::Sleep(0.001f);
+	}
+}
+
+//----------------------------------------------------------------
+// FVoicevoxWorker（ワーカー側）
+//----------------------------------------------------------------
+
+/**
+ * @brief ワーカープロセスとして起動されたか
+ */
+bool FVoicevoxWorker::IsWorkerProcess()
+{
+	FString SharedMemoryName;
+	return FParse::Value(FCommandLine::Get(), TEXT("-VoicevoxWorker="), SharedMemoryName) && !SharedMemoryName.IsEmpty();
+}
+
+/**
+ * @brief コンストラクタ
+ */
+FVoicevoxWorker::FVoicevoxWorker(UVoicevoxCoreSubsystem* InSubsystem) : Subsystem(InSubsystem)
+{
+	Thread = FRunnableThread::Create(this, TEXT("VoicevoxWorker"));
+}
+
+/**
+ * @brief デストラクタ
+ */
+FVoicevoxWorker::~FVoicevoxWorker()
+{
+	if (Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+	}
+}
+
+/**
+ * @brief Run
+ */
+uint32 FVoicevoxWorker::Run()
+{
+	FString SharedMemoryName;
+	uint32 ParentProcessId = 0;
+	int32 CPUNumThreads = 0;
+	FParse::Value(FCommandLine::Get(), TEXT("-VoicevoxWorker="), SharedMemoryName);
+	FParse::Value(FCommandLine::Get(), TEXT("-VoicevoxWorkerParent="), ParentProcessId);
+	FParse::Value(FCommandLine::Get(), TEXT("-VoicevoxCPUThreads="), CPUNumThreads);
+	const bool bUseGPU = FParse::Param(FCommandLine::Get(), TEXT("VoicevoxGPU"));
+
+	ON_SCOPE_EXIT
+	{
+		AsyncTask(ENamedThreads::GameThread, []
+		{
+			RequestEngineExit(TEXT("Voicevox Worker Finished"));
+		});
+	};
+
+	FPlatformMemory::FSharedMemoryRegion* Region = FPlatformMemory::MapNamedSharedMemoryRegion(SharedMemoryName, false,
+		FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write, FVoicevoxWorkerPool::SharedMemorySize);
+	if (Region == nullptr)
+	{
+		UE_LOG(LogVoicevoxWorker, Error, TEXT("Voicevox Worker Shared Memory Error: %s"), *SharedMemoryName);
+		return 1;
+	}
+	ON_SCOPE_EXIT { FPlatformMemory::UnmapNamedSharedMemoryRegion(Region); };
+
+	FVoicevoxWorkerMailbox* Mailbox = GetMailbox(Region);
+	if (!Subsystem->Initialize(bUseGPU, CPUNumThreads, false))
+	{
+		Mailbox->State.store(static_cast<uint32>(EVoicevoxWorkerState::Error), std::memory_order_release);
+		return 1;
+	}
+	Mailbox->State.store(static_cast<uint32>(EVoicevoxWorkerState::Idle), std::memory_order_release);
+	UE_LOG(LogVoicevoxWorker, Log, TEXT("Voicevox Worker Ready: %s"), *SharedMemoryName);
+
+	double LastParentCheckTime = FPlatformTime::Seconds();
+	while (!bStopRequested.load())
+	{
+		// 親プロセスが終了した場合は、ワーカープロセスも終了する
+		if (const double Now = FPlatformTime::Seconds(); ParentProcessId != 0 && Now - LastParentCheckTime > ParentCheckInterval)
+		{
+			LastParentCheckTime = Now;
+			if (!FPlatformProcess::IsApplicationRunning(ParentProcessId)) break;
+		}
+
+		if (Mailbox->State.load(std::memory_order_acquire) != static_cast<uint32>(EVoicevoxWorkerState::Request))
+		{
+			FPlatformProcess::Sleep(0.001f);
+			continue;
+		}
+
+		if (Mailbox->Command == static_cast<uint32>(EVoicevoxWorkerCommand::Shutdown))
+		{
+			Mailbox->State.store(static_cast<uint32>(EVoicevoxWorkerState::Done), std::memory_order_release);
+			break;
+		}
+
+		Mailbox->State.store(static_cast<uint32>(EVoicevoxWorkerState::Processing), std::memory_order_release);
+		const bool bIsSucceeded = ProcessRequest(*Mailbox, WorkerDataCapacity);
+		Mailbox->State.store(static_cast<uint32>(bIsSucceeded ? EVoicevoxWorkerState::Done : EVoicevoxWorkerState::Error), std::memory_order_release);
+	}
+
+	Subsystem->Finalize();
+	return 0;
+}
+
+/**
+ * @brief Stop
+ */
+void FVoicevoxWorker::Stop()
+{
+	bStopRequested = true;
+}
+
+/**
+ * @brief リクエストを処理する
+ */
+bool FVoicevoxWorker::ProcessRequest(FVoicevoxWorkerMailbox& Mailbox, const uint32 DataCapacity)
+{
+	uint8* Data = reinterpret_cast<uint8*>(&Mailbox) + WorkerDataOffset;
+	const int64 SpeakerId = Mailbox.SpeakerId;
+	const bool bKana = (Mailbox.Flags & EVoicevoxWorkerFlag::Kana) != 0;
+	const bool bEnableInterrogativeUpspeak = (Mailbox.Flags & EVoicevoxWorkerFlag::InterrogativeUpspeak) != 0;
+
+	// リクエストのデータ本体はnull終端されていないUTF-8文字列
+	TArray<ANSICHAR> RequestText;
+	RequestText.Append(reinterpret_cast<const ANSICHAR*>(Data), FMath::Min(Mailbox.DataSize, DataCapacity));
+	RequestText.Add('\0');
+
+	if (!LoadedSpeakerSet.Contains(SpeakerId))
+	{
+		if (!Subsystem->LoadModel(SpeakerId)) return false;
+		LoadedSpeakerSet.Add(SpeakerId);
+	}
+
+	TArray<uint8> ResponseData;
+	switch (static_cast<EVoicevoxWorkerCommand>(Mailbox.Command))
+	{
+	case EVoicevoxWorkerCommand::AudioQuery:
+		{
+			const FVoicevoxAudioQuery AudioQuery = Subsystem->GetAudioQuery(SpeakerId, UTF8_TO_TCHAR(RequestText.GetData()), bKana);
+			FString AudioQueryJson;
+			FJsonObjectConverter::UStructToJsonObjectString(AudioQuery, AudioQueryJson, 0, 0, 0, nullptr, false);
+			const FTCHARToUTF8 Utf8(*AudioQueryJson);
+			ResponseData.Append(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+		}
+		break;
+	case EVoicevoxWorkerCommand::TextToSpeech:
+		ResponseData = Subsystem->RunTextToSpeech(SpeakerId, UTF8_TO_TCHAR(RequestText.GetData()), bKana, bEnableInterrogativeUpspeak);
+		break;
+	case EVoicevoxWorkerCommand::Synthesis:
+		ResponseData = Subsystem->RunSynthesis(RequestText.GetData(), SpeakerId, bEnableInterrogativeUpspeak);
+		break;
+	default:
+		return false;
+	}
+
+	if (ResponseData.IsEmpty()) return false;
+	if (ResponseData.Num() > static_cast<int32>(DataCapacity))
+	{
+		UE_LOG(LogVoicevoxWorker, Error, TEXT("Voicevox Worker Response Too Large: %d bytes"), ResponseData.Num());
+		return false;
+	}
+
+	FMemory::Memcpy(Data, ResponseData.GetData(), ResponseData.Num());
+	Mailbox.DataSize = ResponseData.Num();
+	return true;
+}
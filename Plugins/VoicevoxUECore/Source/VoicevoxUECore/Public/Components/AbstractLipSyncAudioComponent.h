@@ -12,11 +12,36 @@
 #include "VoicevoxQuery.h"
 #include "VoicevoxUEDefined.h"
 #include "Components/AudioComponent.h"
+#include <atomic>
 #include "AbstractLipSyncAudioComponent.generated.h"
 
+class UVoicevoxSoundWaveProcedural;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnCreateSoundWave);
 DECLARE_MULTICAST_DELEGATE(FOnCreateSoundWaveNative);
 
+/**
+ * @struct FVoicevoxLongTextChunk
+ * @brief 音声合成したデータ（長文パイプライン再生では文単位）をワーカースレッドで解析し、ゲームスレッドへ受け渡す構造体
+ */
+struct FVoicevoxLongTextChunk
+{
+	//! WAVヘッダーを除いたPCMデータ
+	TArray<uint8> PCMData;
+
+	//! サンプリングレート
+	int32 SampleRate = 0;
+
+	//! チャンネル数
+	int32 NumChannels = 0;
+
+	//! PCMデータの再生時間（秒）
+	float Duration = 0.0f;
+
+	//! リップシンクのデータリスト
+	TArray<FVoicevoxLipSync> LipSyncList;
+};
+
 /**
  * @class UAbstractLipSyncAudioComponent
  * @brief VOICEVOXから生成したデータを元に音再生とリップシンク再生を行う抽象AudioComponentクラス
@@ -35,6 +60,9 @@ class VOICEVOXUECORE_API UAbstractLipSyncAudioComponent : public UAudioComponent
 	//!　音生成タスク実行中か？
 	bool bIsExecTts = false;
 
+	//! 音生成タスクの依頼番号（キャンセル時にも更新し、古いタスクの完了処理を破棄する）
+	uint32 TtsRequestSerial = 0;
+
 	//! モーフターゲット値のマップ
 	TMap<ELipSyncVowelType, float> LipSyncMorphNumMap;
 
@@ -49,6 +77,32 @@ class VOICEVOXUECORE_API UAbstractLipSyncAudioComponent : public UAudioComponent
 
 	//! 簡易リップシンク再生をしているか
 	bool bIsPlayLipSyncSimple = false;
+
+	//! 長文パイプライン再生中か
+	bool bIsLongTextStreaming = false;
+
+	//! 長文パイプライン再生のオーディオ再生を開始したか
+	bool bIsLongTextPlaying = false;
+
+	//! 長文パイプライン再生のキャンセル要求
+	std::atomic<bool> bIsLongTextCancelled = false;
+
+	//! 長文パイプライン再生でキューに積んだ音声の総再生時間（秒）
+	float LongTextQueuedDuration = 0.0f;
+
+	//! 長文パイプライン再生でキューに積んだ音声をオーディオレンダースレッドが全て読み出した時刻（秒、読み出し中は0）
+	double LongTextRenderedEndTime = 0.0;
+
+	//! オーディオデバイスの出力バッファによる遅延（秒）
+	float OutputLatency = 0.0f;
+
+	//! 再生中のAudioQueryアセットのベイク済みリップシンクカーブ（無い場合はnullptr）
+	UPROPERTY(Transient)
+	TObjectPtr<UCurveTable> LipSyncCurveTable;
+
+	//! コアのプールから取得して再生中のSoundWave（再生終了時にプールへ返す）
+	UPROPERTY(Transient)
+	TObjectPtr<UVoicevoxSoundWaveProcedural> PooledSoundWave;
 	
 	/**
 	 * @brief OnAudioPlaybackPercentのコールバック
@@ -59,18 +113,15 @@ class VOICEVOXUECORE_API UAbstractLipSyncAudioComponent : public UAudioComponent
 	void HandlePlaybackPercent(const UAudioComponent* InComponent, const USoundWave* InSoundWave, const float InPlaybackPercentage);
 
 	/**
-	 * @brief BeginPlay
+	 * @brief OnAudioFinishedのコールバック
+	 * @param InComponent 
 	 */
-	virtual void BeginPlay() override;
-	
+	void HandleAudioFinished(UAudioComponent* InComponent);
+
 	/**
-	 * @brief TickComponent
-	 * @param DeltaTime 
-	 * @param TickType 
-	 * @param ThisTickFunction 
+	 * @brief BeginPlay
 	 */
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
-							   FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void BeginPlay() override;
 	
 	/**
 	 * @brief EndPlay 
@@ -85,12 +136,77 @@ class VOICEVOXUECORE_API UAbstractLipSyncAudioComponent : public UAudioComponent
 	 */
 	void ToSoundWave(int64 SpeakerType, bool bEnableInterrogativeUpspeak = true);
 
+	/**
+	 * @brief 音声データを生成してSoundWaveへ変換し、音声データの振幅包絡からリップシンクデータを生成する
+	 * @param [in] SynthesisFunction				: 音声データを生成する関数（タスク内で実行）
+	 */
+	void ToSoundWaveFromWAV(TUniqueFunction<TArray<uint8>()> SynthesisFunction);
+
+	/**
+	 * @brief 音生成タスクの完了処理をゲームスレッドで実行するキューへ積む
+	 * @param [in] Serial							: 音生成タスクの依頼番号（実行時に変わっていた場合は完了処理を破棄する）
+	 * @param [in] Completion						: ゲームスレッドで実行する完了処理
+	 */
+	void EnqueueTtsCompletion(uint32 Serial, TUniqueFunction<void()>&& Completion);
+
+	/**
+	 * @brief WAVデータを解析してPCMデータを取り出す
+	 * @param [in] OutputWAV						: WAVフォーマットの音声データ
+	 * @param [out] OutChunk						: PCMデータ、サンプリングレート、チャンネル数、再生時間
+	 * @return 解析できたらtrue
+	 * @details ワーカースレッドから呼び出す
+	 */
+	static bool ReadChunkFromWAV(const TArray<uint8>& OutputWAV, FVoicevoxLongTextChunk& OutChunk);
+
+	/**
+	 * @brief 解析済みの音声データからSoundWaveを生成してセットし、再生する
+	 * @param [in] Chunk							: 解析済みの音声データとリップシンクのデータリスト
+	 * @details ゲームスレッド（音生成タスクの完了処理）から呼び出す
+	 */
+	void PlaySoundWaveFromChunk(FVoicevoxLongTextChunk& Chunk);
+
+	/**
+	 * @brief 長文パイプライン再生で合成済みの文をSoundWaveとリップシンクリストへ追加する
+	 * @param [in] Chunk							: 文単位の音声データとリップシンクのデータリスト
+	 * @details ゲームスレッド（音生成タスクの完了処理）から呼び出す
+	 */
+	void AppendLongTextChunk(FVoicevoxLongTextChunk& Chunk);
+
+	/**
+	 * @brief 再生を止めてSoundWaveを外し、コアのプールから取得したSoundWaveであればプールへ返す
+	 */
+	void ReleasePooledSoundWave();
+
+	/**
+	 * @brief 長文パイプライン再生の実行中タスクをキャンセルして完了まで待機する
+	 */
+	void CancelLongTextStreaming();
+
 	/**
 	 * @briefテキストから音声変換を実行中かチェック
 	 * @return trueの場合はテキストから音声変換のタスク実行中
 	 */
 	bool CheckExecTts() const;
 
+	/**
+	 * @brief リップシンクに使用する再生時間を取得する
+	 * @param [in] PlaybackTime : OnAudioPlaybackPercentから求めた再生時間（秒）
+	 * @return コンポーネントが生成したSoundWaveの場合はオーディオレンダースレッドの読み出し位置から出力遅延を引いた時間、それ以外はPlaybackTime
+	 */
+	float GetLipSyncPlaybackTime(float PlaybackTime) const;
+
+	/**
+	 * @brief オーディオレンダースレッドが読み出してから実際に再生されるまでの遅延を取得する
+	 * @return AudioLatencyCompensationが0以上の場合はその値、それ以外はオーディオデバイスの出力バッファによる遅延（秒）
+	 */
+	float GetAudioLatency() const;
+
+	/**
+	 * @brief ベイク済みのリップシンクカーブを評価してモーフターゲット値を通知する
+	 * @param [in] PlaybackTime : 再生時間（秒）
+	 */
+	void UpdateLipSyncCurve(float PlaybackTime);
+
 	/**
 	 * @brief モーフターゲット値を初期化
 	 */
@@ -157,6 +273,10 @@ public:
 	//! 簡易的なリップシンクを実行するか。
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Voicevox|LipSync")
 	bool bEnabledSimpleLipSync = false;
+
+	//! 音声出力の遅延補正（秒）。負の値の場合はオーディオデバイスの出力バッファサイズから自動で算出する
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Voicevox|LipSync", meta=(ClampMax = "0.5", UIMin = "-1.0", UIMax = "0.5"))
+	float AudioLatencyCompensation = -1.0f;
 	
 	/**
 	 * @brief コンストラクタ
@@ -186,6 +306,24 @@ public:
 	void PlayToText(FString Message, bool bRunKana = false, bool bEnableInterrogativeUpspeak = true,
 		float SpeedScale = 1.0f, float PitchScale = 0.0f,  float IntonationScale = 1.0f, float VolumeScale = 1.0f, float PrePhonemeLength = 0.1f, float PostPhonemeLength = 0.1f);
 
+	/**
+	 * @brief 長文テキストを文単位に分割し、解析・音声合成・再生をパイプラインで実行しながら音再生とリップシンク再生を行います。
+	 * @param [in] Message							: 音声データに変換するtextデータ
+	 * @param [in] bRunKana							: AquesTalkライクな記法で実行するか
+	 * @param [in] bEnableInterrogativeUpspeak		: 疑問文の調整を有効にする
+	 * @param [in] SpeedScale						: 話速
+	 * @param [in] PitchScale						: 音高
+	 * @param [in] IntonationScale					: 抑揚
+	 * @param [in] VolumeScale						: 音量
+	 * @param [in] PrePhonemeLength					: 開始無音（最初の文のみ適用）
+	 * @param [in] PostPhonemeLength				: 終了無音（各文の末尾に適用）
+	 * @details 「。」「！」「？」や改行で文を分割し、N+1文目のテキスト解析、N文目の音声合成、N-1文目の再生を並行して行います。<br/>
+	 *			合成済みの文は順に一つのSoundWaveへ連結されるため、全文の合成完了を待たずに再生が始まります。
+	 */
+	UFUNCTION(BlueprintCallable, Category="Voicevox|LipSync")
+	void PlayToLongText(FString Message, bool bRunKana = false, bool bEnableInterrogativeUpspeak = true,
+		float SpeedScale = 1.0f, float PitchScale = 0.0f,  float IntonationScale = 1.0f, float VolumeScale = 1.0f, float PrePhonemeLength = 0.1f, float PostPhonemeLength = 0.1f);
+
 	/**
 	 * @brief VOICEVOX COREで取得したAudioQueryを元にSoundWaveを生成後、音再生とリップシンク再生を行います。
 	 * @param [in] Query							: VOICEVOXのAudioQuery
@@ -194,6 +332,33 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Voicevox|LipSync")
 	void PlayToAudioQuery(const FVoicevoxAudioQuery& Query, bool bEnableInterrogativeUpspeak = true);
 
+	/**
+	 * @brief テキストをAudioQuery無しで音声合成し、音声データの振幅包絡から生成したリップシンクで音再生とリップシンク再生を行います。
+	 * @param [in] Message							: 音声データに変換するtextデータ
+	 * @param [in] bRunKana							: AquesTalkライクな記法で実行するか
+	 * @param [in] bEnableInterrogativeUpspeak		: 疑問文の調整を有効にする
+	 * @details AudioQueryの取得を別途行わないため、PlayToTextより口の形の精度は落ちます。
+	 */
+	UFUNCTION(BlueprintCallable, Category="Voicevox|LipSync")
+	void PlayToTextToSpeech(FString Message, bool bRunKana = false, bool bEnableInterrogativeUpspeak = true);
+
+	/**
+	 * @brief 定型文の差し込み部分だけ音声合成してSoundWaveを生成後、音再生とリップシンク再生を行います。
+	 * @param [in] Template							: 定型文（差し込み部分は{名前}で記述する）
+	 * @param [in] SlotValues						: 差し込み部分の名前とテキストのマップ
+	 * @param [in] bEnableInterrogativeUpspeak		: 疑問文の調整を有効にする
+	 * @details 固定部分は初回に音声合成してキャッシュするため、2回目以降は差し込み部分の音声合成のみ行います。
+	 */
+	UFUNCTION(BlueprintCallable, Category="Voicevox|LipSync")
+	void PlayToLineTemplate(FString Template, const TMap<FString, FString>& SlotValues, bool bEnableInterrogativeUpspeak = true);
+
+	/**
+	 * @brief 生成済みの音声データからSoundWaveを生成後、音声データの振幅包絡から生成したリップシンクで音再生とリップシンク再生を行います。
+	 * @param [in] OutputWAV						: WAVフォーマットの音声データ
+	 */
+	UFUNCTION(BlueprintCallable, Category="Voicevox|LipSync")
+	void PlayToWAV(const TArray<uint8>& OutputWAV);
+
 	/**
 	 * @brief AudioQueryアセットからSoundWaveを生成後、音再生とリップシンク再生を行います。
 	 * @param [in] VoicevoxQuery					: Queryアセット
@@ -219,6 +384,15 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, Category="Voicevox|LipSync")
 	void SetLipSyncDataToAudioQueryAsset(UVoicevoxQuery* VoicevoxQuery);
+
+	/**
+	 * @brief 音声データをセットして、振幅包絡からリップシンクデータを事前生成します
+	 * @details AudioQueryを持たない音声データをSetSoundでセット後、リップシンクを行う場合は元の音声データを渡してリップシンクデータを生成してください。<br/>
+	*			サウンド再生中はバグを防ぐため更新は行いません。サウンドをStopした状態で呼び出してください。
+	 * @param [in] OutputWAV : リップシンクデータを生成するWAVフォーマットの音声データ
+	 */
+	UFUNCTION(BlueprintCallable, Category="Voicevox|LipSync")
+	void SetLipSyncDataToWAV(const TArray<uint8>& OutputWAV);
 };
 
 VOICEVOXUECORE_API DECLARE_LOG_CATEGORY_EXTERN(LogVoicevoxLipSync, Log, All);
\ No newline at end of file
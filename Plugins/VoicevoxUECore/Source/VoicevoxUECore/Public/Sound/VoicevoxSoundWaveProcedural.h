@@ -0,0 +1,83 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxSoundWaveProcedural.h
+ * @brief  オーディオレンダースレッドで再生位置を公開するUSoundWaveProceduralのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Sound/SoundWaveProcedural.h"
+#include <atomic>
+#include "VoicevoxSoundWaveProcedural.generated.h"
+
+/**
+ * @class UVoicevoxSoundWaveProcedural
+ * @brief オーディオレンダースレッドが読み出したサンプル数をアトミック変数で公開するUSoundWaveProcedural
+ * @details
+ * OnAudioPlaybackPercentはゲームスレッドの通知間隔でしか更新されず、オーディオレンダースレッドより遅れるため、
+ * リップシンクはこのクラスが公開する読み出し位置から出力バッファ分の遅延を引いた時間で同期します。<br/>
+ * 再生が終わったインスタンスはUVoicevoxCoreSubsystemのプールへ返し、次の音声データで再利用します。
+ */
+UCLASS()
+class VOICEVOXUECORE_API UVoicevoxSoundWaveProcedural : public USoundWaveProcedural
+{
+	GENERATED_BODY()
+
+	//! オーディオレンダースレッドが読み出したフレーム数
+	std::atomic<int64> RenderedFrameNum = 0;
+
+	//! プールへ返した時刻（FPlatformTime::Seconds()）
+	double ReleasedTime = 0.0;
+
+	//! オーディオレンダースレッドが最後にGeneratePCMDataを呼び出した時刻（FPlatformTime::Seconds()）
+	std::atomic<double> LastGeneratedTime = 0.0;
+
+public:
+
+	/**
+	 * @brief GeneratePCMData override
+	 * @details オーディオレンダースレッドから呼び出され、キューから読み出したフレーム数と呼び出した時刻を記録します。
+	 */
+	virtual int32 GeneratePCMData(uint8* PCMData, const int32 SamplesNeeded) override;
+
+	/**
+	 * @brief オーディオレンダースレッドが読み出した音声の時間を取得する
+	 * @return キューから読み出した音声の時間（秒）。アンダーフローで無音を出力した時間は含まない
+	 */
+	double GetRenderedTime() const;
+
+	/**
+	 * @brief 読み出し位置をリセットする
+	 */
+	void ResetRenderedTime();
+
+	/**
+	 * @brief PCMデータをキューへ積み、再生時間、サンプリングレート、チャンネル数を設定する
+	 * @param[in] PCMData WAVヘッダーを除いた16bitのPCMデータ
+	 * @param[in] PCMDataSize PCMデータのバイト数
+	 * @param[in] InSampleRate サンプリングレート
+	 * @param[in] InNumChannels チャンネル数
+	 */
+	void QueuePCMData(const uint8* PCMData, int32 PCMDataSize, int32 InSampleRate, int32 InNumChannels);
+
+	/**
+	 * @brief 再利用できるよう、キューに残った音声データと再生時間、読み出し位置を破棄する
+	 * @details オーディオレンダースレッドが読み出し中の場合に競合するため、CanReuseがtrueの場合のみ呼び出してください。
+	 */
+	void ResetForReuse();
+
+	/**
+	 * @brief プールへ返した時刻を記録する
+	 */
+	void MarkReleased();
+
+	/**
+	 * @brief 再利用できるか
+	 * @param[in] ReuseDelay プールへ返してから、およびオーディオレンダースレッドが最後に読み出してから待つ時間（秒）
+	 * @return 返してから待つ時間が経ち、その間どのサウンドからも読み出されていなければtrue
+	 */
+	bool CanReuse(double ReuseDelay) const;
+};
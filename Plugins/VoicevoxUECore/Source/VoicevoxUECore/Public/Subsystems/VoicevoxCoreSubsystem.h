@@ -12,14 +12,74 @@
 #include "VoicevoxNativeObject.h"
 #include "VoicevoxUEDefined.h"
 #include "VoicevoxQuery.h"
+#include "VoicevoxVoiceBank.h"
+#include "VoicevoxWorkerPool.h"
+#include "VoicevoxSynthesisServer.h"
+#include "VoicevoxSpeculativeSynthesis.h"
+#include "VoicevoxThreadCalibration.h"
+#include "VoicevoxSynthesisThrottle.h"
+#include "VoicevoxQualityGovernor.h"
+#include "VoicevoxSynthesisCostModel.h"
+#include "VoicevoxCompletionQueue.h"
+#include "VoicevoxLineCache.h"
+#include "VoicevoxTraceRecorder.h"
+#include "VoicevoxMemoryTracker.h"
 #include "Subsystems/EngineSubsystem.h"
+#include <atomic>
 #include "VoicevoxCoreSubsystem.generated.h"
 
+//----------------------------------------------------------------
+// struct
+//----------------------------------------------------------------
+
+/**
+ * @struct FVoicevoxPhrasePCM
+ * @brief アクセント句単位でキャッシュする音声データ構造体
+ */
+struct FVoicevoxPhrasePCM
+{
+	//! 前後のアクセント句との境界でクロスフェードする分を含めた16bitPCMデータ
+	TArray<int16> Samples;
+
+	//! サンプリングレート
+	int32 SampleRate = 0;
+
+	//! チャンネル数
+	int32 NumChannels = 0;
+};
+
+/**
+ * @struct FVoicevoxTemplatePart
+ * @brief 定型文を固定部分と差し込み部分に分割した1つ分の構造体
+ */
+struct FVoicevoxTemplatePart
+{
+	//! 固定部分のテキスト、もしくは差し込み部分の名前（差し込み後はテキスト）
+	FString Text;
+
+	//! 差し込み部分か
+	bool bIsSlot = false;
+};
+
+/**
+ * @struct FVoicevoxTemplateSegment
+ * @brief 定型文の固定部分、もしくは差し込み部分を音声合成した結果の構造体
+ */
+struct FVoicevoxTemplateSegment
+{
+	//! 部分のAudioQuery（境界の抑揚の調整とリップシンクに使用する）
+	FVoicevoxAudioQuery AudioQuery;
+
+	//! 部分の音声データ（アクセント句が無い場合は空）
+	FVoicevoxPhrasePCM PCM;
+};
+
 //----------------------------------------------------------------
 // class
 //----------------------------------------------------------------
 
 class UVoicevoxNativeObject;
+class UVoicevoxSoundWaveProcedural;
 
 /**
  * @class UVoicevoxCoreSubsystem
@@ -68,6 +128,100 @@ class VOICEVOXUECORE_API UVoicevoxCoreSubsystem : public UEngineSubsystem
 	UPROPERTY()
 	bool bIsInitialized = false;
 
+	//! Initializeで指定されたGPUモード（推論スレッド数の計測後に元の設定で初期化し直すため）
+	bool bInitializeUseGPU = false;
+
+	//! Initializeで指定された推論スレッド数
+	int32 InitializeCPUNumThreads = 0;
+
+	//! Initializeで指定された全モデルのロード
+	bool bInitializeLoadAllModels = false;
+
+	//! VOICEVOX COREの呼び出しの排他制御（推論スレッド数の計測中は初期化し直すため、このプロセスでの呼び出しを待機させる）
+	mutable FRWLock NativeCoreLock;
+
+	//! 再生が終わり、再利用を待っているSoundWaveのプール
+	UPROPERTY()
+	TArray<TObjectPtr<UVoicevoxSoundWaveProcedural>> SoundWavePool;
+
+	//! SoundWaveのプールに保持する最大数（超えた分はガベージコレクションに任せる）
+	static constexpr int32 SoundWavePoolMaxNum = 16;
+
+	//! プールへ返してから、およびオーディオレンダースレッドが最後に読み出してから再利用するまでの時間（秒）
+	static constexpr double SoundWaveReuseDelay = 0.5;
+
+	//! アクセント句単位の音声データキャッシュ（キーはアクセント句と前後のアクセント句、合成パラメータの文字列から求めた64bitハッシュ値）
+	TMap<uint64, FVoicevoxPhrasePCM> PhrasePCMCacheMap;
+
+	//! 音声データキャッシュの使用順キーリスト（上限を超えた場合は最も長く使われていないものから破棄する）
+	TArray<uint64> PhrasePCMCacheKeyList;
+
+	//! 音声データキャッシュの排他制御
+	mutable FCriticalSection PhrasePCMCacheCriticalSection;
+
+	//! アクセント句単位の音声データキャッシュの最大数
+	static constexpr int32 PhrasePCMCacheMaxNum = 1024;
+
+	//! アクセント句の境界でクロスフェードする時間（秒）
+	static constexpr float PhraseCrossfadeTime = 0.01f;
+
+	//! 事前に音声合成した定型文の固定部分（キーは固定部分のテキスト、位置、話者番号、疑問文調整から求めたハッシュ値）
+	TMap<uint64, FVoicevoxTemplateSegment> TemplateSegmentCacheMap;
+
+	//! 定型文の固定部分の登録順キーリスト（上限を超えた場合は古いものから破棄する）
+	TArray<uint64> TemplateSegmentCacheKeyList;
+
+	//! 定型文の固定部分の排他制御
+	mutable FCriticalSection TemplateSegmentCacheCriticalSection;
+
+	//! 定型文の固定部分の最大数
+	static constexpr int32 TemplateSegmentCacheMaxNum = 256;
+
+	//! 定型文の差し込み部分の境界で調整する音高の上限
+	static constexpr float TemplateMaxPitchOffset = 0.5f;
+
+	//! 最近再生したセリフをADPCMで圧縮して保持するキャッシュ
+	mutable FVoicevoxLineCache RecentLineCache;
+
+	//! 事前に音声合成した音声データのボイスバンク
+	FVoicevoxVoiceBank VoiceBank;
+
+	//! ボイスバンクの排他制御
+	mutable FRWLock VoiceBankLock;
+
+	//! 再生用に変換するサンプリングレート（0の場合は変換しない）
+	std::atomic<int32> PlaybackSampleRate = 0;
+
+	//! VOICEVOX COREを別プロセスで実行するワーカープール（ホスト側）
+	mutable FVoicevoxWorkerPool WorkerPool;
+
+	//! ワーカープロセスとして起動された場合のリクエスト受付（ワーカー側）
+	TUniquePtr<FVoicevoxWorker> Worker;
+
+	//! 他のプロセスへVOICEVOX COREを公開する音声合成サーバー
+	TUniquePtr<FVoicevoxSynthesisServer> SynthesisServer;
+
+	//! 選択肢等の候補テキストの投機的な音声合成
+	TUniquePtr<FVoicevoxSpeculativeSynthesis> SpeculativeSynthesis;
+
+	//! 音声合成の同時実行数、スレッド優先度、フレーム時間に応じた抑制
+	mutable FVoicevoxSynthesisThrottle SynthesisThrottle;
+
+	//! 音声合成の負荷に応じた品質の調整
+	mutable FVoicevoxQualityGovernor QualityGovernor;
+
+	//! 話者毎のモーラあたりの合成時間による所要時間の予測
+	mutable FVoicevoxSynthesisCostModel SynthesisCostModel;
+
+	//! 非同期の音声合成の完了処理をゲームスレッドで実行するキュー
+	mutable FVoicevoxCompletionQueue CompletionQueue;
+
+	//! 性能の回帰テスト用に音声合成リクエストを記録するトレース
+	mutable FVoicevoxTraceRecorder TraceRecorder;
+
+	//! VOICEVOX COREの初期化、モデルのロードで増加したネイティブ側の常駐メモリ
+	mutable FVoicevoxNativeMemoryTracker NativeMemoryTracker;
+
 	//----------------------------------------------------------------
 	// Function
 	//----------------------------------------------------------------
@@ -88,6 +242,153 @@ class VOICEVOXUECORE_API UVoicevoxCoreSubsystem : public UEngineSubsystem
 	 * @param [in] bIsGpuMode
 	 */
 	void AddVoicevoxConfigData(const FString& CoreName, TArray<FVoicevoxMeta> List, FVoicevoxSupportedDevices SupportedDevices, const FString& Version, const bool bIsGpuMode);
+
+	//--------------------------------
+	// アクセント句キャッシュ関連
+	//--------------------------------
+
+	/**
+	 * @brief アクセント句の内容をキャッシュのキーに使う文字列にする
+	 * @param[in] AccentPhrase アクセント句
+	 * @return アクセント句をJSON文字列にしたもの
+	 */
+	static FString GetAccentPhraseKeyText(const FVoicevoxAccentPhrase& AccentPhrase);
+
+	/**
+	 * @brief VOICEVOX COREの音素長の丸め方に合わせて、アクセント句のフレーム数を求める
+	 * @param[in] AccentPhrase アクセント句
+	 * @param[in] SpeedScale 話速
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にするか
+	 * @return アクセント句のフレーム数（1フレームは24kHzで256サンプル）
+	 */
+	static int32 GetAccentPhraseFrameNum(const FVoicevoxAccentPhrase& AccentPhrase, float SpeedScale, bool bEnableInterrogativeUpspeak);
+
+	/**
+	 * @brief 連続したアクセント句の範囲を前後1句の文脈付きで音声合成し、アクセント句単位に切り出す
+	 * @param[in] AudioQuery AudioQuery構造体
+	 * @param[in] FirstIndex 切り出す最初のアクセント句のインデックス
+	 * @param[in] LastIndex 切り出す最後のアクセント句のインデックス
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @param[out] OutPhrasePCMList アクセント句単位の音声データリスト（AudioQueryのアクセント句と同じ要素数）
+	 * @return 音声合成に成功したらtrue
+	 */
+	bool SynthesisAccentPhraseRange(const FVoicevoxAudioQuery& AudioQuery, int32 FirstIndex, int32 LastIndex, int64 SpeakerId,
+									bool bEnableInterrogativeUpspeak, TArray<FVoicevoxPhrasePCM>& OutPhrasePCMList) const;
+
+	/**
+	 * @brief 音声データの末尾に、境界を短いクロスフェードで繋いで音声データを追加する
+	 * @param[in,out] Samples 追加先の16bitPCMデータ
+	 * @param[in] PhrasePCM 追加する音声データ
+	 * @param[in] CrossfadeFrameNum クロスフェードするフレーム数
+	 */
+	static void AppendPhrasePCM(TArray<int16>& Samples, const FVoicevoxPhrasePCM& PhrasePCM, int32 CrossfadeFrameNum);
+
+	//--------------------------------
+	// 定型文関連
+	//--------------------------------
+
+	/**
+	 * @brief 定型文を固定部分と差し込み部分（{名前}）に分割する
+	 * @param[in] Template 定型文
+	 * @param[out] OutParts 分割した部分のリスト（空の固定部分は含めない）
+	 * @return 差し込み部分の括弧が閉じていない場合はfalse
+	 */
+	static bool ParseLineTemplate(const FString& Template, TArray<FVoicevoxTemplatePart>& OutParts);
+
+	/**
+	 * @brief 定型文の固定部分をキャッシュから取得する（無い場合は音声合成してキャッシュする）
+	 * @param[in] Text 固定部分のテキスト
+	 * @param[in] bIsFirst 定型文の先頭か（先頭以外は開始無音を含めない）
+	 * @param[in] bIsLast 定型文の末尾か（末尾以外は終了無音を含めない）
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @param[out] OutSegment 固定部分のAudioQueryと音声データ
+	 * @return 音声合成に成功したらtrue
+	 */
+	bool FindOrSynthesisTemplateSegment(const FString& Text, bool bIsFirst, bool bIsLast, int64 SpeakerId, bool bEnableInterrogativeUpspeak, FVoicevoxTemplateSegment& OutSegment);
+
+	/**
+	 * @brief 定型文の部分を音声合成する
+	 * @param[in] AudioQuery 部分のAudioQuery
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @param[out] OutPCM 部分の音声データ
+	 * @return 音声合成に成功したらtrue
+	 */
+	bool SynthesisTemplateSegment(const FVoicevoxAudioQuery& AudioQuery, int64 SpeakerId, bool bEnableInterrogativeUpspeak, FVoicevoxPhrasePCM& OutPCM) const;
+
+	/**
+	 * @brief 差し込み部分の音高を、前後の部分との境界のモーラの音高へ近づける
+	 * @param[in,out] SlotAudioQuery 差し込み部分のAudioQuery
+	 * @param[in] PrevAudioQuery 直前の部分のAudioQuery（無い場合はnullptr）
+	 * @param[in] NextAudioQuery 直後の部分のAudioQuery（無い場合はnullptr）
+	 * @details 境界毎の音高の差を差し込み部分の有声モーラへ線形に配分して加えるため、差し込み部分のアクセントの形は保たれます。
+	 */
+	static void AdjustTemplateSlotPitch(FVoicevoxAudioQuery& SlotAudioQuery, const FVoicevoxAudioQuery* PrevAudioQuery, const FVoicevoxAudioQuery* NextAudioQuery);
+
+	//--------------------------------
+	// ボイスバンク関連
+	//--------------------------------
+
+	/**
+	 * @brief ボイスバンクから音声データを検索する
+	 * @param[in] AudioQuery AudioQuery構造体
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @param[out] OutputWAV 音声データ
+	 * @return ボイスバンクに音声データがあればtrue
+	 */
+	bool FindVoiceBank(const FVoicevoxAudioQuery& AudioQuery, int64 SpeakerId, bool bEnableInterrogativeUpspeak, TArray<uint8>& OutputWAV) const;
+
+	//--------------------------------
+	// 最近再生したセリフのキャッシュ関連
+	//--------------------------------
+
+	/**
+	 * @brief 最近再生したセリフのキャッシュから音声データを展開する
+	 * @param[in] AudioQuery AudioQuery構造体
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @param[out] OutputWAV 音声データ
+	 * @return キャッシュに音声データがあればtrue
+	 */
+	bool FindRecentLine(const FVoicevoxAudioQuery& AudioQuery, int64 SpeakerId, bool bEnableInterrogativeUpspeak, TArray<uint8>& OutputWAV) const;
+
+	/**
+	 * @brief 音声合成した音声データを最近再生したセリフのキャッシュへ圧縮して保持する
+	 * @param[in] AudioQuery AudioQuery構造体
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @param[in] OutputWAV 音声データ
+	 */
+	void AddRecentLine(const FVoicevoxAudioQuery& AudioQuery, int64 SpeakerId, bool bEnableInterrogativeUpspeak, const TArray<uint8>& OutputWAV) const;
+
+	//--------------------------------
+	// VOICEVOX CORE呼び出し関連
+	//--------------------------------
+
+	/**
+	 * @brief 投機的な音声合成の結果を参照せず、ワーカープロセス、もしくはVOICEVOX COREでAudioQueryを取得する
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] Message 音声データに変換するtextデータ
+	 * @param[in] bKana aquestalk形式のkanaとしてテキストを解釈する
+	 * @return AudioQuery
+	 */
+	FVoicevoxAudioQuery RequestAudioQuery(int64 SpeakerId, const FString& Message, bool bKana) const;
+
+	/**
+	 * @brief 投機的な音声合成の結果を参照せず、ワーカープロセス、もしくはVOICEVOX COREで音声合成する
+	 * @param[in] AudioQuery AudioQuery構造体
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @param[in] Priority セリフの優先度（負荷が高い場合は優先度の低いセリフから品質を下げる）
+	 * @param[in] Deadline 音声合成の期限（nullptrの場合は期限無し）
+	 * @param[out] OutGovernedAudioQuery 品質を下げた場合は実際に音声合成したAudioQueryを設定する（nullptrの場合は受け取らない）
+	 * @return 音声データ（期限に間に合わないため中止した場合は空）
+	 */
+	TArray<uint8> RequestSynthesis(const FVoicevoxAudioQuery& AudioQuery, int64 SpeakerId, bool bEnableInterrogativeUpspeak, EVoicevoxSynthesisPriority Priority,
+		const FVoicevoxSynthesisDeadline* Deadline = nullptr, TOptional<FVoicevoxAudioQuery>* OutGovernedAudioQuery = nullptr) const;
 	
 public:
 
@@ -116,7 +417,7 @@ public:
 	/**
 	 * @brief VoicevoxNativeCoreSubsystem管理インスタンスの初期化処理実行
 	 */
-	void NativeInitialize() const;
+	void NativeInitialize();
 
 	//----------------------------------------------------------------
 	// VOICEVOX CORE APIアクセス関数
@@ -131,7 +432,7 @@ public:
      * VOICEVOX CORE 初期化
      * @brief 音声合成するための初期化を行う。VOICEVOXのAPIを正しく実行するには先に初期化が必要
      * @param[in] bUseGPU			trueならGPU用、falseならCPU用の初期化を行う
-     * @param[in] CPUNumThreads		推論に用いるスレッド数を設定する。0の場合論理コア数の半分か、物理コア数が設定される
+     * @param[in] CPUNumThreads		推論に用いるスレッド数を設定する。0の場合CalibrateCPUNumThreadsで計測したスレッド数、未計測なら論理コア数の半分か、物理コア数が設定される
      * @param[in] bLoadAllModels	trueなら全てのモデルをロードする(かなり時間がかかるのでtrueは非推奨です。trueはデバッグ用として使用してください)
      * @detail
      * VOICEVOXの初期化処理は何度も実行可能。use_gpuを変更して実行しなおすことも可能。
@@ -226,6 +527,7 @@ public:
 	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
 	 * @return 音声データを出力する先のポインタ。使用が終わったらvoicevox_wav_freeで開放する必要がある
 	 * @details
+	 * AudioQuery構造体に変換できる場合は構造体版のRunSynthesisと同様にボイスバンク、キャッシュを参照します。<br/>
 	 * ※メインスレッドが暫く止まるほど重いので、非同期で処理してください。（UE::Tasks::Launch等）
 	 */
 	TArray<uint8> RunSynthesis(const char* AudioQueryJson, int64 SpeakerId, bool bEnableInterrogativeUpspeak) const;
@@ -237,11 +539,45 @@ public:
 	 * @param[in] AudioQuery jsonフォーマットされた AudioQuery構造体
 	 * @param[in] SpeakerId 話者番号
 	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @param[in] Priority セリフの優先度（SetQualityGovernorSettingsで有効にした場合、負荷が高い時は優先度の低いセリフから品質を下げる）
+	 * @param[out] OutSynthesisAudioQuery 実際に音声合成したAudioQuery（nullptrの場合は受け取らない）
 	 * @return 音声データを出力する先のポインタ。使用が終わったらvoicevox_wav_freeで開放する必要がある
 	 * @details
+	 * 品質を下げた場合は無音が短くなるため、リップシンクはAudioQueryではなくOutSynthesisAudioQueryから生成してください。<br/>
 	 * ※メインスレッドが暫く止まるほど重いので、非同期で処理してください。（UE::Tasks::Launch等）
 	 */
-	TArray<uint8> RunSynthesis(const FVoicevoxAudioQuery& AudioQuery, int64 SpeakerId, bool bEnableInterrogativeUpspeak) const;
+	TArray<uint8> RunSynthesis(const FVoicevoxAudioQuery& AudioQuery, int64 SpeakerId, bool bEnableInterrogativeUpspeak,
+		EVoicevoxSynthesisPriority Priority = EVoicevoxSynthesisPriority::Normal, FVoicevoxAudioQuery* OutSynthesisAudioQuery = nullptr) const;
+
+	/**
+	 * @fn
+	 * 期限付きでVOICEVOX COREのvoicevox_synthesisを実行
+	 * @brief 期限を指定してAudioQueryを音声データに変換する。
+	 * @param[in] AudioQuery AudioQuery構造体
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @param[in] Deadline 音声合成の期限
+	 * @param[in] Priority セリフの優先度
+	 * @param[out] OutSynthesisAudioQuery 実際に音声合成したAudioQuery（nullptrの場合は受け取らない）
+	 * @return 音声データ（期限に間に合わないため中止した場合は空）
+	 * @details
+	 * SetSynthesisBudgetで同時実行数の上限を設定した場合、待機中の音声合成は期限の早い順に開始します。<br/>
+	 * 完了時刻は話者毎に計測したモーラあたりの合成時間から予測し、期限に間に合わない場合は合成の完了を待たずにDeadline.OnDeadlineMissを呼び出します。
+	 * 字幕のみの表示やキャッシュ済みのセリフへの切り替え等に利用してください。
+	 *
+	 * ※メインスレッドが暫く止まるほど重いので、非同期で処理してください。（UE::Tasks::Launch等）
+	 */
+	TArray<uint8> RunSynthesisWithDeadline(const FVoicevoxAudioQuery& AudioQuery, int64 SpeakerId, bool bEnableInterrogativeUpspeak,
+		const FVoicevoxSynthesisDeadline& Deadline, EVoicevoxSynthesisPriority Priority = EVoicevoxSynthesisPriority::Normal,
+		FVoicevoxAudioQuery* OutSynthesisAudioQuery = nullptr) const;
+
+	/**
+	 * @brief AudioQueryの音声合成の所要時間を予測する
+	 * @param[in] AudioQuery AudioQuery構造体
+	 * @param[in] SpeakerId 話者番号
+	 * @return 予測した所要時間（秒、実行枠の待機時間は含まない）
+	 */
+	double PredictSynthesisTime(const FVoicevoxAudioQuery& AudioQuery, int64 SpeakerId) const;
 
 	/**
 	 * @fn
@@ -255,6 +591,385 @@ public:
 	 */
 	TArray<uint8> RunSynthesis(const UVoicevoxQuery& VoicevoxQuery, bool bEnableInterrogativeUpspeak) const;
 
+	/**
+	 * @fn
+	 * アクセント句単位のキャッシュを利用してVOICEVOX COREのvoicevox_synthesisを実行
+	 * @brief AudioQueryを音声データに変換する。合成済みのアクセント句は再合成せずにキャッシュを利用する。
+	 * @param[in] AudioQuery AudioQuery構造体
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @return WAVフォーマットの音声データ
+	 * @details
+	 * アクセント句ごとに、アクセント句と前後のアクセント句の内容をキーとして音声データをキャッシュします。<br/>
+	 * 一部のアクセント句だけ編集した場合は、編集したアクセント句と前後のアクセント句のみ再合成し、境界を短いクロスフェードで繋ぎます。<br/>
+	 * AudioQuery編集中のプレビュー等、同じ台詞を繰り返し合成する用途向けです。
+	 *
+	 * ※メインスレッドが暫く止まるほど重いので、非同期で処理してください。（UE::Tasks::Launch等）
+	 */
+	TArray<uint8> RunSynthesisWithPhraseCache(const FVoicevoxAudioQuery& AudioQuery, int64 SpeakerId, bool bEnableInterrogativeUpspeak);
+
+	/**
+	 * @brief アクセント句単位の音声データキャッシュを破棄する
+	 */
+	void ClearPhraseCache();
+
+	//--------------------------------
+	// 定型文関連
+	//--------------------------------
+
+	/**
+	 * @fn
+	 * 定型文の固定部分を再利用してVOICEVOX COREのvoicevox_synthesisを実行
+	 * @brief 「{N}ゴールド手に入れた」のような定型文を、差し込み部分だけ音声合成して音声データに変換する。
+	 * @param[in] Template 定型文（差し込み部分は{名前}で記述する）
+	 * @param[in] SlotValues 差し込み部分の名前とテキストのマップ
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @param[out] OutAudioQuery 各部分のAudioQueryを繋いだAudioQuery（リップシンクに使用する）
+	 * @return WAVフォーマットの音声データ
+	 * @details
+	 * 固定部分は初回に音声合成してキャッシュし、2回目以降は差し込み部分のテキスト解析と音声合成のみ行います。<br/>
+	 * 差し込み部分は前後の固定部分との境界のモーラの音高に合わせて抑揚を調整し、境界を短いクロスフェードで繋ぎます。<br/>
+	 * 頻繁に流れる数値入りのアナウンス等、差し込み部分以外が変わらないセリフ向けです。
+	 *
+	 * ※メインスレッドが暫く止まるほど重いので、非同期で処理してください。（UE::Tasks::Launch等）
+	 */
+	TArray<uint8> RunSynthesisWithTemplate(const FString& Template, const TMap<FString, FString>& SlotValues, int64 SpeakerId, bool bEnableInterrogativeUpspeak, FVoicevoxAudioQuery& OutAudioQuery);
+
+	/**
+	 * @brief 定型文の固定部分を事前に音声合成してキャッシュする
+	 * @param[in] Template 定型文（差し込み部分は{名前}で記述する）
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @return 音声合成に成功したらtrue
+	 * @details
+	 * ※メインスレッドが暫く止まるほど重いので、非同期で処理してください。（UE::Tasks::Launch等）
+	 */
+	bool PrepareLineTemplate(const FString& Template, int64 SpeakerId, bool bEnableInterrogativeUpspeak);
+
+	/**
+	 * @brief 定型文の固定部分のキャッシュを破棄する
+	 */
+	void ClearLineTemplateCache();
+
+	//--------------------------------
+	// 最近再生したセリフのキャッシュ関連
+	//--------------------------------
+
+	/**
+	 * @brief 最近再生したセリフのキャッシュのメモリ予算を設定する
+	 * @param[in] MemoryBudget メモリ予算（バイト、0の場合はキャッシュしない）
+	 * @details
+	 * 有効にすると、音声合成したセリフをIMA ADPCMで圧縮して保持し、同じAudioQuery、話者番号のセリフは再合成せずに展開して返します。<br/>
+	 * 16bit PCMのおよそ1/4のサイズで保持するため、同じメモリ量で約4倍のセリフを保持できます。
+	 * メモリ予算を超えた場合は最後に使用したのが古いセリフから破棄します。<br/>
+	 * 圧縮による劣化があるため、ボイスバンクの作成等で音声データを保存する場合は無効にしてください。
+	 */
+	void SetRecentLineCacheMemoryBudget(int64 MemoryBudget);
+
+	/**
+	 * @brief 最近再生したセリフのキャッシュのメモリ予算を取得する
+	 * @return メモリ予算（バイト）
+	 */
+	int64 GetRecentLineCacheMemoryBudget() const;
+
+	/**
+	 * @brief 最近再生したセリフのキャッシュの使用メモリを取得する
+	 * @return 使用メモリ（バイト）
+	 */
+	int64 GetRecentLineCacheMemoryUsage() const;
+
+	/**
+	 * @brief 最近再生したセリフのキャッシュを破棄する
+	 */
+	void ClearRecentLineCache();
+
+	//--------------------------------
+	// トレースのキャプチャ関連
+	//--------------------------------
+
+	/**
+	 * @brief 音声合成リクエストのキャプチャを開始する
+	 * @param[in] FilePath トレースファイルの保存先（JSON Lines）
+	 * @return 開始できたらtrue（既にキャプチャ中の場合はfalse）
+	 * @details
+	 * キャプチャ中はAudioQueryの取得、音声合成の呼び出しを、経過時間、API、話者番号、AudioQueryとそのハッシュ値、同時実行数、所要時間と共に記録します。<br/>
+	 * 保存したトレースはVoicevoxReplayコマンドレットで再生し、ベースラインとの所要時間、スループットの差を比較できます。<br/>
+	 * 起動引数 -VoicevoxTraceCapture=<ファイル> を指定した場合は起動直後からキャプチャします。
+	 */
+	bool StartTraceCapture(const FString& FilePath);
+
+	/**
+	 * @brief 音声合成リクエストのキャプチャを終了し、トレースファイルへ保存する
+	 * @return 保存できたらtrue
+	 */
+	bool StopTraceCapture();
+
+	/**
+	 * @brief 音声合成リクエストをキャプチャ中か
+	 * @return キャプチャ中の場合はtrue
+	 */
+	bool IsTraceCapturing() const;
+
+	//--------------------------------
+	// メモリ使用量関連
+	//--------------------------------
+
+	/**
+	 * @brief VOICEVOX COREの初期化で増加したネイティブ側の常駐メモリを取得する
+	 * @return 使用メモリ（バイト、Open JTalk辞書と初期化時にロードしたモデルを含む）
+	 * @details
+	 * VOICEVOX COREはUEのアロケーターを通さずにメモリを確保するため、初期化前後のプロセスの常駐メモリの差で計測した目安の値です。
+	 */
+	int64 GetNativeCoreMemory() const;
+
+	/**
+	 * @brief 話者毎のモデルのロードで増加したネイティブ側の常駐メモリを取得する
+	 * @return 話者番号と使用メモリ（バイト）のマップ（同じモデルの話者は最初にロードした話者に計上）
+	 */
+	TMap<int64, int64> GetNativeModelMemoryMap() const;
+
+	/**
+	 * @brief VOICEVOXのメモリ使用量をまとめて出力する（Voicevox.MemReportコマンド）
+	 * @param[in] Ar 出力先
+	 */
+	void DumpMemoryReport(FOutputDevice& Ar) const;
+
+	//--------------------------------
+	// ボイスバンク関連
+	//--------------------------------
+
+	/**
+	 * @brief 既定のボイスバンクファイルパスを取得する
+	 * @return Content/Voicevox/VoiceBank.vvbank のパス
+	 * @details Subsystem初期化時にこのパスのボイスバンクを自動で読み込みます。
+	 *			パッケージに含める場合は「Additional Non-Asset Directories To Copy (Non-UFS)」にContent/Voicevoxを追加してください。
+	 *			pakファイル内のファイルはメモリマップで開けないため、「Additional Non-Asset Directories to Copy」では読み込めません。
+	 */
+	static FString GetDefaultVoiceBankPath();
+
+	/**
+	 * @brief ボイスバンクファイルを読み込む
+	 * @param[in] FilePath ボイスバンクファイルパス
+	 * @return 読み込みに成功したらtrue
+	 * @details 読み込んだボイスバンクはRunSynthesis実行時にVOICEVOX COREより先に検索され、
+	 *			一致するAudioQueryがあれば推論せずにボイスバンクの音声データを返します。
+	 */
+	bool LoadVoiceBank(const FString& FilePath);
+
+	/**
+	 * @brief ボイスバンクファイルを閉じる
+	 */
+	void UnloadVoiceBank();
+
+	//--------------------------------
+	// ワーカープール関連
+	//--------------------------------
+
+	/**
+	 * @brief VOICEVOX COREを実行するワーカープロセスを起動する
+	 * @param[in] WorkerNum 起動するワーカープロセス数
+	 * @param[in] bUseGPU trueならGPU用、falseならCPU用の初期化を行う
+	 * @param[in] CPUNumThreads ワーカープロセス毎の推論に用いるスレッド数。0の場合論理コア数の半分か、物理コア数が設定される
+	 * @return 全てのワーカープロセスの起動に成功したらtrue
+	 * @details 起動中はGetAudioQuery、RunTextToSpeech、RunSynthesisを空いているワーカープロセスで実行し、
+	 *			音声データを共有メモリ経由で受け取ります。ワーカープロセス毎にVOICEVOX COREのインスタンスを持つため、
+	 *			コア数の多い環境では並行して音声合成でき、VOICEVOX COREがクラッシュしてもゲームは終了しません。<br/>
+	 *			ワーカープロセスはVOICEVOX COREの初期化完了まで待つため、非同期で処理してください。（UE::Tasks::Launch等）
+	 */
+	bool StartWorkerPool(int32 WorkerNum, bool bUseGPU, int32 CPUNumThreads = 0);
+
+	/**
+	 * @brief 処理中のリクエストの完了を待ち、全てのワーカープロセスを終了する
+	 */
+	void StopWorkerPool();
+
+	/**
+	 * @brief ワーカープロセスが起動しているか
+	 * @return 起動していたらtrue
+	 */
+	bool IsWorkerPoolRunning() const;
+
+	//--------------------------------
+	// 音声合成サーバー関連
+	//--------------------------------
+
+	/**
+	 * @brief ループバックアドレスで音声合成サーバーを開始する
+	 * @param[in] Port 待ち受けるポート番号
+	 * @return 待ち受けに成功したらtrue
+	 * @details 他のプロセス（-VoicevoxServerAddress=を指定したゲームやエディタ）からのGetAudioQuery、RunTextToSpeech、RunSynthesisを
+	 *			このプロセスで読み込んだVOICEVOX COREで処理し、音声データを圧縮PCMで返します。事前にInitializeを実行してください。
+	 */
+	bool StartSynthesisServer(int32 Port = FVoicevoxRemoteProtocol::DefaultPort);
+
+	/**
+	 * @brief 音声合成サーバーを終了する
+	 */
+	void StopSynthesisServer();
+
+	/**
+	 * @brief 音声合成サーバーが接続を待ち受けているか
+	 * @return 待ち受けていたらtrue
+	 */
+	bool IsSynthesisServerRunning() const;
+
+	//--------------------------------
+	// 投機的音声合成関連
+	//--------------------------------
+
+	/**
+	 * @brief 選択肢のテキスト等、次に再生する可能性のある候補テキストを投機的に音声合成する
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] MessageList 候補テキストのリスト（前回の候補は破棄する）
+	 * @param[in] bKana aquestalk形式のkanaとしてテキストを解釈する
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @details 候補は最低優先度のスレッドで、SetSpeculativeSynthesisCPUBudgetで設定した予算内で順番に合成します。<br/>
+	 *			候補と同じテキストでGetAudioQuery、続けてRunSynthesis（PlayToText等）を呼び出すと合成済みの結果をそのまま返し、
+	 *			残りの候補は破棄します。AudioQueryの話速等を変更した場合は通常通り音声合成します。
+	 */
+	void SubmitSpeculativeSynthesis(int64 SpeakerId, const TArray<FString>& MessageList, bool bKana = false, bool bEnableInterrogativeUpspeak = true);
+
+	/**
+	 * @brief 投機的に音声合成している候補を全て破棄する
+	 */
+	void CancelSpeculativeSynthesis();
+
+	/**
+	 * @brief 投機的な音声合成のCPU使用率の予算を設定する
+	 * @param[in] CPUBudget 候補の合成に使う時間の割合（0.01～1.0、既定値は0.5）
+	 * @details 例えば0.25の場合、1つの候補の合成にかかった時間の3倍待機してから次の候補を合成します。
+	 */
+	void SetSpeculativeSynthesisCPUBudget(float CPUBudget);
+
+	//--------------------------------
+	// 推論スレッド数キャリブレーション関連
+	//--------------------------------
+
+	/**
+	 * @brief 推論スレッド数の候補毎に参照用のテキストを音声合成して最適なスレッド数を計測し、このマシンの設定として保存する
+	 * @param[in] SpeakerId 計測に使う話者番号
+	 * @param[in] bForce trueなら計測済みでも計測し直す
+	 * @return 最適なスレッド数。計測に失敗した場合は0
+	 * @details 事前にInitializeを実行してください。候補毎にCPU用としてVOICEVOX COREを終了、初期化し直し、
+	 *			最後にInitializeで指定した設定で初期化し直します（SpeakerId以外のモデルは再度ロードしてください）。<br/>
+	 *			計測中はこのプロセスでのAudioQueryの生成、音声合成を待機させます。<br/>
+	 *			計測済みの場合は計測せずに保存したスレッド数を返します。以降はInitializeのCPUNumThreadsが0の場合にこのスレッド数を使います。<br/>
+	 *			数秒から数十秒かかるため、初回起動時等に非同期で処理してください。（UE::Tasks::Launch等）
+	 */
+	int32 CalibrateCPUNumThreads(int64 SpeakerId, bool bForce = false);
+
+	/**
+	 * @brief このマシンで計測済みの推論スレッド数を取得する
+	 * @return スレッド数。未計測の場合は0
+	 */
+	static int32 GetCalibratedCPUNumThreads();
+
+	//--------------------------------
+	// 音声合成のCPU予算関連
+	//--------------------------------
+
+	/**
+	 * @brief 音声合成に割り当てるCPU予算を設定する
+	 * @param[in] Budget 同時実行数、呼び出し元スレッドの優先度、フレーム時間の余裕の設定
+	 * @details RunTextToSpeech、RunSynthesis（投機的な音声合成、ワーカープロセスへのリクエストを含む）は同時実行数が上限に達している間、
+	 *			もしくはゲームスレッド、レンダースレッドの処理時間が目標フレーム時間の余裕を割り込んでいる間は開始を待機します。<br/>
+	 *			ゲームスレッドから呼び出した場合はフレーム時間による待機は行いません。<br/>
+	 *			EnqueueGameThreadCompletionで積んだ完了処理は、1フレームにMaxCompletionsPerFrameずつ実行します。
+	 */
+	void SetSynthesisBudget(const FVoicevoxSynthesisBudget& Budget);
+
+	/**
+	 * @brief 音声合成に割り当てるCPU予算を取得する
+	 * @return 同時実行数、呼び出し元スレッドの優先度、フレーム時間の余裕の設定
+	 */
+	FVoicevoxSynthesisBudget GetSynthesisBudget() const;
+
+	/**
+	 * @brief 非同期の音声合成の完了処理をゲームスレッドで実行するキューへ積む（任意のスレッドから呼び出せる）
+	 * @param[in] Completion ゲームスレッドで実行する完了処理
+	 * @details USoundWaveの生成やデリゲートの呼び出し等、ゲームスレッドで行う必要がある処理だけを積んでください。
+	 *			次のフレームの開始時に積んだ順で実行し、1フレームの上限を超えた分は次のフレームへ持ち越します。
+	 *			UObjectを参照する場合は、実行時までに破棄されている可能性があるためTWeakObjectPtrで確認してください。
+	 */
+	void EnqueueGameThreadCompletion(TUniqueFunction<void()>&& Completion) const;
+
+	//--------------------------------
+	// 負荷に応じた品質調整関連
+	//--------------------------------
+
+	/**
+	 * @brief 音声合成の負荷に応じて品質を調整する設定を変更する
+	 * @param[in] Settings 負荷に応じて品質を調整する設定
+	 * @details 有効にすると、RunSynthesisは待機中、実行中の音声合成数と実時間比から求めた負荷段階に応じて、
+	 *			優先度の低いセリフから無音の短縮、モノラル化、出力サンプリングレートの引き下げを行います。負荷が下がると品質を戻します。
+	 */
+	void SetQualityGovernorSettings(const FVoicevoxQualityGovernorSettings& Settings);
+
+	/**
+	 * @brief 音声合成の負荷に応じて品質を調整する設定を取得する
+	 * @return 負荷に応じて品質を調整する設定
+	 */
+	FVoicevoxQualityGovernorSettings GetQualityGovernorSettings() const;
+
+	/**
+	 * @brief 現在の負荷段階を取得する
+	 * @return 負荷段階（0～3、0の場合は品質を下げない）
+	 */
+	int32 GetQualityGovernorLevel() const;
+
+	//--------------------------------
+	// 再生サンプリングレート関連
+	//--------------------------------
+
+	/**
+	 * @brief 再生用に変換するサンプリングレートを設定する
+	 * @param[in] SampleRate サンプリングレート（0の場合は変換しない）
+	 * @details 設定すると、リップシンクコンポーネント等で再生する音声データを音声合成時に1度だけリサンプリングし、
+	 *			オーディオミキサーが再生の度にリサンプリングする負荷を無くします。
+	 */
+	void SetPlaybackSampleRate(int32 SampleRate);
+
+	/**
+	 * @brief 再生用に変換するサンプリングレートをメインのオーディオデバイスに合わせる
+	 * @return 設定したサンプリングレート。オーディオデバイスが無い場合は0
+	 */
+	int32 SetPlaybackSampleRateToAudioDevice();
+
+	/**
+	 * @brief 再生用に変換するサンプリングレートを取得する
+	 * @return サンプリングレート（0の場合は変換しない）
+	 */
+	int32 GetPlaybackSampleRate() const;
+
+	/**
+	 * @brief 音声データを再生用のサンプリングレートへ変換する
+	 * @param[in,out] OutputWAV WAVフォーマットの音声データ
+	 * @details 再生用のサンプリングレートが未設定、もしくは既に同じサンプリングレートの場合は何もしません。
+	 */
+	void ConvertToPlaybackSampleRate(TArray<uint8>& OutputWAV) const;
+
+	//--------------------------------
+	// SoundWaveプール関連
+	//--------------------------------
+
+	/**
+	 * @brief 再生用のSoundWaveをプールから取得する（空の場合は生成する）
+	 * @return キューが空のSoundWave
+	 * @details ゲームスレッド以外から呼び出した場合はプールを使わずに生成します。<br/>
+	 *			返してから、およびオーディオレンダースレッドが最後に読み出してから0.5秒経ったものだけを、キューを破棄して再利用します。
+	 */
+	UVoicevoxSoundWaveProcedural* AcquireSoundWave();
+
+	/**
+	 * @brief 再生が終わったSoundWaveをプールへ返す
+	 * @param[in] SoundWave 再生が終わったSoundWave
+	 * @details 返したSoundWaveは別の音声データで再利用されるため、呼び出し後は参照しないでください。
+	 *			別のAudioComponentで再生中のものを返した場合は、再生が止まるまで再利用しません。
+	 *			ゲームスレッド以外から呼び出した場合は何もしません。
+	 */
+	void ReleaseSoundWave(UVoicevoxSoundWaveProcedural* SoundWave);
+
 	//--------------------------------
 	// VOICEVOX CORE LipSync関連
 	//--------------------------------
@@ -266,7 +981,38 @@ public:
 	 * @param[in] PitchModulation USoundWave再生時のピッチ
 	 * @return AudioQuery情報を元に生成した、中品質のLipSyncに必要なデータリスト
 	 */
-	static TArray<FVoicevoxLipSync> GetLipSyncList(FVoicevoxAudioQuery AudioQuery, bool bIsSimple = false, float PitchModulation = 1.0f);
+	static TArray<FVoicevoxLipSync> GetLipSyncList(const FVoicevoxAudioQuery& AudioQuery, bool bIsSimple = false, float PitchModulation = 1.0f);
+
+	/**
+	 * @brief 音声データの振幅包絡から、LipSyncに必要なデータリストを取得
+	 * @param[in] OutputWAV WAVフォーマットの音声データ
+	 * @param[in] bIsSimple 簡易のリップシンクで再生するか
+	 * @return 音声データから推定した、LipSyncに必要なデータリスト
+	 * @details TextToSpeechやボイスバンク等、AudioQueryを持たない音声データのリップシンクに使用します。
+	 *			テキスト解析を再実行しないため軽量ですが、AudioQueryから生成する場合より精度は落ちます。
+	 */
+	static TArray<FVoicevoxLipSync> GetLipSyncListFromWAV(const TArray<uint8>& OutputWAV, bool bIsSimple = false);
+
+	/**
+	 * @brief AudioQueryのリップシンクをモーフターゲット値のカーブとしてカーブテーブルへベイクする
+	 * @param[in] AudioQuery AudioQuery構造体
+	 * @param[out] CurveTable ベイク先のカーブテーブル（既存の行は破棄する）
+	 * @details 行名は「A」「I」「U」「E」「O」（通常のリップシンク）と「Simple」（簡易のリップシンク）で、値は0～1のモーフターゲット値です。<br/>
+	 *			再生時はMaxMouthScaleを掛けて使用します。
+	 */
+	static void BakeLipSyncCurveTable(const FVoicevoxAudioQuery& AudioQuery, UCurveTable* CurveTable);
+	
+	//--------------------------------
+	// VOICEVOX CORE 長文関連
+	//--------------------------------
+
+	/**
+	 * @brief 長文テキストを日本語の文末記号（。！？等）と改行で文単位に分割する
+	 * @param[in] Message 分割するテキスト
+	 * @return 文単位に分割したテキストリスト。文末記号は各文の末尾に残し、空白のみの文は除外する
+	 * @details 長文のパイプライン再生で、文ごとにAudioQuery生成と音声合成を並行実行するために使用する
+	 */
+	static TArray<FString> SplitLongText(const FString& Message);
 	
 	//--------------------------------
 	// VOICEVOX CORE Meta関連
@@ -389,4 +1135,6 @@ public:
 	 */
 	TArray<float> DecodeForward(int64 Length, int64 PhonemeSize, TArray<float> F0, TArray<float> Phoneme, int64 SpeakerID) const;
 	
-};
\ No newline at end of file
+};
+
+VOICEVOXUECORE_API DECLARE_LOG_CATEGORY_EXTERN(LogVoicevoxCore, Log, All);
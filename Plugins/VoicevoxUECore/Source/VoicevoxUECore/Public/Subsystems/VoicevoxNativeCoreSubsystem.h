@@ -79,6 +79,16 @@ public:
 	 * @brief コンストラクタ
 	 */
 	UVoicevoxNativeCoreSubsystem() = default;
+
+	//--------------------------------
+	// override
+	//--------------------------------
+
+	/**
+	 * @brief ShouldCreateSubsystem
+	 * @details 音声合成サーバーのアドレスが設定されている場合は、VOICEVOX COREライブラリを読み込むSubsystemを生成しない
+	 */
+	VOICEVOXUECORE_API virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
 	
 	//--------------------------------
 	// VOICEVOX CORE Initialize関連
@@ -99,7 +109,7 @@ public:
 	 *
 	 * ※メインスレッドが暫く止まるほど重いので、非同期で処理してください。（UE::Tasks::Launch等）
 	 */
-	VOICEVOXUECORE_API bool CoreInitialize(bool bUseGPU, int CPUNumThreads = 0, bool bLoadAllModels = false);
+	VOICEVOXUECORE_API virtual bool CoreInitialize(bool bUseGPU, int CPUNumThreads = 0, bool bLoadAllModels = false);
 
 	/**
 	 * @brief デフォルトの初期化オプションを生成する
@@ -119,7 +129,7 @@ public:
 	 * VOICEVOXの終了処理は何度も実行可能。
 	 * 実行せずにexitしても大抵の場合問題ないが、CUDAを利用している場合は終了処理を実行しておかないと例外が起こることがある。
 	 */
-	VOICEVOXUECORE_API void Finalize();
+	VOICEVOXUECORE_API virtual void Finalize();
 
 	//--------------------------------
 	// VOICEVOX CORE Model関連
@@ -136,7 +146,7 @@ public:
 	 *
 	 * ※モデルによってはメインスレッドが暫く止まるほど重いので、その場合は非同期で処理してください。（UE::Tasks::Launch等）
 	 */
-	VOICEVOXUECORE_API bool LoadModel(int64 SpeakerId);
+	VOICEVOXUECORE_API virtual bool LoadModel(int64 SpeakerId);
 
 	/**
 	 * @fn
@@ -162,7 +172,7 @@ public:
 	 * @details
 	 * ※メインスレッドが暫く止まるほど重いので、非同期で処理してください。（UE::Tasks::Launch等）
 	 */
-	VOICEVOXUECORE_API FVoicevoxAudioQuery GetAudioQuery(int64 SpeakerId, const FString& Message, bool bKana);
+	VOICEVOXUECORE_API virtual FVoicevoxAudioQuery GetAudioQuery(int64 SpeakerId, const FString& Message, bool bKana);
 
 	/**
 	 * @brief デフォルトの AudioQuery のオプションを生成する
@@ -186,7 +196,7 @@ public:
 	 * @details
 	 * ※メインスレッドが暫く止まるほど重いので、非同期で処理してください。（UE::Tasks::Launch等）
 	 */
-	VOICEVOXUECORE_API TArray<uint8> RunTextToSpeech(int64 SpeakerId, const FString& Message, bool bKana, bool bEnableInterrogativeUpspeak);
+	VOICEVOXUECORE_API virtual TArray<uint8> RunTextToSpeech(int64 SpeakerId, const FString& Message, bool bKana, bool bEnableInterrogativeUpspeak);
 
 	/**
 	 * @brief デフォルトのテキスト音声合成オプションを生成する
@@ -205,7 +215,7 @@ public:
 	 * @details
 	 * ※メインスレッドが暫く止まるほど重いので、非同期で処理してください。（UE::Tasks::Launch等）
 	 */
-	VOICEVOXUECORE_API TArray<uint8> RunSynthesis(const char* AudioQueryJson, int64 SpeakerId, bool bEnableInterrogativeUpspeak);
+	VOICEVOXUECORE_API virtual TArray<uint8> RunSynthesis(const char* AudioQueryJson, int64 SpeakerId, bool bEnableInterrogativeUpspeak);
 
 	/**
 	 * @fn
@@ -218,7 +228,7 @@ public:
 	 * @details
 	 * ※メインスレッドが暫く止まるほど重いので、非同期で処理してください。（UE::Tasks::Launch等）
 	 */
-	VOICEVOXUECORE_API TArray<uint8> RunSynthesis(const FVoicevoxAudioQuery& AudioQueryJson, int64 SpeakerId, bool bEnableInterrogativeUpspeak);
+	VOICEVOXUECORE_API virtual TArray<uint8> RunSynthesis(const FVoicevoxAudioQuery& AudioQueryJson, int64 SpeakerId, bool bEnableInterrogativeUpspeak);
 
 	/**
 	 * @brief デフォルトの `voicevox_synthesis` のオプションを生成する
@@ -244,25 +254,25 @@ public:
 	 * @brief 話者名や話者IDのリストを取得する
 	 * @return メタ情報が格納されたjson形式の構造体
 	 */
-	VOICEVOXUECORE_API TArray<FVoicevoxMeta> GetMetaList();
+	VOICEVOXUECORE_API virtual TArray<FVoicevoxMeta> GetMetaList();
 
 	/**
 	 * @brief サポートデバイス情報を取得する
 	 * @return サポートデバイス情報の構造体
 	 */
-	VOICEVOXUECORE_API FVoicevoxSupportedDevices GetSupportedDevices();
+	VOICEVOXUECORE_API virtual FVoicevoxSupportedDevices GetSupportedDevices();
 
 	/**
 	 * @brief VOICEVOX COREのバージョンを取得する
 	 * @return SemVerでフォーマットされたバージョン
 	 */
-	VOICEVOXUECORE_API FString GetVoicevoxVersion();
+	VOICEVOXUECORE_API virtual FString GetVoicevoxVersion();
 
 	/**
 	 * @brief ハードウェアアクセラレーションがGPUモードか判定する
 	 * @return GPUモードならtrue、そうでないならfalse
 	 */
-	VOICEVOXUECORE_API bool IsGpuMode();
+	VOICEVOXUECORE_API virtual bool IsGpuMode();
 
 	//--------------------------------
 	// VOICEVOX CORE PhonemeLength関連
@@ -0,0 +1,189 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxRemoteCoreSubsystem.h
+ * @brief  音声合成サーバーへVOICEVOX COREのAPI呼び出しを転送するSubsystemヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoicevoxRemoteProtocol.h"
+#include "Async/Future.h"
+#include "Subsystems/VoicevoxNativeCoreSubsystem.h"
+#include "VoicevoxRemoteCoreSubsystem.generated.h"
+
+class FSocket;
+
+/**
+ * @class UVoicevoxRemoteCoreSubsystem
+ * @brief VOICEVOX COREライブラリを読み込まず、音声合成サーバーへAPI呼び出しを転送するSubsystem
+ * @details
+ * コマンドライン引数の「-VoicevoxServerAddress=127.0.0.1:50121」、もしくはDefaultEngine.iniの[Voicevox]ServerAddressが設定されている場合のみ生成され、
+ * その場合は他のVOICEVOX COREライブラリのSubsystemは生成されません。<br/>
+ * 複数スレッドから同時に呼び出されたリクエストは、1つの接続上でバッチにまとめて送信します。
+ */
+UCLASS(MinimalAPI)
+class UVoicevoxRemoteCoreSubsystem final : public UVoicevoxNativeCoreSubsystem
+{
+	GENERATED_BODY()
+
+	//----------------------------------------------------------------
+	// struct
+	//----------------------------------------------------------------
+
+	/**
+	 * @struct FPendingRequest
+	 * @brief 送信待ちのリクエスト構造体
+	 */
+	struct FPendingRequest
+	{
+		//! リクエスト
+		FVoicevoxRemoteRequest Request;
+
+		//! レスポンスの受け渡し
+		TPromise<FVoicevoxRemoteResponse> Promise;
+	};
+
+	//----------------------------------------------------------------
+	// Variable
+	//----------------------------------------------------------------
+
+	//! 音声合成サーバーのアドレス
+	FString ServerAddress;
+
+	//! 音声合成サーバーの情報
+	FVoicevoxRemoteServerInfo ServerInfo;
+
+	//! 音声合成サーバーとの接続
+	FSocket* Socket = nullptr;
+
+	//! 送信待ちのリクエストリスト
+	TArray<TSharedPtr<FPendingRequest>> PendingRequestList;
+
+	//! 送信待ちのリクエストリストの排他制御
+	FCriticalSection PendingRequestCriticalSection;
+
+	//! いずれかのスレッドが送受信中か
+	bool bIsSending = false;
+
+	//----------------------------------------------------------------
+	// Function
+	//----------------------------------------------------------------
+
+	/**
+	 * @brief 音声合成サーバーへ接続する
+	 * @return 接続に成功したらtrue
+	 */
+	bool Connect();
+
+	/**
+	 * @brief 音声合成サーバーとの接続を切断する
+	 */
+	void Disconnect();
+
+	/**
+	 * @brief リクエストを送信し、レスポンスを待つ
+	 * @param[in] Request リクエスト
+	 * @return レスポンス
+	 * @details 他のスレッドが送受信中の場合は送信待ちに積み、送受信中のスレッドが次のバッチとしてまとめて送信します。
+	 */
+	FVoicevoxRemoteResponse SendRequest(FVoicevoxRemoteRequest&& Request);
+
+	/**
+	 * @brief バッチを送信し、レスポンスを受信する
+	 * @param[in] Batch 送信するリクエストリスト
+	 * @param[out] OutResponseList リクエストと同じ順序のレスポンスリスト
+	 * @return 送受信に成功したらtrue
+	 */
+	bool SendBatch(const TArray<TSharedPtr<FPendingRequest>>& Batch, TArray<FVoicevoxRemoteResponse>& OutResponseList);
+
+	/**
+	 * @brief 圧縮PCMのレスポンスをWAVフォーマットの音声データに戻す
+	 * @param[in] Response レスポンス
+	 * @return WAVフォーマットの音声データ
+	 */
+	static TArray<uint8> ToWAV(const FVoicevoxRemoteResponse& Response);
+
+public:
+
+	//--------------------------------
+	// override
+	//--------------------------------
+
+	/**
+	 * @brief ShouldCreateSubsystem
+	 */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/**
+	 * @brief Deinitialize
+	 */
+	virtual void Deinitialize() override;
+
+	//--------------------------------
+	// VOICEVOX CORE API
+	//--------------------------------
+
+	/**
+	 * @brief 音声合成サーバーへ接続し、サーバーのVOICEVOX CORE情報を取得する
+	 */
+	virtual bool CoreInitialize(bool bUseGPU, int CPUNumThreads = 0, bool bLoadAllModels = false) override;
+
+	/**
+	 * @brief 音声合成サーバーとの接続を切断する（サーバーのVOICEVOX COREは終了しない）
+	 */
+	virtual void Finalize() override;
+
+	/**
+	 * @brief 音声合成サーバーでモデルをロードする
+	 */
+	virtual bool LoadModel(int64 SpeakerId) override;
+
+	/**
+	 * @brief 音声合成サーバーでAudioQueryを取得する
+	 */
+	virtual FVoicevoxAudioQuery GetAudioQuery(int64 SpeakerId, const FString& Message, bool bKana) override;
+
+	/**
+	 * @brief 音声合成サーバーでtext to speechを実行する
+	 */
+	virtual TArray<uint8> RunTextToSpeech(int64 SpeakerId, const FString& Message, bool bKana, bool bEnableInterrogativeUpspeak) override;
+
+	/**
+	 * @brief 音声合成サーバーで音声合成する
+	 */
+	virtual TArray<uint8> RunSynthesis(const char* AudioQueryJson, int64 SpeakerId, bool bEnableInterrogativeUpspeak) override;
+
+	/**
+	 * @brief 音声合成サーバーで音声合成する
+	 */
+	virtual TArray<uint8> RunSynthesis(const FVoicevoxAudioQuery& AudioQueryJson, int64 SpeakerId, bool bEnableInterrogativeUpspeak) override;
+
+	/**
+	 * @brief 音声合成サーバーの話者名や話者IDのリストを取得する
+	 */
+	virtual TArray<FVoicevoxMeta> GetMetaList() override;
+
+	/**
+	 * @brief 音声合成サーバーのサポートデバイス情報を取得する
+	 */
+	virtual FVoicevoxSupportedDevices GetSupportedDevices() override;
+
+	/**
+	 * @brief 音声合成サーバーのVOICEVOX COREのバージョンを取得する
+	 */
+	virtual FString GetVoicevoxVersion() override;
+
+	/**
+	 * @brief 音声合成サーバーがGPUモードか判定する
+	 */
+	virtual bool IsGpuMode() override;
+
+	/**
+	 * @brief VOICEVOX CORE名取得
+	 * @return 「REMOTE」
+	 */
+	virtual FString GetVoicevoxCoreName() override;
+};
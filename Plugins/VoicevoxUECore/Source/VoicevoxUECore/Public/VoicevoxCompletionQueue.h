@@ -0,0 +1,74 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxCompletionQueue.h
+ * @brief  非同期の音声合成の完了処理をゲームスレッドでまとめて実行するキューのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+/**
+ * @class FVoicevoxCompletionQueue
+ * @brief ワーカースレッドから積んだ完了処理を、ゲームスレッドで1フレームに一定数ずつ実行するクラス
+ * @details
+ * 音声合成等の重い処理はワーカースレッドで行い、USoundWaveの生成やデリゲートの呼び出し等、
+ * ゲームスレッドで行う必要がある処理だけをEnqueueで積みます。<br/>
+ * キューはロックフリーの複数生産者・単一消費者キューで、FCoreDelegates::OnBeginFrameで積んだ順に実行します。
+ * 1フレームに実行する数を超えた分は次のフレームへ持ち越すため、完了が集中してもフレーム時間の突出を抑えられます。
+ */
+class VOICEVOXUECORE_API FVoicevoxCompletionQueue
+{
+public:
+
+	/**
+	 * @brief 毎フレームの完了処理の実行を開始する
+	 */
+	void Start();
+
+	/**
+	 * @brief 毎フレームの完了処理の実行を終了し、未実行の完了処理を破棄する
+	 */
+	void Stop();
+
+	/**
+	 * @brief 完了処理を積む（任意のスレッドから呼び出せる）
+	 * @param[in] Completion ゲームスレッドで実行する完了処理
+	 */
+	void Enqueue(TUniqueFunction<void()>&& Completion);
+
+	/**
+	 * @brief 1フレームに実行する完了処理の最大数を設定する
+	 * @param[in] InMaxCompletionsPerFrame 最大数（0の場合は制限しない）
+	 */
+	void SetMaxCompletionsPerFrame(const int32 InMaxCompletionsPerFrame) { MaxCompletionsPerFrame = FMath::Max(0, InMaxCompletionsPerFrame); }
+
+	/**
+	 * @brief 未実行の完了処理の数を取得する
+	 * @return 完了処理の数
+	 */
+	int32 GetPendingNum() const { return PendingNum.load(); }
+
+private:
+
+	/**
+	 * @brief フレーム開始時に積まれた完了処理を実行する
+	 */
+	void OnBeginFrame();
+
+	//! ゲームスレッドで実行する完了処理のキュー
+	TQueue<TUniqueFunction<void()>, EQueueMode::Mpsc> Queue;
+
+	//! 未実行の完了処理の数
+	std::atomic<int32> PendingNum = 0;
+
+	//! 1フレームに実行する完了処理の最大数（0の場合は制限しない）
+	std::atomic<int32> MaxCompletionsPerFrame = 8;
+
+	//! OnBeginFrameのデリゲートハンドル
+	FDelegateHandle BeginFrameHandle;
+};
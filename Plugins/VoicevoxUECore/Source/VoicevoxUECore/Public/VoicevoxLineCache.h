@@ -0,0 +1,137 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxLineCache.h
+ * @brief  最近再生したセリフの音声データをADPCMで圧縮してメモリに保持するキャッシュのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @class FVoicevoxLineCache
+ * @brief 音声合成したセリフをIMA ADPCM（4bit）で圧縮し、メモリ予算内で最近使用した順に保持するクラス
+ * @details
+ * 16bit PCMのおよそ1/4のサイズで保持するため、同じメモリ量で約4倍のセリフを保持できます。<br/>
+ * 音声データはチャンネル毎に一定フレーム数のブロックへ分けて圧縮し、ブロックの先頭で予測値と量子化幅を初期化するため、
+ * 圧縮誤差がブロックをまたいで蓄積しません。<br/>
+ * メモリ予算を超えた場合は最後に使用したのが古いセリフから破棄します。
+ */
+class VOICEVOXUECORE_API FVoicevoxLineCache
+{
+public:
+
+	//! 圧縮ブロックあたりのフレーム数
+	static constexpr int32 BlockFrameNum = 1024;
+
+	/**
+	 * @brief メモリ予算を設定する（超えた分は古いセリフから破棄する）
+	 * @param[in] InMemoryBudget メモリ予算（バイト、0の場合はキャッシュしない）
+	 */
+	void SetMemoryBudget(int64 InMemoryBudget);
+
+	/**
+	 * @brief メモリ予算を取得する
+	 * @return メモリ予算（バイト）
+	 */
+	int64 GetMemoryBudget() const;
+
+	/**
+	 * @brief 保持しているセリフの使用メモリを取得する
+	 * @return 使用メモリ（バイト）
+	 */
+	int64 GetMemoryUsage() const;
+
+	/**
+	 * @brief 保持しているセリフ数を取得する
+	 * @return セリフ数
+	 */
+	int32 GetLineNum() const;
+
+	/**
+	 * @brief 音声データを圧縮して保持する
+	 * @param[in] Key 検索キー
+	 * @param[in] OutputWAV WAVフォーマットの音声データ（16bit PCM）
+	 */
+	void Add(uint64 Key, const TArray<uint8>& OutputWAV);
+
+	/**
+	 * @brief 保持している音声データを展開する
+	 * @param[in] Key 検索キー
+	 * @param[out] OutputWAV WAVフォーマットの音声データ
+	 * @return 見つかった場合はtrue
+	 */
+	bool Find(uint64 Key, TArray<uint8>& OutputWAV);
+
+	/**
+	 * @brief 保持している全てのセリフを破棄する
+	 */
+	void Empty();
+
+	/**
+	 * @brief 16bit PCMをIMA ADPCMへ圧縮する
+	 * @param[in] Samples 16bit PCM（チャンネルインターリーブ）
+	 * @param[in] NumChannels チャンネル数
+	 * @param[out] OutData 圧縮データ
+	 */
+	static void Encode(TArrayView<const int16> Samples, int32 NumChannels, TArray<uint8>& OutData);
+
+	/**
+	 * @brief IMA ADPCMを16bit PCMへ展開する
+	 * @param[in] Data 圧縮データ
+	 * @param[in] NumChannels チャンネル数
+	 * @param[in] NumFrames 展開するフレーム数
+	 * @param[out] OutSamples 16bit PCM（チャンネルインターリーブ）
+	 */
+	static void Decode(TArrayView<const uint8> Data, int32 NumChannels, int32 NumFrames, TArray<int16>& OutSamples);
+
+private:
+
+	/**
+	 * @struct FLine
+	 * @brief 圧縮したセリフ1つ分のデータ
+	 */
+	struct FLine
+	{
+		//! IMA ADPCMの圧縮データ
+		TArray<uint8> Data;
+
+		//! サンプリングレート
+		int32 SampleRate = 0;
+
+		//! チャンネル数
+		int32 NumChannels = 0;
+
+		//! フレーム数
+		int32 NumFrames = 0;
+	};
+
+	/**
+	 * @brief メモリ予算を超えた分を古いセリフから破棄する（CriticalSectionをロックして呼び出す）
+	 */
+	void Trim();
+
+	/**
+	 * @brief セリフ1つ分の使用メモリを求める
+	 * @param[in] Line セリフ
+	 * @return 使用メモリ（バイト）
+	 */
+	static int64 GetLineMemory(const FLine& Line);
+
+	//! 圧縮したセリフ（キーはAudioQuery、話者番号、疑問文調整から求めたハッシュ値）
+	TMap<uint64, FLine> LineMap;
+
+	//! 最後に使用した順のキーリスト（先頭が最も古い）
+	TArray<uint64> KeyList;
+
+	//! 保持しているセリフの使用メモリ（バイト）
+	int64 MemoryUsage = 0;
+
+	//! メモリ予算（バイト、0の場合はキャッシュしない）
+	int64 MemoryBudget = 0;
+
+	//! キャッシュの排他制御
+	mutable FCriticalSection CriticalSection;
+};
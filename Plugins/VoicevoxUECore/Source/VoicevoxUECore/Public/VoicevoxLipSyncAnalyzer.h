@@ -0,0 +1,62 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxLipSyncAnalyzer.h
+ * @brief  音声データの振幅包絡からリップシンクのデータリストを生成する解析クラスのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoicevoxUEDefined.h"
+
+/**
+ * @class FVoicevoxLipSyncAnalyzer
+ * @brief AudioQuery無しで、PCMのRMSとゼロ交差率から口の開き具合を推定してリップシンクのデータリストを生成するクラス
+ * @details
+ * 10ミリ秒毎のフレームでRMS（音量）とゼロ交差率（音の明るさ）をSIMD（VectorRegister）で1パス計算し、
+ * 最大音量との相対音量を口の開き具合、ゼロ交差率を前舌母音（い・え）と後舌母音（う・お）の判別に使用します。<br/>
+ * 音量が小さくゼロ交差率が高いフレームは無声子音、ごく小さいフレームは無音として扱います。<br/>
+ * AudioQueryから生成するリップシンクより精度は落ちますが、TextToSpeechやボイスバンク等のAudioQueryを持たない音声データにも使用できます。
+ */
+class VOICEVOXUECORE_API FVoicevoxLipSyncAnalyzer
+{
+public:
+
+	//! 解析フレームの長さ（秒）
+	static constexpr float FrameTime = 0.01f;
+
+	//! 無音として扱う最大音量との相対音量（dB）
+	static constexpr float SilenceThreshold = -35.0f;
+
+	//! 無声子音として扱う最大音量との相対音量（dB）の上限
+	static constexpr float ConsonantThreshold = -15.0f;
+
+	//! 無声子音として扱う1サンプルあたりのゼロ交差率の下限
+	static constexpr float ConsonantZeroCrossingRate = 0.25f;
+
+	//! 前舌母音（い・え）として扱う1秒あたりのゼロ交差数の下限
+	static constexpr float FrontVowelZeroCrossingNum = 1500.0f;
+
+	//! これより短い区間は直前の区間へまとめる（秒）
+	static constexpr float MinSegmentTime = 0.03f;
+
+	/**
+	 * @brief PCMからリップシンクのデータリストを生成する
+	 * @param[in] Samples 16bit PCM（チャンネルインターリーブ）
+	 * @param[in] NumChannels チャンネル数
+	 * @param[in] SampleRate サンプリングレート
+	 * @param[in] bIsSimple 簡易のリップシンクで再生するか
+	 * @return リップシンクのデータリスト
+	 */
+	static TArray<FVoicevoxLipSync> Analyze(TArrayView<const int16> Samples, int32 NumChannels, int32 SampleRate, bool bIsSimple = false);
+
+	/**
+	 * @brief WAVデータからリップシンクのデータリストを生成する
+	 * @param[in] OutputWAV WAVフォーマットの音声データ（16bit PCM）
+	 * @param[in] bIsSimple 簡易のリップシンクで再生するか
+	 * @return リップシンクのデータリスト。WAVデータが不正な場合は空
+	 */
+	static TArray<FVoicevoxLipSync> AnalyzeWAV(const TArray<uint8>& OutputWAV, bool bIsSimple = false);
+};
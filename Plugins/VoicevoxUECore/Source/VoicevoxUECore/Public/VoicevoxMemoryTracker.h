@@ -0,0 +1,136 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxMemoryTracker.h
+ * @brief  VOICEVOXのLLM（Low Level Memory Tracker）タグと、VOICEVOX COREのネイティブメモリを計測するクラスのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+//------------------------------------------------------------------------
+// LLM tag
+//------------------------------------------------------------------------
+
+//! VOICEVOX全体（stat LLMではVoicevoxにまとめて表示）
+LLM_DECLARE_TAG_API(Voicevox, VOICEVOXUECORE_API);
+
+//! VOICEVOX CORE、Open JTalk辞書、モデル（ネイティブ側の常駐メモリを含む）
+LLM_DECLARE_TAG_API(Voicevox_Core, VOICEVOXUECORE_API);
+
+//! AudioQuery
+LLM_DECLARE_TAG_API(Voicevox_AudioQuery, VOICEVOXUECORE_API);
+
+//! 音声合成した音声データ（WAV、PCM）
+LLM_DECLARE_TAG_API(Voicevox_PCM, VOICEVOXUECORE_API);
+
+//! アクセント句、定型文、最近再生したセリフ等のキャッシュ
+LLM_DECLARE_TAG_API(Voicevox_Cache, VOICEVOXUECORE_API);
+
+//! 再生用のSoundWave
+LLM_DECLARE_TAG_API(Voicevox_SoundWave, VOICEVOXUECORE_API);
+
+//------------------------------------------------------------------------
+// class
+//------------------------------------------------------------------------
+
+/**
+ * @class FVoicevoxNativeMemoryTracker
+ * @brief VOICEVOX COREの初期化、モデルのロード前後の常駐メモリの増加量を、ネイティブ側の使用メモリとして記録するクラス
+ * @details
+ * VOICEVOX CORE、Open JTalk、ONNX RuntimeはUEのアロケーターを通さずにメモリを確保するため、LLMからは見えません。<br/>
+ * 呼び出し前後のプロセスの常駐メモリ（UsedPhysical）の差を話者毎に記録し、LLMのVoicevox/Coreタグとstat Voicevoxに計上します。<br/>
+ * 計測中に他のスレッドが確保したメモリも含まれるため、目安の値です。ワーカープロセスで実行する場合は計測しません。
+ */
+class VOICEVOXUECORE_API FVoicevoxNativeMemoryTracker
+{
+public:
+
+	/**
+	 * @class FScope
+	 * @brief VOICEVOX COREの呼び出し1回分の常駐メモリの増加量を計測するスコープ（計測中の呼び出しは直列化する）
+	 */
+	class VOICEVOXUECORE_API FScope
+	{
+	public:
+
+		/**
+		 * @brief コンストラクタ
+		 * @param[in] InTracker 記録先
+		 * @param[in] InSpeakerId モデルをロードする話者番号（INDEX_NONEの場合はVOICEVOX COREの初期化）
+		 */
+		FScope(FVoicevoxNativeMemoryTracker& InTracker, int64 InSpeakerId = INDEX_NONE);
+
+		/**
+		 * @brief デストラクタ（常駐メモリの増加量を記録する）
+		 */
+		~FScope();
+
+	private:
+
+		//! 記録先
+		FVoicevoxNativeMemoryTracker& Tracker;
+
+		//! 計測中の排他制御
+		FScopeLock Lock;
+
+		//! モデルをロードする話者番号
+		int64 SpeakerId = INDEX_NONE;
+
+		//! 呼び出し前の常駐メモリ（バイト）
+		uint64 StartUsedPhysical = 0;
+	};
+
+	/**
+	 * @brief VOICEVOX COREの初期化で増加した常駐メモリを取得する
+	 * @return 使用メモリ（バイト、Open JTalk辞書と初期化時にロードしたモデルを含む）
+	 */
+	int64 GetCoreMemory() const;
+
+	/**
+	 * @brief モデルのロードで増加した常駐メモリの合計を取得する
+	 * @return 使用メモリ（バイト）
+	 */
+	int64 GetModelMemory() const;
+
+	/**
+	 * @brief 話者毎のモデルのロードで増加した常駐メモリを取得する
+	 * @return 話者番号と使用メモリ（バイト）のマップ
+	 */
+	TMap<int64, int64> GetModelMemoryMap() const;
+
+	/**
+	 * @brief 記録した使用メモリを破棄する（VOICEVOX COREの終了時に呼び出す）
+	 */
+	void Reset();
+
+private:
+
+	/**
+	 * @brief 常駐メモリの増加量を記録し、LLMとstatに計上する（CriticalSectionをロックして呼び出す）
+	 * @param[in] InSpeakerId モデルをロードした話者番号（INDEX_NONEの場合はVOICEVOX COREの初期化）
+	 * @param[in] DeltaMemory 増加量（バイト）
+	 */
+	void Record(int64 InSpeakerId, int64 DeltaMemory);
+
+	/**
+	 * @brief LLMのVoicevox/Coreタグの値を更新する（CriticalSectionをロックして呼び出す）
+	 * @param[in] DeltaMemory 増加量（バイト）
+	 */
+	void UpdateLLM(int64 DeltaMemory) const;
+
+	//! VOICEVOX COREの初期化で増加した常駐メモリ（バイト）
+	int64 CoreMemory = 0;
+
+	//! モデルのロードで増加した常駐メモリの合計（バイト）
+	int64 ModelMemory = 0;
+
+	//! 話者毎のモデルのロードで増加した常駐メモリ（バイト）
+	TMap<int64, int64> ModelMemoryMap;
+
+	//! 記録の排他制御
+	mutable FCriticalSection CriticalSection;
+};
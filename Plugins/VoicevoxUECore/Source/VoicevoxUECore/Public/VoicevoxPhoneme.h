@@ -0,0 +1,90 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxPhoneme.h
+ * @brief  AudioQueryの子音、母音を音素IDとして扱うための音素テーブルをまとめたヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoicevoxUEDefined.h"
+
+/**
+ * @class FVoicevoxPhoneme
+ * @brief VOICEVOXの音素テーブルと、モーラの子音、母音の音素IDを扱うクラス
+ * @details
+ * AudioQueryの取得、インポート、読み込み時にInternAudioQueryで各モーラの音素IDを設定し、
+ * リップシンク等の解析は文字列ではなく音素IDで行います。<br/>
+ * 音素IDは文字列と一緒に保持しているだけなので、GetConsonantId/GetVowelIdは文字列と音素名が一致するか確認してから返し、
+ * 文字列だけが書き換えられていた場合は音素テーブルから引き直します。
+ */
+class VOICEVOXUECORE_API FVoicevoxPhoneme
+{
+public:
+
+	//! 子音なし、もしくは音素テーブルに無い音素のID
+	static constexpr uint8 NoneId = 0;
+
+	/**
+	 * @brief 音素名から音素IDを取得する
+	 * @param[in] Phoneme 音素名（"a"、"ky"、"pau"等）
+	 * @return 音素ID（音素テーブルに無い場合はNoneId）
+	 */
+	static uint8 FindId(const FString& Phoneme);
+
+	/**
+	 * @brief 音素IDから音素名を取得する
+	 * @param[in] PhonemeId 音素ID
+	 * @return 音素名
+	 */
+	static const TCHAR* GetName(uint8 PhonemeId);
+
+	/**
+	 * @brief モーラの子音、母音の音素IDを設定する
+	 * @param[in,out] Mora モーラ情報
+	 */
+	static void InternMora(FVoicevoxMora& Mora);
+
+	/**
+	 * @brief AudioQueryの全モーラ（句読点モーラを含む）の音素IDを設定する
+	 * @param[in,out] AudioQuery AudioQuery情報
+	 */
+	static void InternAudioQuery(FVoicevoxAudioQuery& AudioQuery);
+
+	/**
+	 * @brief モーラの子音の音素IDを取得する
+	 * @param[in] Mora モーラ情報
+	 * @return 子音の音素ID
+	 */
+	static uint8 GetConsonantId(const FVoicevoxMora& Mora);
+
+	/**
+	 * @brief モーラの母音の音素IDを取得する
+	 * @param[in] Mora モーラ情報
+	 * @return 母音の音素ID
+	 */
+	static uint8 GetVowelId(const FVoicevoxMora& Mora);
+
+	/**
+	 * @brief 音素IDに対応するリップシンク用の母音を取得する
+	 * @param[in] PhonemeId 音素ID
+	 * @return リップシンク用の母音（無声化母音は有声の母音、子音や句読点は無音）
+	 */
+	static ELipSyncVowelType GetVowelType(uint8 PhonemeId);
+
+	/**
+	 * @brief 音素IDが口唇音、もしくは破裂音（口を閉じて発音する子音）か判定する
+	 * @param[in] PhonemeId 音素ID
+	 * @return 口唇音、もしくは破裂音ならtrue
+	 */
+	static bool IsLabialOrPlosive(uint8 PhonemeId);
+
+	/**
+	 * @brief モーラが句読点の無音か判定する
+	 * @param[in] Mora モーラ情報
+	 * @return 母音が「pau」ならtrue
+	 */
+	static bool IsPause(const FVoicevoxMora& Mora);
+};
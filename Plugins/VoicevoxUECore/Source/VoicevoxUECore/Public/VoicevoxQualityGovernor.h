@@ -0,0 +1,102 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxQualityGovernor.h
+ * @brief  音声合成の負荷に応じてAudioQueryの品質を調整するクラスのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoicevoxUEDefined.h"
+
+/**
+ * @class FVoicevoxQualityGovernor
+ * @brief 待機中の音声合成数と実時間比から負荷段階を求め、優先度の低いセリフから品質を下げるクラス
+ * @details
+ * 負荷段階は待機中、実行中の音声合成数と、平滑化した実時間比（合成時間 / 音声の長さ）の高い方から求めます。
+ * 負荷が上がった場合はすぐに段階を上げ、下がった場合はRestoreDelay秒続いてから1段階ずつ戻します。<br/>
+ * 各段階で品質を下げる内容は以下の通りです。（高優先度のセリフは品質を下げません）
+ * - 段階1：低優先度のセリフの無音を短くし、モノラルにする
+ * - 段階2：さらに低優先度のセリフの出力サンプリングレートを下げ、通常優先度のセリフの無音を短くし、モノラルにする
+ * - 段階3：さらに通常優先度のセリフの出力サンプリングレートを下げる
+ */
+class VOICEVOXUECORE_API FVoicevoxQualityGovernor
+{
+public:
+
+	//! 負荷段階の最大値
+	static constexpr int32 MaxLevel = 3;
+
+	/**
+	 * @brief 設定を変更する
+	 * @param[in] InSettings 負荷に応じて品質を調整する設定
+	 */
+	void SetSettings(const FVoicevoxQualityGovernorSettings& InSettings);
+
+	/**
+	 * @brief 設定を取得する
+	 * @return 負荷に応じて品質を調整する設定
+	 */
+	FVoicevoxQualityGovernorSettings GetSettings() const;
+
+	/**
+	 * @brief 現在の負荷に応じて品質を下げたAudioQueryを作成する
+	 * @param[in] AudioQuery 元のAudioQuery
+	 * @param[in] Priority セリフの優先度
+	 * @param[in] QueueDepth 待機中、実行中の音声合成の数
+	 * @param[out] OutAudioQuery 品質を下げたAudioQuery
+	 * @return 品質を下げた場合はtrue（falseの場合はOutAudioQueryを変更しない）
+	 */
+	bool Apply(const FVoicevoxAudioQuery& AudioQuery, EVoicevoxSynthesisPriority Priority, int32 QueueDepth, FVoicevoxAudioQuery& OutAudioQuery);
+
+	/**
+	 * @brief 音声合成1回分の実時間比を記録する
+	 * @param[in] SynthesisTime 合成にかかった時間（秒）
+	 * @param[in] AudioQuery 合成したAudioQuery
+	 */
+	void Record(double SynthesisTime, const FVoicevoxAudioQuery& AudioQuery);
+
+	/**
+	 * @brief 現在の負荷段階を取得する
+	 * @return 負荷段階（0の場合は品質を下げない）
+	 */
+	int32 GetLevel() const;
+
+	/**
+	 * @brief 平滑化した実時間比を取得する
+	 * @return 実時間比（未計測の場合は0）
+	 */
+	double GetRealTimeFactor() const;
+
+	/**
+	 * @brief AudioQueryから音声の長さを求める
+	 * @param[in] AudioQuery AudioQuery
+	 * @return 音声の長さ（秒）
+	 */
+	static double GetAudioQueryDuration(const FVoicevoxAudioQuery& AudioQuery);
+
+private:
+
+	/**
+	 * @brief 待機中の音声合成数と実時間比から負荷段階を更新する（CriticalSectionをロックして呼び出す）
+	 * @param[in] QueueDepth 待機中、実行中の音声合成の数
+	 */
+	void UpdateLevel(int32 QueueDepth);
+
+	//! 負荷に応じて品質を調整する設定
+	FVoicevoxQualityGovernorSettings Settings;
+
+	//! 設定、負荷段階の排他制御
+	mutable FCriticalSection CriticalSection;
+
+	//! 現在の負荷段階
+	int32 Level = 0;
+
+	//! 負荷が現在の段階を下回り始めた時刻（下回っていない場合は0）
+	double LowLoadStartTime = 0.0;
+
+	//! 平滑化した実時間比
+	double RealTimeFactor = 0.0;
+};
@@ -9,8 +9,34 @@
 
 #include "CoreMinimal.h"
 #include "VoicevoxUEDefined.h"
+#include "Engine/CurveTable.h"
+#include "Misc/Guid.h"
 #include "VoicevoxQuery.generated.h"
 
+/**
+ * @struct FVoicevoxQueryCustomVersion
+ * @brief UVoicevoxQueryのシリアライズ形式のバージョン
+ */
+struct VOICEVOXUECORE_API FVoicevoxQueryCustomVersion
+{
+	enum Type
+	{
+		//! AudioQueryをタグ付きプロパティとして保存していたバージョン
+		BeforeCustomVersionWasAdded = 0,
+		//! AudioQueryを音素ID + floatの配列にまとめたバイナリとして保存するバージョン
+		CompactAudioQuery,
+
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	//! カスタムバージョンのGUID
+	static const FGuid GUID;
+
+private:
+	FVoicevoxQueryCustomVersion() {}
+};
+
 /**
  * @classs UVoicevoxQuery
  * @brief Voicevoxで生成されるクエリ情報を保存するためのクラス
@@ -42,4 +68,68 @@ public:
 	 */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX CORE")
 	FString YomikataText;
+
+	/**
+	 * @brief ベイク済みのリップシンクカーブ
+	 * @details エディターのアセットメニュー「Bake Lip Sync Curves」で生成します。行名は「A」「I」「U」「E」「O」「Simple」で、値は0～1のモーフターゲット値です。<br/>
+	 *			セットされていてLipSyncCurveTableKeyがAudioQueryと一致する場合、リップシンクコンポーネントはリップシンクのデータリストを生成せずにカーブを評価します。
+	 *			アニメーションブループリント等からカーブを直接評価することもできます。
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX CORE")
+	TObjectPtr<UCurveTable> LipSyncCurveTable;
+
+	/**
+	 * @brief LipSyncCurveTableをベイクした時のAudioQueryのキー
+	 * @details ベイク後にAudioQueryを編集した場合は一致しなくなり、リップシンクコンポーネントはカーブを使わずにAudioQueryからリップシンクを生成します。
+	 */
+	UPROPERTY(VisibleAnywhere, Category="VOICEVOX CORE")
+	uint64 LipSyncCurveTableKey = 0;
+
+	/**
+	 * @brief ベイク済みのリップシンクカーブの照合に使うAudioQueryのキーを求める
+	 * @return VoicevoxAudioQueryから求めたキー（リップシンクは話者に依存しないため話者番号は含めない）
+	 */
+	uint64 GetLipSyncCurveTableKey() const;
+
+	/**
+	 * @brief ベイク済みのリップシンクカーブがAudioQueryと一致するかを求め直す
+	 * @details 読み込み時、詳細パネルでの編集時、ベイク時に呼ばれます。実行時にVoicevoxAudioQueryを書き換えた場合も呼んでください。
+	 */
+	void UpdateLipSyncCurveTableValidity();
+
+	/**
+	 * @brief AudioQueryと一致するベイク済みのリップシンクカーブを取得する
+	 * @return ベイク済みのカーブ（無い場合、もしくはベイク後にAudioQueryを編集した場合はnullptr）
+	 */
+	UCurveTable* GetValidLipSyncCurveTable() const;
+
+	/**
+	 * @brief Serialize
+	 * @details パッケージへの保存、読み込みではVoicevoxAudioQueryをタグ付きプロパティではなく、
+	 *			モーラの文字列を音素IDに置き換えてfloatの配列にまとめたバイナリで保存します。
+	 */
+	virtual void Serialize(FArchive& Ar) override;
+
+	/**
+	 * @brief PostLoad
+	 */
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	/**
+	 * @brief PostEditChangeProperty
+	 */
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+
+	/**
+	 * @brief VoicevoxAudioQueryをバイナリ形式でシリアライズする
+	 * @param[in] Ar アーカイブ
+	 */
+	void SerializeCompactAudioQuery(FArchive& Ar);
+
+	// LipSyncCurveTableKeyがAudioQueryと一致するか（再生の度にAudioQueryのキーを求めないようにキャッシュする）
+	bool bIsLipSyncCurveTableValid = false;
 };
@@ -0,0 +1,168 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxRemoteProtocol.h
+ * @brief  音声合成サーバーとクライアント間の通信プロトコルを定義したヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoicevoxUEDefined.h"
+#include <atomic>
+
+class FSocket;
+
+//------------------------------------------------------------------------
+// enum
+//------------------------------------------------------------------------
+
+/**
+ * @enum EVoicevoxRemoteCommand
+ * @brief 音声合成サーバーへのリクエスト種別
+ */
+enum class EVoicevoxRemoteCommand : uint8
+{
+	//! サーバー情報（メタ情報、サポートデバイス、バージョン、GPUモード）取得
+	ServerInfo,
+	//! モデルのロード
+	LoadModel,
+	//! AudioQuery取得（レスポンスはAudioQueryのJSON文字列）
+	AudioQuery,
+	//! text to speech（レスポンスは圧縮PCM）
+	TextToSpeech,
+	//! 音声合成（リクエストはAudioQueryのJSON文字列、レスポンスは圧縮PCM）
+	Synthesis,
+};
+
+//------------------------------------------------------------------------
+// struct
+//------------------------------------------------------------------------
+
+/**
+ * @struct FVoicevoxRemoteRequest
+ * @brief 音声合成サーバーへのリクエスト1件分の構造体
+ */
+struct FVoicevoxRemoteRequest
+{
+	//! リクエスト種別
+	EVoicevoxRemoteCommand Command = EVoicevoxRemoteCommand::ServerInfo;
+
+	//! 話者番号
+	int64 SpeakerId = 0;
+
+	//! aquestalk形式のkanaとしてテキストを解釈する
+	bool bKana = false;
+
+	//! 疑問文の調整を有効にする
+	bool bEnableInterrogativeUpspeak = true;
+
+	//! テキスト、もしくはAudioQueryのJSON文字列
+	FString Text;
+
+	friend FArchive& operator<<(FArchive& Ar, FVoicevoxRemoteRequest& Request);
+};
+
+/**
+ * @struct FVoicevoxRemoteResponse
+ * @brief 音声合成サーバーからのレスポンス1件分の構造体
+ */
+struct FVoicevoxRemoteResponse
+{
+	//! 処理に成功したか
+	bool bIsSucceeded = false;
+
+	//! レスポンスのデータ本体
+	TArray<uint8> Data;
+
+	friend FArchive& operator<<(FArchive& Ar, FVoicevoxRemoteResponse& Response);
+};
+
+/**
+ * @struct FVoicevoxRemoteServerInfo
+ * @brief 音声合成サーバーが読み込んでいるVOICEVOX COREの情報構造体
+ */
+struct FVoicevoxRemoteServerInfo
+{
+	//! 話者名や話者IDのリスト
+	TArray<FVoicevoxMeta> MetaList;
+
+	//! サポートデバイス情報
+	FVoicevoxSupportedDevices SupportedDevices;
+
+	//! VOICEVOX COREのバージョン
+	FString Version;
+
+	//! GPUモードか
+	bool bIsGpuMode = false;
+
+	friend FArchive& operator<<(FArchive& Ar, FVoicevoxRemoteServerInfo& ServerInfo);
+};
+
+//------------------------------------------------------------------------
+// class
+//------------------------------------------------------------------------
+
+/**
+ * @class FVoicevoxRemoteProtocol
+ * @brief 音声合成サーバーとクライアント間のフレーム送受信と、PCMの圧縮を行うクラス
+ * @details
+ * 1フレームは「識別子(4byte) / データ本体のサイズ(4byte) / データ本体」で構成され、
+ * データ本体は複数のリクエスト、もしくは同数のレスポンスをまとめたバッチです。<br/>
+ * 音声データはWAVのままではなく、チャンネル毎の差分を上位/下位バイトに分けてZlibで可逆圧縮したPCMで送ります。
+ */
+class VOICEVOXUECORE_API FVoicevoxRemoteProtocol
+{
+public:
+
+	//! フレーム識別子（VVRP）
+	static constexpr uint32 FrameMagic = 0x50525656;
+
+	//! 既定の待ち受けポート番号
+	static constexpr int32 DefaultPort = 50121;
+
+	//! 1フレームの最大サイズ
+	static constexpr uint32 MaxFrameSize = 256 * 1024 * 1024;
+
+	/**
+	 * @brief フレームを送信する
+	 * @param[in] Socket 送信するソケット
+	 * @param[in] Payload データ本体
+	 * @return 送信に成功したらtrue
+	 */
+	static bool SendFrame(FSocket& Socket, TArrayView<const uint8> Payload);
+
+	/**
+	 * @brief フレームを受信する
+	 * @param[in] Socket 受信するソケット
+	 * @param[out] OutPayload データ本体
+	 * @param[in] bAbort trueになったら受信を中断するフラグ（nullptrの場合は中断しない）
+	 * @return 受信に成功したらtrue
+	 */
+	static bool ReceiveFrame(FSocket& Socket, TArray<uint8>& OutPayload, const std::atomic<bool>* bAbort = nullptr);
+
+	/**
+	 * @brief WAVフォーマットの音声データを圧縮PCMに変換する
+	 * @param[in] OutputWAV 16bitのWAVフォーマットの音声データ
+	 * @param[out] OutCompressed 圧縮PCM
+	 * @return 変換に成功したらtrue
+	 */
+	static bool CompressWAV(const TArray<uint8>& OutputWAV, TArray<uint8>& OutCompressed);
+
+	/**
+	 * @brief 圧縮PCMをWAVフォーマットの音声データに戻す
+	 * @param[in] Compressed 圧縮PCM
+	 * @param[out] OutputWAV WAVフォーマットの音声データ
+	 * @return 変換に成功したらtrue
+	 */
+	static bool DecompressWAV(const TArray<uint8>& Compressed, TArray<uint8>& OutputWAV);
+
+	/**
+	 * @brief 音声合成サーバーのアドレスを取得する
+	 * @param[out] OutAddress 「ホスト名:ポート番号」形式のアドレス
+	 * @return コマンドライン引数の「-VoicevoxServerAddress=」、もしくはDefaultEngine.iniの[Voicevox]ServerAddressが設定されていればtrue
+	 * @details ワーカープロセスでは常にfalse、コマンドレットではiniの設定を無視します。
+	 */
+	static bool GetServerAddress(FString& OutAddress);
+};
@@ -0,0 +1,50 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxResampler.h
+ * @brief  VOICEVOX COREが出力した音声データを再生デバイスのサンプリングレートへ変換するリサンプラーのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @class FVoicevoxResampler
+ * @brief 有理数比のポリフェーズFIRフィルタ（カイザー窓付きsinc）で16bit PCMをリサンプリングするクラス
+ * @details
+ * 出力サンプリングレートを入力サンプリングレートとの最大公約数で約分した比（L/M）で位相毎のフィルタ係数を事前計算し、
+ * 1出力サンプルあたりTapNum回の積和をSIMD（VectorRegister）で計算します。<br/>
+ * 音声合成時に1度だけ変換しておくことで、オーディオミキサーが再生の度にリサンプリングする負荷を無くします。
+ */
+class VOICEVOXUECORE_API FVoicevoxResampler
+{
+public:
+
+	//! 1位相あたりのフィルタのタップ数（4の倍数）
+	static constexpr int32 TapNum = 32;
+
+	//! 事前計算する位相数の上限（超える比率の場合はリサンプリングしない）
+	static constexpr int32 MaxPhaseNum = 2048;
+
+	/**
+	 * @brief 16bit PCMをリサンプリングする
+	 * @param[in] InSamples 入力PCM（チャンネルインターリーブ）
+	 * @param[in] NumChannels チャンネル数
+	 * @param[in] InSampleRate 入力サンプリングレート
+	 * @param[in] OutSampleRate 出力サンプリングレート
+	 * @param[out] OutSamples 出力PCM（チャンネルインターリーブ）
+	 * @return リサンプリングに成功したらtrue
+	 */
+	static bool Resample(TArrayView<const int16> InSamples, int32 NumChannels, int32 InSampleRate, int32 OutSampleRate, TArray<int16>& OutSamples);
+
+	/**
+	 * @brief WAVデータをリサンプリングする
+	 * @param[in] InWAV 入力WAVデータ（16bit PCM）
+	 * @param[in] OutSampleRate 出力サンプリングレート
+	 * @param[out] OutWAV 出力WAVデータ
+	 * @return リサンプリングに成功したらtrue。既に出力サンプリングレートの場合もfalse
+	 */
+	static bool ResampleWAV(const TArray<uint8>& InWAV, int32 OutSampleRate, TArray<uint8>& OutWAV);
+};
@@ -0,0 +1,206 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxSpeculativeSynthesis.h
+ * @brief  選択肢のテキスト等、次に再生する可能性のあるテキストを投機的に音声合成するクラスのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoicevoxUEDefined.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+/**
+ * @class FVoicevoxSpeculativeSynthesis
+ * @brief 候補テキストを最低優先度のスレッドで順番に音声合成し、選ばれた候補の結果を受け渡すクラス
+ * @details
+ * Submitで渡した候補は、前回の候補を破棄してから先頭から順番にAudioQuery取得と音声合成を行います。<br/>
+ * 合成にかかった時間に対してCPU使用率の予算を超えないように、次の候補の合成まで待機します。<br/>
+ * FindAudioQuery、FindSynthesisで合成中、もしくは合成済みの候補が見つかった場合はその結果を受け渡し、残りの候補は破棄します。<br/>
+ * 合成中の候補が選ばれた場合は、完了を待つ間スレッドの優先度を通常に上げ、完了後は待機せずに最低優先度へ戻します。
+ */
+class VOICEVOXUECORE_API FVoicevoxSpeculativeSynthesis : public FRunnable
+{
+public:
+
+	//! AudioQuery取得関数
+	using FQueryFunction = TFunction<FVoicevoxAudioQuery(int64 SpeakerId, const FString& Message, bool bKana)>;
+
+	//! 音声合成関数（負荷が高く品質を下げた場合は、実際に音声合成したAudioQueryをOutGovernedAudioQueryに設定する）
+	using FSynthesisFunction = TFunction<TArray<uint8>(const FVoicevoxAudioQuery& AudioQuery, int64 SpeakerId, bool bEnableInterrogativeUpspeak,
+		TOptional<FVoicevoxAudioQuery>& OutGovernedAudioQuery)>;
+
+	//! 1度に投機的に合成する候補の最大数
+	static constexpr int32 MaxLineNum = 8;
+
+	/**
+	 * @brief コンストラクタ
+	 * @param[in] InQueryFunction AudioQuery取得関数
+	 * @param[in] InSynthesisFunction 音声合成関数
+	 */
+	FVoicevoxSpeculativeSynthesis(FQueryFunction&& InQueryFunction, FSynthesisFunction&& InSynthesisFunction);
+
+	/**
+	 * @brief デストラクタ
+	 */
+	virtual ~FVoicevoxSpeculativeSynthesis() override;
+
+	/**
+	 * @brief 候補テキストを投機的に音声合成する（前回の候補は破棄する）
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] MessageList 候補テキストのリスト（MaxLineNumを超えた分は無視する）
+	 * @param[in] bKana aquestalk形式のkanaとしてテキストを解釈する
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 */
+	void Submit(int64 SpeakerId, const TArray<FString>& MessageList, bool bKana, bool bEnableInterrogativeUpspeak);
+
+	/**
+	 * @brief 全ての候補を破棄する（合成中の候補は合成完了後に破棄する）
+	 */
+	void Cancel();
+
+	/**
+	 * @brief CPU使用率の予算を設定する
+	 * @param[in] InCPUBudget 候補の合成に使う時間の割合（0.01～1.0、1.0の場合は待機せずに連続で合成する）
+	 */
+	void SetCPUBudget(float InCPUBudget);
+
+	/**
+	 * @brief 候補のAudioQueryを取得する
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] Message テキスト
+	 * @param[in] bKana aquestalk形式のkanaとしてテキストを解釈する
+	 * @param[out] OutAudioQuery AudioQuery
+	 * @return 合成中、もしくは合成済みの候補が見つかればtrue（AudioQuery取得中の場合は取得まで待機する）
+	 * @details 見つかった候補は続くFindSynthesisのために残し、他の候補は破棄します。未処理の候補しか見つからなかった場合は全ての候補を破棄します。
+	 */
+	bool FindAudioQuery(int64 SpeakerId, const FString& Message, bool bKana, FVoicevoxAudioQuery& OutAudioQuery);
+
+	/**
+	 * @brief AudioQueryが一致する候補の音声データを取得する
+	 * @param[in] AudioQuery AudioQuery
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にする
+	 * @param[in] Priority 呼び出し元のセリフの優先度
+	 * @param[out] OutputWAV WAVフォーマットの音声データ
+	 * @param[out] OutSynthesisAudioQuery 実際に音声合成したAudioQuery（nullptrの場合は受け取らない、品質を下げていない場合は変更しない）
+	 * @return 合成中、もしくは合成済みの候補が見つかればtrue（合成中の場合は完了まで待機する）
+	 * @details 候補が見つかった場合は、見つかった候補を含め全ての候補を破棄します。<br/>
+	 *			候補は低優先度として音声合成するため、負荷が高く品質を下げた候補は呼び出し元の優先度が低優先度より高い場合は受け渡さずにfalseを返します。
+	 */
+	bool FindSynthesis(const FVoicevoxAudioQuery& AudioQuery, int64 SpeakerId, bool bEnableInterrogativeUpspeak, EVoicevoxSynthesisPriority Priority,
+		TArray<uint8>& OutputWAV, FVoicevoxAudioQuery* OutSynthesisAudioQuery = nullptr);
+
+	//--------------------------------
+	// FRunnable override
+	//--------------------------------
+
+	/**
+	 * @brief Run
+	 */
+	virtual uint32 Run() override;
+
+	/**
+	 * @brief Stop
+	 */
+	virtual void Stop() override;
+
+private:
+
+	/**
+	 * @enum ELineState
+	 * @brief 候補の処理状態
+	 */
+	enum class ELineState : uint8
+	{
+		//! 未処理
+		Pending,
+		//! 合成中
+		Running,
+		//! 合成完了
+		Done,
+	};
+
+	/**
+	 * @struct FLine
+	 * @brief 候補1件分の情報
+	 */
+	struct FLine
+	{
+		//! 話者番号
+		int64 SpeakerId = 0;
+
+		//! テキスト
+		FString Message;
+
+		//! aquestalk形式のkanaとしてテキストを解釈する
+		bool bKana = false;
+
+		//! 疑問文の調整を有効にする
+		bool bEnableInterrogativeUpspeak = true;
+
+		//! 処理状態
+		ELineState State = ELineState::Pending;
+
+		//! FindAudioQuery、FindSynthesisで選ばれて完了を待たれている
+		bool bIsChosen = false;
+
+		//! AudioQuery（AudioQueryHashが0以外になった時点で有効）
+		FVoicevoxAudioQuery AudioQuery;
+
+		//! AudioQueryのハッシュ値
+		uint32 AudioQueryHash = 0;
+
+		//! WAVフォーマットの音声データ
+		TArray<uint8> OutputWAV;
+
+		//! 負荷が高く品質を下げて音声合成した場合のAudioQuery
+		TOptional<FVoicevoxAudioQuery> GovernedAudioQuery;
+
+		//! AudioQuery取得完了イベント
+		FEventRef QueryEvent{EEventMode::ManualReset};
+
+		//! 合成完了イベント
+		FEventRef DoneEvent{EEventMode::ManualReset};
+	};
+
+	/**
+	 * @brief AudioQueryのハッシュ値を求める
+	 * @param[in] AudioQuery AudioQuery
+	 * @return ハッシュ値（0にはならない）
+	 */
+	static uint32 GetAudioQueryHash(const FVoicevoxAudioQuery& AudioQuery);
+
+	/**
+	 * @brief 選ばれた候補の完了を待つため、合成中であれば合成スレッドの優先度を上げる
+	 * @param[in] Line 選ばれた候補
+	 */
+	void PromoteChosenLine(FLine& Line);
+
+	//! AudioQuery取得関数
+	FQueryFunction QueryFunction;
+
+	//! 音声合成関数
+	FSynthesisFunction SynthesisFunction;
+
+	//! 候補リスト
+	TArray<TSharedRef<FLine>> LineList;
+
+	//! 候補リストの排他制御
+	FCriticalSection LineCriticalSection;
+
+	//! 合成スレッドを起こすイベント
+	FEventRef WakeEvent;
+
+	//! 合成スレッド
+	FRunnableThread* Thread = nullptr;
+
+	//! CPU使用率の予算
+	std::atomic<float> CPUBudget = 0.5f;
+
+	//! 停止要求フラグ
+	std::atomic<bool> bStopRequested = false;
+};
@@ -0,0 +1,65 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxSynthesisCostModel.h
+ * @brief  話者毎のモーラあたりの合成時間から音声合成の所要時間を予測するクラスのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoicevoxUEDefined.h"
+
+/**
+ * @class FVoicevoxSynthesisCostModel
+ * @brief 音声合成の所要時間を「モーラ数 × 計測したモーラあたりの合成時間」で予測するクラス
+ * @details
+ * モーラあたりの合成時間は話者毎に平滑化して保持します。
+ * 未計測の話者は計測済みの全話者の平均、何も計測していない場合は既定値で予測します。
+ */
+class VOICEVOXUECORE_API FVoicevoxSynthesisCostModel
+{
+public:
+
+	/**
+	 * @brief 音声合成1回分の所要時間を記録する
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] MoraNum 合成したモーラ数
+	 * @param[in] SynthesisTime 合成にかかった時間（秒）
+	 */
+	void Record(int64 SpeakerId, int32 MoraNum, double SynthesisTime);
+
+	/**
+	 * @brief 音声合成の所要時間を予測する
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] MoraNum 合成するモーラ数
+	 * @return 予測した所要時間（秒）
+	 */
+	double Predict(int64 SpeakerId, int32 MoraNum) const;
+
+	/**
+	 * @brief モーラあたりの合成時間を取得する
+	 * @param[in] SpeakerId 話者番号
+	 * @return モーラあたりの合成時間（秒）
+	 */
+	double GetSecondsPerMora(int64 SpeakerId) const;
+
+	/**
+	 * @brief AudioQueryのモーラ数を求める（無音のモーラを含む）
+	 * @param[in] AudioQuery AudioQuery
+	 * @return モーラ数
+	 */
+	static int32 GetMoraNum(const FVoicevoxAudioQuery& AudioQuery);
+
+private:
+
+	//! 話者毎のモーラあたりの合成時間（秒）
+	TMap<int64, double> SecondsPerMoraMap;
+
+	//! 全話者のモーラあたりの合成時間（秒、未計測の場合は0）
+	double GlobalSecondsPerMora = 0.0;
+
+	//! 合成時間の排他制御
+	mutable FCriticalSection CriticalSection;
+};
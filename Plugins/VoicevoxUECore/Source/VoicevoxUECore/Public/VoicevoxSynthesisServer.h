@@ -0,0 +1,95 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxSynthesisServer.h
+ * @brief  VOICEVOX COREのAPIをローカルのソケット経由で公開する音声合成サーバーのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoicevoxRemoteProtocol.h"
+#include <atomic>
+
+class FSocket;
+class FTcpListener;
+class UVoicevoxCoreSubsystem;
+struct FIPv4Endpoint;
+
+/**
+ * @class FVoicevoxSynthesisServer
+ * @brief 1つのプロセスで読み込んだVOICEVOX COREを、ループバックのソケット経由で複数のクライアントへ公開するクラス
+ * @details
+ * 接続毎に受信スレッドを作成し、受信したバッチ内のリクエストを並列に処理して、同じ順序のレスポンスをまとめて返します。<br/>
+ * リクエストはUVoicevoxCoreSubsystemの公開APIで処理するため、ボイスバンクやワーカープールもそのまま利用されます。
+ */
+class VOICEVOXUECORE_API FVoicevoxSynthesisServer
+{
+public:
+
+	/**
+	 * @brief コンストラクタ
+	 * @param[in] InSubsystem リクエストを処理するSubsystem
+	 */
+	explicit FVoicevoxSynthesisServer(UVoicevoxCoreSubsystem* InSubsystem);
+
+	/**
+	 * @brief デストラクタ
+	 */
+	~FVoicevoxSynthesisServer();
+
+	/**
+	 * @brief ループバックアドレスで接続の待ち受けを開始する
+	 * @param[in] Port 待ち受けるポート番号
+	 * @return 待ち受けに成功したらtrue
+	 */
+	bool Start(int32 Port);
+
+	/**
+	 * @brief 接続の待ち受けを終了し、全ての接続を切断する
+	 */
+	void Stop();
+
+	/**
+	 * @brief 接続を待ち受けているか
+	 * @return 待ち受けていたらtrue
+	 */
+	bool IsRunning() const;
+
+private:
+
+	class FConnection;
+
+	/**
+	 * @brief 接続を受け付けた時の処理
+	 * @param[in] Socket 接続したソケット
+	 * @param[in] Endpoint 接続元
+	 * @return ソケットを受け取ったらtrue
+	 */
+	bool HandleConnectionAccepted(FSocket* Socket, const FIPv4Endpoint& Endpoint);
+
+	/**
+	 * @brief リクエストを処理する
+	 * @param[in] Request リクエスト
+	 * @return レスポンス
+	 */
+	FVoicevoxRemoteResponse ProcessRequest(const FVoicevoxRemoteRequest& Request) const;
+
+	//! リクエストを処理するSubsystem
+	UVoicevoxCoreSubsystem* Subsystem;
+
+	//! 接続の待ち受け
+	TUniquePtr<FTcpListener> Listener;
+
+	//! 接続リスト
+	TArray<TUniquePtr<FConnection>> ConnectionList;
+
+	//! 接続リストの排他制御
+	FCriticalSection ConnectionCriticalSection;
+
+	//! 停止要求フラグ
+	std::atomic<bool> bStopRequested = false;
+};
+
+VOICEVOXUECORE_API DECLARE_LOG_CATEGORY_EXTERN(LogVoicevoxServer, Log, All);
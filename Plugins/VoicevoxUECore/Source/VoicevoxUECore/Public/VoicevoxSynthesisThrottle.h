@@ -0,0 +1,231 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxSynthesisThrottle.h
+ * @brief  音声合成の同時実行数、スレッド優先度、フレーム時間に応じた抑制を行うクラスのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoicevoxUEDefined.h"
+#include <atomic>
+
+/**
+ * @struct FVoicevoxSynthesisDeadline
+ * @brief 音声合成の期限
+ */
+struct FVoicevoxSynthesisDeadline
+{
+	//! 音声合成を完了させる期限（FPlatformTime::Seconds()の時刻、0以下の場合は期限無し）
+	double Deadline = 0.0;
+
+	//! 期限に間に合わないと予測した時に1度だけ呼び出す関数（引数は予測した完了時刻、呼び出し元のスレッドで呼ばれる）
+	TFunction<void(double PredictedCompletionTime)> OnDeadlineMiss;
+
+	//! 期限に間に合わないと予測した場合、音声合成を開始せずに中止するか
+	bool bCancelOnDeadlineMiss = false;
+
+	/**
+	 * @brief 現在から指定秒数後を期限にする
+	 * @param[in] Seconds 期限までの秒数
+	 * @return 音声合成の期限
+	 */
+	static FVoicevoxSynthesisDeadline FromNow(const double Seconds)
+	{
+		FVoicevoxSynthesisDeadline Deadline;
+		Deadline.Deadline = FPlatformTime::Seconds() + Seconds;
+		return Deadline;
+	}
+};
+
+/**
+ * @class FVoicevoxSynthesisThrottle
+ * @brief FVoicevoxSynthesisBudgetの設定に従って、音声合成の開始を待機させるクラス
+ * @details
+ * 音声合成を行う関数はFScopeで囲み、同時実行数が上限に達している間、もしくはゲームスレッドのフレーム時間に余裕が無い間は開始を待機します。<br/>
+ * 同時実行数に上限がある場合、待機中の音声合成は期限の早い順（期限が無いものは期限付きの後に依頼順）に開始します。
+ * 期限付きの音声合成は、先に開始する音声合成の予測所要時間から完了時刻を予測し、期限に間に合わない場合は待機中でも早めに通知します。<br/>
+ * フレーム時間（ゲームスレッドとレンダースレッドの処理時間の長い方）はFCoreDelegates::OnBeginFrameで平滑化して保持するため、フレームが進まないコマンドレットやワーカープロセスでは抑制しません。
+ * ゲームスレッドから呼び出された場合も、待機するとフレームが進まないためフレーム時間による抑制は行いません。<br/>
+ * VOICEVOX CORE内部の推論スレッドの優先度は変更できないため、スレッド優先度は音声合成を呼び出したスレッドにのみ設定します。
+ */
+class VOICEVOXUECORE_API FVoicevoxSynthesisThrottle
+{
+public:
+
+	/**
+	 * @class FScope
+	 * @brief 生存期間中、音声合成の実行枠を1つ確保するクラス
+	 */
+	class VOICEVOXUECORE_API FScope
+	{
+	public:
+
+		/**
+		 * @brief コンストラクタ（実行枠が空くまで待機し、スレッド優先度を設定する）
+		 * @param[in] InThrottle 音声合成の抑制
+		 * @param[in] Deadline 音声合成の期限（nullptrの場合は期限無し）
+		 * @param[in] PredictedCost 予測した音声合成の所要時間（秒）
+		 */
+		explicit FScope(FVoicevoxSynthesisThrottle& InThrottle, const FVoicevoxSynthesisDeadline* Deadline = nullptr, double PredictedCost = 0.0);
+
+		/**
+		 * @brief デストラクタ（スレッド優先度を戻し、実行枠を解放する）
+		 */
+		~FScope();
+
+		UE_NONCOPYABLE(FScope);
+
+		/**
+		 * @brief 実行枠を確保できたか
+		 * @return 期限に間に合わないため中止した場合はfalse
+		 */
+		bool IsAcquired() const { return bIsAcquired; }
+
+	private:
+
+		//! 音声合成の抑制
+		FVoicevoxSynthesisThrottle& Throttle;
+
+		//! 実行枠の依頼番号
+		uint64 Sequence = 0;
+
+		//! 実行枠を確保できたか
+		bool bIsAcquired = false;
+
+		//! 変更前のスレッド優先度（変更していない場合はTPri_Num）
+		EThreadPriority PrevThreadPriority = TPri_Num;
+	};
+
+	/**
+	 * @brief フレーム時間の計測を開始する
+	 */
+	void Start();
+
+	/**
+	 * @brief フレーム時間の計測を終了し、待機中の音声合成を全て開始させる
+	 */
+	void Stop();
+
+	/**
+	 * @brief 設定を変更する
+	 * @param[in] InBudget 音声合成に割り当てるCPU予算の設定
+	 */
+	void SetBudget(const FVoicevoxSynthesisBudget& InBudget);
+
+	/**
+	 * @brief 設定を取得する
+	 * @return 音声合成に割り当てるCPU予算の設定
+	 */
+	FVoicevoxSynthesisBudget GetBudget() const;
+
+	/**
+	 * @brief 平滑化したゲームスレッドのフレーム時間を取得する
+	 * @return フレーム時間（秒）。計測していない場合は0
+	 */
+	double GetFrameTime() const { return FrameTime.load(); }
+
+	/**
+	 * @brief 待機中、実行中の音声合成の数を取得する
+	 * @return 音声合成の数
+	 */
+	int32 GetQueueDepth() const;
+
+private:
+
+	/**
+	 * @struct FEntry
+	 * @brief 待機中、実行中の音声合成
+	 */
+	struct FEntry
+	{
+		//! 期限（期限無しの場合はdoubleの最大値）
+		double Deadline = 0.0;
+
+		//! 依頼番号
+		uint64 Sequence = 0;
+
+		//! 予測した所要時間（秒）
+		double PredictedCost = 0.0;
+
+		//! 開始した時刻（待機中の場合は0）
+		double StartTime = 0.0;
+
+		//! 待機を開始した時刻
+		double RequestTime = 0.0;
+
+		//! フレーム時間による抑制の対象か（ゲームスレッドからの依頼は対象外）
+		bool bCanThrottle = true;
+
+		/**
+		 * @brief 期限の早い順、同じ期限の場合は依頼順で先に開始するか
+		 */
+		bool IsEarlierThan(const FEntry& Other) const
+		{
+			return Deadline < Other.Deadline || (Deadline == Other.Deadline && Sequence < Other.Sequence);
+		}
+	};
+
+	/**
+	 * @brief 実行枠が空くまで待機して確保する
+	 * @param[in] Deadline 音声合成の期限（nullptrの場合は期限無し）
+	 * @param[in] PredictedCost 予測した音声合成の所要時間（秒）
+	 * @param[out] OutSequence 実行枠の依頼番号
+	 * @return 期限に間に合わないため中止した場合はfalse
+	 */
+	bool Acquire(const FVoicevoxSynthesisDeadline* Deadline, double PredictedCost, uint64& OutSequence);
+
+	/**
+	 * @brief 実行枠を解放する
+	 * @param[in] Sequence 実行枠の依頼番号
+	 */
+	void Release(uint64 Sequence);
+
+	/**
+	 * @brief 待機中の音声合成が開始するまでの時間を予測する（CriticalSectionをロックして呼び出す）
+	 * @param[in] Entry 待機中の音声合成
+	 * @param[in] Now 現在時刻
+	 * @return 予測した待機時間（秒）
+	 */
+	double PredictWaitTime(const FEntry& Entry, double Now) const;
+
+	/**
+	 * @brief ゲームスレッドのフレーム時間に余裕が無いか
+	 * @return 余裕が無い場合はtrue
+	 */
+	bool IsFrameOverBudget() const;
+
+	/**
+	 * @brief フレーム開始時にフレーム時間を平滑化して記録する
+	 */
+	void OnBeginFrame();
+
+	//! 音声合成に割り当てるCPU予算の設定
+	FVoicevoxSynthesisBudget Budget;
+
+	//! 設定、実行数の排他制御
+	mutable FCriticalSection CriticalSection;
+
+	//! 実行中の音声合成のリスト
+	TArray<FEntry> RunningList;
+
+	//! 実行枠が空くのを待機中の音声合成のリスト
+	TArray<FEntry> WaitingList;
+
+	//! 次に割り当てる依頼番号
+	uint64 NextSequence = 0;
+
+	//! 実行枠の解放、設定変更を通知するイベント
+	FEventRef ReleaseEvent;
+
+	//! 平滑化したゲームスレッドのフレーム時間（秒）
+	std::atomic<double> FrameTime = 0.0;
+
+	//! 停止済みフラグ（停止後は待機しない）
+	std::atomic<bool> bIsStopped = false;
+
+	//! OnBeginFrameのデリゲートハンドル
+	FDelegateHandle BeginFrameHandle;
+};
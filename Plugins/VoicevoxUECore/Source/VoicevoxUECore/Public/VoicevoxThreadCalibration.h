@@ -0,0 +1,102 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxThreadCalibration.h
+ * @brief  VOICEVOX COREの推論スレッド数を実機で計測して決めるキャリブレーションクラスのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @class FVoicevoxThreadCalibration
+ * @brief 推論スレッド数の候補毎に参照用AudioQueryを音声合成して、最適なスレッド数を求めて保存するクラス
+ * @details
+ * 候補毎に実時間比（合成時間 / 音声の長さ）と、合成中に別スレッドで一定量の計算にかかる時間の増加率（ゲームスレッドへの干渉）を計測し、
+ * 実時間比 × (1 + 干渉率) が最小になるスレッド数を採用します。<br/>
+ * 結果はマシン毎の設定としてGameUserSettings.iniの[Voicevox]セクションに、CPU名とコア数と一緒に保存します。
+ * CPUが変わった場合は保存したスレッド数を使いません。
+ */
+class VOICEVOXUECORE_API FVoicevoxThreadCalibration
+{
+public:
+
+	//! 指定したスレッド数でVOICEVOX COREを初期化し、モデルをロードする関数
+	using FInitializeFunction = TFunctionRef<bool(int32 CPUNumThreads)>;
+
+	//! 参照用AudioQueryを音声合成する関数（WAVフォーマットの音声データを返す）
+	using FSynthesisFunction = TFunctionRef<TArray<uint8>()>;
+
+	/**
+	 * @struct FTrialResult
+	 * @brief スレッド数1候補分の計測結果
+	 */
+	struct FTrialResult
+	{
+		//! 推論スレッド数
+		int32 CPUNumThreads = 0;
+
+		//! 実時間比（合成時間 / 音声の長さ）
+		double RealTimeFactor = 0.0;
+
+		//! 合成中の別スレッドの計算時間の増加率
+		double Interference = 0.0;
+
+		/**
+		 * @brief 評価値を取得する
+		 * @return 実時間比 × (1 + 干渉率)（小さいほど良い）
+		 */
+		double GetScore() const { return RealTimeFactor * (1.0 + Interference); }
+	};
+
+	/**
+	 * @brief 推論スレッド数の候補毎に計測し、最適なスレッド数を求める
+	 * @param[in] InitializeFunction 指定したスレッド数でVOICEVOX COREを初期化し、モデルをロードする関数
+	 * @param[in] SynthesisFunction 参照用AudioQueryを音声合成する関数
+	 * @param[out] OutResultList 候補毎の計測結果
+	 * @return 最適なスレッド数。全ての候補で計測に失敗した場合は0
+	 * @details 候補毎にVOICEVOX COREを初期化し直すため、数秒から数十秒かかります。非同期で処理してください。（UE::Tasks::Launch等）
+	 */
+	static int32 Run(FInitializeFunction InitializeFunction, FSynthesisFunction SynthesisFunction, TArray<FTrialResult>& OutResultList);
+
+	/**
+	 * @brief 推論スレッド数の候補リストを取得する
+	 * @return 1、2、4…と倍にしたスレッド数と、物理コア数、論理コア数の重複を除いたリスト
+	 */
+	static TArray<int32> GetCandidateList();
+
+	/**
+	 * @brief このマシンで保存したスレッド数を読み込む
+	 * @return スレッド数。未計測、もしくは別のマシンで計測した値の場合は0
+	 */
+	static int32 LoadCPUNumThreads();
+
+	/**
+	 * @brief このマシンのスレッド数として保存する
+	 * @param[in] CPUNumThreads スレッド数
+	 */
+	static void SaveCPUNumThreads(int32 CPUNumThreads);
+
+private:
+
+	/**
+	 * @brief マシンの識別文字列を取得する
+	 * @return CPU名と物理コア数、論理コア数を繋げた文字列
+	 */
+	static FString GetMachineId();
+
+	/**
+	 * @brief 一定量の計算を行い、かかった時間を計測する
+	 * @return 計算にかかった時間（秒）
+	 */
+	static double RunProbe();
+
+	/**
+	 * @brief WAVフォーマットの音声データの長さを取得する
+	 * @param[in] OutputWAV WAVフォーマットの音声データ
+	 * @return 音声の長さ（秒）。解析に失敗した場合は0
+	 */
+	static double GetWaveDuration(const TArray<uint8>& OutputWAV);
+};
@@ -0,0 +1,144 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxTraceRecorder.h
+ * @brief  音声合成リクエストを時刻付きで記録し、トレースファイルへ保存するクラスのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoicevoxUEDefined.h"
+#include <atomic>
+
+/**
+ * @class FVoicevoxTraceRecorder
+ * @brief 実際のセッションの音声合成リクエスト（API、話者、AudioQuery、同時実行数、所要時間）を記録するクラス
+ * @details
+ * キャプチャ中はUVoicevoxCoreSubsystemの公開APIの呼び出しを1件ずつ記録し、終了時にJSON Linesのトレースファイルへ保存します。<br/>
+ * API内部から呼び出したAPI（定型文の部分の音声合成等）は記録しないため、トレースを再生すると同じ負荷を再現できます。<br/>
+ * トレースはVoicevoxReplayコマンドレットで再生し、ベースラインとの所要時間、スループットの差を比較します。
+ */
+class VOICEVOXUECORE_API FVoicevoxTraceRecorder
+{
+public:
+
+	/**
+	 * @class FScope
+	 * @brief APIの呼び出し1回分を記録するスコープ（キャプチャ中の最も外側のAPI呼び出しのみ記録する）
+	 */
+	class VOICEVOXUECORE_API FScope
+	{
+	public:
+
+		/**
+		 * @brief コンストラクタ
+		 * @param[in] InRecorder 記録先
+		 * @param[in] Api 呼び出したAPI
+		 */
+		FScope(FVoicevoxTraceRecorder& InRecorder, EVoicevoxTraceApi Api);
+
+		/**
+		 * @brief デストラクタ（所要時間を求めて記録する）
+		 */
+		~FScope();
+
+		/**
+		 * @brief 記録するか
+		 * @return キャプチャ中の最も外側のAPI呼び出しの場合はtrue
+		 */
+		bool IsActive() const { return bIsActive; }
+
+		/**
+		 * @brief 記録する内容を取得する（記録する場合のみ変更する）
+		 * @return トレース1件分
+		 */
+		FVoicevoxTraceEntry& GetEntry() { return Entry; }
+
+		/**
+		 * @brief テキストを使うAPIのリクエスト内容を記録する
+		 * @param[in] SpeakerId 話者番号
+		 * @param[in] Text テキスト
+		 * @param[in] bKana AquesTalkライクな記法か
+		 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にするか
+		 */
+		void SetText(int64 SpeakerId, const FString& Text, bool bKana, bool bEnableInterrogativeUpspeak);
+
+		/**
+		 * @brief AudioQueryを使うAPIのリクエスト内容を記録する
+		 * @param[in] SpeakerId 話者番号
+		 * @param[in] AudioQuery AudioQuery
+		 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にするか
+		 * @param[in] Priority セリフの優先度
+		 */
+		void SetAudioQuery(int64 SpeakerId, const FVoicevoxAudioQuery& AudioQuery, bool bEnableInterrogativeUpspeak, EVoicevoxSynthesisPriority Priority);
+
+		/**
+		 * @brief 結果を記録する
+		 * @param[in] bSucceeded 成功したか
+		 */
+		void SetSucceeded(const bool bSucceeded) { Entry.bSucceeded = bSucceeded; }
+
+	private:
+
+		//! 記録先
+		FVoicevoxTraceRecorder& Recorder;
+
+		//! トレース1件分
+		FVoicevoxTraceEntry Entry;
+
+		//! 呼び出した時刻
+		double StartTime = 0.0;
+
+		//! 記録するか
+		bool bIsActive = false;
+	};
+
+	/**
+	 * @brief キャプチャを開始する
+	 * @param[in] InFilePath トレースファイルの保存先
+	 * @return 開始できたらtrue（既にキャプチャ中の場合はfalse）
+	 */
+	bool Start(const FString& InFilePath);
+
+	/**
+	 * @brief キャプチャを終了し、記録したリクエストをトレースファイルへ保存する
+	 * @return 保存できたらtrue（キャプチャしていない場合はfalse）
+	 */
+	bool Stop();
+
+	/**
+	 * @brief キャプチャ中か
+	 * @return キャプチャ中の場合はtrue
+	 */
+	bool IsCapturing() const { return bIsCapturing.load(); }
+
+	/**
+	 * @brief トレースファイルを読み込む
+	 * @param[in] FilePath トレースファイル
+	 * @param[out] OutEntryList 記録したリクエストのリスト（経過時間の昇順）
+	 * @return 読み込めたらtrue
+	 */
+	static bool Load(const FString& FilePath, TArray<FVoicevoxTraceEntry>& OutEntryList);
+
+private:
+
+	//! キャプチャ中か
+	std::atomic<bool> bIsCapturing = false;
+
+	//! 記録中のAPI呼び出し数
+	std::atomic<int32> InFlightNum = 0;
+
+	//! キャプチャを開始した時刻
+	double CaptureStartTime = 0.0;
+
+	//! トレースファイルの保存先
+	FString FilePath;
+
+	//! 記録したリクエストのリスト
+	TArray<FVoicevoxTraceEntry> EntryList;
+
+	//! 記録の排他制御
+	FCriticalSection CriticalSection;
+};
@@ -31,6 +31,46 @@ enum class ELipSyncVowelType : uint8
 	Non		UMETA(DisplayName = "無音",		ToolTip = "無音（句読点の待機時間）"),
 };
 
+/**
+ * @enum EVoicevoxSynthesisPriority
+ * @brief 音声合成するセリフの優先度を示す列挙体
+ */
+UENUM(BlueprintType)
+enum class EVoicevoxSynthesisPriority : uint8
+{
+	Low		UMETA(DisplayName = "低",	ToolTip = "群衆のセリフ等。負荷が高い場合は最初に品質を下げる"),
+	Normal	UMETA(DisplayName = "通常",	ToolTip = "通常のセリフ。負荷がとても高い場合は品質を下げる"),
+	High	UMETA(DisplayName = "高",	ToolTip = "重要なセリフ。負荷に関わらず品質を下げない"),
+};
+
+/**
+ * @enum EVoicevoxSynthesisThreadPriority
+ * @brief 音声合成中に呼び出し元スレッドへ設定する優先度を示す列挙体
+ */
+UENUM(BlueprintType)
+enum class EVoicevoxSynthesisThreadPriority : uint8
+{
+	Default				UMETA(DisplayName = "変更しない",		ToolTip = "呼び出し元スレッドの優先度を変更しない"),
+	SlightlyBelowNormal	UMETA(DisplayName = "通常より少し低い",	ToolTip = "TPri_SlightlyBelowNormal"),
+	BelowNormal			UMETA(DisplayName = "通常より低い",		ToolTip = "TPri_BelowNormal"),
+	Lowest				UMETA(DisplayName = "最低",				ToolTip = "TPri_Lowest"),
+};
+
+/**
+ * @enum EVoicevoxTraceApi
+ * @brief トレースに記録したリクエストのAPIを示す列挙体
+ */
+UENUM()
+enum class EVoicevoxTraceApi : uint8
+{
+	GetAudioQuery,
+	RunTextToSpeech,
+	RunSynthesis,
+	RunSynthesisWithDeadline,
+	RunSynthesisWithPhraseCache,
+	RunSynthesisWithTemplate,
+};
+
 //------------------------------------------------------------------------
 // struct
 //------------------------------------------------------------------------
@@ -133,6 +173,12 @@ struct FVoicevoxMora
 	//! イントネーション
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Engine")
 	float Pitch;
+
+	//! 子音の音素ID（FVoicevoxPhoneme::InternAudioQueryで設定）
+	uint8 ConsonantId = 0;
+
+	//! 母音の音素ID（FVoicevoxPhoneme::InternAudioQueryで設定）
+	uint8 VowelId = 0;
 };
 
 /**
@@ -237,6 +283,144 @@ struct FVoicevoxLipSync
 	bool IsLabialOrPlosive;
 };
 
+/**
+ * @struct FVoicevoxSynthesisBudget
+ * @brief 音声合成に割り当てるCPU予算の設定をまとめた構造体
+ */
+USTRUCT(BlueprintType)
+struct FVoicevoxSynthesisBudget
+{
+	GENERATED_USTRUCT_BODY()
+
+	//! 同時に実行する音声合成の最大数（0の場合は制限しない）
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Engine", meta=(ClampMin="0"))
+	int32 MaxConcurrentSynthesis = 0;
+
+	//! 音声合成中に呼び出し元スレッドへ設定する優先度（元の優先度より低い場合のみ設定する）
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Engine")
+	EVoicevoxSynthesisThreadPriority ThreadPriority = EVoicevoxSynthesisThreadPriority::Default;
+
+	//! 目標フレームレート（0の場合はフレーム時間による抑制を行わない）
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Engine", meta=(ClampMin="0"))
+	float TargetFrameRate = 0.0f;
+
+	//! 目標フレーム時間に対して確保する余裕の割合（フレーム時間がこの余裕を割り込んでいる間は音声合成の開始を待機する）
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Engine", meta=(ClampMin="0", ClampMax="1"))
+	float MinFrameHeadroom = 0.1f;
+
+	//! フレーム時間による抑制で待機する最大時間（秒）。超えた場合は余裕が無くても音声合成を開始する
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Engine", meta=(ClampMin="0"))
+	float MaxThrottleTime = 1.0f;
+
+	//! ゲームスレッドで1フレームに実行する非同期の音声合成の完了処理（USoundWaveの生成、デリゲートの呼び出し等）の最大数（0の場合は制限しない）
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Engine", meta=(ClampMin="0"))
+	int32 MaxCompletionsPerFrame = 8;
+};
+
+/**
+ * @struct FVoicevoxQualityGovernorSettings
+ * @brief 音声合成の負荷に応じて品質を調整する設定をまとめた構造体
+ */
+USTRUCT(BlueprintType)
+struct FVoicevoxQualityGovernorSettings
+{
+	GENERATED_USTRUCT_BODY()
+
+	//! 負荷に応じた品質の調整を有効にする
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Engine")
+	bool bEnabled = false;
+
+	//! 負荷段階1とする待機中、実行中の音声合成数（段階2は2倍、段階3は4倍）
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Engine", meta=(ClampMin="1"))
+	int32 QueueDepthThreshold = 4;
+
+	//! 負荷段階1とする実時間比（合成時間 / 音声の長さ。段階2は1.5倍、段階3は2倍）
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Engine", meta=(ClampMin="0.01"))
+	float RealTimeFactorThreshold = 0.5f;
+
+	//! 品質を下げたセリフの出力サンプリングレート
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Engine", meta=(ClampMin="8000"))
+	int32 ReducedSamplingRate = 16000;
+
+	//! 品質を下げたセリフの前後の無音、句読点の無音の長さの倍率
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Engine", meta=(ClampMin="0", ClampMax="1"))
+	float PauseScale = 0.5f;
+
+	//! 負荷が下がってから品質を1段階戻すまでの時間（秒）
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Engine", meta=(ClampMin="0"))
+	float RestoreDelay = 2.0f;
+};
+
+/**
+ * @struct FVoicevoxTraceEntry
+ * @brief 音声合成リクエストのトレース1件分の構造体（JSON Linesで保存する）
+ */
+USTRUCT()
+struct FVoicevoxTraceEntry
+{
+	GENERATED_USTRUCT_BODY()
+
+	//! キャプチャ開始からリクエストまでの経過時間（秒）
+	UPROPERTY()
+	double Time = 0.0;
+
+	//! 呼び出したAPI
+	UPROPERTY()
+	EVoicevoxTraceApi Api = EVoicevoxTraceApi::RunSynthesis;
+
+	//! 話者番号
+	UPROPERTY()
+	int64 SpeakerId = 0;
+
+	//! AudioQuery、話者番号、疑問文調整から求めたハッシュ値（16進数、AudioQueryを使わないAPIは空）
+	UPROPERTY()
+	FString AudioQueryHash;
+
+	//! AudioQuery（AudioQueryを使うAPIのみ）
+	UPROPERTY()
+	FVoicevoxAudioQuery AudioQuery;
+
+	//! テキスト、もしくは定型文（テキストを使うAPIのみ）
+	UPROPERTY()
+	FString Text;
+
+	//! 定型文の差し込み部分の名前とテキストのマップ
+	UPROPERTY()
+	TMap<FString, FString> SlotValues;
+
+	//! AquesTalkライクな記法か
+	UPROPERTY()
+	bool bKana = false;
+
+	//! 疑問文の調整を有効にするか
+	UPROPERTY()
+	bool bEnableInterrogativeUpspeak = true;
+
+	//! セリフの優先度
+	UPROPERTY()
+	EVoicevoxSynthesisPriority Priority = EVoicevoxSynthesisPriority::Normal;
+
+	//! リクエストから音声合成を完了させる期限までの時間（秒、0の場合は期限無し）
+	UPROPERTY()
+	double Deadline = 0.0;
+
+	//! 期限に間に合わないと予測した場合、音声合成を開始せずに中止するか
+	UPROPERTY()
+	bool bCancelOnDeadlineMiss = false;
+
+	//! リクエスト時に実行中だったリクエスト数（このリクエストを含む）
+	UPROPERTY()
+	int32 Concurrency = 0;
+
+	//! リクエストから完了までの時間（秒）
+	UPROPERTY()
+	double Latency = 0.0;
+
+	//! 成功したか
+	UPROPERTY()
+	bool bSucceeded = false;
+};
+
 /**
  * @struct FVoicevoxCoreProperty
  * @brief VOICEVOXのプロパティ情報をまとめた構造体
@@ -0,0 +1,136 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxVoiceBank.h
+ * @brief  事前に音声合成した音声データをまとめたボイスバンクファイルの読み書きを行うヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoicevoxUEDefined.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+//------------------------------------------------------------------------
+// struct
+//------------------------------------------------------------------------
+
+/**
+ * @struct FVoicevoxVoiceBankHeader
+ * @brief ボイスバンクファイルのヘッダー構造体
+ */
+struct FVoicevoxVoiceBankHeader
+{
+	//! ファイル識別子
+	uint32 Magic;
+
+	//! ファイルフォーマットのバージョン
+	uint32 Version;
+
+	//! 音声データ数
+	uint32 EntryNum;
+
+	//! 予約領域
+	uint32 Reserved;
+};
+
+/**
+ * @struct FVoicevoxVoiceBankEntry
+ * @brief ボイスバンクファイルの索引構造体（キーの昇順に並ぶ）
+ */
+struct FVoicevoxVoiceBankEntry
+{
+	//! AudioQuery、話者番号、疑問文調整から求めたキー
+	uint64 Key;
+
+	//! ファイル先頭からのWAVデータの位置
+	uint64 Offset;
+
+	//! WAVデータのサイズ
+	uint64 Size;
+};
+
+//------------------------------------------------------------------------
+// class
+//------------------------------------------------------------------------
+
+/**
+ * @class FVoicevoxVoiceBank
+ * @brief 事前に音声合成したWAVデータを索引付きでまとめた、メモリマップ可能なボイスバンクファイルを扱うクラス
+ * @details
+ * ファイル構成は ヘッダー / キー昇順の索引 / WAVデータ の順です。<br/>
+ * 読み込み時はファイル全体をメモリマップし、索引の二分探索で音声データを検索するため、
+ * 検索した音声データのページ読込のみで再生でき、VOICEVOX COREの推論やモデルのロードは発生しません。
+ */
+class VOICEVOXUECORE_API FVoicevoxVoiceBank
+{
+public:
+
+	//! ファイル識別子（VVBK）
+	static constexpr uint32 FileMagic = 0x4B425656;
+
+	//! ファイルフォーマットのバージョン
+	static constexpr uint32 FileVersion = 1;
+
+	/**
+	 * @brief デストラクタ
+	 */
+	~FVoicevoxVoiceBank();
+
+	/**
+	 * @brief ボイスバンクの検索キーを求める
+	 * @param[in] AudioQuery AudioQuery構造体
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] bEnableInterrogativeUpspeak 疑問文の調整を有効にするか
+	 * @return 検索キー
+	 */
+	static uint64 GetKey(const FVoicevoxAudioQuery& AudioQuery, int64 SpeakerId, bool bEnableInterrogativeUpspeak);
+
+	/**
+	 * @brief ボイスバンクファイルを書き込む
+	 * @param[in] FilePath 書き込むファイルパス
+	 * @param[in] WavMap 検索キーとWAVデータのマップ
+	 * @return 書き込みに成功したらtrue
+	 */
+	static bool Write(const FString& FilePath, const TMap<uint64, TArray<uint8>>& WavMap);
+
+	/**
+	 * @brief ボイスバンクファイルをメモリマップで開く
+	 * @param[in] FilePath ボイスバンクファイルパス
+	 * @return 開くことに成功したらtrue
+	 */
+	bool Open(const FString& FilePath);
+
+	/**
+	 * @brief ボイスバンクファイルを閉じる
+	 */
+	void Close();
+
+	/**
+	 * @brief ボイスバンクファイルを開いているか
+	 * @return 開いていたらtrue
+	 */
+	bool IsOpen() const;
+
+	/**
+	 * @brief 検索キーに一致するWAVデータを取得する
+	 * @param[in] Key 検索キー
+	 * @param[out] OutputWAV WAVデータ
+	 * @return 一致するWAVデータがあればtrue
+	 */
+	bool Find(uint64 Key, TArray<uint8>& OutputWAV) const;
+
+private:
+
+	//! メモリマップしたファイルハンドル
+	TUniquePtr<IMappedFileHandle> MappedFileHandle;
+
+	//! メモリマップした領域
+	TUniquePtr<IMappedFileRegion> MappedFileRegion;
+
+	//! メモリマップした領域上の索引
+	TArrayView<const FVoicevoxVoiceBankEntry> EntryList;
+};
@@ -0,0 +1,286 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxWorkerPool.h
+ * @brief  VOICEVOX COREを別プロセスで実行するワーカープールのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+class UVoicevoxCoreSubsystem;
+class FRunnableThread;
+
+//------------------------------------------------------------------------
+// enum
+//------------------------------------------------------------------------
+
+/**
+ * @enum EVoicevoxWorkerState
+ * @brief ワーカープロセスとの共有メモリ上のメールボックス状態
+ */
+enum class EVoicevoxWorkerState : uint32
+{
+	//! ワーカープロセスの起動中（VOICEVOX COREの初期化中）
+	Starting,
+	//! リクエスト待ち
+	Idle,
+	//! ホストがリクエストを書き込み済み
+	Request,
+	//! ワーカープロセスが処理中
+	Processing,
+	//! ワーカープロセスがレスポンスを書き込み済み
+	Done,
+	//! ワーカープロセスでの処理失敗
+	Error,
+};
+
+/**
+ * @enum EVoicevoxWorkerCommand
+ * @brief ワーカープロセスへのリクエスト種別
+ */
+enum class EVoicevoxWorkerCommand : uint32
+{
+	//! AudioQuery取得（リクエストはUTF-8テキスト、レスポンスはUTF-8のAudioQuery JSON）
+	AudioQuery,
+	//! text to speech（リクエストはUTF-8テキスト、レスポンスはWAV）
+	TextToSpeech,
+	//! 音声合成（リクエストはUTF-8のAudioQuery JSON、レスポンスはWAV）
+	Synthesis,
+	//! ワーカープロセスの終了
+	Shutdown,
+};
+
+//------------------------------------------------------------------------
+// struct
+//------------------------------------------------------------------------
+
+/**
+ * @struct FVoicevoxWorkerMailbox
+ * @brief ホストとワーカープロセス間の共有メモリ先頭に配置するメールボックス構造体
+ * @details 直後にリクエスト、もしくはレスポンスのデータ本体が続きます。
+ */
+struct FVoicevoxWorkerMailbox
+{
+	//! メールボックス状態（EVoicevoxWorkerState）
+	std::atomic<uint32> State;
+
+	//! リクエスト種別（EVoicevoxWorkerCommand）
+	uint32 Command;
+
+	//! 話者番号
+	int64 SpeakerId;
+
+	//! リクエストのフラグ（EVoicevoxWorkerFlag）
+	uint32 Flags;
+
+	//! 共有メモリ上のデータ本体のサイズ
+	uint32 DataSize;
+};
+
+/**
+ * @brief リクエストのフラグ
+ */
+namespace EVoicevoxWorkerFlag
+{
+	//! aquestalk形式のkanaとしてテキストを解釈する
+	constexpr uint32 Kana = 1 << 0;
+	//! 疑問文の調整を有効にする
+	constexpr uint32 InterrogativeUpspeak = 1 << 1;
+}
+
+//------------------------------------------------------------------------
+// class
+//------------------------------------------------------------------------
+
+/**
+ * @class FVoicevoxWorkerPool
+ * @brief VOICEVOX COREを読み込んだワーカープロセスを複数起動し、リクエストを振り分けるクラス（ホスト側）
+ * @details
+ * VOICEVOX COREはライブラリ毎にプロセス内で1つのインスタンスしか持てないため、同一プロセスから並行して呼び出しても推論は直列化されます。<br/>
+ * ワーカープロセスは自身の実行ファイルを「-VoicevoxWorker」引数付きのヘッドレスなゲームとして起動し、
+ * ワーカー毎に名前付き共有メモリを割り当て、リクエストとPCMデータを共有メモリ経由で受け渡します。<br/>
+ * ワーカープロセスがクラッシュした場合は処理中のリクエストを失敗として返し、ワーカープロセスを再起動します。
+ */
+class VOICEVOXUECORE_API FVoicevoxWorkerPool
+{
+public:
+
+	//! ワーカー毎の共有メモリのサイズ（メールボックスを含む）
+	static constexpr uint32 SharedMemorySize = 16 * 1024 * 1024;
+
+	//! ワーカープロセスの起動（VOICEVOX COREの初期化）を待つ時間（秒）
+	static constexpr double StartupTimeout = 120.0;
+
+	//! 1リクエストの処理を待つ時間（秒）
+	static constexpr double RequestTimeout = 60.0;
+
+	/**
+	 * @brief デストラクタ
+	 */
+	~FVoicevoxWorkerPool();
+
+	/**
+	 * @brief ワーカープロセスを起動する
+	 * @param[in] WorkerNum 起動するワーカープロセス数
+	 * @param[in] bUseGPU trueならGPU用、falseならCPU用の初期化を行う
+	 * @param[in] CPUNumThreads ワーカープロセス毎の推論に用いるスレッド数
+	 * @return 起動に成功したらtrue
+	 */
+	bool Start(int32 WorkerNum, bool bUseGPU, int32 CPUNumThreads);
+
+	/**
+	 * @brief 処理中のリクエストの完了を待ち、全てのワーカープロセスを終了する
+	 */
+	void Stop();
+
+	/**
+	 * @brief ワーカープロセスが起動しているか
+	 * @return 起動していたらtrue
+	 */
+	bool IsRunning() const;
+
+	/**
+	 * @brief 空いているワーカープロセスにリクエストを送り、レスポンスを待つ
+	 * @param[in] Command リクエスト種別
+	 * @param[in] SpeakerId 話者番号
+	 * @param[in] Flags リクエストのフラグ（EVoicevoxWorkerFlag）
+	 * @param[in] RequestData リクエストのデータ本体
+	 * @param[out] OutResponseData レスポンスのデータ本体
+	 * @return 処理に成功したらtrue
+	 * @details ワーカープロセスが全て処理中の場合は空くまで待機します。
+	 */
+	bool Request(EVoicevoxWorkerCommand Command, int64 SpeakerId, uint32 Flags, TArrayView<const uint8> RequestData, TArray<uint8>& OutResponseData);
+
+private:
+
+	/**
+	 * @struct FWorkerSlot
+	 * @brief ワーカープロセス1つ分の管理情報
+	 */
+	struct FWorkerSlot
+	{
+		//! ワーカープロセスのハンドル
+		FProcHandle ProcHandle;
+
+		//! 共有メモリ
+		FPlatformMemory::FSharedMemoryRegion* SharedMemoryRegion = nullptr;
+
+		//! 共有メモリ名
+		FString SharedMemoryName;
+
+		//! リクエスト処理中か
+		bool bIsBusy = false;
+	};
+
+	/**
+	 * @brief ワーカープロセスを起動する（起動済みの場合は終了してから起動しなおす）
+	 * @param[in] Slot ワーカープロセスの管理情報
+	 * @return 起動に成功したらtrue
+	 */
+	bool SpawnWorker(FWorkerSlot& Slot) const;
+
+	/**
+	 * @brief ワーカープロセスを終了し、共有メモリを解放する
+	 * @param[in] Slot ワーカープロセスの管理情報
+	 * @param[in] bGraceful trueならShutdownリクエストを送って終了を待つ
+	 */
+	static void DestroyWorker(FWorkerSlot& Slot, bool bGraceful);
+
+	/**
+	 * @brief メールボックスが指定の状態以外になるまで待つ
+	 * @param[in] Slot ワーカープロセスの管理情報
+	 * @param[in] WaitState 待機する状態
+	 * @param[in] Timeout 待つ時間（秒）
+	 * @return 待機後の状態。ワーカープロセスが終了、もしくはタイムアウトした場合はError
+	 */
+	static EVoicevoxWorkerState WaitWhile(FWorkerSlot& Slot, EVoicevoxWorkerState WaitState, double Timeout);
+
+	//! ワーカープロセスの管理情報リスト
+	TArray<TUniquePtr<FWorkerSlot>> SlotList;
+
+	//! 管理情報リストの排他制御
+	mutable FCriticalSection SlotCriticalSection;
+
+	//! GPUモードで初期化するか
+	bool bUseGPU = false;
+
+	//! ワーカープロセス毎の推論に用いるスレッド数
+	int32 CPUNumThreads = 0;
+
+	//! 起動しているか
+	std::atomic<bool> bIsRunning = false;
+
+	//! 処理中のリクエスト数
+	std::atomic<int32> ActiveRequestNum = 0;
+};
+
+/**
+ * @class FVoicevoxWorker
+ * @brief ワーカープロセス内で共有メモリのリクエストを受け付け、VOICEVOX COREを実行するクラス（ワーカー側）
+ * @details 「-VoicevoxWorker」引数付きで起動されたプロセスでのみ生成されます。
+ */
+class VOICEVOXUECORE_API FVoicevoxWorker : public FRunnable
+{
+public:
+
+	/**
+	 * @brief ワーカープロセスとして起動されたか
+	 * @return コマンドライン引数に「-VoicevoxWorker」があればtrue
+	 */
+	static bool IsWorkerProcess();
+
+	/**
+	 * @brief コンストラクタ
+	 * @param[in] InSubsystem VOICEVOX COREを実行するSubsystem
+	 */
+	explicit FVoicevoxWorker(UVoicevoxCoreSubsystem* InSubsystem);
+
+	/**
+	 * @brief デストラクタ
+	 */
+	virtual ~FVoicevoxWorker() override;
+
+	//--------------------------------
+	// FRunnable override
+	//--------------------------------
+
+	/**
+	 * @brief Run
+	 */
+	virtual uint32 Run() override;
+
+	/**
+	 * @brief Stop
+	 */
+	virtual void Stop() override;
+
+private:
+
+	/**
+	 * @brief リクエストを処理する
+	 * @param[in] Mailbox 共有メモリ上のメールボックス
+	 * @param[in] DataCapacity 共有メモリ上のデータ本体の最大サイズ
+	 * @return 処理に成功したらtrue
+	 */
+	bool ProcessRequest(FVoicevoxWorkerMailbox& Mailbox, uint32 DataCapacity);
+
+	//! VOICEVOX COREを実行するSubsystem
+	UVoicevoxCoreSubsystem* Subsystem;
+
+	//! ロード済みの話者番号
+	TSet<int64> LoadedSpeakerSet;
+
+	//! リクエスト受付スレッド
+	FRunnableThread* Thread = nullptr;
+
+	//! 停止要求フラグ
+	std::atomic<bool> bStopRequested = false;
+};
+
+VOICEVOXUECORE_API DECLARE_LOG_CATEGORY_EXTERN(LogVoicevoxWorker, Log, All);
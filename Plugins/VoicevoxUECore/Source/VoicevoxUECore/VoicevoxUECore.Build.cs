@@ -25,7 +25,9 @@ public class VoicevoxUECore : ModuleRules
 				"Slate",
 				"SlateCore",
 				"Json",
-				"JsonUtilities"
+				"JsonUtilities",
+				"Sockets",
+				"Networking"
 			}
 		);
 	}
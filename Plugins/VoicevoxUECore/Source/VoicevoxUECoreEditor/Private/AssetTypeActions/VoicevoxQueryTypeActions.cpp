@@ -7,7 +7,11 @@
  */
 
 #include "AssetTypeActions/VoicevoxQueryTypeActions.h"
+#include "ToolMenuSection.h"
 #include "VoicevoxQuery.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/CurveTable.h"
+#include "Subsystems/VoicevoxCoreSubsystem.h"
 
 /**
  * @brief コンストラクタ
@@ -69,4 +73,65 @@ void FVoicevoxQueryTypeActions::OpenAssetEditor(const TArray<UObject*>& InObject
 	{
 		FSimpleAssetEditor::CreateEditor(EToolkitMode::Standalone, EditWithinLevelEditor, InObjects[i]);
 	}
-};
\ No newline at end of file
+};
+
+/**
+ * @brief HasActions 
+ */	
+bool FVoicevoxQueryTypeActions::HasActions(const TArray<UObject*>& InObjects) const
+{
+	return true;
+}
+
+/**
+ * @brief GetActions 
+ */	
+void FVoicevoxQueryTypeActions::GetActions(const TArray<UObject*>& InObjects, FToolMenuSection& Section)
+{
+	TArray<TWeakObjectPtr<UVoicevoxQuery>> Queries = GetTypedWeakObjectPtrs<UVoicevoxQuery>(InObjects);
+	Section.AddMenuEntry(
+		TEXT("VoicevoxQuery_BakeLipSyncCurves"),
+		FText::FromString(TEXT("Bake Lip Sync Curves")),
+		FText::FromString(TEXT("リップシンクのモーフターゲット値をカーブテーブルアセット（<アセット名>_LipSync）へベイクします")),
+		FSlateIcon(),
+		FUIAction(FExecuteAction::CreateStatic(&FVoicevoxQueryTypeActions::BakeLipSyncCurves, Queries)));
+}
+
+/**
+ * @brief AudioQueryアセットのリップシンクをカーブテーブルアセットへベイクする
+ */
+void FVoicevoxQueryTypeActions::BakeLipSyncCurves(TArray<TWeakObjectPtr<UVoicevoxQuery>> Queries)
+{
+	for (const TWeakObjectPtr<UVoicevoxQuery>& WeakQuery : Queries)
+	{
+		UVoicevoxQuery* Query = WeakQuery.Get();
+		if (Query == nullptr) continue;
+
+		// 既存のカーブテーブルは上書きする
+		UCurveTable* CurveTable = Query->LipSyncCurveTable;
+		if (CurveTable == nullptr)
+		{
+			const FString AssetName = Query->GetName() + TEXT("_LipSync");
+			const FString PackageName = FPaths::Combine(FPackageName::GetLongPackagePath(Query->GetPackage()->GetName()), AssetName);
+			UPackage* Package = CreatePackage(*PackageName);
+			Package->FullyLoad();
+			CurveTable = FindObject<UCurveTable>(Package, *AssetName);
+			if (CurveTable == nullptr)
+			{
+				CurveTable = NewObject<UCurveTable>(Package, *AssetName, RF_Public | RF_Standalone | RF_Transactional);
+				FAssetRegistryModule::AssetCreated(CurveTable);
+			}
+		}
+
+		CurveTable->Modify();
+		UVoicevoxCoreSubsystem::BakeLipSyncCurveTable(Query->VoicevoxAudioQuery, CurveTable);
+		CurveTable->OnCurveTableChanged().Broadcast();
+		CurveTable->MarkPackageDirty();
+
+		Query->Modify();
+		Query->LipSyncCurveTable = CurveTable;
+		Query->LipSyncCurveTableKey = Query->GetLipSyncCurveTableKey();
+		Query->UpdateLipSyncCurveTableValidity();
+		Query->MarkPackageDirty();
+	}
+}
\ No newline at end of file
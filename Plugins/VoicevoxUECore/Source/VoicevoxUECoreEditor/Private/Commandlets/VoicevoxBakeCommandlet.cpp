@@ -0,0 +1,337 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  CSV、もしくはDataTableからAudioQueryアセットとSoundWaveアセットを一括生成するコマンドレットのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "Commandlets/VoicevoxBakeCommandlet.h"
+
+#include "FileHelpers.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Factories/VoicevoxQueryFactory.h"
+#include "Factories/VoicevoxSoundWaveFactory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Sound/SoundWave.h"
+#include "Subsystems/VoicevoxCoreSubsystem.h"
+#include "Tasks/Task.h"
+#include <atomic>
+
+DEFINE_LOG_CATEGORY(LogVoicevoxBake);
+
+/**
+ * @brief コンストラクタ
+ */
+UVoicevoxBakeCommandlet::UVoicevoxBakeCommandlet(): Super()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+/**
+ * @brief Main override
+ */
+int32 UVoicevoxBakeCommandlet::Main(const FString& Params)
+{
+	FString CsvPath;
+	FString DataTablePath;
+	FString OutPath = TEXT("/Game/Voicevox/Bake");
+	int32 WorkerNum = 2;
+	int32 BatchSize = 64;
+	int32 CPUThreads = 0;
+	FParse::Value(*Params, TEXT("Csv="), CsvPath);
+	FParse::Value(*Params, TEXT("DataTable="), DataTablePath);
+	FParse::Value(*Params, TEXT("OutPath="), OutPath);
+	FParse::Value(*Params, TEXT("Workers="), WorkerNum);
+	FParse::Value(*Params, TEXT("BatchSize="), BatchSize);
+	FParse::Value(*Params, TEXT("CPUThreads="), CPUThreads);
+	const bool bUseGPU = FParse::Param(*Params, TEXT("GPU"));
+	const bool bIsCreateAudioQuery = !FParse::Param(*Params, TEXT("NoAudioQuery"));
+	const bool bIsCreateSoundWave = !FParse::Param(*Params, TEXT("NoSoundWave"));
+	const bool bIsForce = FParse::Param(*Params, TEXT("Force"));
+	WorkerNum = FMath::Max(WorkerNum, 1);
+	BatchSize = FMath::Max(BatchSize, 1);
+
+	// 行データの読込
+	const UDataTable* DataTable = nullptr;
+	if (!DataTablePath.IsEmpty())
+	{
+		DataTable = LoadObject<UDataTable>(nullptr, *DataTablePath);
+	}
+	else if (!CsvPath.IsEmpty())
+	{
+		FString CsvString;
+		if (!FFileHelper::LoadFileToString(CsvString, *CsvPath))
+		{
+			UE_LOG(LogVoicevoxBake, Error, TEXT("Can't Load CSV File: %s"), *CsvPath);
+			return 1;
+		}
+
+		UDataTable* CsvDataTable = NewObject<UDataTable>(GetTransientPackage());
+		CsvDataTable->RowStruct = FVoicevoxBakeRow::StaticStruct();
+		for (const FString& Problem : CsvDataTable->CreateTableFromCSVString(CsvString))
+		{
+			UE_LOG(LogVoicevoxBake, Warning, TEXT("CSV: %s"), *Problem);
+		}
+		DataTable = CsvDataTable;
+	}
+
+	if (DataTable == nullptr || DataTable->GetRowStruct() != FVoicevoxBakeRow::StaticStruct())
+	{
+		UE_LOG(LogVoicevoxBake, Error, TEXT("Usage: -run=VoicevoxBake -Csv=<Path> | -DataTable=<ObjectPath> (RowStruct: VoicevoxBakeRow)"));
+		return 1;
+	}
+
+	// VOICEVOX COREの初期化
+	UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+	if (!Subsystem->Initialize(bUseGPU, CPUThreads, false))
+	{
+		UE_LOG(LogVoicevoxBake, Error, TEXT("VOICEVOX CORE Initialize Error"));
+		return 1;
+	}
+
+	// 前回から入力内容の変更が無い行はスキップする
+	const FString ManifestPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Voicevox"), TEXT("BakeManifest.txt"));
+	TMap<FString, uint32> Manifest = LoadManifest(ManifestPath);
+	TArray<FVoicevoxBakeJob> AllJobList;
+	TSet<int64> SpeakerIdSet;
+	DataTable->ForeachRow<FVoicevoxBakeRow>(TEXT("VoicevoxBake"), [&](const FName& Key, const FVoicevoxBakeRow& Row)
+	{
+		const FString PackageName = FPaths::Combine(OutPath, Key.ToString());
+		const uint32 Hash = GetRowHash(Row);
+		if (!bIsForce)
+		{
+			const bool bIsExistAudioQuery = !bIsCreateAudioQuery || FPackageName::DoesPackageExist(PackageName + TEXT("_AudioQuery"));
+			const bool bIsExistSoundWave = !bIsCreateSoundWave || FPackageName::DoesPackageExist(PackageName);
+			if (const uint32* ManifestHash = Manifest.Find(PackageName); ManifestHash != nullptr && *ManifestHash == Hash && bIsExistAudioQuery && bIsExistSoundWave)
+			{
+				return;
+			}
+		}
+
+		FVoicevoxBakeJob& Job = AllJobList.AddDefaulted_GetRef();
+		Job.RowName = Key;
+		Job.Row = Row;
+		Job.Hash = Hash;
+		SpeakerIdSet.Add(Row.SpeakerId);
+	});
+
+	UE_LOG(LogVoicevoxBake, Display, TEXT("Bake %d / %d Rows (Workers: %d)"), AllJobList.Num(), DataTable->GetRowMap().Num(), WorkerNum);
+	if (AllJobList.IsEmpty())
+	{
+		return 0;
+	}
+
+	for (const int64 SpeakerId : SpeakerIdSet)
+	{
+		Subsystem->LoadModel(SpeakerId);
+	}
+
+	UVoicevoxQueryFactory* QueryFactory = NewObject<UVoicevoxQueryFactory>();
+	UVoicevoxSoundWaveFactory* SoundWaveFactory = NewObject<UVoicevoxSoundWaveFactory>();
+	QueryFactory->AddToRoot();
+	SoundWaveFactory->AddToRoot();
+
+	// 音声合成はワーカーで並列に行い、アセット生成と保存はゲームスレッドでバッチ単位に行う
+	int32 FailedNum = 0;
+	for (int32 BatchStart = 0; BatchStart < AllJobList.Num(); BatchStart += BatchSize)
+	{
+		TArray<FVoicevoxBakeJob> JobList(AllJobList.GetData() + BatchStart, FMath::Min(BatchSize, AllJobList.Num() - BatchStart));
+		RunJobs(JobList, WorkerNum, bIsCreateSoundWave);
+
+		TArray<UPackage*> PackageList;
+		for (const FVoicevoxBakeJob& Job : JobList)
+		{
+			if (!Job.bIsSucceeded)
+			{
+				UE_LOG(LogVoicevoxBake, Error, TEXT("Synthesis Error: %s"), *Job.RowName.ToString());
+				++FailedNum;
+				continue;
+			}
+
+			const FString PackageName = FPaths::Combine(OutPath, Job.RowName.ToString());
+			bool bIsCreated = true;
+			if (bIsCreateAudioQuery)
+			{
+				QueryFactory->EditAudioQuery = NewObject<UVoicevoxQuery>();
+				QueryFactory->EditAudioQuery->VoicevoxAudioQuery = Job.AudioQuery;
+				QueryFactory->EditAudioQuery->SpeakerType = Job.Row.SpeakerId;
+				QueryFactory->EditAudioQuery->Text = Job.Row.Text;
+				QueryFactory->EditAudioQuery->YomikataText = Job.AudioQuery.Kana;
+				if (UPackage* Package = CreateAsset(QueryFactory, PackageName + TEXT("_AudioQuery")))
+				{
+					PackageList.Add(Package);
+				}
+				else
+				{
+					bIsCreated = false;
+				}
+			}
+
+			if (bIsCreateSoundWave)
+			{
+				SoundWaveFactory->OutputWAV = Job.OutputWAV;
+				if (UPackage* Package = CreateAsset(SoundWaveFactory, PackageName))
+				{
+					PackageList.Add(Package);
+				}
+				else
+				{
+					bIsCreated = false;
+				}
+			}
+
+			if (bIsCreated)
+			{
+				Manifest.Add(PackageName, Job.Hash);
+			}
+			else
+			{
+				++FailedNum;
+			}
+		}
+
+		if (!PackageList.IsEmpty() && !UEditorLoadingAndSavingUtils::SavePackages(PackageList, false))
+		{
+			UE_LOG(LogVoicevoxBake, Error, TEXT("Save Packages Error"));
+		}
+
+		// 途中で中断しても再開できるよう、バッチ毎にマニフェストを保存する
+		SaveManifest(ManifestPath, Manifest);
+		UE_LOG(LogVoicevoxBake, Display, TEXT("Baked %d / %d"), BatchStart + JobList.Num(), AllJobList.Num());
+
+		SoundWaveFactory->OutputWAV.Empty();
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	QueryFactory->RemoveFromRoot();
+	SoundWaveFactory->RemoveFromRoot();
+
+	if (FailedNum > 0)
+	{
+		UE_LOG(LogVoicevoxBake, Error, TEXT("Bake Failed: %d Rows"), FailedNum);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief 行データから入力内容のハッシュ値を求める
+ */
+uint32 UVoicevoxBakeCommandlet::GetRowHash(const FVoicevoxBakeRow& Row)
+{
+	uint32 Hash = GetTypeHash(Row.SpeakerId);
+	Hash = HashCombine(Hash, GetTypeHash(Row.Text));
+	Hash = HashCombine(Hash, GetTypeHash(Row.bRunKana));
+	Hash = HashCombine(Hash, GetTypeHash(Row.bEnableInterrogativeUpspeak));
+	Hash = HashCombine(Hash, GetTypeHash(Row.SpeedScale));
+	Hash = HashCombine(Hash, GetTypeHash(Row.PitchScale));
+	Hash = HashCombine(Hash, GetTypeHash(Row.IntonationScale));
+	Hash = HashCombine(Hash, GetTypeHash(Row.VolumeScale));
+	Hash = HashCombine(Hash, GetTypeHash(Row.PrePhonemeLength));
+	Hash = HashCombine(Hash, GetTypeHash(Row.PostPhonemeLength));
+	return Hash;
+}
+
+/**
+ * @brief マニフェストファイルを読み込む
+ */
+TMap<FString, uint32> UVoicevoxBakeCommandlet::LoadManifest(const FString& FilePath)
+{
+	TMap<FString, uint32> Manifest;
+	TArray<FString> Lines;
+	if (FFileHelper::LoadFileToStringArray(Lines, *FilePath))
+	{
+		for (const FString& Line : Lines)
+		{
+			if (FString PackageName, Hash; Line.Split(TEXT("\t"), &PackageName, &Hash))
+			{
+				Manifest.Add(PackageName, FCString::Strtoui64(*Hash, nullptr, 10));
+			}
+		}
+	}
+	return Manifest;
+}
+
+/**
+ * @brief マニフェストファイルを保存する
+ */
+void UVoicevoxBakeCommandlet::SaveManifest(const FString& FilePath, const TMap<FString, uint32>& Manifest)
+{
+	TArray<FString> Lines;
+	Lines.Reserve(Manifest.Num());
+	for (const TPair<FString, uint32>& Pair : Manifest)
+	{
+		Lines.Add(FString::Printf(TEXT("%s\t%u"), *Pair.Key, Pair.Value));
+	}
+
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *FilePath))
+	{
+		UE_LOG(LogVoicevoxBake, Error, TEXT("Can't Save Manifest File: %s"), *FilePath);
+	}
+}
+
+/**
+ * @brief ワーカー数分のタスクでジョブを並列に音声合成する
+ */
+void UVoicevoxBakeCommandlet::RunJobs(TArray<FVoicevoxBakeJob>& JobList, const int32 WorkerNum, const bool bIsSynthesis)
+{
+	const UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+	std::atomic<int32> NextIndex = 0;
+	TArray<UE::Tasks::FTask> WorkerList;
+	WorkerList.Reserve(WorkerNum);
+	for (int32 Worker = 0; Worker < WorkerNum; ++Worker)
+	{
+		WorkerList.Add(UE::Tasks::Launch(TEXT("VoicevoxBakeWorker"), [&JobList, &NextIndex, Subsystem, bIsSynthesis]
+		{
+			for (int32 Index = NextIndex++; Index < JobList.Num(); Index = NextIndex++)
+			{
+				FVoicevoxBakeJob& Job = JobList[Index];
+				const FVoicevoxBakeRow& Row = Job.Row;
+				Job.AudioQuery = Subsystem->GetAudioQuery(Row.SpeakerId, Row.Text, Row.bRunKana);
+				if (Job.AudioQuery.Accent_phrases.IsEmpty()) continue;
+
+				Job.AudioQuery.Speed_scale = Row.SpeedScale;
+				Job.AudioQuery.Pitch_scale = Row.PitchScale;
+				Job.AudioQuery.Intonation_scale = Row.IntonationScale;
+				Job.AudioQuery.Volume_scale = Row.VolumeScale;
+				Job.AudioQuery.Pre_phoneme_length = Row.PrePhonemeLength;
+				Job.AudioQuery.Post_phoneme_length = Row.PostPhonemeLength;
+				if (bIsSynthesis)
+				{
+					Job.OutputWAV = Subsystem->RunSynthesis(Job.AudioQuery, Row.SpeakerId, Row.bEnableInterrogativeUpspeak);
+					Job.bIsSucceeded = !Job.OutputWAV.IsEmpty();
+				}
+				else
+				{
+					Job.bIsSucceeded = true;
+				}
+			}
+		}));
+	}
+	UE::Tasks::Wait(WorkerList);
+}
+
+/**
+ * @brief ファクトリーでアセットを生成、もしくは上書きする
+ */
+UPackage* UVoicevoxBakeCommandlet::CreateAsset(UFactory* Factory, const FString& PackageName)
+{
+	UPackage* Package = CreatePackage(*PackageName);
+	Package->FullyLoad();
+
+	const FName AssetName = FName(FPackageName::GetShortName(PackageName));
+	UObject* Asset = Factory->FactoryCreateNew(Factory->GetSupportedClass(), Package, AssetName, RF_Public | RF_Standalone | RF_Transactional, nullptr, GWarn);
+	if (Asset == nullptr)
+	{
+		UE_LOG(LogVoicevoxBake, Error, TEXT("Create Asset Error: %s"), *PackageName);
+		return nullptr;
+	}
+
+	FAssetRegistryModule::AssetCreated(Asset);
+	Package->MarkPackageDirty();
+	return Package;
+}
@@ -0,0 +1,336 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  キャプチャした音声合成リクエストのトレースを再生し、ベースラインと所要時間、スループットを比較するコマンドレットのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "Commandlets/VoicevoxReplayCommandlet.h"
+
+#include "JsonObjectConverter.h"
+#include "Misc/FileHelper.h"
+#include "Subsystems/VoicevoxCoreSubsystem.h"
+#include "Tasks/Task.h"
+#include "VoicevoxTraceRecorder.h"
+#include <atomic>
+
+DEFINE_LOG_CATEGORY(LogVoicevoxReplay);
+
+namespace
+{
+	/**
+	 * @brief 昇順に並べた所要時間リストからパーセンタイルを求める
+	 */
+	double GetPercentile(const TArray<double>& SortedLatencyList, const double Percentile)
+	{
+		if (SortedLatencyList.IsEmpty()) return 0.0;
+
+		const int32 Index = FMath::CeilToInt(SortedLatencyList.Num() * Percentile) - 1;
+		return SortedLatencyList[FMath::Clamp(Index, 0, SortedLatencyList.Num() - 1)];
+	}
+
+	/**
+	 * @brief 所要時間リストから集計結果を求める
+	 */
+	void FinishStats(FVoicevoxReplayStats& Stats, TArray<double>& LatencyList, const double Duration)
+	{
+		LatencyList.Sort();
+		double Sum = 0.0;
+		for (const double Latency : LatencyList)
+		{
+			Sum += Latency;
+		}
+		Stats.MeanLatency = LatencyList.IsEmpty() ? 0.0 : Sum / LatencyList.Num();
+		Stats.P50Latency = GetPercentile(LatencyList, 0.5);
+		Stats.P95Latency = GetPercentile(LatencyList, 0.95);
+		Stats.MaxLatency = LatencyList.IsEmpty() ? 0.0 : LatencyList.Last();
+		Stats.Throughput = Duration > 0.0 ? LatencyList.Num() / Duration : 0.0;
+	}
+
+	/**
+	 * @brief ベースラインからの変化の割合を求める
+	 */
+	double GetDeltaPercent(const double Baseline, const double Current)
+	{
+		return Baseline > 0.0 ? (Current - Baseline) / Baseline * 100.0 : 0.0;
+	}
+}
+
+/**
+ * @brief コンストラクタ
+ */
+UVoicevoxReplayCommandlet::UVoicevoxReplayCommandlet(): Super()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+/**
+ * @brief Main override
+ */
+int32 UVoicevoxReplayCommandlet::Main(const FString& Params)
+{
+	FString TracePath;
+	FString BaselinePath;
+	FString SaveBaselinePath;
+	float Speed = 1.0f;
+	float Threshold = 10.0f;
+	int32 WorkerNum = 0;
+	int32 CPUThreads = 0;
+	FParse::Value(*Params, TEXT("Trace="), TracePath);
+	FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+	FParse::Value(*Params, TEXT("SaveBaseline="), SaveBaselinePath);
+	FParse::Value(*Params, TEXT("Speed="), Speed);
+	FParse::Value(*Params, TEXT("Threshold="), Threshold);
+	FParse::Value(*Params, TEXT("Workers="), WorkerNum);
+	FParse::Value(*Params, TEXT("CPUThreads="), CPUThreads);
+	const bool bUseGPU = FParse::Param(*Params, TEXT("GPU"));
+	Speed = FMath::Max(Speed, 0.0f);
+
+	// トレースの読込
+	TArray<FVoicevoxTraceEntry> TraceEntryList;
+	if (TracePath.IsEmpty() || !FVoicevoxTraceRecorder::Load(TracePath, TraceEntryList))
+	{
+		UE_LOG(LogVoicevoxReplay, Error, TEXT("Can't Load Trace File: %s"), *TracePath);
+		return 1;
+	}
+	if (TraceEntryList.IsEmpty())
+	{
+		UE_LOG(LogVoicevoxReplay, Warning, TEXT("Trace Has No Requests: %s"), *TracePath);
+		return 0;
+	}
+
+	// ベースラインの読込（指定が無い場合はトレースに記録した所要時間を使う）
+	FVoicevoxReplayReport Baseline;
+	if (!BaselinePath.IsEmpty())
+	{
+		FString BaselineJson;
+		if (!FFileHelper::LoadFileToString(BaselineJson, *BaselinePath) || !FJsonObjectConverter::JsonObjectStringToUStruct(BaselineJson, &Baseline, 0, 0))
+		{
+			UE_LOG(LogVoicevoxReplay, Error, TEXT("Can't Load Baseline File: %s"), *BaselinePath);
+			return 1;
+		}
+	}
+	else
+	{
+		double TraceEndTime = 0.0;
+		for (const FVoicevoxTraceEntry& Entry : TraceEntryList)
+		{
+			TraceEndTime = FMath::Max(TraceEndTime, Entry.Time + Entry.Latency);
+		}
+		Baseline = MakeReport(TraceEntryList, TraceEndTime - TraceEntryList[0].Time, 1.0f);
+	}
+
+	// VOICEVOX COREの初期化
+	UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+	if (!Subsystem->Initialize(bUseGPU, CPUThreads, false))
+	{
+		UE_LOG(LogVoicevoxReplay, Error, TEXT("VOICEVOX CORE Initialize Error"));
+		return 1;
+	}
+
+	if (WorkerNum > 0 && !Subsystem->StartWorkerPool(WorkerNum, bUseGPU, CPUThreads))
+	{
+		return 1;
+	}
+
+	// モデルの読込時間を含めないよう、再生前に全ての話者のモデルを読み込む
+	TSet<int64> SpeakerIdSet;
+	for (const FVoicevoxTraceEntry& Entry : TraceEntryList)
+	{
+		SpeakerIdSet.Add(Entry.SpeakerId);
+	}
+	for (const int64 SpeakerId : SpeakerIdSet)
+	{
+		Subsystem->LoadModel(SpeakerId);
+	}
+
+	UE_LOG(LogVoicevoxReplay, Display, TEXT("Replay %d Requests (Speed: %.2f, Workers: %d)"), TraceEntryList.Num(), Speed, WorkerNum);
+	TArray<FVoicevoxTraceEntry> EntryList = TraceEntryList;
+	const double Duration = Replay(EntryList, Speed);
+	const FVoicevoxReplayReport Report = MakeReport(EntryList, Duration, Speed);
+	Subsystem->StopWorkerPool();
+
+	if (!SaveBaselinePath.IsEmpty())
+	{
+		FString ReportJson;
+		FJsonObjectConverter::UStructToJsonObjectString(Report, ReportJson);
+		if (!FFileHelper::SaveStringToFile(ReportJson, *SaveBaselinePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+		{
+			UE_LOG(LogVoicevoxReplay, Error, TEXT("Can't Write Baseline File: %s"), *SaveBaselinePath);
+			return 1;
+		}
+		UE_LOG(LogVoicevoxReplay, Display, TEXT("Baseline Written: %s"), *SaveBaselinePath);
+	}
+
+	return Compare(Baseline, Report, Threshold) ? 1 : 0;
+}
+
+/**
+ * @brief トレースのリクエストを記録した時刻どおりに再生し、所要時間と結果を書き換える
+ */
+double UVoicevoxReplayCommandlet::Replay(TArray<FVoicevoxTraceEntry>& EntryList, const float Speed)
+{
+	UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+	const double FirstTime = EntryList.IsEmpty() ? 0.0 : EntryList[0].Time;
+	std::atomic<int32> InFlightNum = 0;
+	TArray<UE::Tasks::FTask> TaskList;
+	TaskList.Reserve(EntryList.Num());
+
+	const double StartTime = FPlatformTime::Seconds();
+	for (FVoicevoxTraceEntry& Entry : EntryList)
+	{
+		// 記録した時刻まで待ってから開始する
+		if (Speed > 0.0f)
+		{
+			if (const double WaitTime = StartTime + (Entry.Time - FirstTime) / Speed - FPlatformTime::Seconds(); WaitTime > 0.0)
+			{
+				FPlatformProcess::Sleep(static_cast<float>(WaitTime));
+			}
+		}
+
+		// タスクの開始待ちも所要時間に含める
+		const double RequestTime = FPlatformTime::Seconds();
+		Entry.Time = RequestTime - StartTime;
+		TaskList.Add(UE::Tasks::Launch(TEXT("VoicevoxReplay"), [&Entry, &InFlightNum, Subsystem, RequestTime]
+		{
+			Entry.Concurrency = ++InFlightNum;
+			Entry.bSucceeded = RunEntry(Subsystem, Entry);
+			Entry.Latency = FPlatformTime::Seconds() - RequestTime;
+			--InFlightNum;
+		}));
+	}
+	UE::Tasks::Wait(TaskList);
+	return FPlatformTime::Seconds() - StartTime;
+}
+
+/**
+ * @brief トレースのリクエスト1件分を実行する
+ */
+bool UVoicevoxReplayCommandlet::RunEntry(UVoicevoxCoreSubsystem* Subsystem, const FVoicevoxTraceEntry& Entry)
+{
+	switch (Entry.Api)
+	{
+	case EVoicevoxTraceApi::GetAudioQuery:
+		return !Subsystem->GetAudioQuery(Entry.SpeakerId, Entry.Text, Entry.bKana).Accent_phrases.IsEmpty();
+	case EVoicevoxTraceApi::RunTextToSpeech:
+		return !Subsystem->RunTextToSpeech(Entry.SpeakerId, Entry.Text, Entry.bKana, Entry.bEnableInterrogativeUpspeak).IsEmpty();
+	case EVoicevoxTraceApi::RunSynthesis:
+		return !Subsystem->RunSynthesis(Entry.AudioQuery, Entry.SpeakerId, Entry.bEnableInterrogativeUpspeak, Entry.Priority).IsEmpty();
+	case EVoicevoxTraceApi::RunSynthesisWithDeadline:
+		{
+			FVoicevoxSynthesisDeadline Deadline;
+			if (Entry.Deadline != 0.0)
+			{
+				Deadline = FVoicevoxSynthesisDeadline::FromNow(Entry.Deadline);
+				Deadline.bCancelOnDeadlineMiss = Entry.bCancelOnDeadlineMiss;
+			}
+			return !Subsystem->RunSynthesisWithDeadline(Entry.AudioQuery, Entry.SpeakerId, Entry.bEnableInterrogativeUpspeak, Deadline, Entry.Priority).IsEmpty();
+		}
+	case EVoicevoxTraceApi::RunSynthesisWithPhraseCache:
+		return !Subsystem->RunSynthesisWithPhraseCache(Entry.AudioQuery, Entry.SpeakerId, Entry.bEnableInterrogativeUpspeak).IsEmpty();
+	case EVoicevoxTraceApi::RunSynthesisWithTemplate:
+		{
+			FVoicevoxAudioQuery AudioQuery;
+			return !Subsystem->RunSynthesisWithTemplate(Entry.Text, Entry.SlotValues, Entry.SpeakerId, Entry.bEnableInterrogativeUpspeak, AudioQuery).IsEmpty();
+		}
+	default:
+		return false;
+	}
+}
+
+/**
+ * @brief トレースのリクエストリストを集計する
+ */
+FVoicevoxReplayReport UVoicevoxReplayCommandlet::MakeReport(const TArray<FVoicevoxTraceEntry>& EntryList, const double Duration, const float Speed)
+{
+	FVoicevoxReplayReport Report;
+	Report.Speed = Speed;
+	Report.Duration = Duration;
+
+	// 失敗したリクエストは期限切れ等ですぐに戻るため、所要時間に含めない
+	const UEnum* ApiEnum = StaticEnum<EVoicevoxTraceApi>();
+	TArray<double> TotalLatencyList;
+	TMap<FString, TArray<double>> ApiLatencyMap;
+	for (const FVoicevoxTraceEntry& Entry : EntryList)
+	{
+		const FString ApiName = ApiEnum->GetNameStringByValue(static_cast<int64>(Entry.Api));
+		FVoicevoxReplayStats& ApiStats = Report.ApiStats.FindOrAdd(ApiName);
+		TArray<double>& ApiLatencyList = ApiLatencyMap.FindOrAdd(ApiName);
+		++Report.Total.RequestNum;
+		++ApiStats.RequestNum;
+		if (!Entry.bSucceeded)
+		{
+			++Report.Total.FailedNum;
+			++ApiStats.FailedNum;
+			continue;
+		}
+		TotalLatencyList.Add(Entry.Latency * 1000.0);
+		ApiLatencyList.Add(Entry.Latency * 1000.0);
+	}
+
+	FinishStats(Report.Total, TotalLatencyList, Duration);
+	for (TPair<FString, FVoicevoxReplayStats>& ApiStats : Report.ApiStats)
+	{
+		FinishStats(ApiStats.Value, ApiLatencyMap[ApiStats.Key], Duration);
+	}
+	return Report;
+}
+
+/**
+ * @brief ベースラインと比較して差を出力する
+ */
+bool UVoicevoxReplayCommandlet::Compare(const FVoicevoxReplayReport& Baseline, const FVoicevoxReplayReport& Report, const float Threshold)
+{
+	bool bIsRegressed = false;
+	auto CompareStats = [&bIsRegressed, Threshold](const FString& Name, const FVoicevoxReplayStats& Base, const FVoicevoxReplayStats& Current)
+	{
+		const double MeanDelta = GetDeltaPercent(Base.MeanLatency, Current.MeanLatency);
+		const double P50Delta = GetDeltaPercent(Base.P50Latency, Current.P50Latency);
+		const double P95Delta = GetDeltaPercent(Base.P95Latency, Current.P95Latency);
+		UE_LOG(LogVoicevoxReplay, Display, TEXT("%-28s Requests: %d (Failed: %d -> %d) Mean: %.1f -> %.1f ms (%+.1f%%) P50: %.1f -> %.1f ms (%+.1f%%) P95: %.1f -> %.1f ms (%+.1f%%)"),
+			*Name, Current.RequestNum, Base.FailedNum, Current.FailedNum,
+			Base.MeanLatency, Current.MeanLatency, MeanDelta, Base.P50Latency, Current.P50Latency, P50Delta, Base.P95Latency, Current.P95Latency, P95Delta);
+
+		if (MeanDelta > Threshold || P95Delta > Threshold)
+		{
+			UE_LOG(LogVoicevoxReplay, Warning, TEXT("%s: Latency Regression Over %.1f%%"), *Name, Threshold);
+			bIsRegressed = true;
+		}
+		if (Current.FailedNum > Base.FailedNum)
+		{
+			UE_LOG(LogVoicevoxReplay, Warning, TEXT("%s: Failed Requests Increased"), *Name);
+		}
+	};
+
+	CompareStats(TEXT("Total"), Baseline.Total, Report.Total);
+	for (const TPair<FString, FVoicevoxReplayStats>& ApiStats : Report.ApiStats)
+	{
+		if (const FVoicevoxReplayStats* BaseStats = Baseline.ApiStats.Find(ApiStats.Key))
+		{
+			CompareStats(ApiStats.Key, *BaseStats, ApiStats.Value);
+		}
+	}
+
+	// 再生速度が異なる場合はリクエストの間隔が異なるため、スループットは比較しない
+	if (FMath::IsNearlyEqual(Baseline.Speed, Report.Speed))
+	{
+		const double ThroughputDelta = GetDeltaPercent(Baseline.Total.Throughput, Report.Total.Throughput);
+		UE_LOG(LogVoicevoxReplay, Display, TEXT("Throughput: %.2f -> %.2f req/s (%+.1f%%) Duration: %.2f -> %.2f s"),
+			Baseline.Total.Throughput, Report.Total.Throughput, ThroughputDelta, Baseline.Duration, Report.Duration);
+		if (-ThroughputDelta > Threshold)
+		{
+			UE_LOG(LogVoicevoxReplay, Warning, TEXT("Throughput Regression Over %.1f%%"), Threshold);
+			bIsRegressed = true;
+		}
+	}
+	else
+	{
+		UE_LOG(LogVoicevoxReplay, Display, TEXT("Throughput: %.2f req/s (Not Compared: Speed %.2f -> %.2f)"), Report.Total.Throughput, Baseline.Speed, Report.Speed);
+	}
+
+	UE_LOG(LogVoicevoxReplay, Display, TEXT("Replay Result: %s"), bIsRegressed ? TEXT("Regressed") : TEXT("OK"));
+	return bIsRegressed;
+}
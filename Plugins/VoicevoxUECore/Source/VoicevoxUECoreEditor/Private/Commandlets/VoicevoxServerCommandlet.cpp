@@ -0,0 +1,63 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  VOICEVOX COREを読み込み、音声合成サーバーとして待ち受けるコマンドレットのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "Commandlets/VoicevoxServerCommandlet.h"
+
+#include "VoicevoxSynthesisServer.h"
+#include "Subsystems/VoicevoxCoreSubsystem.h"
+
+/**
+ * @brief コンストラクタ
+ */
+UVoicevoxServerCommandlet::UVoicevoxServerCommandlet(): Super()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+/**
+ * @brief Main override
+ */
+int32 UVoicevoxServerCommandlet::Main(const FString& Params)
+{
+	int32 Port = FVoicevoxRemoteProtocol::DefaultPort;
+	int32 WorkerNum = 0;
+	int32 CPUThreads = 0;
+	FParse::Value(*Params, TEXT("Port="), Port);
+	FParse::Value(*Params, TEXT("Workers="), WorkerNum);
+	FParse::Value(*Params, TEXT("CPUThreads="), CPUThreads);
+	const bool bUseGPU = FParse::Param(*Params, TEXT("GPU"));
+
+	// 話者情報をクライアントへ返すため、ワーカープロセスを使う場合もこのプロセスでVOICEVOX COREを初期化する
+	UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+	if (!Subsystem->Initialize(bUseGPU, CPUThreads, false))
+	{
+		UE_LOG(LogVoicevoxServer, Error, TEXT("VOICEVOX CORE Initialize Error"));
+		return 1;
+	}
+
+	if (WorkerNum > 0 && !Subsystem->StartWorkerPool(WorkerNum, bUseGPU, CPUThreads))
+	{
+		return 1;
+	}
+
+	if (!Subsystem->StartSynthesisServer(Port))
+	{
+		return 1;
+	}
+
+	while (!IsEngineExitRequested())
+	{
+		FPlatformProcess::Sleep(0.1f);
+	}
+
+	Subsystem->StopSynthesisServer();
+	Subsystem->StopWorkerPool();
+	return 0;
+}
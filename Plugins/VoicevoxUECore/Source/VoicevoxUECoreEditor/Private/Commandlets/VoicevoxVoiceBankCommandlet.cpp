@@ -0,0 +1,148 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @brief  プロジェクト内のAudioQueryアセットを事前に音声合成し、ボイスバンクファイルを生成するコマンドレットのCPPファイル
+ * @author Yuuki Ogino
+ */
+
+#include "Commandlets/VoicevoxVoiceBankCommandlet.h"
+
+#include "VoicevoxQuery.h"
+#include "VoicevoxVoiceBank.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Subsystems/VoicevoxCoreSubsystem.h"
+#include "Tasks/Task.h"
+#include <atomic>
+
+DEFINE_LOG_CATEGORY(LogVoicevoxVoiceBank);
+
+/**
+ * @brief コンストラクタ
+ */
+UVoicevoxVoiceBankCommandlet::UVoicevoxVoiceBankCommandlet(): Super()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+/**
+ * @brief Main override
+ */
+int32 UVoicevoxVoiceBankCommandlet::Main(const FString& Params)
+{
+	FString SearchPath = TEXT("/Game");
+	FString OutputPath = UVoicevoxCoreSubsystem::GetDefaultVoiceBankPath();
+	int32 WorkerNum = 2;
+	int32 CPUThreads = 0;
+	FParse::Value(*Params, TEXT("Path="), SearchPath);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Workers="), WorkerNum);
+	FParse::Value(*Params, TEXT("CPUThreads="), CPUThreads);
+	const bool bUseGPU = FParse::Param(*Params, TEXT("GPU"));
+	const bool bEnableInterrogativeUpspeak = !FParse::Param(*Params, TEXT("NoUpspeak"));
+	WorkerNum = FMath::Max(WorkerNum, 1);
+
+	// AudioQueryアセットの検索
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	FARFilter Filter;
+	Filter.ClassPaths.Add(UVoicevoxQuery::StaticClass()->GetClassPathName());
+	Filter.PackagePaths.Add(FName(SearchPath));
+	Filter.bRecursivePaths = true;
+	TArray<FAssetData> AssetDataList;
+	AssetRegistry.GetAssets(Filter, AssetDataList);
+
+	// 同じ内容のAudioQueryは1つのジョブにまとめる
+	TArray<FVoicevoxVoiceBankJob> JobList;
+	TSet<uint64> KeySet;
+	TSet<int64> SpeakerIdSet;
+	for (const FAssetData& AssetData : AssetDataList)
+	{
+		const UVoicevoxQuery* Query = Cast<UVoicevoxQuery>(AssetData.GetAsset());
+		if (Query == nullptr || Query->VoicevoxAudioQuery.Accent_phrases.IsEmpty()) continue;
+
+		const uint64 Key = FVoicevoxVoiceBank::GetKey(Query->VoicevoxAudioQuery, Query->SpeakerType, bEnableInterrogativeUpspeak);
+		if (KeySet.Contains(Key)) continue;
+		KeySet.Add(Key);
+
+		FVoicevoxVoiceBankJob& Job = JobList.AddDefaulted_GetRef();
+		Job.AudioQuery = Query->VoicevoxAudioQuery;
+		Job.SpeakerId = Query->SpeakerType;
+		Job.bEnableInterrogativeUpspeak = bEnableInterrogativeUpspeak;
+		Job.Key = Key;
+		SpeakerIdSet.Add(Query->SpeakerType);
+	}
+
+	UE_LOG(LogVoicevoxVoiceBank, Display, TEXT("Voice Bank %d Entries / %d Assets (Workers: %d)"), JobList.Num(), AssetDataList.Num(), WorkerNum);
+
+	// VOICEVOX COREの初期化（既存のボイスバンクに含まれる音声データはSubsystemが推論せずに返す）
+	UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+	if (!Subsystem->Initialize(bUseGPU, CPUThreads, false))
+	{
+		UE_LOG(LogVoicevoxVoiceBank, Error, TEXT("VOICEVOX CORE Initialize Error"));
+		return 1;
+	}
+	Subsystem->LoadVoiceBank(OutputPath);
+
+	for (const int64 SpeakerId : SpeakerIdSet)
+	{
+		Subsystem->LoadModel(SpeakerId);
+	}
+
+	RunJobs(JobList, WorkerNum);
+
+	TMap<uint64, TArray<uint8>> WavMap;
+	int32 FailedNum = 0;
+	for (FVoicevoxVoiceBankJob& Job : JobList)
+	{
+		if (Job.OutputWAV.IsEmpty())
+		{
+			++FailedNum;
+			continue;
+		}
+		WavMap.Add(Job.Key, MoveTemp(Job.OutputWAV));
+	}
+
+	// メモリマップ中のファイルは上書きできないため、書き込む前に閉じる
+	Subsystem->UnloadVoiceBank();
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(OutputPath), true);
+	if (!FVoicevoxVoiceBank::Write(OutputPath, WavMap))
+	{
+		UE_LOG(LogVoicevoxVoiceBank, Error, TEXT("Can't Write Voice Bank File: %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogVoicevoxVoiceBank, Display, TEXT("Voice Bank Written: %s (%d Entries)"), *OutputPath, WavMap.Num());
+	if (FailedNum > 0)
+	{
+		UE_LOG(LogVoicevoxVoiceBank, Error, TEXT("Synthesis Failed: %d Entries"), FailedNum);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief ワーカー数分のタスクでジョブを並列に音声合成する
+ */
+void UVoicevoxVoiceBankCommandlet::RunJobs(TArray<FVoicevoxVoiceBankJob>& JobList, const int32 WorkerNum)
+{
+	const UVoicevoxCoreSubsystem* Subsystem = GEngine->GetEngineSubsystem<UVoicevoxCoreSubsystem>();
+	std::atomic<int32> NextIndex = 0;
+	TArray<UE::Tasks::FTask> WorkerList;
+	WorkerList.Reserve(WorkerNum);
+	for (int32 Worker = 0; Worker < WorkerNum; ++Worker)
+	{
+		WorkerList.Add(UE::Tasks::Launch(TEXT("VoicevoxVoiceBankWorker"), [&JobList, &NextIndex, Subsystem]
+		{
+			for (int32 Index = NextIndex++; Index < JobList.Num(); Index = NextIndex++)
+			{
+				FVoicevoxVoiceBankJob& Job = JobList[Index];
+				Job.OutputWAV = Subsystem->RunSynthesis(Job.AudioQuery, Job.SpeakerId, Job.bEnableInterrogativeUpspeak);
+			}
+		}));
+	}
+	UE::Tasks::Wait(WorkerList);
+}
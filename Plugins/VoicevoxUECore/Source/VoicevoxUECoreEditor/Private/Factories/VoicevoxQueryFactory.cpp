@@ -7,6 +7,7 @@
 
 #include "Factories/VoicevoxQueryFactory.h"
 #include "JsonObjectConverter.h"
+#include "VoicevoxPhoneme.h"
 
 /**
  * @brief コンストラクタ
@@ -50,6 +51,7 @@ UObject* UVoicevoxQueryFactory::FactoryCreateText(UClass* InClass, UObject* InPa
 {
 	FVoicevoxAudioQuery AudioQuery{};
 	FJsonObjectConverter::JsonObjectStringToUStruct(Buffer, &AudioQuery, 0, 0);
+	FVoicevoxPhoneme::InternAudioQuery(AudioQuery);
  
 	UVoicevoxQuery* NewAudioQueryAsset = NewObject<UVoicevoxQuery>(InParent, InClass, InName, Flags);
 	NewAudioQueryAsset->VoicevoxAudioQuery = AudioQuery;
@@ -10,6 +10,8 @@
 
 #include "AssetTypeActions_Base.h"
 
+class UVoicevoxQuery;
+
 //------------------------------------------------------------------------
 // class
 //------------------------------------------------------------------------
@@ -67,4 +69,24 @@ public:
 	 */		
 	virtual void OpenAssetEditor(const TArray<UObject*>& InObjects,
 								  TSharedPtr<IToolkitHost> EditWithinLevelEditor = TSharedPtr<IToolkitHost>()) override;
+
+	/**
+	 * @brief HasActions override
+	 * @return Returns true if this class can supply actions for InObjects.
+	 */
+	virtual bool HasActions(const TArray<UObject*>& InObjects) const override;
+
+	/**
+	 * @brief GetActions override
+	 * @details AudioQueryアセットのリップシンクをカーブテーブルへベイクするメニューを追加します。
+	 */
+	virtual void GetActions(const TArray<UObject*>& InObjects, FToolMenuSection& Section) override;
+
+private:
+
+	/**
+	 * @brief AudioQueryアセットのリップシンクをカーブテーブルアセット（<アセット名>_LipSync）へベイクする
+	 * @param [in] Queries : AudioQueryアセットリスト
+	 */
+	static void BakeLipSyncCurves(TArray<TWeakObjectPtr<UVoicevoxQuery>> Queries);
 };
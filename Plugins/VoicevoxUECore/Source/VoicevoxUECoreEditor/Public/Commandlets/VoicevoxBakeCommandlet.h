@@ -0,0 +1,175 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxBakeCommandlet.h
+ * @brief  CSV、もしくはDataTableからAudioQueryアセットとSoundWaveアセットを一括生成するコマンドレットのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "Engine/DataTable.h"
+#include "VoicevoxUEDefined.h"
+#include "VoicevoxBakeCommandlet.generated.h"
+
+//------------------------------------------------------------------------
+// struct
+//------------------------------------------------------------------------
+
+/**
+ * @struct FVoicevoxBakeRow
+ * @brief 一括生成する台詞の行データ構造体（CSVのヘッダー行、もしくはDataTableの行構造体として使用）
+ */
+USTRUCT(BlueprintType)
+struct VOICEVOXUECOREEDITOR_API FVoicevoxBakeRow : public FTableRowBase
+{
+	GENERATED_USTRUCT_BODY()
+
+	//! 話者番号
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Bake")
+	int64 SpeakerId = 3;
+
+	//! 音声データに変換するtextデータ
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Bake")
+	FString Text;
+
+	//! AquesTalkライクな記法で実行するか
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Bake")
+	bool bRunKana = false;
+
+	//! 疑問文の調整を有効にする
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Bake")
+	bool bEnableInterrogativeUpspeak = true;
+
+	//! 話速
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Bake")
+	float SpeedScale = 1.0f;
+
+	//! 音高
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Bake")
+	float PitchScale = 0.0f;
+
+	//! 抑揚
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Bake")
+	float IntonationScale = 1.0f;
+
+	//! 音量
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Bake")
+	float VolumeScale = 1.0f;
+
+	//! 開始無音
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Bake")
+	float PrePhonemeLength = 0.1f;
+
+	//! 終了無音
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="VOICEVOX Bake")
+	float PostPhonemeLength = 0.1f;
+};
+
+/**
+ * @struct FVoicevoxBakeJob
+ * @brief 1行分の音声合成ジョブ構造体
+ */
+struct FVoicevoxBakeJob
+{
+	//! 行名（アセット名）
+	FName RowName;
+
+	//! 行データ
+	FVoicevoxBakeRow Row;
+
+	//! 入力内容のハッシュ値
+	uint32 Hash = 0;
+
+	//! 生成したAudioQuery
+	FVoicevoxAudioQuery AudioQuery;
+
+	//! 生成した音声データ
+	TArray<uint8> OutputWAV;
+
+	//! 音声合成に成功したか
+	bool bIsSucceeded = false;
+};
+
+//------------------------------------------------------------------------
+// class
+//------------------------------------------------------------------------
+
+/**
+ * @class UVoicevoxBakeCommandlet
+ * @brief CSV、もしくはDataTableの各行からAudioQueryアセットとSoundWaveアセットをダイアログ無しで一括生成するコマンドレット
+ * @details
+ * UnrealEditor-Cmd.exe <Project> -run=VoicevoxBake -Csv=<CSVファイルパス> [オプション]<br/>
+ * -Csv=<Path>				: 行データのCSVファイル（1列目は行名、ヘッダー行はFVoicevoxBakeRowのプロパティ名）<br/>
+ * -DataTable=<ObjectPath>	: 行データのDataTableアセット（行構造体はFVoicevoxBakeRow）<br/>
+ * -OutPath=<PackagePath>	: アセットの出力先（デフォルトは/Game/Voicevox/Bake）<br/>
+ * -Workers=<Num>			: 並列で音声合成するワーカー数（デフォルトは2）<br/>
+ * -BatchSize=<Num>			: アセット保存とGCを行う行数の単位（デフォルトは64）<br/>
+ * -CPUThreads=<Num>		: VOICEVOX COREの推論スレッド数（デフォルトは0）<br/>
+ * -GPU						: GPUモードでVOICEVOX COREを初期化する<br/>
+ * -NoAudioQuery			: AudioQueryアセットを生成しない<br/>
+ * -NoSoundWave				: SoundWaveアセットを生成しない<br/>
+ * -Force					: 入力が変更されていない行も生成し直す<br/>
+ * 入力内容のハッシュ値はSaved/Voicevox/BakeManifest.txtに記録し、前回から変更の無い行はスキップします。
+ */
+UCLASS()
+class VOICEVOXUECOREEDITOR_API UVoicevoxBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+	//----------------------------------------------------------------
+	// Function
+	//----------------------------------------------------------------
+
+	/**
+	 * @brief 行データから入力内容のハッシュ値を求める
+	 * @param [in] Row : 行データ
+	 * @return ハッシュ値
+	 */
+	static uint32 GetRowHash(const FVoicevoxBakeRow& Row);
+
+	/**
+	 * @brief マニフェストファイルを読み込む
+	 * @param [in] FilePath : マニフェストファイルパス
+	 * @return アセットパスと入力内容のハッシュ値のマップ
+	 */
+	static TMap<FString, uint32> LoadManifest(const FString& FilePath);
+
+	/**
+	 * @brief マニフェストファイルを保存する
+	 * @param [in] FilePath : マニフェストファイルパス
+	 * @param [in] Manifest : アセットパスと入力内容のハッシュ値のマップ
+	 */
+	static void SaveManifest(const FString& FilePath, const TMap<FString, uint32>& Manifest);
+
+	/**
+	 * @brief ワーカー数分のタスクでジョブを並列に音声合成する
+	 * @param [in,out] JobList : ジョブリスト
+	 * @param [in] WorkerNum : ワーカー数
+	 * @param [in] bIsSynthesis : 音声データを生成するか（falseの場合はAudioQueryのみ生成）
+	 */
+	static void RunJobs(TArray<FVoicevoxBakeJob>& JobList, int32 WorkerNum, bool bIsSynthesis);
+
+	/**
+	 * @brief ファクトリーでアセットを生成、もしくは上書きする
+	 * @param [in] Factory : ファクトリー
+	 * @param [in] PackageName : パッケージ名
+	 * @return 生成したアセットのパッケージ。失敗した場合はnullptr
+	 */
+	static UPackage* CreateAsset(UFactory* Factory, const FString& PackageName);
+
+public:
+
+	/**
+	 * @brief コンストラクタ
+	 */
+	UVoicevoxBakeCommandlet();
+
+	/**
+	 * @brief Main override
+	 */
+	virtual int32 Main(const FString& Params) override;
+};
+
+DECLARE_LOG_CATEGORY_EXTERN(LogVoicevoxBake, Log, All);
@@ -0,0 +1,161 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxReplayCommandlet.h
+ * @brief  キャプチャした音声合成リクエストのトレースを再生し、ベースラインと所要時間、スループットを比較するコマンドレットのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VoicevoxUEDefined.h"
+#include "VoicevoxReplayCommandlet.generated.h"
+
+class UVoicevoxCoreSubsystem;
+
+//------------------------------------------------------------------------
+// struct
+//------------------------------------------------------------------------
+
+/**
+ * @struct FVoicevoxReplayStats
+ * @brief リクエストの所要時間とスループットの集計結果の構造体
+ */
+USTRUCT()
+struct VOICEVOXUECOREEDITOR_API FVoicevoxReplayStats
+{
+	GENERATED_USTRUCT_BODY()
+
+	//! リクエスト数
+	UPROPERTY()
+	int32 RequestNum = 0;
+
+	//! 失敗したリクエスト数
+	UPROPERTY()
+	int32 FailedNum = 0;
+
+	//! 所要時間の平均（ミリ秒、成功したリクエストのみ）
+	UPROPERTY()
+	double MeanLatency = 0.0;
+
+	//! 所要時間の中央値（ミリ秒）
+	UPROPERTY()
+	double P50Latency = 0.0;
+
+	//! 所要時間の95パーセンタイル（ミリ秒）
+	UPROPERTY()
+	double P95Latency = 0.0;
+
+	//! 所要時間の最大値（ミリ秒）
+	UPROPERTY()
+	double MaxLatency = 0.0;
+
+	//! 1秒あたりに完了したリクエスト数
+	UPROPERTY()
+	double Throughput = 0.0;
+};
+
+/**
+ * @struct FVoicevoxReplayReport
+ * @brief トレースを再生した結果の構造体（ベースラインとしてJSONで保存する）
+ */
+USTRUCT()
+struct VOICEVOXUECOREEDITOR_API FVoicevoxReplayReport
+{
+	GENERATED_USTRUCT_BODY()
+
+	//! 再生速度（0の場合は全てのリクエストを同時に開始）
+	UPROPERTY()
+	float Speed = 1.0f;
+
+	//! 最初のリクエストから最後の完了までの時間（秒）
+	UPROPERTY()
+	double Duration = 0.0;
+
+	//! 全てのリクエストの集計結果
+	UPROPERTY()
+	FVoicevoxReplayStats Total;
+
+	//! API毎の集計結果
+	UPROPERTY()
+	TMap<FString, FVoicevoxReplayStats> ApiStats;
+};
+
+//------------------------------------------------------------------------
+// class
+//------------------------------------------------------------------------
+
+/**
+ * @class UVoicevoxReplayCommandlet
+ * @brief キャプチャしたトレースのリクエストを記録した時刻どおりに再生し、ベースラインとの所要時間、スループットの差を報告するコマンドレット
+ * @details
+ * UnrealEditor-Cmd.exe <Project> -run=VoicevoxReplay -Trace=<トレースファイルパス> [オプション]<br/>
+ * -Trace=<Path>			: UVoicevoxCoreSubsystem::StartTraceCaptureで保存したトレースファイル<br/>
+ * -Baseline=<Path>			: 比較するベースラインのJSONファイル（省略した場合はトレースに記録した所要時間と比較）<br/>
+ * -SaveBaseline=<Path>		: 再生した結果をベースラインとして保存する<br/>
+ * -Speed=<X>				: 再生速度（デフォルトは1、0の場合は全てのリクエストを同時に開始）<br/>
+ * -Threshold=<Percent>		: 回帰とみなす悪化の割合（デフォルトは10%）<br/>
+ * -Workers=<Num>			: VOICEVOX COREを実行するワーカープロセス数（デフォルトは0で、このプロセスで実行する）<br/>
+ * -CPUThreads=<Num>		: VOICEVOX COREの推論スレッド数（デフォルトは0）<br/>
+ * -GPU						: GPUモードでVOICEVOX COREを初期化する<br/>
+ * 「-VoicevoxServerAddress=<Address>」を指定すると音声合成サーバーに対して再生します。
+ * 所要時間の平均、95パーセンタイル、もしくはスループットが閾値を超えて悪化した場合は1を返します。
+ */
+UCLASS()
+class VOICEVOXUECOREEDITOR_API UVoicevoxReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+	//----------------------------------------------------------------
+	// Function
+	//----------------------------------------------------------------
+
+	/**
+	 * @brief トレースのリクエストを記録した時刻どおりに再生し、所要時間と結果を書き換える
+	 * @param [in,out] EntryList : トレースのリクエストリスト（経過時間の昇順）
+	 * @param [in] Speed : 再生速度（0の場合は全てのリクエストを同時に開始）
+	 * @return 最初のリクエストから最後の完了までの時間（秒）
+	 */
+	static double Replay(TArray<FVoicevoxTraceEntry>& EntryList, float Speed);
+
+	/**
+	 * @brief トレースのリクエスト1件分を実行する
+	 * @param [in] Subsystem : VOICEVOX CORE Subsystem
+	 * @param [in] Entry : トレースのリクエスト
+	 * @return 成功したらtrue
+	 */
+	static bool RunEntry(UVoicevoxCoreSubsystem* Subsystem, const FVoicevoxTraceEntry& Entry);
+
+	/**
+	 * @brief トレースのリクエストリストを集計する
+	 * @param [in] EntryList : トレースのリクエストリスト
+	 * @param [in] Duration : 最初のリクエストから最後の完了までの時間（秒）
+	 * @param [in] Speed : 再生速度
+	 * @return 集計結果
+	 */
+	static FVoicevoxReplayReport MakeReport(const TArray<FVoicevoxTraceEntry>& EntryList, double Duration, float Speed);
+
+	/**
+	 * @brief ベースラインと比較して差を出力する
+	 * @param [in] Baseline : ベースライン
+	 * @param [in] Report : 再生した結果
+	 * @param [in] Threshold : 回帰とみなす悪化の割合（%）
+	 * @return 閾値を超えて悪化した場合はtrue
+	 */
+	static bool Compare(const FVoicevoxReplayReport& Baseline, const FVoicevoxReplayReport& Report, float Threshold);
+
+public:
+
+	/**
+	 * @brief コンストラクタ
+	 */
+	UVoicevoxReplayCommandlet();
+
+	/**
+	 * @brief Main override
+	 */
+	virtual int32 Main(const FString& Params) override;
+};
+
+DECLARE_LOG_CATEGORY_EXTERN(LogVoicevoxReplay, Log, All);
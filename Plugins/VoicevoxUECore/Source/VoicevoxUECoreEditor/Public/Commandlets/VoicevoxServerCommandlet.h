@@ -0,0 +1,41 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxServerCommandlet.h
+ * @brief  VOICEVOX COREを読み込み、音声合成サーバーとして待ち受けるコマンドレットのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VoicevoxServerCommandlet.generated.h"
+
+/**
+ * @class UVoicevoxServerCommandlet
+ * @brief VOICEVOX COREを1度だけ読み込み、同じマシン上のゲームやエディタからの音声合成リクエストを処理するコマンドレット
+ * @details
+ * UnrealEditor-Cmd.exe <Project> -run=VoicevoxServer [オプション]<br/>
+ * -Port=<Num>				: 待ち受けるポート番号（デフォルトは50121）<br/>
+ * -Workers=<Num>			: VOICEVOX COREを実行するワーカープロセス数（デフォルトは0で、このプロセスで実行する）<br/>
+ * -CPUThreads=<Num>		: VOICEVOX COREの推論スレッド数（デフォルトは0）<br/>
+ * -GPU						: GPUモードでVOICEVOX COREを初期化する<br/>
+ * クライアント側は「-VoicevoxServerAddress=127.0.0.1:<Port>」を指定して起動してください。終了するまで待ち受けを続けます。
+ */
+UCLASS()
+class VOICEVOXUECOREEDITOR_API UVoicevoxServerCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * @brief コンストラクタ
+	 */
+	UVoicevoxServerCommandlet();
+
+	/**
+	 * @brief Main override
+	 */
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,88 @@
+// Copyright Yuuki Ogino. All Rights Reserved.
+
+/**
+ * @headerfile VoicevoxVoiceBankCommandlet.h
+ * @brief  プロジェクト内のAudioQueryアセットを事前に音声合成し、ボイスバンクファイルを生成するコマンドレットのヘッダーファイル
+ * @author Yuuki Ogino
+ */
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VoicevoxUEDefined.h"
+#include "VoicevoxVoiceBankCommandlet.generated.h"
+
+//------------------------------------------------------------------------
+// struct
+//------------------------------------------------------------------------
+
+/**
+ * @struct FVoicevoxVoiceBankJob
+ * @brief 1アセット分の音声合成ジョブ構造体
+ */
+struct FVoicevoxVoiceBankJob
+{
+	//! AudioQuery
+	FVoicevoxAudioQuery AudioQuery;
+
+	//! 話者番号
+	int64 SpeakerId = 0;
+
+	//! 疑問文の調整を有効にする
+	bool bEnableInterrogativeUpspeak = true;
+
+	//! ボイスバンクの検索キー
+	uint64 Key = 0;
+
+	//! 生成した音声データ
+	TArray<uint8> OutputWAV;
+};
+
+//------------------------------------------------------------------------
+// class
+//------------------------------------------------------------------------
+
+/**
+ * @class UVoicevoxVoiceBankCommandlet
+ * @brief プロジェクト内のAudioQueryアセットを事前に音声合成し、ランタイムでメモリマップして使うボイスバンクファイルを生成するコマンドレット
+ * @details
+ * パッケージ化（BuildCookRun）の前に実行してください。<br/>
+ * UnrealEditor-Cmd.exe <Project> -run=VoicevoxVoiceBank [オプション]<br/>
+ * -Path=<PackagePath>		: AudioQueryアセットを検索するパス（デフォルトは/Game）<br/>
+ * -Output=<FilePath>		: ボイスバンクファイルの出力先（デフォルトはContent/Voicevox/VoiceBank.vvbank）<br/>
+ * -Workers=<Num>			: 並列で音声合成するワーカー数（デフォルトは2）<br/>
+ * -CPUThreads=<Num>		: VOICEVOX COREの推論スレッド数（デフォルトは0）<br/>
+ * -GPU						: GPUモードでVOICEVOX COREを初期化する<br/>
+ * -NoUpspeak				: 疑問文の調整を無効にした音声データを生成する<br/>
+ * 既存のボイスバンクに含まれる音声データは推論せずにそのまま再利用します。
+ */
+UCLASS()
+class VOICEVOXUECOREEDITOR_API UVoicevoxVoiceBankCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+	//----------------------------------------------------------------
+	// Function
+	//----------------------------------------------------------------
+
+	/**
+	 * @brief ワーカー数分のタスクでジョブを並列に音声合成する
+	 * @param [in,out] JobList : ジョブリスト
+	 * @param [in] WorkerNum : ワーカー数
+	 */
+	static void RunJobs(TArray<FVoicevoxVoiceBankJob>& JobList, int32 WorkerNum);
+
+public:
+
+	/**
+	 * @brief コンストラクタ
+	 */
+	UVoicevoxVoiceBankCommandlet();
+
+	/**
+	 * @brief Main override
+	 */
+	virtual int32 Main(const FString& Params) override;
+};
+
+DECLARE_LOG_CATEGORY_EXTERN(LogVoicevoxVoiceBank, Log, All);
@@ -23,6 +23,7 @@ public class VoicevoxUECoreEditor : ModuleRules
             new string[]
             {
                 "UnrealEd",
+                "ToolMenus",
                 "CoreUObject",
                 "Engine",
                 "Slate",